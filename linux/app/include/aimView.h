@@ -0,0 +1,28 @@
+// Live aiming view: the target, and a crosshair where the accelerometer
+// points, in a square field on the LCD. Each update erases and redraws
+// only the sprites which moved.
+// Like the widgets, it draws into the image GUI_Paint has selected,
+// which must still hold what it last drew there.
+#ifndef _AIM_VIEW_H_
+#define _AIM_VIEW_H_
+
+#include <stdbool.h>
+#include "displayQueue.h"
+#include "hal/accelerometer.h"
+
+// An update changes at most this many regions: each sprite's old and
+// new rectangles.
+#define AIM_VIEW_MAX_REGIONS 4
+
+// Draw the empty field (its border) into the selected image, and forget
+// the sprites; writes the region it covers.
+void AimView_drawField(DisplayQueue_region_t *pRegion);
+
+// Move the sprites to `aim` and `target` (in the accelerometer's
+// coordinates); the target is highlighted when `onTarget`. Writes the
+// regions it changed and returns how many there are; 0 if neither
+// sprite moved by a pixel.
+int AimView_update(coordinates aim, coordinates target, bool onTarget,
+    DisplayQueue_region_t *pRegions);
+
+#endif
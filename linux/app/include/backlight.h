@@ -0,0 +1,33 @@
+// LCD backlight brightness, with fades and auto-dim.
+// Fades run on the module's own thread, so callers (the render thread)
+// only record what they want and return.
+// Usage:
+//  1. Call Backlight_init() once the panel is up (after DrawStuff_init());
+//     the backlight fades in to BACKLIGHT_MAX.
+//  2. Call Backlight_fadeTo() to change the brightness.
+//  3. Call Backlight_poke() on any user activity. With auto-dim on, the
+//     backlight fades to the dim level after the idle time passes
+//     without a poke, and the next poke brings it back.
+#ifndef _BACKLIGHT_H_
+#define _BACKLIGHT_H_
+
+// Brightness runs from 0 (off) to BACKLIGHT_MAX, as DEV_SetBacklight().
+#define BACKLIGHT_MAX 1023
+
+void Backlight_init(void);
+// Turns the backlight off.
+void Backlight_cleanup(void);
+
+// Fade from the current brightness to `level` over `durationMS`
+// (0 sets it at once). This is the brightness used while active; while
+// dimmed, it is faded to on waking.
+void Backlight_fadeTo(int level, int durationMS);
+
+// Dim to `dimLevel` after `idleMS` without a poke, counting from now;
+// 0 idleMS turns auto-dim off.
+void Backlight_setAutoDim(int dimLevel, long long idleMS);
+
+// Note user activity. Cheap enough to call every frame.
+void Backlight_poke(void);
+
+#endif
@@ -0,0 +1,65 @@
+// Queue of frames for the LCD, transmitted by a worker thread.
+// Usage:
+//  1. Call DisplayQueue_getBuffer() and draw into it; it starts out
+//     holding the last frame submitted, so only what changed need be
+//     drawn.
+//  2. Call DisplayQueue_submit() with the regions which changed. The
+//     worker sends them while the next frame is drawn into another
+//     buffer. A frame still waiting when the next is submitted is
+//     dropped; its regions are sent with the newer frame.
+// Between init and cleanup the worker owns the SPI bus: nothing else
+// may send to the LCD while frames are queued.
+#ifndef _DISPLAY_QUEUE_H_
+#define _DISPLAY_QUEUE_H_
+
+#include <stdint.h>
+
+// Regions of a frame are kept apart, up to this many; more are merged.
+#define DISPLAY_QUEUE_MAX_REGIONS 8
+
+// [xStart, xEnd) x [yStart, yEnd)
+typedef struct {
+    uint16_t xStart;
+    uint16_t yStart;
+    uint16_t xEnd;
+    uint16_t yEnd;
+} DisplayQueue_region_t;
+
+typedef struct {
+    long long numSubmitted;
+    long long numSent;
+    long long numDropped;
+} DisplayQueue_stats_t;
+
+// Allocate the buffers and start the worker; call after DEV_ModuleInit()
+// and Period_init().
+void DisplayQueue_init(void);
+// Send any frame still queued, then stop the worker.
+void DisplayQueue_cleanup(void);
+
+// Buffer (LCD_1IN54_WIDTH x LCD_1IN54_HEIGHT) for the next frame.
+uint16_t *DisplayQueue_getBuffer(void);
+
+// Queue the buffer from DisplayQueue_getBuffer(); the regions hold what
+// changed. sampleNS is when the newest input the frame shows was sampled
+// (Timing_getCounterNS()), or 0. When it is set, the time from then
+// until the frame has been sent is recorded as PERIOD_EVENT_LCD_LATENCY.
+void DisplayQueue_submit(const DisplayQueue_region_t *pRegions, int numRegions,
+    long long sampleNS);
+
+// Block until the worker has taken the last submitted frame. A renderer
+// which calls this before each frame draws while the previous frame is
+// being sent, and never draws a frame which would be dropped.
+void DisplayQueue_waitForFrame(void);
+
+void DisplayQueue_getStats(DisplayQueue_stats_t *pStats);
+
+// Have the worker call sentFn with each frame once it is sent; NULL
+// for none. sentFn is first called here with the last frame submitted.
+// A call already under way may finish after this returns.
+// The frame is only valid during the call, which holds up sending the
+// next, so it should do no more than copy it.
+typedef void (*DisplayQueue_sentFn)(const uint16_t *pFrame);
+void DisplayQueue_setSentHook(DisplayQueue_sentFn sentFn);
+
+#endif
@@ -0,0 +1,40 @@
+// Serve what the LCD shows to remote viewers over TCP.
+// Each viewer is sent a keyframe when it connects, then at most
+// FRAME_STREAM_MAX_FPS updates a second holding just the 16x16 tiles
+// which changed, run-length encoded. A viewer which can't keep up is
+// sent nothing new until it has taken what is queued for it; the
+// changes meanwhile are coalesced into its next update. Frames are
+// copied off the display queue's worker, so viewers never hold up
+// drawing.
+// Usage:
+//  1. Call FrameStream_init() after DrawStuff_init() (the display
+//     queue is up), and FrameStream_cleanup() before its cleanup.
+//  2. Connect a viewer, e.g. tools/framedump.c, to FRAME_STREAM_PORT.
+#ifndef _FRAME_STREAM_H_
+#define _FRAME_STREAM_H_
+
+#define FRAME_STREAM_PORT 12347
+#define FRAME_STREAM_MAX_FPS 10
+#define FRAME_STREAM_MAX_VIEWERS 4
+
+// Protocol; every field is big-endian. An update is
+//   u8 type (FRAME_STREAM_KEYFRAME or FRAME_STREAM_DELTA),
+//   u16 width, u16 height, u16 number of tiles,
+// then for each tile
+//   u8 tile column, u8 tile row, u16 number of runs,
+// then, with no runs, the tile's pixels row by row; else each run as
+//   u8 length - 1, u16 pixel.
+// Pixels are RGB565. Tiles on the right and bottom edges are cut to
+// the frame. A keyframe holds every tile.
+#define FRAME_STREAM_TILE_SIZE 16
+#define FRAME_STREAM_KEYFRAME 'K'
+#define FRAME_STREAM_DELTA 'D'
+#define FRAME_STREAM_UPDATE_HEADER_BYTES 7
+#define FRAME_STREAM_TILE_HEADER_BYTES 4
+#define FRAME_STREAM_RUN_BYTES 3
+#define FRAME_STREAM_MAX_RUN 256
+
+void FrameStream_init(void);
+void FrameStream_cleanup(void);
+
+#endif
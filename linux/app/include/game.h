@@ -2,6 +2,8 @@
 #ifndef _GAME_H_
 #define _GAME_H_
 
+#include "hal/accelerometer.h"
+
 // init/cleanup
 void Game_init(void);
 void Game_cleanup(void);
@@ -13,4 +15,9 @@ int Game_getMisses(void);
 // get elapsed time in milliseconds
 long long Game_getElapsedTimeMS(void);
 
+// get where the player must aim, in the accelerometer's coordinates;
+// on target within GAME_TARGET_RADIUS of it on both axes
+#define GAME_TARGET_RADIUS 0.1
+coordinates Game_getTarget(void);
+
 #endif
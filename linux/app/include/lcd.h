@@ -2,10 +2,21 @@
 #ifndef _DRAW_STUFF_H_
 #define _DRAW_STUFF_H_
 
+#include "hal/accelerometer.h"
+
+// init/cleanup bring the panel up and down, with the backlight off
+// (see backlight.h); start/stop the thread which draws the game's state
+// (needs Game_init(), Backlight_init() and Period_init()); stop prints
+// the aiming view's latency
 void DrawStuff_init();
 void DrawStuff_cleanup();
+void DrawStuff_start();
+void DrawStuff_stop();
 
-// update the main screen
-void DrawStuff_updateScreen_main(char* beatName, char* volume, char* bpm);
+// update the main screen: the stats, and the crosshair at the aim's
+// reading with the target; only what changed since the last update is
+// drawn and sent to the LCD
+void DrawStuff_updateScreen_main(int hits, int misses, long long elapsedTimeMS,
+    const accel_snapshot_t *pAim, coordinates target);
 
 #endif
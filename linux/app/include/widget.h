@@ -0,0 +1,88 @@
+// Retained widgets drawn with GUI_Paint: labels, counters, progress bars
+// and icons.
+// Usage:
+//  1. Initialize each widget once, then set its value as often as you
+//     like; a widget is only marked dirty when its value changes.
+//  2. When Widget_isDirty() is true for any of them, select the frame
+//     (Paint_NewImage/Paint_SelectImage) and call Widget_draw() on each.
+//     Only dirty widgets are drawn, and the rectangle they cover is
+//     returned so just that region need be sent to the LCD.
+// Widgets draw into whatever image GUI_Paint has selected, which must
+// still hold what they last drew there (as DisplayQueue buffers do).
+#ifndef _WIDGET_H_
+#define _WIDGET_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "fonts.h"
+
+#define WIDGET_MAX_TEXT 32
+
+typedef enum {
+    WIDGET_LABEL,
+    WIDGET_COUNTER,
+    WIDGET_PROGRESS,
+    WIDGET_ICON,
+} Widget_kind_t;
+
+// [xStart, xEnd) x [yStart, yEnd); empty when xStart == xEnd
+typedef struct {
+    uint16_t xStart;
+    uint16_t yStart;
+    uint16_t xEnd;
+    uint16_t yEnd;
+} Widget_rect_t;
+
+typedef struct {
+    Widget_kind_t kind;
+    uint16_t x;
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+    uint16_t foreground;
+    uint16_t background;
+
+    // Label: the text. Counter: the format, with one %d for the value.
+    sFONT *pFont;
+    char text[WIDGET_MAX_TEXT];
+
+    // Counter and progress bar; a bar is full at max.
+    int value;
+    int max;
+
+    // Icon: width x height RGB565 pixels, as for Paint_DrawImage();
+    // NULL fills its box with the background.
+    const unsigned char *pImage;
+
+    // What is on the screen, and whether it has changed since.
+    bool isDrawn;
+    bool isDirty;
+    char drawnText[WIDGET_MAX_TEXT];
+    uint16_t drawnFill;
+} Widget_t;
+
+void Widget_initLabel(Widget_t *pWidget, uint16_t x, uint16_t y, sFONT *pFont,
+    uint16_t foreground, uint16_t background, const char *text);
+void Widget_initCounter(Widget_t *pWidget, uint16_t x, uint16_t y, sFONT *pFont,
+    uint16_t foreground, uint16_t background, const char *format, int value);
+void Widget_initProgress(Widget_t *pWidget, uint16_t x, uint16_t y, uint16_t width,
+    uint16_t height, uint16_t foreground, uint16_t background, int value, int max);
+void Widget_initIcon(Widget_t *pWidget, uint16_t x, uint16_t y, uint16_t width,
+    uint16_t height, uint16_t background, const unsigned char *pImage);
+
+// Change a widget's value; it is only marked dirty if the value differs.
+void Widget_setText(Widget_t *pWidget, const char *text);
+void Widget_setValue(Widget_t *pWidget, int value);
+void Widget_setImage(Widget_t *pWidget, const unsigned char *pImage);
+
+// Mark a widget to be drawn again, as after the frame is cleared.
+void Widget_invalidate(Widget_t *pWidget);
+bool Widget_isDirty(const Widget_t *pWidget);
+
+// Draw the widget if it is dirty, adding the pixels it changed to
+// *pDirty: a label redraws only the characters which differ, and a
+// progress bar only the part of the bar which moved. Returns whether
+// it drew anything.
+bool Widget_draw(Widget_t *pWidget, Widget_rect_t *pDirty);
+
+#endif
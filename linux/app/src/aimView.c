@@ -0,0 +1,170 @@
+// Live aiming view: target and crosshair sprites in a field on the LCD.
+
+#include "aimView.h"
+#include "game.h"
+#include "GUI_Paint.h"
+#include <math.h>
+
+// The field: a square below the stats, with a border
+#define FIELD_X 28
+#define FIELD_Y 50
+#define FIELD_SIZE 184
+#define FIELD_CENTER_X (FIELD_X + FIELD_SIZE / 2)
+#define FIELD_CENTER_Y (FIELD_Y + FIELD_SIZE / 2)
+#define FIELD_BACKGROUND WHITE
+#define FIELD_BORDER BLACK
+
+// Accelerometer reading at the edge of the field
+#define FIELD_RANGE 1.0
+#define PIXELS_PER_UNIT ((FIELD_SIZE / 2 - 2) / FIELD_RANGE)
+
+// The target is drawn as big as the area which counts as on target.
+#define TARGET_RADIUS ((int)(GAME_TARGET_RADIUS * PIXELS_PER_UNIT))
+#define TARGET_COLOR BLUE
+#define TARGET_HIT_COLOR GREEN
+#define CROSSHAIR_ARM 7
+#define CROSSHAIR_COLOR RED
+
+// GUI_Paint draws a point of width 1 at (X - 1, Y - 1)
+#define PAINT_OFFSET 1
+
+typedef struct {
+    bool isShown;
+    int x;              // Centre, in pixels
+    int y;
+    bool isHighlighted;
+} sprite_t;
+
+static sprite_t s_target;
+static sprite_t s_crosshair;
+
+// Pixel for a reading, keeping a sprite of `half` pixels either side of
+// its centre inside the border.
+static int toPixel(double value, int center, int half)
+{
+    int pixel = center + (int)lround(value * PIXELS_PER_UNIT);
+    int min = center - FIELD_SIZE / 2 + 1 + half;
+    int max = center + FIELD_SIZE / 2 - 2 - half;
+    if (pixel < min) return min;
+    if (pixel > max) return max;
+    return pixel;
+}
+
+static DisplayQueue_region_t rectOf(const sprite_t *pSprite, int half)
+{
+    DisplayQueue_region_t rect = {
+        pSprite->x - half, pSprite->y - half,
+        pSprite->x + half + 1, pSprite->y + half + 1
+    };
+    return rect;
+}
+
+static bool isSame(const sprite_t *pA, const sprite_t *pB)
+{
+    return pA->isShown == pB->isShown && pA->x == pB->x && pA->y == pB->y
+        && pA->isHighlighted == pB->isHighlighted;
+}
+
+static bool touchesAny(DisplayQueue_region_t rect, const DisplayQueue_region_t *pRegions,
+    int numRegions)
+{
+    for (int i = 0; i < numRegions; i++) {
+        if (rect.xStart < pRegions[i].xEnd && pRegions[i].xStart < rect.xEnd
+                && rect.yStart < pRegions[i].yEnd && pRegions[i].yStart < rect.yEnd) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void erase(DisplayQueue_region_t rect)
+{
+    Paint_ClearWindow(rect.xStart, rect.yStart, rect.xEnd, rect.yEnd, FIELD_BACKGROUND);
+}
+
+static void drawTarget(const sprite_t *pSprite)
+{
+    int x = pSprite->x + PAINT_OFFSET;
+    int y = pSprite->y + PAINT_OFFSET;
+    if (pSprite->isHighlighted) {
+        Paint_DrawCircle(x, y, TARGET_RADIUS, TARGET_HIT_COLOR, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    } else {
+        Paint_DrawCircle(x, y, TARGET_RADIUS, TARGET_COLOR, DOT_PIXEL_1X1, DRAW_FILL_EMPTY);
+    }
+}
+
+static void drawCrosshair(const sprite_t *pSprite)
+{
+    int x = pSprite->x + PAINT_OFFSET;
+    int y = pSprite->y + PAINT_OFFSET;
+    Paint_DrawLine(x - CROSSHAIR_ARM, y, x + CROSSHAIR_ARM, y,
+        CROSSHAIR_COLOR, DOT_PIXEL_1X1, LINE_STYLE_SOLID);
+    Paint_DrawLine(x, y - CROSSHAIR_ARM, x, y + CROSSHAIR_ARM,
+        CROSSHAIR_COLOR, DOT_PIXEL_1X1, LINE_STYLE_SOLID);
+}
+
+void AimView_drawField(DisplayQueue_region_t *pRegion)
+{
+    Paint_ClearWindow(FIELD_X, FIELD_Y, FIELD_X + FIELD_SIZE, FIELD_Y + FIELD_SIZE,
+        FIELD_BACKGROUND);
+    Paint_DrawRectangle(FIELD_X + PAINT_OFFSET, FIELD_Y + PAINT_OFFSET,
+        FIELD_X + FIELD_SIZE - 1 + PAINT_OFFSET, FIELD_Y + FIELD_SIZE - 1 + PAINT_OFFSET,
+        FIELD_BORDER, DOT_PIXEL_1X1, DRAW_FILL_EMPTY);
+
+    s_target.isShown = false;
+    s_crosshair.isShown = false;
+
+    DisplayQueue_region_t field = {FIELD_X, FIELD_Y, FIELD_X + FIELD_SIZE, FIELD_Y + FIELD_SIZE};
+    *pRegion = field;
+}
+
+int AimView_update(coordinates aim, coordinates target, bool onTarget,
+    DisplayQueue_region_t *pRegions)
+{
+    // Screen y grows downwards
+    sprite_t newTarget = {
+        true,
+        toPixel(target.x, FIELD_CENTER_X, TARGET_RADIUS),
+        toPixel(-target.y, FIELD_CENTER_Y, TARGET_RADIUS),
+        onTarget
+    };
+    sprite_t newCrosshair = {
+        true,
+        toPixel(aim.x, FIELD_CENTER_X, CROSSHAIR_ARM),
+        toPixel(-aim.y, FIELD_CENTER_Y, CROSSHAIR_ARM),
+        false
+    };
+    bool isTargetMoved = !isSame(&s_target, &newTarget);
+    bool isCrosshairMoved = !isSame(&s_crosshair, &newCrosshair);
+    if (!isTargetMoved && !isCrosshairMoved) {
+        return 0;
+    }
+
+    // Erase the sprites which moved...
+    int numRegions = 0;
+    if (isTargetMoved && s_target.isShown) {
+        pRegions[numRegions] = rectOf(&s_target, TARGET_RADIUS);
+        erase(pRegions[numRegions++]);
+    }
+    if (isCrosshairMoved && s_crosshair.isShown) {
+        pRegions[numRegions] = rectOf(&s_crosshair, CROSSHAIR_ARM);
+        erase(pRegions[numRegions++]);
+    }
+
+    // ...then draw, bottom first, those which moved or which something
+    // erased or drawn so far overlaps.
+    DisplayQueue_region_t targetRect = rectOf(&newTarget, TARGET_RADIUS);
+    if (isTargetMoved || touchesAny(targetRect, pRegions, numRegions)) {
+        drawTarget(&newTarget);
+        pRegions[numRegions++] = targetRect;
+    }
+    DisplayQueue_region_t crosshairRect = rectOf(&newCrosshair, CROSSHAIR_ARM);
+    if (isCrosshairMoved || touchesAny(crosshairRect, pRegions, numRegions)) {
+        drawCrosshair(&newCrosshair);
+        pRegions[numRegions++] = crosshairRect;
+    }
+
+    s_target = newTarget;
+    s_crosshair = newCrosshair;
+    return numRegions;
+}
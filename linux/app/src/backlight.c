@@ -0,0 +1,243 @@
+// LCD backlight brightness, with fades and auto-dim.
+
+#include "backlight.h"
+#include "DEV_Config.h"
+#include "common/timing.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include <pthread.h>
+#include <time.h>
+
+_Static_assert(BACKLIGHT_MAX == DEV_BACKLIGHT_MAX, "backlight range differs from DEV_Config's");
+
+// A fade moves the brightness 100 times a second.
+#define FADE_STEP_NS (10 * TIMING_NS_PER_MS)
+#define FADE_IN_MS 500
+#define DIM_FADE_MS 1000
+#define WAKE_FADE_MS 150
+
+static bool isInitialized = false;
+static bool isRunning = false;
+static pthread_t backlightThreadID;
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_changed;
+static bool s_isChanged = false;
+
+// Brightness while active, and after s_idleNS without a poke (0: never)
+static int s_activeLevel;
+static int s_dimLevel;
+static long long s_idleNS;
+static bool s_isDimmed;
+
+// Brightness as last set, and the fade under way
+static int s_level;
+static bool s_isFading;
+static int s_fadeFrom;
+static int s_fadeTo;
+static long long s_fadeStartNS;
+static long long s_fadeNS;
+
+// Written without the lock by Backlight_poke(); while dimmed, the
+// thread sleeps until a poke wakes it.
+static atomic_llong s_lastActivityNS;
+static atomic_bool s_isWakeNeeded;
+
+static int clampLevel(int level)
+{
+    if (level < 0) return 0;
+    if (level > BACKLIGHT_MAX) return BACKLIGHT_MAX;
+    return level;
+}
+
+static void startFade(int level, int durationMS, long long nowNS)
+{
+    s_fadeFrom = s_level;
+    s_fadeTo = level;
+    s_fadeStartNS = nowNS;
+    s_fadeNS = durationMS * TIMING_NS_PER_MS;
+    s_isFading = true;
+}
+
+// Brightness for now, ending the fade once it is done.
+static int levelAt(long long nowNS)
+{
+    if (s_isFading) {
+        long long elapsedNS = nowNS - s_fadeStartNS;
+        if (elapsedNS >= s_fadeNS) {
+            s_level = s_fadeTo;
+            s_isFading = false;
+        } else {
+            s_level = s_fadeFrom
+                + (int)((long long)(s_fadeTo - s_fadeFrom) * elapsedNS / s_fadeNS);
+        }
+    }
+    return s_level;
+}
+
+static void updateAutoDim(long long nowNS)
+{
+    long long idleNS = nowNS - atomic_load(&s_lastActivityNS);
+    bool isIdle = s_idleNS > 0 && idleNS >= s_idleNS;
+
+    if (isIdle && !s_isDimmed) {
+        s_isDimmed = true;
+        atomic_store(&s_isWakeNeeded, true);
+        int dimLevel = s_dimLevel < s_activeLevel ? s_dimLevel : s_activeLevel;
+        startFade(dimLevel, DIM_FADE_MS, nowNS);
+    } else if (!isIdle && s_isDimmed) {
+        s_isDimmed = false;
+        atomic_store(&s_isWakeNeeded, false);
+        startFade(s_activeLevel, WAKE_FADE_MS, nowNS);
+    }
+}
+
+// When there is next something to do; 0 if only a change will tell.
+static long long nextWakeNS(long long nowNS)
+{
+    if (s_isFading) {
+        return nowNS + FADE_STEP_NS;
+    }
+    if (s_idleNS > 0 && !s_isDimmed) {
+        return atomic_load(&s_lastActivityNS) + s_idleNS;
+    }
+    return 0;
+}
+
+static void *backlightThread(void *args)
+{
+    (void)args;
+
+    pthread_mutex_lock(&s_lock);
+    while (isRunning) {
+        s_isChanged = false;
+
+        long long nowNS = Timing_getTimeNS();
+        updateAutoDim(nowNS);
+        int level = levelAt(nowNS);
+        long long wakeNS = nextWakeNS(nowNS);
+
+        // Only this thread sets the brightness, so it needn't hold
+        // the lock for the (sysfs or lgpio) write.
+        pthread_mutex_unlock(&s_lock);
+        DEV_SetBacklight(level);
+        pthread_mutex_lock(&s_lock);
+
+        while (isRunning && !s_isChanged) {
+            if (wakeNS == 0) {
+                pthread_cond_wait(&s_changed, &s_lock);
+                continue;
+            }
+            struct timespec deadline = {
+                wakeNS / TIMING_NS_PER_SECOND,
+                wakeNS % TIMING_NS_PER_SECOND
+            };
+            if (pthread_cond_timedwait(&s_changed, &s_lock, &deadline) != 0) {
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+
+    return NULL;
+}
+
+// Wake the thread to act on a change; call with the lock held.
+static void signalChange(void)
+{
+    s_isChanged = true;
+    pthread_cond_signal(&s_changed);
+}
+
+void Backlight_init(void)
+{
+    assert(!isInitialized);
+
+    // Timing_getTimeNS() is CLOCK_MONOTONIC, so the waits must be too.
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&s_changed, &attr);
+    pthread_condattr_destroy(&attr);
+
+    long long nowNS = Timing_getTimeNS();
+    s_activeLevel = BACKLIGHT_MAX;
+    s_dimLevel = BACKLIGHT_MAX;
+    s_idleNS = 0;
+    s_isDimmed = false;
+    s_level = 0;
+    s_isChanged = false;
+    atomic_store(&s_lastActivityNS, nowNS);
+    atomic_store(&s_isWakeNeeded, false);
+    startFade(s_activeLevel, FADE_IN_MS, nowNS);
+
+    isInitialized = true;
+    isRunning = true;
+    int err = pthread_create(&backlightThreadID, NULL, backlightThread, NULL);
+    if (err) {
+        perror("Backlight: failed to create thread");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void Backlight_cleanup(void)
+{
+    assert(isInitialized);
+
+    pthread_mutex_lock(&s_lock);
+    isRunning = false;
+    signalChange();
+    pthread_mutex_unlock(&s_lock);
+
+    int err = pthread_join(backlightThreadID, NULL);
+    if (err) {
+        perror("Backlight: failed to join thread");
+        exit(EXIT_FAILURE);
+    }
+    pthread_cond_destroy(&s_changed);
+
+    DEV_SetBacklight(0);
+    isInitialized = false;
+}
+
+void Backlight_fadeTo(int level, int durationMS)
+{
+    assert(isInitialized);
+
+    pthread_mutex_lock(&s_lock);
+    s_activeLevel = clampLevel(level);
+    // While dimmed, the new level is faded to on waking.
+    if (!s_isDimmed) {
+        startFade(s_activeLevel, durationMS, Timing_getTimeNS());
+    }
+    signalChange();
+    pthread_mutex_unlock(&s_lock);
+}
+
+void Backlight_setAutoDim(int dimLevel, long long idleMS)
+{
+    assert(isInitialized);
+
+    pthread_mutex_lock(&s_lock);
+    s_dimLevel = clampLevel(dimLevel);
+    s_idleNS = idleMS > 0 ? idleMS * TIMING_NS_PER_MS : 0;
+    // The idle time counts from now.
+    atomic_store(&s_lastActivityNS, Timing_getTimeNS());
+    signalChange();
+    pthread_mutex_unlock(&s_lock);
+}
+
+void Backlight_poke(void)
+{
+    atomic_store(&s_lastActivityNS, Timing_getTimeNS());
+
+    // Only the first poke after dimming takes the lock.
+    if (atomic_exchange(&s_isWakeNeeded, false)) {
+        pthread_mutex_lock(&s_lock);
+        signalChange();
+        pthread_mutex_unlock(&s_lock);
+    }
+}
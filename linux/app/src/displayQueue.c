@@ -0,0 +1,292 @@
+// Queue of frames for the LCD, transmitted by a worker thread.
+
+#include "displayQueue.h"
+#include "LCD_1in54.h"
+#include "common/periodTimer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <pthread.h>
+
+// One buffer being drawn, one waiting and one being sent.
+#define NUM_BUFFERS 3
+#define NO_BUFFER (-1)
+#define FRAME_BYTES (LCD_1IN54_WIDTH * LCD_1IN54_HEIGHT * sizeof(uint16_t))
+
+static bool isInitialized = false;
+static bool isRunning = false;
+static pthread_t workerThreadID;
+
+static uint16_t *s_buffers[NUM_BUFFERS];
+
+// All below are guarded by s_lock.
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_changed = PTHREAD_COND_INITIALIZER;
+static int s_drawing = NO_BUFFER;
+static int s_pending = NO_BUFFER;
+static int s_sending = NO_BUFFER;
+static int s_latest = NO_BUFFER;
+static int s_catchingUp = NO_BUFFER;
+static DisplayQueue_region_t s_dirty[DISPLAY_QUEUE_MAX_REGIONS];
+static int s_numDirty = 0;
+static long long s_sampleNS = 0;
+static DisplayQueue_stats_t s_stats;
+static DisplayQueue_sentFn s_sentFn = NULL;
+
+static long long areaOf(DisplayQueue_region_t region)
+{
+    return (long long)(region.xEnd - region.xStart) * (region.yEnd - region.yStart);
+}
+
+static DisplayQueue_region_t unionOf(DisplayQueue_region_t a, DisplayQueue_region_t b)
+{
+    if (b.xStart < a.xStart) a.xStart = b.xStart;
+    if (b.yStart < a.yStart) a.yStart = b.yStart;
+    if (b.xEnd > a.xEnd) a.xEnd = b.xEnd;
+    if (b.yEnd > a.yEnd) a.yEnd = b.yEnd;
+    return a;
+}
+
+static bool overlaps(DisplayQueue_region_t a, DisplayQueue_region_t b)
+{
+    return a.xStart < b.xEnd && b.xStart < a.xEnd
+        && a.yStart < b.yEnd && b.yStart < a.yEnd;
+}
+
+// Overlapping regions are merged, so no pixel is sent twice; when there
+// are too many, the region is merged with the one it grows the least.
+static void addToDirty(DisplayQueue_region_t region)
+{
+    for (int i = 0; i < s_numDirty; i++) {
+        if (overlaps(s_dirty[i], region)) {
+            region = unionOf(s_dirty[i], region);
+            s_dirty[i] = s_dirty[--s_numDirty];
+            i = -1;
+        }
+    }
+
+    if (s_numDirty < DISPLAY_QUEUE_MAX_REGIONS) {
+        s_dirty[s_numDirty++] = region;
+        return;
+    }
+
+    int best = 0;
+    long long bestGrowth = -1;
+    for (int i = 0; i < s_numDirty; i++) {
+        long long growth = areaOf(unionOf(s_dirty[i], region)) - areaOf(s_dirty[i]);
+        if (bestGrowth < 0 || growth < bestGrowth) {
+            best = i;
+            bestGrowth = growth;
+        }
+    }
+    s_dirty[best] = unionOf(s_dirty[best], region);
+}
+
+static void *workerThread(void *args)
+{
+    (void)args;
+
+    pthread_mutex_lock(&s_lock);
+    while (true) {
+        while (isRunning && s_pending == NO_BUFFER) {
+            pthread_cond_wait(&s_changed, &s_lock);
+        }
+        // Flush what is queued before stopping.
+        if (s_pending == NO_BUFFER) {
+            break;
+        }
+
+        s_sending = s_pending;
+        s_pending = NO_BUFFER;
+        DisplayQueue_region_t regions[DISPLAY_QUEUE_MAX_REGIONS];
+        int numRegions = s_numDirty;
+        memcpy(regions, s_dirty, sizeof(regions[0]) * numRegions);
+        s_numDirty = 0;
+        long long sampleNS = s_sampleNS;
+        s_sampleNS = 0;
+        DisplayQueue_sentFn sentFn = s_sentFn;
+        pthread_cond_broadcast(&s_changed);
+        pthread_mutex_unlock(&s_lock);
+
+        for (int i = 0; i < numRegions; i++) {
+            LCD_1IN54_DisplayWindows(regions[i].xStart, regions[i].yStart,
+                regions[i].xEnd, regions[i].yEnd, s_buffers[s_sending]);
+        }
+        Period_markEvent(PERIOD_EVENT_LCD_FRAME);
+        if (sampleNS != 0) {
+            Period_markInterval(PERIOD_EVENT_LCD_LATENCY, sampleNS);
+        }
+        // Still ours: the renderer never draws into the buffer being sent.
+        if (sentFn != NULL) {
+            sentFn(s_buffers[s_sending]);
+        }
+
+        pthread_mutex_lock(&s_lock);
+        s_sending = NO_BUFFER;
+        s_stats.numSent++;
+    }
+    pthread_mutex_unlock(&s_lock);
+
+    return NULL;
+}
+
+void DisplayQueue_init(void)
+{
+    assert(!isInitialized);
+
+    for (int i = 0; i < NUM_BUFFERS; i++) {
+        s_buffers[i] = calloc(1, FRAME_BYTES);
+        if (s_buffers[i] == NULL) {
+            perror("Display queue: failed to allocate frame buffer");
+            exit(EXIT_FAILURE);
+        }
+    }
+    s_drawing = s_pending = s_sending = s_latest = s_catchingUp = NO_BUFFER;
+    s_numDirty = 0;
+    s_sampleNS = 0;
+    memset(&s_stats, 0, sizeof(s_stats));
+
+    isInitialized = true;
+    isRunning = true;
+
+    int err = pthread_create(&workerThreadID, NULL, &workerThread, NULL);
+    if (err) {
+        printf("Display queue: failed to create worker thread.\n");
+        perror("Error is:");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void DisplayQueue_cleanup(void)
+{
+    assert(isInitialized);
+
+    pthread_mutex_lock(&s_lock);
+    isRunning = false;
+    pthread_cond_broadcast(&s_changed);
+    pthread_mutex_unlock(&s_lock);
+
+    int err = pthread_join(workerThreadID, NULL);
+    if (err) {
+        perror("Display queue: failed to join worker thread:");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("Display queue: %lld frames submitted, %lld sent, %lld dropped\n",
+        s_stats.numSubmitted, s_stats.numSent, s_stats.numDropped);
+
+    for (int i = 0; i < NUM_BUFFERS; i++) {
+        free(s_buffers[i]);
+        s_buffers[i] = NULL;
+    }
+    isInitialized = false;
+}
+
+uint16_t *DisplayQueue_getBuffer(void)
+{
+    assert(isInitialized);
+
+    pthread_mutex_lock(&s_lock);
+    if (s_drawing == NO_BUFFER) {
+        // With one buffer waiting and one being sent, one is free unless
+        // the sent hook is catching up on the third.
+        while (true) {
+            for (int i = 0; i < NUM_BUFFERS; i++) {
+                if (i != s_pending && i != s_sending && i != s_catchingUp) {
+                    s_drawing = i;
+                    break;
+                }
+            }
+            if (s_drawing != NO_BUFFER) {
+                break;
+            }
+            pthread_cond_wait(&s_changed, &s_lock);
+        }
+
+        // The worker only reads s_latest, and only we replace it.
+        if (s_latest != NO_BUFFER && s_latest != s_drawing) {
+            memcpy(s_buffers[s_drawing], s_buffers[s_latest], FRAME_BYTES);
+        }
+    }
+    uint16_t *pBuffer = s_buffers[s_drawing];
+    pthread_mutex_unlock(&s_lock);
+
+    return pBuffer;
+}
+
+void DisplayQueue_submit(const DisplayQueue_region_t *pRegions, int numRegions,
+    long long sampleNS)
+{
+    assert(isInitialized);
+    assert(numRegions > 0);
+    for (int i = 0; i < numRegions; i++) {
+        assert(pRegions[i].xStart < pRegions[i].xEnd && pRegions[i].xEnd <= LCD_1IN54_WIDTH);
+        assert(pRegions[i].yStart < pRegions[i].yEnd && pRegions[i].yEnd <= LCD_1IN54_HEIGHT);
+    }
+
+    pthread_mutex_lock(&s_lock);
+    assert(s_drawing != NO_BUFFER);
+
+    if (s_pending != NO_BUFFER) {
+        s_stats.numDropped++;
+    }
+    s_pending = s_drawing;
+    s_latest = s_drawing;
+    s_drawing = NO_BUFFER;
+    for (int i = 0; i < numRegions; i++) {
+        addToDirty(pRegions[i]);
+    }
+    // A dropped frame's input is shown by this one, or is older than it
+    if (sampleNS != 0) {
+        s_sampleNS = sampleNS;
+    }
+    s_stats.numSubmitted++;
+
+    pthread_cond_broadcast(&s_changed);
+    pthread_mutex_unlock(&s_lock);
+}
+
+void DisplayQueue_waitForFrame(void)
+{
+    assert(isInitialized);
+
+    pthread_mutex_lock(&s_lock);
+    while (s_pending != NO_BUFFER) {
+        pthread_cond_wait(&s_changed, &s_lock);
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+void DisplayQueue_getStats(DisplayQueue_stats_t *pStats)
+{
+    pthread_mutex_lock(&s_lock);
+    *pStats = s_stats;
+    pthread_mutex_unlock(&s_lock);
+}
+
+void DisplayQueue_setSentHook(DisplayQueue_sentFn sentFn)
+{
+    pthread_mutex_lock(&s_lock);
+    s_sentFn = sentFn;
+    // Catch up with the last frame submitted, unless it is being drawn
+    // into again (it will be sent after). Like the worker, the hook is
+    // called without the lock; the renderer leaves the buffer alone.
+    int catchUp = NO_BUFFER;
+    if (sentFn != NULL && s_latest != NO_BUFFER && s_latest != s_drawing
+        && s_catchingUp == NO_BUFFER) {
+        catchUp = s_catchingUp = s_latest;
+    }
+    pthread_mutex_unlock(&s_lock);
+
+    if (catchUp == NO_BUFFER) {
+        return;
+    }
+    sentFn(s_buffers[catchUp]);
+
+    pthread_mutex_lock(&s_lock);
+    s_catchingUp = NO_BUFFER;
+    pthread_cond_broadcast(&s_changed);
+    pthread_mutex_unlock(&s_lock);
+}
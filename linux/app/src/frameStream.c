@@ -0,0 +1,399 @@
+// Serve what the LCD shows to remote viewers over TCP.
+
+#include "frameStream.h"
+#include "displayQueue.h"
+#include "LCD_1in54.h"
+#include "common/timing.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#define WIDTH LCD_1IN54_WIDTH
+#define HEIGHT LCD_1IN54_HEIGHT
+#define TILE FRAME_STREAM_TILE_SIZE
+#define TILES_X ((WIDTH + TILE - 1) / TILE)
+#define TILES_Y ((HEIGHT + TILE - 1) / TILE)
+#define PIXEL_BYTES 2
+
+// A tile is only run-length encoded when that is smaller, so no update
+// is bigger than a keyframe of raw tiles.
+#define MAX_UPDATE_BYTES (FRAME_STREAM_UPDATE_HEADER_BYTES \
+    + TILES_X * TILES_Y * FRAME_STREAM_TILE_HEADER_BYTES \
+    + WIDTH * HEIGHT * PIXEL_BYTES)
+
+typedef struct {
+    int socket;             // -1 when the slot is free
+    bool needsKeyframe;
+    unsigned int frameSeq;  // s_frameSeq its last update was from
+
+    // What the viewer has been sent, and the update queued for it
+    uint16_t *pShadow;
+    uint8_t *pOut;
+    size_t outLen;
+    size_t outSent;
+
+    long long connectedNS;
+    long long numBytes;
+} viewer_t;
+
+static bool isInitialized = false;
+static bool isRunning = false;
+static pthread_t serverThreadID;
+static int s_listenSocket = -1;
+static viewer_t s_viewers[FRAME_STREAM_MAX_VIEWERS];
+
+// The newest frame sent to the LCD, copied by the display queue's
+// worker; guarded by s_captureLock.
+static pthread_mutex_t s_captureLock = PTHREAD_MUTEX_INITIALIZER;
+static uint16_t s_capture[WIDTH * HEIGHT];
+static unsigned int s_captureSeq = 0;
+
+// The server thread's copy of it, which updates are encoded from
+static uint16_t s_frame[WIDTH * HEIGHT];
+static unsigned int s_frameSeq = 0;
+
+static void onFrameSent(const uint16_t *pFrame)
+{
+    pthread_mutex_lock(&s_captureLock);
+    memcpy(s_capture, pFrame, sizeof(s_capture));
+    s_captureSeq++;
+    pthread_mutex_unlock(&s_captureLock);
+}
+
+static uint8_t *putU16(uint8_t *p, uint16_t value)
+{
+    p[0] = value >> 8;
+    p[1] = value & 0xFF;
+    return p + 2;
+}
+
+static int tileWidth(int tileX)
+{
+    int width = WIDTH - tileX * TILE;
+    return width < TILE ? width : TILE;
+}
+
+static int tileHeight(int tileY)
+{
+    int height = HEIGHT - tileY * TILE;
+    return height < TILE ? height : TILE;
+}
+
+static bool isTileSame(const uint16_t *pA, const uint16_t *pB, int tileX, int tileY)
+{
+    int offset = tileY * TILE * WIDTH + tileX * TILE;
+    for (int y = 0; y < tileHeight(tileY); y++) {
+        if (memcmp(pA + offset, pB + offset, tileWidth(tileX) * PIXEL_BYTES) != 0) {
+            return false;
+        }
+        offset += WIDTH;
+    }
+    return true;
+}
+
+static void copyTile(uint16_t *pDest, const uint16_t *pSrc, int tileX, int tileY)
+{
+    int offset = tileY * TILE * WIDTH + tileX * TILE;
+    for (int y = 0; y < tileHeight(tileY); y++) {
+        memcpy(pDest + offset, pSrc + offset, tileWidth(tileX) * PIXEL_BYTES);
+        offset += WIDTH;
+    }
+}
+
+// Encode a tile of s_frame at p, as runs if that is smaller than its
+// pixels. Pixels go as they are in the frame: RGB565, high byte first.
+static uint8_t *encodeTile(uint8_t *p, int tileX, int tileY)
+{
+    int width = tileWidth(tileX);
+    int height = tileHeight(tileY);
+    int rawBytes = width * height * PIXEL_BYTES;
+    const uint16_t *pTile = s_frame + tileY * TILE * WIDTH + tileX * TILE;
+
+    uint8_t *pHeader = p;
+    pHeader[0] = tileX;
+    pHeader[1] = tileY;
+    p += FRAME_STREAM_TILE_HEADER_BYTES;
+
+    uint8_t *pRuns = p;
+    int numRuns = 0;
+    int runLength = 0;
+    uint16_t runPixel = 0;
+    for (int y = 0; y < height && numRuns >= 0; y++) {
+        for (int x = 0; x < width; x++) {
+            uint16_t pixel = pTile[y * WIDTH + x];
+            if (runLength > 0 && pixel == runPixel && runLength < FRAME_STREAM_MAX_RUN) {
+                runLength++;
+                continue;
+            }
+            if (runLength > 0) {
+                // The run in hand, and the one starting, must still be
+                // smaller than the raw pixels.
+                if ((numRuns + 2) * FRAME_STREAM_RUN_BYTES >= rawBytes) {
+                    numRuns = -1;
+                    break;
+                }
+                *p++ = runLength - 1;
+                memcpy(p, &runPixel, PIXEL_BYTES);
+                p += PIXEL_BYTES;
+                numRuns++;
+            }
+            runPixel = pixel;
+            runLength = 1;
+        }
+    }
+
+    if (numRuns < 0) {
+        p = pRuns;
+        for (int y = 0; y < height; y++) {
+            memcpy(p, pTile + y * WIDTH, width * PIXEL_BYTES);
+            p += width * PIXEL_BYTES;
+        }
+        putU16(pHeader + 2, 0);
+        return p;
+    }
+
+    *p++ = runLength - 1;
+    memcpy(p, &runPixel, PIXEL_BYTES);
+    p += PIXEL_BYTES;
+    putU16(pHeader + 2, numRuns + 1);
+    return p;
+}
+
+// Queue the tiles which differ from what the viewer has; every tile
+// for a keyframe.
+static void encodeUpdate(viewer_t *pViewer)
+{
+    bool isKeyframe = pViewer->needsKeyframe;
+    uint8_t *p = pViewer->pOut + FRAME_STREAM_UPDATE_HEADER_BYTES;
+    int numTiles = 0;
+
+    for (int tileY = 0; tileY < TILES_Y; tileY++) {
+        for (int tileX = 0; tileX < TILES_X; tileX++) {
+            if (!isKeyframe && isTileSame(s_frame, pViewer->pShadow, tileX, tileY)) {
+                continue;
+            }
+            p = encodeTile(p, tileX, tileY);
+            copyTile(pViewer->pShadow, s_frame, tileX, tileY);
+            numTiles++;
+        }
+    }
+    pViewer->frameSeq = s_frameSeq;
+    if (numTiles == 0) {
+        return;
+    }
+
+    uint8_t *pHeader = pViewer->pOut;
+    pHeader[0] = isKeyframe ? FRAME_STREAM_KEYFRAME : FRAME_STREAM_DELTA;
+    pHeader = putU16(pHeader + 1, WIDTH);
+    pHeader = putU16(pHeader, HEIGHT);
+    putU16(pHeader, numTiles);
+
+    pViewer->outLen = p - pViewer->pOut;
+    pViewer->outSent = 0;
+    pViewer->needsKeyframe = false;
+}
+
+static void closeViewer(viewer_t *pViewer)
+{
+    double seconds = (Timing_getTimeNS() - pViewer->connectedNS) / (double)TIMING_NS_PER_SECOND;
+    printf("Frame stream: viewer left after %.1fs, %lld bytes (%.2f KB/s)\n",
+        seconds, pViewer->numBytes,
+        seconds > 0 ? pViewer->numBytes / 1024.0 / seconds : 0.0);
+
+    close(pViewer->socket);
+    pViewer->socket = -1;
+}
+
+// Send what the socket will take without blocking.
+static void flushViewer(viewer_t *pViewer)
+{
+    while (pViewer->outSent < pViewer->outLen) {
+        ssize_t sent = send(pViewer->socket, pViewer->pOut + pViewer->outSent,
+            pViewer->outLen - pViewer->outSent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        if (sent <= 0) {
+            closeViewer(pViewer);
+            return;
+        }
+        pViewer->outSent += sent;
+        pViewer->numBytes += sent;
+    }
+}
+
+// Viewers have nothing to say; reading just notices when they leave.
+static void checkViewerOpen(viewer_t *pViewer)
+{
+    char discard[64];
+    ssize_t got;
+    while ((got = recv(pViewer->socket, discard, sizeof(discard), MSG_DONTWAIT)) > 0) {
+    }
+    if (got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        closeViewer(pViewer);
+    }
+}
+
+static void acceptViewers(void)
+{
+    while (true) {
+        int viewerSocket = accept(s_listenSocket, NULL, NULL);
+        if (viewerSocket < 0) {
+            return;
+        }
+        fcntl(viewerSocket, F_SETFL, fcntl(viewerSocket, F_GETFL) | O_NONBLOCK);
+        fcntl(viewerSocket, F_SETFD, FD_CLOEXEC);
+
+        viewer_t *pViewer = NULL;
+        for (int i = 0; i < FRAME_STREAM_MAX_VIEWERS; i++) {
+            if (s_viewers[i].socket < 0) {
+                pViewer = &s_viewers[i];
+                break;
+            }
+        }
+        if (pViewer == NULL) {
+            printf("Frame stream: refused a viewer; %d already watching\n",
+                FRAME_STREAM_MAX_VIEWERS);
+            close(viewerSocket);
+            continue;
+        }
+
+        // Kept for the next viewer in the slot
+        if (pViewer->pShadow == NULL) {
+            pViewer->pShadow = malloc(sizeof(s_frame));
+            pViewer->pOut = malloc(MAX_UPDATE_BYTES);
+            if (pViewer->pShadow == NULL || pViewer->pOut == NULL) {
+                perror("Frame stream: failed to allocate viewer");
+                exit(EXIT_FAILURE);
+            }
+        }
+        pViewer->socket = viewerSocket;
+        pViewer->needsKeyframe = true;
+        pViewer->outLen = 0;
+        pViewer->outSent = 0;
+        pViewer->connectedNS = Timing_getTimeNS();
+        pViewer->numBytes = 0;
+        printf("Frame stream: viewer connected\n");
+    }
+}
+
+static void *serverThread(void *args)
+{
+    (void)args;
+
+    Timing_deadline_t deadline;
+    Timing_deadlineStart(&deadline, TIMING_NS_PER_SECOND / FRAME_STREAM_MAX_FPS);
+
+    while (isRunning) {
+        Timing_deadlineWait(&deadline);
+        acceptViewers();
+
+        pthread_mutex_lock(&s_captureLock);
+        if (s_captureSeq != s_frameSeq) {
+            memcpy(s_frame, s_capture, sizeof(s_frame));
+            s_frameSeq = s_captureSeq;
+        }
+        pthread_mutex_unlock(&s_captureLock);
+
+        for (int i = 0; i < FRAME_STREAM_MAX_VIEWERS; i++) {
+            viewer_t *pViewer = &s_viewers[i];
+            if (pViewer->socket < 0) {
+                continue;
+            }
+            checkViewerOpen(pViewer);
+            if (pViewer->socket < 0) {
+                continue;
+            }
+
+            // A viewer still taking its last update gets the changes
+            // since in its next one.
+            bool isIdle = pViewer->outSent == pViewer->outLen;
+            if (isIdle && (pViewer->frameSeq != s_frameSeq || pViewer->needsKeyframe)) {
+                encodeUpdate(pViewer);
+            }
+            flushViewer(pViewer);
+        }
+    }
+
+    return NULL;
+}
+
+void FrameStream_init(void)
+{
+    assert(!isInitialized);
+
+    for (int i = 0; i < FRAME_STREAM_MAX_VIEWERS; i++) {
+        s_viewers[i].socket = -1;
+    }
+
+    s_listenSocket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (s_listenSocket < 0) {
+        perror("Frame stream: failed to create socket");
+        exit(EXIT_FAILURE);
+    }
+    int reuse = 1;
+    setsockopt(s_listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in address = {0};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(FRAME_STREAM_PORT);
+    if (bind(s_listenSocket, (struct sockaddr *)&address, sizeof(address)) < 0
+            || listen(s_listenSocket, FRAME_STREAM_MAX_VIEWERS) < 0) {
+        perror("Frame stream: failed to listen");
+        exit(EXIT_FAILURE);
+    }
+
+    // Takes the frame already on the screen, if any.
+    DisplayQueue_setSentHook(onFrameSent);
+
+    isInitialized = true;
+    isRunning = true;
+    int err = pthread_create(&serverThreadID, NULL, serverThread, NULL);
+    if (err) {
+        perror("Frame stream: failed to create thread");
+        exit(EXIT_FAILURE);
+    }
+    printf("Frame stream: serving on port %d\n", FRAME_STREAM_PORT);
+}
+
+void FrameStream_cleanup(void)
+{
+    assert(isInitialized);
+
+    // A copy under way finishes into s_capture, which stays valid.
+    DisplayQueue_setSentHook(NULL);
+
+    // Sees isRunning within a frame period
+    isRunning = false;
+    int err = pthread_join(serverThreadID, NULL);
+    if (err) {
+        perror("Frame stream: failed to join thread");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < FRAME_STREAM_MAX_VIEWERS; i++) {
+        if (s_viewers[i].socket >= 0) {
+            closeViewer(&s_viewers[i]);
+        }
+        free(s_viewers[i].pShadow);
+        free(s_viewers[i].pOut);
+        s_viewers[i].pShadow = NULL;
+        s_viewers[i].pOut = NULL;
+    }
+    close(s_listenSocket);
+    s_listenSocket = -1;
+    isInitialized = false;
+}
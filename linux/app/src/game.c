@@ -21,7 +21,7 @@
 #define BREAKPOINT_4 0.4
 #define BREAKPOINT_3 0.3
 #define BREAKPOINT_2 0.2
-#define BREAKPOINT_1 0.1
+#define BREAKPOINT_1 GAME_TARGET_RADIUS
 
 // LED indexes (0 - 7 = moving up)
 #define LED_0 0
@@ -185,12 +185,15 @@ static void newTarget() {
 static void playAnimation(uint32_t animation[][NEO_NUM_LEDS])
 {
     isPlayingAnimation = true;
+    Timing_deadline_t frameDeadline;
+    Timing_deadlineStart(&frameDeadline,
+        ANIMATION_PLAY_TIME_MS / ANIMATION_FRAMES * TIMING_NS_PER_MS);
     for (int frame = 0; frame < ANIMATION_FRAMES; frame++) {
         for (int led = 0; led < NEO_NUM_LEDS; led++) {
             Neopixel_setLED(led, animation[frame][led]);
         }
 
-        Timing_sleepForMS(ANIMATION_PLAY_TIME_MS / ANIMATION_FRAMES);
+        Timing_deadlineWait(&frameDeadline);
     }
     isPlayingAnimation = false;
 }
@@ -281,6 +284,9 @@ static void* gameThread(void* _args)
     // Set random point as target
     newTarget();
 
+    Timing_deadline_t loopDeadline;
+    Timing_deadlineStart(&loopDeadline, LOOP_DELAY_MS * TIMING_NS_PER_MS);
+
     while (isRunning) {
         assert(curr >= (LED_0 - 1));
         assert(curr <= NEO_NUM_LEDS);
@@ -336,6 +342,7 @@ static void* gameThread(void* _args)
 
             playAnimation(hitAnimation);
             newTarget();
+            Timing_deadlineStart(&loopDeadline, LOOP_DELAY_MS * TIMING_NS_PER_MS);
         }
         // Off target and fired (IMPLEMENT LED MISS EFFECT)
         else if (!onTarget && currentRotaryCounter != prevRotaryCounter) {
@@ -343,11 +350,14 @@ static void* gameThread(void* _args)
             misses += 1;
 
             playAnimation(missAnimation);
+            Timing_deadlineStart(&loopDeadline, LOOP_DELAY_MS * TIMING_NS_PER_MS);
         }
 
         prevRotaryCounter = currentRotaryCounter;
 
-        Timing_sleepForMS(LOOP_DELAY_MS);
+        // Sleep to the deadline so the loop keeps its period however
+        // long this iteration took (an animation restarts the period).
+        Timing_deadlineWait(&loopDeadline);
         long long currentTimeMS = Timing_getTimeMS(); // + account for sleep
         elapsedTimeMS += currentTimeMS - startTimeMS;
     }
@@ -408,3 +418,11 @@ long long Game_getElapsedTimeMS(void)
 
     return elapsedTimeMS;
 }
+
+// get where the player must aim
+coordinates Game_getTarget(void)
+{
+    assert(isInitialized);
+
+    return Target;
+}
@@ -10,13 +10,19 @@
 #include <signal.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <math.h>
 #include <pthread.h>
 #include <unistd.h> 
 #include "game.h"
+#include "displayQueue.h"
+#include "widget.h"
+#include "aimView.h"
+#include "backlight.h"
+#include "common/timing.h"
+#include "common/periodTimer.h"
 #include "hal/joystickBtn.h"
 #include "hal/accelerometer.h"
 
-static UWORD *s_fb;
 static bool isInitialized = false;
 static bool isRunning = false;
 
@@ -25,119 +31,236 @@ static pthread_t lcdThread;
 #define MS_PER_S 1000
 #define US_PER_S 1000000
 #define S_PER_MIN 60
-#define LCD_DEV_DELAY_MS 2000
-#define LCD_BACKLIGHT_LEVEL 1023
+// The panel's power-up wait, counted from the start of DrawStuff_init()
+// so that opening the devices and drawing the first frame come off it.
+#define LCD_POWER_UP_MS 2000
 #define LCD_LINE_HEIGHT 20
 #define LCD_VOL_POS_X 10
 #define LCD_VOL_POS_Y_OFFSET 30
 #define LCD_BPM_POS_X_OFFSET 110
 #define LCD_BPM_POS_Y_OFFSET 30
-#define BUFF_MAX_LEN 30
+
+// How often the game is checked for changes; the screen is only
+// redrawn when something shown has changed.
+#define LCD_UPDATE_HZ 60
+// From the accelerometer sample to the frame showing it being sent:
+// two updates.
+#define LCD_LATENCY_BUDGET_MS (2 * MS_PER_S / LCD_UPDATE_HZ)
+
+// Dim the backlight when nobody has fired or tilted the board by more
+// than LCD_ACTIVITY_TILT (in g) for a while.
+#define LCD_IDLE_MS (30 * MS_PER_S)
+#define LCD_DIM_LEVEL (BACKLIGHT_MAX / 8)
+#define LCD_ACTIVITY_TILT 0.05
 
 static void* lcdThreadProgram (void* arg) {
 
     (void)arg;
 
-    while (isRunning) {
+    Timing_deadline_t updateDeadline;
+    Timing_deadlineStart(&updateDeadline, TIMING_NS_PER_SECOND / LCD_UPDATE_HZ);
 
-        int elapsedTimeMS = Game_getElapsedTimeMS();
-        int total_seconds = elapsedTimeMS / MS_PER_S;
-        int minutes = total_seconds / S_PER_MIN;
-        int seconds = total_seconds % S_PER_MIN;
+    int lastShots = 0;
+    coordinates lastAim = {0, 0};
 
-        char hits[BUFF_MAX_LEN];
-        char misses[BUFF_MAX_LEN];
-        char elapsedTimeStr[BUFF_MAX_LEN];
+    while (isRunning) {
+        Timing_deadlineWait(&updateDeadline);
 
-        snprintf(hits, BUFF_MAX_LEN, "Hits = %d", Game_getHits());
-        snprintf(misses, BUFF_MAX_LEN, "Misses = %d", Game_getMisses());
-        snprintf(elapsedTimeStr, BUFF_MAX_LEN, "%02d:%02d", minutes, seconds);
+        // The newest reading, straight from the accelerometer rather
+        // than through the game, so the crosshair lags it least.
+        accel_snapshot_t aim = Accel_getSnapshot();
+        int hits = Game_getHits();
+        int misses = Game_getMisses();
 
-        DrawStuff_updateScreen_main(hits, misses, elapsedTimeStr);
+        // Noise moves the crosshair a little; only a real tilt counts.
+        if (hits + misses != lastShots
+                || fabs(aim.coords.x - lastAim.x) > LCD_ACTIVITY_TILT
+                || fabs(aim.coords.y - lastAim.y) > LCD_ACTIVITY_TILT) {
+            Backlight_poke();
+            lastShots = hits + misses;
+            lastAim = aim.coords;
+        }
 
+        DrawStuff_updateScreen_main(hits, misses,
+            Game_getElapsedTimeMS(), &aim, Game_getTarget());
     }
 
     return NULL;
 }
 
+// The main screen; each widget only redraws when what it shows changes.
+static Widget_t s_hitsCounter;
+static Widget_t s_missesCounter;
+static Widget_t s_timeLabel;
+static Widget_t *s_mainWidgets[] = {&s_hitsCounter, &s_missesCounter, &s_timeLabel};
+#define NUM_MAIN_WIDGETS (sizeof(s_mainWidgets) / sizeof(s_mainWidgets[0]))
+
+static void setMainWidgets(int hits, int misses, long long elapsedTimeMS);
+static void drawMain(UWORD *pFrame, Widget_rect_t *pDirty);
+static void printLatency(void);
+
+// Bring up the panel and show the first frame. The panel's init switches
+// the backlight fully on; Backlight_init() then takes it over and fades
+// it in from off. The screen isn't updated until DrawStuff_start().
 void DrawStuff_init()
 {
     assert(!isInitialized);
 
+    uint64_t powerUpDeadline = DEV_Deadline_ms(LCD_POWER_UP_MS);
+
     // Module Init
     if(DEV_ModuleInit() != 0){
         DEV_ModuleExit();
         exit(0);
     }
 
+    // Nothing is queued until the panel is up, so the worker leaves
+    // the bus to us until then.
+    DisplayQueue_init();
+    isInitialized = true;
+
+    // Draw the first frame while the panel powers up; it replaces the
+    // clear, so the screen is never blank.
+    UWORD *pFrame = DisplayQueue_getBuffer();
+    Paint_NewImage(pFrame, LCD_1IN54_WIDTH, LCD_1IN54_HEIGHT, 0, WHITE, 16);
+    Paint_Clear(WHITE);
+
+    // The stats go in a band above the aiming field.
+    const int x = 8;
+    const int y = 6;
+    Widget_initCounter(&s_hitsCounter, x, y, &Font16_Packed, BLACK, WHITE,
+        "Hits %d", 0);
+    Widget_initCounter(&s_missesCounter, x + 114, y, &Font16_Packed, BLACK, WHITE,
+        "Misses %d", 0);
+    Widget_initLabel(&s_timeLabel, x, y + 20, &Font16_Packed, BLACK, WHITE,
+        "00:00");
+
+    Widget_rect_t dirty = {0, 0, 0, 0};
+    drawMain(pFrame, &dirty);
+    DisplayQueue_region_t field;
+    AimView_drawField(&field);
+
     // LCD Init
-    DEV_Delay_ms(LCD_DEV_DELAY_MS);
+    DEV_Delay_Until(powerUpDeadline);
     LCD_1IN54_Init(HORIZONTAL);
-    LCD_1IN54_Clear(WHITE);
-    LCD_SetBacklight(LCD_BACKLIGHT_LEVEL);
+    DisplayQueue_region_t screen = {0, 0, LCD_1IN54_WIDTH, LCD_1IN54_HEIGHT};
+    DisplayQueue_submit(&screen, 1, 0);
+}
 
-    UDOUBLE Imagesize = LCD_1IN54_HEIGHT*LCD_1IN54_WIDTH*2;
-    if((s_fb = (UWORD *)malloc(Imagesize)) == NULL) {
-        perror("Failed to apply for black memory");
-        exit(0);
-    }
-    isInitialized = true;
+// Start updating the screen from the game; needs Game_init().
+void DrawStuff_start()
+{
+    assert(isInitialized);
     isRunning = true;
 
+    Backlight_setAutoDim(LCD_DIM_LEVEL, LCD_IDLE_MS);
+
     pthread_create(&lcdThread, NULL, lcdThreadProgram, NULL);
+}
 
+void DrawStuff_stop()
+{
+    assert(isInitialized);
+    isRunning = false;
 
+    // Not cancelled: it may be waiting on the display queue's lock.
+    // It sees isRunning within a frame.
+    int err = pthread_join(lcdThread, NULL);
+    if (err) {
+        perror("LCD: failed to join main thread:");
+        exit(EXIT_FAILURE);
+    }
+
+    printLatency();
 }
+
 void DrawStuff_cleanup()
 {
     
     assert(isInitialized);
-    isRunning = false;
+    assert(!isRunning);
+
+    // Send the last frame; the bus is ours again after.
+    DisplayQueue_cleanup();
 
     LCD_1IN54_Clear(BLACK); 
     LCD_SetBacklight(0);
 
-    int cancelErr = pthread_cancel(lcdThread);
-    
-    if (cancelErr) {
-        perror("LCD: failed to cancel main thread:");
-        exit(EXIT_FAILURE);
-    }
-
-    int err = pthread_join(lcdThread, NULL);
-    if (err) {
-        perror("LCD: failed to cancel main thread:");
-        exit(EXIT_FAILURE);
-    }
     // Module Exit
-    free(s_fb);
-    s_fb = NULL;
     DEV_ModuleExit();
 
     isInitialized = false;
 }
 
-void DrawStuff_updateScreen_main(char* hits, char* misses, char* timeElapsed)
+void DrawStuff_updateScreen_main(int hits, int misses, long long elapsedTimeMS,
+    const accel_snapshot_t *pAim, coordinates target)
 {
     assert(isInitialized);
 
-    const int x = 60;
-    const int y = 80;
+    setMainWidgets(hits, misses, elapsedTimeMS);
 
-    // Initialize the RAM frame buffer to be blank (white)
-    Paint_NewImage(s_fb, LCD_1IN54_WIDTH, LCD_1IN54_HEIGHT, 0, WHITE, 16);
-    Paint_Clear(WHITE);
+    // Same test as the game's
+    bool onTarget = fabs(pAim->coords.x - target.x) <= GAME_TARGET_RADIUS
+        && fabs(pAim->coords.y - target.y) <= GAME_TARGET_RADIUS;
+
+    // Draw the next frame while the last one is sent.
+    DisplayQueue_waitForFrame();
+    UWORD *pFrame = DisplayQueue_getBuffer();
+
+    Widget_rect_t dirty = {0, 0, 0, 0};
+    drawMain(pFrame, &dirty);
+
+    DisplayQueue_region_t regions[1 + AIM_VIEW_MAX_REGIONS];
+    int numRegions = 0;
+    if (dirty.xStart < dirty.xEnd) {
+        DisplayQueue_region_t stats = {dirty.xStart, dirty.yStart, dirty.xEnd, dirty.yEnd};
+        regions[numRegions++] = stats;
+    }
+    int numAimRegions = AimView_update(pAim->coords, target, onTarget, &regions[numRegions]);
+    numRegions += numAimRegions;
+
+    // Queue what changed for the LCD; the display queue's worker
+    // sends it while we draw the next. Only a frame which moved the
+    // crosshair or target counts towards the latency.
+    // If nothing visible changed, the buffer is kept for the next frame.
+    if (numRegions > 0) {
+        DisplayQueue_submit(regions, numRegions, numAimRegions > 0 ? pAim->sampleNS : 0);
+    }
+}
+
+static void setMainWidgets(int hits, int misses, long long elapsedTimeMS)
+{
+    long long totalSeconds = elapsedTimeMS / MS_PER_S;
+    char elapsedTimeStr[WIDGET_MAX_TEXT];
+    snprintf(elapsedTimeStr, WIDGET_MAX_TEXT, "%02lld:%02lld",
+        totalSeconds / S_PER_MIN, totalSeconds % S_PER_MIN);
+
+    Widget_setValue(&s_hitsCounter, hits);
+    Widget_setValue(&s_missesCounter, misses);
+    Widget_setText(&s_timeLabel, elapsedTimeStr);
+}
+
+// Draw the widgets which changed into the frame; the frame still holds
+// the rest from the last one submitted.
+static void drawMain(UWORD *pFrame, Widget_rect_t *pDirty)
+{
+    Paint_SelectImage(pFrame);
+    for (size_t i = 0; i < NUM_MAIN_WIDGETS; i++) {
+        Widget_draw(s_mainWidgets[i], pDirty);
+    }
+}
+
+// Sample-to-sent latency of the aiming view since the screen started.
+static void printLatency(void)
+{
+    Period_statistics_t stats;
+    Period_getStatisticsAndClear(PERIOD_EVENT_LCD_LATENCY, &stats);
+    Period_printStatistics("LCD latency", &stats);
+    if (stats.numSamples > 0 && stats.p99PeriodInMs > LCD_LATENCY_BUDGET_MS) {
+        printf("LCD: p99 latency %.3fms is over the %dms budget\n",
+            stats.p99PeriodInMs, LCD_LATENCY_BUDGET_MS);
+    }
 
-    // Draw into the RAM frame buffer
-    // WARNING: Don't print strings with `\n`; will crash!
-    Paint_DrawString_EN(x, y, hits, &Font20, WHITE, BLACK);
-    Paint_DrawString_EN(x, y + 30, misses, &Font20, WHITE, BLACK);
-    Paint_DrawString_EN(x, y + 60, timeElapsed, &Font20, WHITE, BLACK);
-
-    // Send the RAM frame buffer to the LCD (actually display it)
-    // Option 1) Full screen refresh (~1 update / second)
-    // LCD_1IN54_Display(s_fb);
-    // Option 2) Update just a small window (~15 updates / second)
-    //           Assume font height <= 20
-    LCD_1IN54_DisplayWindows(0, 0, LCD_1IN54_WIDTH, LCD_1IN54_HEIGHT, s_fb);
+    Period_getStatisticsAndClear(PERIOD_EVENT_LCD_FRAME, &stats);
+    Period_printStatistics("LCD frames", &stats);
 }
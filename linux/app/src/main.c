@@ -6,54 +6,78 @@
 #include <assert.h>
 
 #include "game.h"
+#include "common/lifecycle.h"
 #include "common/shutdown.h"
 #include "common/timing.h"
+#include "common/periodTimer.h"
 #include "hal/neopixelR5.h"
 #include "hal/accelerometer.h"
 #include "hal/gpio.h"
 #include "hal/rotaryEncoderBtn.h"
 #include "hal/joystickBtn.h"
 #include "lcd.h"
+#include "backlight.h"
+#include "frameStream.h"
+
+// Modules, in an order where each comes after those it depends on
+enum {
+    MODULE_NEOPIXEL,
+    MODULE_ACCEL,
+    MODULE_GPIO,
+    MODULE_ROTARY_ENCODER_BTN,
+    MODULE_JOYSTICK_BTN,
+    MODULE_LCD,
+    MODULE_BACKLIGHT,
+    MODULE_GAME,
+    MODULE_SCREEN,
+#ifdef APP_FRAME_STREAM
+    MODULE_FRAME_STREAM,
+#endif
+    NUM_MODULES
+};
+
+static const Lifecycle_module_t modules[NUM_MODULES] = {
+    [MODULE_NEOPIXEL] = {"neopixel", Neopixel_init, Neopixel_cleanup, 0},
+    [MODULE_ACCEL] = {"accel", Accel_init, Accel_cleanup, 0},
+    [MODULE_GPIO] = {"gpio", Gpio_initialize, Gpio_cleanup, 0},
+    [MODULE_ROTARY_ENCODER_BTN] = {"rotary encoder", RotaryEncoderBtn_init, RotaryEncoderBtn_cleanup,
+        LIFECYCLE_DEP(MODULE_GPIO)},
+    [MODULE_JOYSTICK_BTN] = {"joystick", JoystickBtn_init, JoystickBtn_cleanup,
+        LIFECYCLE_DEP(MODULE_GPIO)},
+    [MODULE_LCD] = {"lcd", DrawStuff_init, DrawStuff_cleanup, 0},
+    [MODULE_BACKLIGHT] = {"backlight", Backlight_init, Backlight_cleanup,
+        LIFECYCLE_DEP(MODULE_LCD)},
+    [MODULE_GAME] = {"game", Game_init, Game_cleanup,
+        LIFECYCLE_DEP(MODULE_NEOPIXEL) | LIFECYCLE_DEP(MODULE_ACCEL)
+        | LIFECYCLE_DEP(MODULE_ROTARY_ENCODER_BTN) | LIFECYCLE_DEP(MODULE_JOYSTICK_BTN)},
+    [MODULE_SCREEN] = {"screen", DrawStuff_start, DrawStuff_stop,
+        LIFECYCLE_DEP(MODULE_LCD) | LIFECYCLE_DEP(MODULE_BACKLIGHT)
+        | LIFECYCLE_DEP(MODULE_GAME)},
+#ifdef APP_FRAME_STREAM
+    [MODULE_FRAME_STREAM] = {"frame stream", FrameStream_init, FrameStream_cleanup,
+        LIFECYCLE_DEP(MODULE_LCD)},
+#endif
+};
 
 int main()
 {
     printf("Find dot!\n");
 
-    // Start modules
-    Neopixel_init();
-    Accel_init();
-    Gpio_initialize();
-    RotaryEncoderBtn_init();
-    JoystickBtn_init();
-
-    // Main app modules
+    // The game may trigger a shutdown as soon as it starts.
+    Timing_init();
+    Period_init();
     Shutdown_init();
-    Game_init();
-    DrawStuff_init();
+
+    // Start modules
+    Lifecycle_start(modules, NUM_MODULES);
 
     Shutdown_wait();
     // End main body
     printf("Shutting down...\n");
 
-    // End main app modules
-    DrawStuff_cleanup();
-    // printf("LCD off!\n");
-    Game_cleanup();
-    // printf("Game off!\n");
+    Lifecycle_stop(modules, NUM_MODULES);
     Shutdown_cleanup();
-    // printf("Shutdown off!\n");
-
-    // End hal modules
-    JoystickBtn_cleanup();
-    // printf("Joystick off!\n");
-    RotaryEncoderBtn_cleanup();
-    // printf("RotaryEncoder off!\n");
-    Gpio_cleanup();
-    // printf("GPIO off!\n");
-    Accel_cleanup();
-    // printf("Accel off!\n");
-    Neopixel_cleanup();
-    // printf("Neopixel off!\n");
+    Period_cleanup();
 
     printf("!!! DONE !!!\n"); 
 }
@@ -0,0 +1,227 @@
+// Retained widgets drawn with GUI_Paint.
+
+#include "widget.h"
+#include "GUI_Paint.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+static void initWidget(Widget_t *pWidget, Widget_kind_t kind, uint16_t x, uint16_t y,
+    uint16_t foreground, uint16_t background)
+{
+    memset(pWidget, 0, sizeof(*pWidget));
+    pWidget->kind = kind;
+    pWidget->x = x;
+    pWidget->y = y;
+    pWidget->foreground = foreground;
+    pWidget->background = background;
+    pWidget->isDirty = true;
+}
+
+void Widget_initLabel(Widget_t *pWidget, uint16_t x, uint16_t y, sFONT *pFont,
+    uint16_t foreground, uint16_t background, const char *text)
+{
+    initWidget(pWidget, WIDGET_LABEL, x, y, foreground, background);
+    pWidget->pFont = pFont;
+    snprintf(pWidget->text, WIDGET_MAX_TEXT, "%s", text);
+}
+
+void Widget_initCounter(Widget_t *pWidget, uint16_t x, uint16_t y, sFONT *pFont,
+    uint16_t foreground, uint16_t background, const char *format, int value)
+{
+    initWidget(pWidget, WIDGET_COUNTER, x, y, foreground, background);
+    pWidget->pFont = pFont;
+    snprintf(pWidget->text, WIDGET_MAX_TEXT, "%s", format);
+    pWidget->value = value;
+}
+
+void Widget_initProgress(Widget_t *pWidget, uint16_t x, uint16_t y, uint16_t width,
+    uint16_t height, uint16_t foreground, uint16_t background, int value, int max)
+{
+    assert(max > 0);
+    initWidget(pWidget, WIDGET_PROGRESS, x, y, foreground, background);
+    pWidget->width = width;
+    pWidget->height = height;
+    pWidget->value = value;
+    pWidget->max = max;
+}
+
+void Widget_initIcon(Widget_t *pWidget, uint16_t x, uint16_t y, uint16_t width,
+    uint16_t height, uint16_t background, const unsigned char *pImage)
+{
+    initWidget(pWidget, WIDGET_ICON, x, y, 0, background);
+    pWidget->width = width;
+    pWidget->height = height;
+    pWidget->pImage = pImage;
+}
+
+void Widget_setText(Widget_t *pWidget, const char *text)
+{
+    assert(pWidget->kind == WIDGET_LABEL);
+    if (strncmp(pWidget->text, text, WIDGET_MAX_TEXT - 1) != 0) {
+        snprintf(pWidget->text, WIDGET_MAX_TEXT, "%s", text);
+        pWidget->isDirty = true;
+    }
+}
+
+void Widget_setValue(Widget_t *pWidget, int value)
+{
+    assert(pWidget->kind == WIDGET_COUNTER || pWidget->kind == WIDGET_PROGRESS);
+    if (pWidget->value != value) {
+        pWidget->value = value;
+        pWidget->isDirty = true;
+    }
+}
+
+void Widget_setImage(Widget_t *pWidget, const unsigned char *pImage)
+{
+    assert(pWidget->kind == WIDGET_ICON);
+    if (pWidget->pImage != pImage) {
+        pWidget->pImage = pImage;
+        pWidget->isDirty = true;
+    }
+}
+
+void Widget_invalidate(Widget_t *pWidget)
+{
+    pWidget->isDrawn = false;
+    pWidget->isDirty = true;
+}
+
+bool Widget_isDirty(const Widget_t *pWidget)
+{
+    return pWidget->isDirty;
+}
+
+// Add [xStart, xEnd) x [yStart, yEnd), clipped to the image, to *pDirty.
+static void addToDirty(Widget_rect_t *pDirty, int xStart, int yStart, int xEnd, int yEnd)
+{
+    if (xEnd > Paint.Width) xEnd = Paint.Width;
+    if (yEnd > Paint.Height) yEnd = Paint.Height;
+    if (xStart >= xEnd || yStart >= yEnd) {
+        return;
+    }
+
+    if (pDirty->xStart >= pDirty->xEnd) {
+        *pDirty = (Widget_rect_t){xStart, yStart, xEnd, yEnd};
+        return;
+    }
+    if (xStart < pDirty->xStart) pDirty->xStart = xStart;
+    if (yStart < pDirty->yStart) pDirty->yStart = yStart;
+    if (xEnd > pDirty->xEnd) pDirty->xEnd = xEnd;
+    if (yEnd > pDirty->yEnd) pDirty->yEnd = yEnd;
+}
+
+// Draw the characters of text which differ from what is on the screen,
+// and clear those past its end. Text doesn't wrap.
+static bool drawText(Widget_t *pWidget, const char *text, Widget_rect_t *pDirty)
+{
+    sFONT *pFont = pWidget->pFont;
+    const char *drawn = pWidget->isDrawn ? pWidget->drawnText : "";
+    size_t newLen = strlen(text);
+    size_t oldLen = strlen(drawn);
+    size_t len = newLen > oldLen ? newLen : oldLen;
+
+    size_t first = len;
+    size_t end = 0;
+    for (size_t i = 0; i < len; i++) {
+        char newChar = i < newLen ? text[i] : '\0';
+        char oldChar = i < oldLen ? drawn[i] : '\0';
+        if (newChar == oldChar) {
+            continue;
+        }
+
+        int x = pWidget->x + (int)i * pFont->Width;
+        if (x >= Paint.Width) {
+            break;
+        }
+        // Paint_DrawChar() leaves the background alone when it is
+        // FONT_BACKGROUND, so the old character is cleared first.
+        int xEnd = x + pFont->Width < Paint.Width ? x + pFont->Width : Paint.Width;
+        Paint_ClearWindow(x, pWidget->y, xEnd, pWidget->y + pFont->Height,
+            pWidget->background);
+        if (newChar != '\0') {
+            Paint_DrawChar(x, pWidget->y, newChar, pFont,
+                pWidget->foreground, pWidget->background);
+        }
+        if (i < first) first = i;
+        end = i + 1;
+    }
+
+    snprintf(pWidget->drawnText, WIDGET_MAX_TEXT, "%s", text);
+    if (first >= end) {
+        return false;
+    }
+    addToDirty(pDirty, pWidget->x + (int)first * pFont->Width, pWidget->y,
+        pWidget->x + (int)end * pFont->Width, pWidget->y + pFont->Height);
+    return true;
+}
+
+// Fill or empty just the part of the bar between its old and new ends.
+static bool drawProgress(Widget_t *pWidget, Widget_rect_t *pDirty)
+{
+    int value = pWidget->value;
+    if (value < 0) value = 0;
+    if (value > pWidget->max) value = pWidget->max;
+    uint16_t fill = (uint16_t)((long long)pWidget->width * value / pWidget->max);
+
+    int xStart = pWidget->x;
+    int xEnd = pWidget->x + pWidget->width;
+    if (pWidget->isDrawn) {
+        if (fill == pWidget->drawnFill) {
+            return false;
+        }
+        xStart = pWidget->x + (fill < pWidget->drawnFill ? fill : pWidget->drawnFill);
+        xEnd = pWidget->x + (fill > pWidget->drawnFill ? fill : pWidget->drawnFill);
+    }
+    int yEnd = pWidget->y + pWidget->height;
+    int xFill = pWidget->x + fill;
+
+    Paint_ClearWindow(xStart, pWidget->y, xFill < xEnd ? xFill : xEnd, yEnd,
+        pWidget->foreground);
+    Paint_ClearWindow(xFill > xStart ? xFill : xStart, pWidget->y, xEnd, yEnd,
+        pWidget->background);
+
+    pWidget->drawnFill = fill;
+    addToDirty(pDirty, xStart, pWidget->y, xEnd, yEnd);
+    return true;
+}
+
+bool Widget_draw(Widget_t *pWidget, Widget_rect_t *pDirty)
+{
+    if (!pWidget->isDirty) {
+        return false;
+    }
+
+    bool isDrawn = false;
+    switch (pWidget->kind) {
+    case WIDGET_LABEL:
+        isDrawn = drawText(pWidget, pWidget->text, pDirty);
+        break;
+    case WIDGET_COUNTER: {
+        char text[WIDGET_MAX_TEXT];
+        snprintf(text, WIDGET_MAX_TEXT, pWidget->text, pWidget->value);
+        isDrawn = drawText(pWidget, text, pDirty);
+        break;
+    }
+    case WIDGET_PROGRESS:
+        isDrawn = drawProgress(pWidget, pDirty);
+        break;
+    case WIDGET_ICON:
+        if (pWidget->pImage != NULL) {
+            Paint_DrawImage(pWidget->pImage, pWidget->x, pWidget->y,
+                pWidget->width, pWidget->height);
+        } else {
+            Paint_ClearWindow(pWidget->x, pWidget->y, pWidget->x + pWidget->width,
+                pWidget->y + pWidget->height, pWidget->background);
+        }
+        addToDirty(pDirty, pWidget->x, pWidget->y,
+            pWidget->x + pWidget->width, pWidget->y + pWidget->height);
+        isDrawn = true;
+        break;
+    }
+
+    pWidget->isDrawn = true;
+    pWidget->isDirty = false;
+    return isDrawn;
+}
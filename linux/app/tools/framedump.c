@@ -0,0 +1,183 @@
+// Reference viewer for the frame stream (see frameStream.h): connects,
+// applies updates as they come, and writes the frame as a PPM.
+// Usage: framedump HOST [PORT] [UPDATES] [OUT.ppm]
+//   Takes UPDATES updates (1: just the keyframe), printing the size of
+//   each, then writes the frame to OUT.ppm (frame.ppm).
+// It needs nothing from the board, so also builds on the host:
+//   cc -Iapp/include -o framedump app/tools/framedump.c
+
+#include "frameStream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+
+static int s_socket = -1;
+
+static void readAll(void *pData, size_t len)
+{
+    uint8_t *p = pData;
+    while (len > 0) {
+        ssize_t got = recv(s_socket, p, len, 0);
+        if (got <= 0) {
+            fprintf(stderr, "framedump: stream ended\n");
+            exit(EXIT_FAILURE);
+        }
+        p += got;
+        len -= got;
+    }
+}
+
+static uint16_t getU16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+static int connectTo(const char *host, const char *port)
+{
+    struct addrinfo hints = {0};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo *pResults;
+    int err = getaddrinfo(host, port, &hints, &pResults);
+    if (err) {
+        fprintf(stderr, "framedump: %s: %s\n", host, gai_strerror(err));
+        exit(EXIT_FAILURE);
+    }
+
+    int fd = -1;
+    for (struct addrinfo *p = pResults; p != NULL && fd < 0; p = p->ai_next) {
+        fd = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
+        if (fd >= 0 && connect(fd, p->ai_addr, p->ai_addrlen) < 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(pResults);
+    if (fd < 0) {
+        perror("framedump: failed to connect");
+        exit(EXIT_FAILURE);
+    }
+    return fd;
+}
+
+// Read one tile into the frame (pixels kept as sent: RGB565, high byte
+// first); returns its size on the wire.
+static size_t readTile(uint8_t *pFrame, int width, int height)
+{
+    uint8_t header[FRAME_STREAM_TILE_HEADER_BYTES];
+    readAll(header, sizeof(header));
+    int x0 = header[0] * FRAME_STREAM_TILE_SIZE;
+    int y0 = header[1] * FRAME_STREAM_TILE_SIZE;
+    int numRuns = getU16(&header[2]);
+    if (x0 >= width || y0 >= height) {
+        fprintf(stderr, "framedump: tile (%d, %d) is off the frame\n", header[0], header[1]);
+        exit(EXIT_FAILURE);
+    }
+    int tileWidth = width - x0 < FRAME_STREAM_TILE_SIZE ? width - x0 : FRAME_STREAM_TILE_SIZE;
+    int tileHeight = height - y0 < FRAME_STREAM_TILE_SIZE ? height - y0 : FRAME_STREAM_TILE_SIZE;
+
+    if (numRuns == 0) {
+        for (int y = 0; y < tileHeight; y++) {
+            readAll(pFrame + ((y0 + y) * width + x0) * 2, tileWidth * 2);
+        }
+        return sizeof(header) + tileWidth * tileHeight * 2;
+    }
+
+    int x = 0;
+    int y = 0;
+    for (int i = 0; i < numRuns; i++) {
+        uint8_t run[FRAME_STREAM_RUN_BYTES];
+        readAll(run, sizeof(run));
+        for (int n = run[0] + 1; n > 0; n--) {
+            if (y >= tileHeight) {
+                fprintf(stderr, "framedump: run overflows its tile\n");
+                exit(EXIT_FAILURE);
+            }
+            memcpy(pFrame + ((y0 + y) * width + x0 + x) * 2, &run[1], 2);
+            if (++x == tileWidth) {
+                x = 0;
+                y++;
+            }
+        }
+    }
+    return sizeof(header) + numRuns * FRAME_STREAM_RUN_BYTES;
+}
+
+static void writePPM(const char *path, const uint8_t *pFrame, int width, int height)
+{
+    FILE *pFile = fopen(path, "wb");
+    if (pFile == NULL) {
+        perror("framedump: failed to open output");
+        exit(EXIT_FAILURE);
+    }
+    fprintf(pFile, "P6\n%d %d\n255\n", width, height);
+    for (int i = 0; i < width * height; i++) {
+        uint16_t pixel = getU16(&pFrame[i * 2]);
+        uint8_t r = (pixel >> 11) & 0x1F;
+        uint8_t g = (pixel >> 5) & 0x3F;
+        uint8_t b = pixel & 0x1F;
+        uint8_t rgb[3] = {
+            (uint8_t)(r << 3 | r >> 2),
+            (uint8_t)(g << 2 | g >> 4),
+            (uint8_t)(b << 3 | b >> 2)
+        };
+        fwrite(rgb, 1, sizeof(rgb), pFile);
+    }
+    fclose(pFile);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s HOST [PORT] [UPDATES] [OUT.ppm]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    char defaultPort[8];
+    snprintf(defaultPort, sizeof(defaultPort), "%d", FRAME_STREAM_PORT);
+    const char *port = argc > 2 ? argv[2] : defaultPort;
+    int numUpdates = argc > 3 ? atoi(argv[3]) : 1;
+    const char *outPath = argc > 4 ? argv[4] : "frame.ppm";
+
+    s_socket = connectTo(argv[1], port);
+
+    uint8_t *pFrame = NULL;
+    int width = 0;
+    int height = 0;
+    for (int update = 0; update < numUpdates; update++) {
+        uint8_t header[FRAME_STREAM_UPDATE_HEADER_BYTES];
+        readAll(header, sizeof(header));
+        int numTiles = getU16(&header[5]);
+        if (pFrame == NULL) {
+            if (header[0] != FRAME_STREAM_KEYFRAME) {
+                fprintf(stderr, "framedump: stream didn't start with a keyframe\n");
+                return EXIT_FAILURE;
+            }
+            width = getU16(&header[1]);
+            height = getU16(&header[3]);
+            pFrame = calloc((size_t)width * height, 2);
+            if (pFrame == NULL) {
+                perror("framedump: failed to allocate frame");
+                return EXIT_FAILURE;
+            }
+        }
+
+        size_t numBytes = sizeof(header);
+        for (int i = 0; i < numTiles; i++) {
+            numBytes += readTile(pFrame, width, height);
+        }
+        printf("%c %3d tiles %7zu bytes\n", header[0], numTiles, numBytes);
+    }
+
+    if (pFrame != NULL) {
+        writePPM(outPath, pFrame, width, height);
+        printf("Wrote %dx%d frame to %s\n", width, height, outPath);
+    }
+    free(pFrame);
+    close(s_socket);
+    return EXIT_SUCCESS;
+}
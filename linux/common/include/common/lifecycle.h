@@ -0,0 +1,33 @@
+// Module to start and stop the application's modules in dependency order.
+// Usage:
+//  1. Build a table of Lifecycle_module_t; a module may only depend on
+//     modules earlier in the table.
+//  2. Call Lifecycle_start() to initialize them. Every module whose
+//     dependencies are initialized is started at once, each on its own
+//     thread, so slow hardware bring-up runs alongside the rest.
+//  3. Call Lifecycle_stop() to clean them up; a module is cleaned up
+//     only once every module which depends on it has been.
+// Both calls block until they are done, then print how long each
+// module took.
+
+#ifndef _LIFECYCLE_H_
+#define _LIFECYCLE_H_
+
+#define LIFECYCLE_MAX_MODULES 32
+
+// Bit for the module at `index`, to build Lifecycle_module_t.dependsOn
+#define LIFECYCLE_DEP(index) (1u << (index))
+
+typedef struct {
+    const char *name;
+    void (*init)(void);
+    void (*cleanup)(void);
+
+    // LIFECYCLE_DEP() of each module which must be initialized first
+    unsigned int dependsOn;
+} Lifecycle_module_t;
+
+void Lifecycle_start(const Lifecycle_module_t *pModules, int numModules);
+void Lifecycle_stop(const Lifecycle_module_t *pModules, int numModules);
+
+#endif
@@ -10,18 +10,25 @@
 //     occurrence of the event. For example, call this function
 //     each time you sample the A2D.
 //  3. Call getStatisticsAndClear() to get the statistics for
-//     an event of interest. Calling this will clear the 
+//     an event of interest. Calling this will clear the
 //     data collected for this event (but not others).
 //     For example, call this function once a second to get timing
 //     information to print to the screen.
-
-// Maximum number of timestamps to record for a given event.
-#define MAX_EVENT_TIMESTAMPS (1024*4)
+//
+// The period between two marks of an event by the same thread is
+// recorded into a histogram owned by that thread, so marking never
+// takes a lock and there is no limit on the number of marks between
+// calls to Period_getStatisticsAndClear(). A thread's histogram is
+// kept for the next call when the thread exits, then freed. The
+// histogram has log-spaced buckets which keep percentiles within
+// about 3%.
 
 enum Period_whichEvent {
     PERIOD_EVENT_SAMPLE_LIGHT,
     PERIOD_EVENT_PLAYBACK_BUFFER,
     PERIOD_EVENT_ACCEL,
+    PERIOD_EVENT_LCD_FRAME,     // Each frame sent by displayQueue.c
+    PERIOD_EVENT_LCD_LATENCY,   // Sample to sent, by Period_markInterval()
     NUM_PERIOD_EVENTS
 };
 
@@ -30,18 +37,33 @@ typedef struct {
     double minPeriodInMs;
     double maxPeriodInMs;
     double avgPeriodInMs;
+
+    // Percentiles of the period, from the histogram
+    double p50PeriodInMs;
+    double p90PeriodInMs;
+    double p99PeriodInMs;
+    double p999PeriodInMs;
+
+    // Standard deviation of the period
+    double jitterInMs;
 } Period_statistics_t;
 
 // Initialize/cleanup the module's data structures.
 void Period_init(void);
 void Period_cleanup(void);
 
-// Record the current time as a timestamp for the 
-// indicated event. This allows later calls to 
+// Record the current time as a timestamp for the
+// indicated event. This allows later calls to
 // Period_getStatisticsAndClear() to access these timestamps
 // and compute the timing statistics for this periodic event.
 void Period_markEvent(enum Period_whichEvent whichEvent);
 
+// Record the time since `startInNs` (from Timing_getCounterNS()) for
+// an event which is a latency rather than a period, such as from a
+// sensor sample to the frame showing it being sent. The statistics of
+// such an event are of these intervals.
+void Period_markInterval(enum Period_whichEvent whichEvent, long long startInNs);
+
 // Fill the `pStats` struct, which must be allocated by the calling
 // code, with the statistics about the periodic event `whichEvent`.
 // This function is threadsafe, and may be called by any thread.
@@ -52,4 +74,7 @@ void Period_getStatisticsAndClear(
     Period_statistics_t *pStats
 );
 
+// Print the statistics in one line, prefixed by `name`.
+void Period_printStatistics(const char *name, Period_statistics_t *pStats);
+
 #endif
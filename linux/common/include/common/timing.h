@@ -1,12 +1,68 @@
 // Manage time/sleep. Modified code provided by assignment description.
+//
+// Every time returned by this module is on the same monotonic timebase
+// (CLOCK_MONOTONIC), so values from different modules may be compared
+// and subtracted. The clock is never stepped by NTP or `date`.
 
 #ifndef _TIMING_H_
 #define _TIMING_H_
 
+#include <stdint.h>
+
+#define TIMING_NS_PER_US 1000LL
+#define TIMING_NS_PER_MS 1000000LL
+#define TIMING_NS_PER_SECOND 1000000000LL
+
+// Calibrate the cycle counter used by Timing_getCounterNS().
+// Optional; until it is called Timing_getCounterNS() uses the clock.
+void Timing_init(void);
+
+// Get current time in nanoseconds
+long long Timing_getTimeNS(void);
+
 // Get current time in milliseconds
 long long Timing_getTimeMS(void);
 
+// Get current time in milliseconds from the kernel's tick-rate clock.
+// Only as precise as the scheduler tick (1-10ms), but several times
+// cheaper than Timing_getTimeMS(); use it for timeouts and statistics.
+long long Timing_getCoarseTimeMS(void);
+
+// Get current time in nanoseconds from the CPU's counter (CNTVCT_EL0
+// on ARMv8) without a system call. Uses the clock elsewhere.
+long long Timing_getCounterNS(void);
+
+// Raw counter ticks and their conversion to nanoseconds; for
+// measuring short intervals with the least overhead.
+uint64_t Timing_getTicks(void);
+long long Timing_ticksToNS(uint64_t ticks);
+
 // Make application sleep for milliseconds
 void Timing_sleepForMS(long long);
 
+// Sleep until the absolute time `deadlineNS` (as from Timing_getTimeNS()).
+// Returns how many nanoseconds after the deadline we woke; this is
+// also the overrun when the deadline had already passed.
+long long Timing_sleepUntilNS(long long deadlineNS);
+
+// A periodic deadline: sleeping to it keeps a loop at its period
+// however long each iteration takes, without drift.
+typedef struct {
+    long long periodNS;
+    long long nextNS;
+
+    // Periods skipped because an iteration ran past the next deadline
+    long long numOverruns;
+    long long maxLateNS;
+} Timing_deadline_t;
+
+// Start the period now; the first deadline is one period away.
+void Timing_deadlineStart(Timing_deadline_t *pDeadline, long long periodNS);
+
+// Sleep until the next deadline and advance it by one period. If it
+// has already passed, missed periods are counted as overruns and the
+// next deadline is the first one still in the future.
+// Returns how late we woke, in nanoseconds.
+long long Timing_deadlineWait(Timing_deadline_t *pDeadline);
+
 #endif
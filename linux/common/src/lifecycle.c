@@ -0,0 +1,161 @@
+// Start and stop the application's modules in dependency order.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include "common/lifecycle.h"
+#include "common/timing.h"
+
+// One run through the table: every module waits for `waitFor[i]` to be
+// done, then runs its init (or cleanup).
+typedef struct {
+    const Lifecycle_module_t *pModules;
+    int numModules;
+    bool isStarting;
+
+    unsigned int waitFor[LIFECYCLE_MAX_MODULES];
+    long long startNS[LIFECYCLE_MAX_MODULES];
+    long long endNS[LIFECYCLE_MAX_MODULES];
+
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    unsigned int done;
+} phase_t;
+
+typedef struct {
+    phase_t *pPhase;
+    int index;
+} worker_t;
+
+static void runPhase(phase_t *pPhase);
+static void *workerThread(void *args);
+static void report(phase_t *pPhase, long long phaseStartNS);
+
+
+void Lifecycle_start(const Lifecycle_module_t *pModules, int numModules)
+{
+    assert(numModules > 0 && numModules <= LIFECYCLE_MAX_MODULES);
+
+    static phase_t phase;
+    phase.pModules = pModules;
+    phase.numModules = numModules;
+    phase.isStarting = true;
+
+    for (int i = 0; i < numModules; i++) {
+        // Only earlier modules: the graph can't have a cycle.
+        assert((pModules[i].dependsOn >> i) == 0);
+        phase.waitFor[i] = pModules[i].dependsOn;
+    }
+
+    runPhase(&phase);
+}
+
+void Lifecycle_stop(const Lifecycle_module_t *pModules, int numModules)
+{
+    assert(numModules > 0 && numModules <= LIFECYCLE_MAX_MODULES);
+
+    static phase_t phase;
+    phase.pModules = pModules;
+    phase.numModules = numModules;
+    phase.isStarting = false;
+
+    // Wait for the modules which depend on us instead.
+    for (int i = 0; i < numModules; i++) {
+        phase.waitFor[i] = 0;
+    }
+    for (int i = 0; i < numModules; i++) {
+        for (int dep = 0; dep < numModules; dep++) {
+            if (pModules[i].dependsOn & LIFECYCLE_DEP(dep)) {
+                phase.waitFor[dep] |= LIFECYCLE_DEP(i);
+            }
+        }
+    }
+
+    runPhase(&phase);
+}
+
+static void runPhase(phase_t *pPhase)
+{
+    static worker_t workers[LIFECYCLE_MAX_MODULES];
+    pthread_t threads[LIFECYCLE_MAX_MODULES];
+
+    pthread_mutex_init(&pPhase->lock, NULL);
+    pthread_cond_init(&pPhase->changed, NULL);
+    pPhase->done = 0;
+
+    long long phaseStartNS = Timing_getTimeNS();
+
+    for (int i = 0; i < pPhase->numModules; i++) {
+        workers[i].pPhase = pPhase;
+        workers[i].index = i;
+        int err = pthread_create(&threads[i], NULL, &workerThread, &workers[i]);
+        if (err) {
+            printf("Lifecycle: failed to create thread for %s.\n",
+                pPhase->pModules[i].name);
+            perror("Error is:");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (int i = 0; i < pPhase->numModules; i++) {
+        if (pthread_join(threads[i], NULL)) {
+            perror("Lifecycle: failed to join thread:");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    pthread_cond_destroy(&pPhase->changed);
+    pthread_mutex_destroy(&pPhase->lock);
+
+    report(pPhase, phaseStartNS);
+}
+
+static void *workerThread(void *args)
+{
+    worker_t *pWorker = args;
+    phase_t *pPhase = pWorker->pPhase;
+    int i = pWorker->index;
+    const Lifecycle_module_t *pModule = &pPhase->pModules[i];
+
+    pthread_mutex_lock(&pPhase->lock);
+    while ((pPhase->done & pPhase->waitFor[i]) != pPhase->waitFor[i]) {
+        pthread_cond_wait(&pPhase->changed, &pPhase->lock);
+    }
+    pthread_mutex_unlock(&pPhase->lock);
+
+    void (*function)(void) = pPhase->isStarting ? pModule->init : pModule->cleanup;
+    pPhase->startNS[i] = Timing_getTimeNS();
+    if (function != NULL) {
+        function();
+    }
+    pPhase->endNS[i] = Timing_getTimeNS();
+
+    pthread_mutex_lock(&pPhase->lock);
+    pPhase->done |= LIFECYCLE_DEP(i);
+    pthread_cond_broadcast(&pPhase->changed);
+    pthread_mutex_unlock(&pPhase->lock);
+
+    return NULL;
+}
+
+static void report(phase_t *pPhase, long long phaseStartNS)
+{
+    #define MS_PER_NS (1000*1000.0)
+    const char *verb = pPhase->isStarting ? "init" : "cleanup";
+    long long lastEndNS = phaseStartNS;
+
+    for (int i = 0; i < pPhase->numModules; i++) {
+        printf("Lifecycle: %-8s %-16s %8.1f ms (at +%.1f ms)\n",
+            verb, pPhase->pModules[i].name,
+            (pPhase->endNS[i] - pPhase->startNS[i]) / MS_PER_NS,
+            (pPhase->startNS[i] - phaseStartNS) / MS_PER_NS);
+        if (pPhase->endNS[i] > lastEndNS) {
+            lastEndNS = pPhase->endNS[i];
+        }
+    }
+    printf("Lifecycle: %s done in %.1f ms\n",
+        verb, (lastEndNS - phaseStartNS) / MS_PER_NS);
+}
@@ -1,47 +1,100 @@
 #include <assert.h>
+#include <math.h>
 #include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "common/periodTimer.h"
+#include "common/timing.h"
 
 // Written by Brian Fraser
 
 
+// Histogram layout: periods below 64ns get a bucket each, above that
+// every power of two is split into 32 buckets.
+#define SUB_BUCKETS 32
+#define EXACT_BUCKETS (2 * SUB_BUCKETS)
+#define MAX_MAGNITUDE 36    // periods up to ~2^41 ns (36 minutes)
+#define NUM_BUCKETS (EXACT_BUCKETS + MAX_MAGNITUDE * SUB_BUCKETS)
 
-// Data collected
+// Data collected by one thread for one event
 typedef struct {
-    // Store the timestamp samples each time we mark an event.
-    long timestampCount;
-    long long timestampsInNs[MAX_EVENT_TIMESTAMPS];
+    atomic_uint_least64_t buckets[NUM_BUCKETS];
+    atomic_uint_least64_t count;
+    atomic_uint_least64_t sumNs;
+    atomic_uint_least64_t minNs;
+    atomic_uint_least64_t maxNs;
 
-    // Used for recording the event between analysis periods.
+    // Only touched by the owning thread.
     long long prevTimestampInNs;
-} timestamps_t;
-static timestamps_t s_eventData[NUM_PERIOD_EVENTS];
+} recorder_t;
+
+typedef struct threadData {
+    struct threadData *next;
+    recorder_t events[NUM_PERIOD_EVENTS];
+} threadData_t;
+
+// Every live thread which has marked an event, newest first. Only
+// getMyThread() adds to it, at the head; the rest is changed only with
+// s_lock held.
+static _Atomic(threadData_t *) s_threads = NULL;
+
+// A thread's data is only its own while s_myGeneration matches: each
+// Period_cleanup() frees the data of every thread.
+static _Thread_local threadData_t *s_myThread = NULL;
+static _Thread_local unsigned s_myGeneration = 0;
+static atomic_uint s_generation = 1;
+
+// What threads recorded before they exited, until it is collected.
+static threadData_t s_exited;
+
+static pthread_once_t s_keyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t s_threadKey;
 
 static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
 static bool s_initialized = false;
 
 
 // Prototypes
-static void updateStats(
-    timestamps_t *pData, 
+static threadData_t *getMyThread(void);
+static void resetThread(threadData_t *pThread);
+static void onThreadExit(void *pThread);
+static void record(recorder_t *pData, uint64_t periodNs);
+static int bucketOf(uint64_t ns);
+static double bucketMidInNs(int bucket);
+static void collect(
+    enum Period_whichEvent whichEvent,
+    uint64_t *buckets,
     Period_statistics_t *pStats
 );
-static long long getTimeInNanoS(void);
 
 
 void Period_init(void)
 {
-    memset(s_eventData, 0, sizeof(s_eventData[0]) * NUM_PERIOD_EVENTS);
+    pthread_mutex_lock(&s_lock);
+    resetThread(&s_exited);
     s_initialized = true;
+    pthread_mutex_unlock(&s_lock);
 }
 void Period_cleanup(void)
 {
-    // nothing
+    // No thread may mark an event after this. Threads still holding
+    // their data see the new generation and start afresh.
+    pthread_mutex_lock(&s_lock);
     s_initialized = false;
+    atomic_fetch_add(&s_generation, 1);
+
+    threadData_t *pThread = atomic_exchange(&s_threads, NULL);
+    while (pThread) {
+        threadData_t *pNext = pThread->next;
+        free(pThread);
+        pThread = pNext;
+    }
+    pthread_mutex_unlock(&s_lock);
 }
 
 void Period_markEvent(enum Period_whichEvent whichEvent)
@@ -49,17 +102,41 @@ void Period_markEvent(enum Period_whichEvent whichEvent)
     assert (whichEvent >= 0 && whichEvent < NUM_PERIOD_EVENTS);
     assert (s_initialized);
 
-    timestamps_t *pData = &s_eventData[whichEvent];
-    pthread_mutex_lock(&s_lock);
-    {
-        if (pData->timestampCount < MAX_EVENT_TIMESTAMPS) {
-            pData->timestampsInNs[pData->timestampCount] = getTimeInNanoS();
-            pData->timestampCount++;
-        } else {
-            printf("WARNING: No sample space for event collection on %d\n", whichEvent);
+    threadData_t *pThread = s_myThread;
+    if (pThread == NULL || s_myGeneration != atomic_load_explicit(
+            &s_generation, memory_order_relaxed)) {
+        pThread = getMyThread();
+        if (pThread == NULL) {
+            return;
         }
     }
-    pthread_mutex_unlock(&s_lock);
+
+    recorder_t *pData = &pThread->events[whichEvent];
+    long long nowInNs = Timing_getCounterNS();
+
+    // The first mark on a thread only starts the period.
+    if (pData->prevTimestampInNs != 0) {
+        record(pData, nowInNs - pData->prevTimestampInNs);
+    }
+    pData->prevTimestampInNs = nowInNs;
+}
+
+void Period_markInterval(enum Period_whichEvent whichEvent, long long startInNs)
+{
+    assert (whichEvent >= 0 && whichEvent < NUM_PERIOD_EVENTS);
+    assert (s_initialized);
+
+    threadData_t *pThread = s_myThread;
+    if (pThread == NULL || s_myGeneration != atomic_load_explicit(
+            &s_generation, memory_order_relaxed)) {
+        pThread = getMyThread();
+        if (pThread == NULL) {
+            return;
+        }
+    }
+
+    long long intervalInNs = Timing_getCounterNS() - startInNs;
+    record(&pThread->events[whichEvent], intervalInNs > 0 ? intervalInNs : 0);
 }
 
 void Period_getStatisticsAndClear(
@@ -69,83 +146,253 @@ void Period_getStatisticsAndClear(
 {
     assert (whichEvent >= 0 && whichEvent < NUM_PERIOD_EVENTS);
     assert (s_initialized);
-    timestamps_t *pData = &s_eventData[whichEvent];
+
+    static uint64_t buckets[NUM_BUCKETS];
+
+    // One reader at a time; markers are never blocked.
     pthread_mutex_lock(&s_lock);
     {
-        // Compute stats
-        updateStats(pData, pStats);
+        collect(whichEvent, buckets, pStats);
+    }
+    pthread_mutex_unlock(&s_lock);
+}
 
-        // Update the "previous" sample (if we have any)
-        if (pData->timestampCount > 0) {
-            pData->prevTimestampInNs = pData->timestampsInNs[pData->timestampCount - 1];
-        }
+void Period_printStatistics(const char *name, Period_statistics_t *pStats)
+{
+    printf("%s: %d samples, ms min %.3f max %.3f avg %.3f"
+        " p50 %.3f p90 %.3f p99 %.3f p99.9 %.3f jitter %.3f\n",
+        name, pStats->numSamples,
+        pStats->minPeriodInMs, pStats->maxPeriodInMs, pStats->avgPeriodInMs,
+        pStats->p50PeriodInMs, pStats->p90PeriodInMs,
+        pStats->p99PeriodInMs, pStats->p999PeriodInMs,
+        pStats->jitterInMs);
+}
+
+static void createThreadKey(void)
+{
+    pthread_key_create(&s_threadKey, onThreadExit);
+}
+
+static threadData_t *getMyThread(void)
+{
+    pthread_once(&s_keyOnce, createThreadKey);
 
-        // Clear
-        pData->timestampCount = 0;
+    threadData_t *pThread = malloc(sizeof(*pThread));
+    if (pThread == NULL) {
+        return NULL;
     }
-    pthread_mutex_unlock(&s_lock);
+    resetThread(pThread);
+
+    // Publish to the readers
+    pThread->next = atomic_load(&s_threads);
+    while (!atomic_compare_exchange_weak(&s_threads, &pThread->next, pThread)) {
+        // pThread->next was reloaded; retry
+    }
+
+    s_myThread = pThread;
+    s_myGeneration = atomic_load(&s_generation);
+    pthread_setspecific(s_threadKey, pThread);
+    return pThread;
 }
 
-static void updateStats(
-    timestamps_t *pData, 
-    Period_statistics_t *pStats
-)
+static void resetThread(threadData_t *pThread)
 {
-    long long prevInNs = pData->prevTimestampInNs;
+    memset(pThread, 0, sizeof(*pThread));
+    for (int i = 0; i < NUM_PERIOD_EVENTS; i++) {
+        atomic_init(&pThread->events[i].minNs, UINT64_MAX);
+    }
+}
+
+// Fold an exiting thread's data into s_exited and free it, so threads
+// which come and go don't each keep a block until Period_cleanup().
+static void onThreadExit(void *pData)
+{
+    threadData_t *pThread = pData;
 
-    // Handle startup (no previous sample)
-    if (prevInNs == 0) {
-        prevInNs = pData->timestampsInNs[0];
+    pthread_mutex_lock(&s_lock);
+    // Already freed by Period_cleanup()?
+    if (s_myGeneration != atomic_load(&s_generation)) {
+        pthread_mutex_unlock(&s_lock);
+        return;
     }
-    
-    // Find min/max/sum time delta between consecutive samples
-    long long sumDeltasNs = 0;
-    long long minNs = 0;
-    long long maxNs = 0;
-    for (int i = 0; i < pData->timestampCount; i++) {
-        long long thisTime = pData->timestampsInNs[i];
-        long long deltaNs = thisTime - prevInNs;
-        sumDeltasNs += deltaNs;
 
-        if (i == 0 || deltaNs < minNs) {
-            minNs = deltaNs;
+    for (int event = 0; event < NUM_PERIOD_EVENTS; event++) {
+        recorder_t *pFrom = &pThread->events[event];
+        recorder_t *pTo = &s_exited.events[event];
+        for (int i = 0; i < NUM_BUCKETS; i++) {
+            atomic_fetch_add(&pTo->buckets[i], atomic_load(&pFrom->buckets[i]));
+        }
+        atomic_fetch_add(&pTo->count, atomic_load(&pFrom->count));
+        atomic_fetch_add(&pTo->sumNs, atomic_load(&pFrom->sumNs));
+        if (atomic_load(&pFrom->minNs) < atomic_load(&pTo->minNs)) {
+            atomic_store(&pTo->minNs, atomic_load(&pFrom->minNs));
         }
-        if (i == 0 || deltaNs > maxNs) {
-            maxNs = deltaNs;
+        if (atomic_load(&pFrom->maxNs) > atomic_load(&pTo->maxNs)) {
+            atomic_store(&pTo->maxNs, atomic_load(&pFrom->maxNs));
         }
+    }
 
-        prevInNs = thisTime;
+    // Unlink it. New threads only ever replace the head, so if it was
+    // the head and one has arrived since, it is further down.
+    threadData_t *pExpected = pThread;
+    if (!atomic_compare_exchange_strong(&s_threads, &pExpected, pThread->next)) {
+        threadData_t *pPrev = atomic_load(&s_threads);
+        while (pPrev->next != pThread) {
+            pPrev = pPrev->next;
+        }
+        pPrev->next = pThread->next;
     }
+    pthread_mutex_unlock(&s_lock);
 
-    long long avgNs = 0;
-    if (pData->timestampCount > 0) {
-        avgNs = sumDeltasNs / pData->timestampCount;
-    } 
+    free(pThread);
+}
 
-    // Save stats
-    #define MS_PER_NS (1000*1000.0)
-    pStats->minPeriodInMs = minNs / MS_PER_NS;
-    pStats->maxPeriodInMs = maxNs / MS_PER_NS;
-    pStats->avgPeriodInMs = avgNs / MS_PER_NS;
-    pStats->numSamples = pData->timestampCount;
+static void record(recorder_t *pData, uint64_t periodNs)
+{
+    // Only this thread adds to pData; a reader may concurrently
+    // take the values, so every update is a single atomic operation.
+    atomic_fetch_add_explicit(&pData->buckets[bucketOf(periodNs)], 1,
+        memory_order_relaxed);
+    atomic_fetch_add_explicit(&pData->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&pData->sumNs, periodNs, memory_order_relaxed);
+
+    // This thread is the only writer, so no retry loop: a reader which
+    // resets min/max in between only loses this period to the next
+    // call's extremes.
+    if (periodNs < atomic_load_explicit(&pData->minNs, memory_order_relaxed)) {
+        atomic_store_explicit(&pData->minNs, periodNs, memory_order_relaxed);
+    }
+    if (periodNs > atomic_load_explicit(&pData->maxNs, memory_order_relaxed)) {
+        atomic_store_explicit(&pData->maxNs, periodNs, memory_order_relaxed);
+    }
+}
+
+static int bucketOf(uint64_t ns)
+{
+    if (ns < EXACT_BUCKETS) {
+        return (int)ns;
+    }
+
+    // magnitude >= 1 is the shift which leaves SUB_BUCKETS..2*SUB_BUCKETS-1
+    int magnitude = (63 - __builtin_clzll(ns)) - 5;
+    if (magnitude > MAX_MAGNITUDE) {
+        return NUM_BUCKETS - 1;
+    }
+    return EXACT_BUCKETS + (magnitude - 1) * SUB_BUCKETS
+        + (int)(ns >> magnitude) - SUB_BUCKETS;
 }
 
+static double bucketMidInNs(int bucket)
+{
+    if (bucket < EXACT_BUCKETS) {
+        return bucket;
+    }
 
+    int magnitude = (bucket - EXACT_BUCKETS) / SUB_BUCKETS + 1;
+    uint64_t sub = (bucket - EXACT_BUCKETS) % SUB_BUCKETS + SUB_BUCKETS;
+    uint64_t width = 1ULL << magnitude;
+    return (sub << magnitude) + width / 2.0;
+}
 
+// Every live thread's data, then s_exited; NULL starts
+static threadData_t *nextThread(threadData_t *pThread)
+{
+    if (pThread == &s_exited) {
+        return NULL;
+    }
+    threadData_t *pNext = pThread == NULL ? atomic_load(&s_threads) : pThread->next;
+    return pNext != NULL ? pNext : &s_exited;
+}
+
+static double percentileInNs(uint64_t *buckets, uint64_t count, double fraction)
+{
+    uint64_t target = (uint64_t)ceil(fraction * count);
+    if (target == 0) {
+        target = 1;
+    }
 
+    uint64_t seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= target) {
+            return bucketMidInNs(i);
+        }
+    }
+    return 0;
+}
 
-// Timing function
-static long long getTimeInNanoS(void) 
+static void collect(
+    enum Period_whichEvent whichEvent,
+    uint64_t *buckets,
+    Period_statistics_t *pStats
+)
 {
-    struct timespec spec;
-    clock_gettime(CLOCK_BOOTTIME, &spec);
-    long long seconds = spec.tv_sec;
-    long long nanoSeconds = spec.tv_nsec + seconds * 1000*1000*1000;
-	assert(nanoSeconds > 0);
-    
-    static long long lastTimeHack = 0;
-    assert(nanoSeconds > lastTimeHack);
-    lastTimeHack = nanoSeconds;
+    uint64_t count = 0;
+    uint64_t sumNs = 0;
+    uint64_t minNs = UINT64_MAX;
+    uint64_t maxNs = 0;
+
+    memset(buckets, 0, sizeof(buckets[0]) * NUM_BUCKETS);
+
+    // Take (and clear) what each thread has recorded, then what
+    // exited threads left.
+    for (threadData_t *pThread = nextThread(NULL);
+            pThread != NULL;
+            pThread = nextThread(pThread)) {
+        recorder_t *pData = &pThread->events[whichEvent];
+
+        for (int i = 0; i < NUM_BUCKETS; i++) {
+            buckets[i] += atomic_exchange_explicit(&pData->buckets[i], 0,
+                memory_order_relaxed);
+        }
+        count += atomic_exchange_explicit(&pData->count, 0, memory_order_relaxed);
+        sumNs += atomic_exchange_explicit(&pData->sumNs, 0, memory_order_relaxed);
+
+        uint64_t threadMin = atomic_exchange_explicit(&pData->minNs, UINT64_MAX,
+            memory_order_relaxed);
+        uint64_t threadMax = atomic_exchange_explicit(&pData->maxNs, 0,
+            memory_order_relaxed);
+        if (threadMin < minNs) {
+            minNs = threadMin;
+        }
+        if (threadMax > maxNs) {
+            maxNs = threadMax;
+        }
+    }
 
-    return nanoSeconds;
+    // The bucket counts are the authority on the sample count; a
+    // period recorded while we were reading may be split between
+    // this and the next call.
+    uint64_t numInBuckets = 0;
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        numInBuckets += buckets[i];
+    }
+
+    #define MS_PER_NS (1000*1000.0)
+    memset(pStats, 0, sizeof(*pStats));
+    pStats->numSamples = (int)numInBuckets;
+
+    if (count == 0 || numInBuckets == 0) {
+        return;
+    }
+
+    double avgNs = (double)sumNs / count;
+
+    double sumSquares = 0;
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        if (buckets[i]) {
+            double delta = bucketMidInNs(i) - avgNs;
+            sumSquares += delta * delta * buckets[i];
+        }
+    }
+
+    pStats->minPeriodInMs = (minNs == UINT64_MAX ? 0 : minNs) / MS_PER_NS;
+    pStats->maxPeriodInMs = maxNs / MS_PER_NS;
+    pStats->avgPeriodInMs = avgNs / MS_PER_NS;
+    pStats->p50PeriodInMs = percentileInNs(buckets, numInBuckets, 0.50) / MS_PER_NS;
+    pStats->p90PeriodInMs = percentileInNs(buckets, numInBuckets, 0.90) / MS_PER_NS;
+    pStats->p99PeriodInMs = percentileInNs(buckets, numInBuckets, 0.99) / MS_PER_NS;
+    pStats->p999PeriodInMs = percentileInNs(buckets, numInBuckets, 0.999) / MS_PER_NS;
+    pStats->jitterInMs = sqrt(sumSquares / numInBuckets) / MS_PER_NS;
 }
+
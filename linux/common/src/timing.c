@@ -1,17 +1,96 @@
 // Manage time/sleep. Modified code provided by assignment description.
 
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <time.h>
 
 #include "common/timing.h"
 
 #define MS_PER_SECOND 1000
-#define NS_PER_MS 1000000
-#define NS_PER_SECOND 1000000000
+#define NS_PER_MS TIMING_NS_PER_MS
+#define NS_PER_SECOND TIMING_NS_PER_SECOND
+
+// How long Timing_init() watches the counter against the clock, and how
+// far the measured rate may be from the advertised one before we
+// distrust the advertised one (some boot firmware sets CNTFRQ wrongly).
+#define CALIBRATE_MS 20
+#define CALIBRATE_TOLERANCE_PPM 1000
+
+#if defined(__aarch64__)
+// Written once by Timing_init(), before other threads are started.
+// s_counterHz is 0 until then.
+static uint64_t s_counterHz = 0;
+static uint64_t s_baseTicks = 0;
+static long long s_baseNS = 0;
+#endif
+
+static long long timespecToNS(const struct timespec *pSpec)
+{
+    return (long long)pSpec->tv_sec * NS_PER_SECOND + pSpec->tv_nsec;
+}
+
+#if defined(__aarch64__)
+// The virtual counter runs at a fixed rate in all power states and is
+// readable from user space (the kernel sets CNTKCTL_EL1.EL0VCTEN).
+static inline uint64_t readCounter(void)
+{
+    uint64_t ticks;
+    // isb: don't let the read be hoisted above earlier instructions
+    __asm__ __volatile__("isb\n\tmrs %0, cntvct_el0" : "=r"(ticks) :: "memory");
+    return ticks;
+}
+
+static uint64_t readCounterHz(void)
+{
+    uint64_t hz;
+    __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(hz));
+    return hz;
+}
+#endif
+
+void Timing_init(void)
+{
+#if defined(__aarch64__)
+    uint64_t nominalHz = readCounterHz();
+
+    uint64_t startTicks = readCounter();
+    long long startNS = Timing_getTimeNS();
+    Timing_sleepForMS(CALIBRATE_MS);
+    uint64_t endTicks = readCounter();
+    long long endNS = Timing_getTimeNS();
+
+    uint64_t measuredHz = (endTicks - startTicks) * (uint64_t)NS_PER_SECOND
+        / (uint64_t)(endNS - startNS);
+
+    uint64_t error = measuredHz > nominalHz
+        ? measuredHz - nominalHz
+        : nominalHz - measuredHz;
+    if (nominalHz == 0 || error * 1000000 > nominalHz * CALIBRATE_TOLERANCE_PPM) {
+        printf("Timing: counter runs at %llu Hz, not the advertised %llu Hz\n",
+            (unsigned long long)measuredHz, (unsigned long long)nominalHz);
+        s_counterHz = measuredHz;
+    } else {
+        s_counterHz = nominalHz;
+    }
+
+    // Tie the counter to the clock so both give the same times.
+    s_baseTicks = endTicks;
+    s_baseNS = endNS;
+#endif
+}
+
+long long Timing_getTimeNS(void)
+{
+    struct timespec spec;
+    clock_gettime(CLOCK_MONOTONIC, &spec);
+    return timespecToNS(&spec);
+}
 
 long long Timing_getTimeMS(void)
 {
     struct timespec spec;
-    clock_gettime(CLOCK_REALTIME, &spec);
+    clock_gettime(CLOCK_MONOTONIC, &spec);
     long long seconds = spec.tv_sec;
     long long nanoseconds = spec.tv_nsec;
     long long milliseconds = seconds * MS_PER_SECOND
@@ -19,6 +98,46 @@ long long Timing_getTimeMS(void)
     return milliseconds;
 }
 
+long long Timing_getCoarseTimeMS(void)
+{
+    struct timespec spec;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &spec);
+    return timespecToNS(&spec) / NS_PER_MS;
+}
+
+long long Timing_getCounterNS(void)
+{
+#if defined(__aarch64__)
+    if (s_counterHz != 0) {
+        return s_baseNS + Timing_ticksToNS(readCounter() - s_baseTicks);
+    }
+#endif
+    return Timing_getTimeNS();
+}
+
+uint64_t Timing_getTicks(void)
+{
+#if defined(__aarch64__)
+    return readCounter();
+#else
+    return (uint64_t)Timing_getTimeNS();
+#endif
+}
+
+long long Timing_ticksToNS(uint64_t ticks)
+{
+#if defined(__aarch64__)
+    uint64_t hz = s_counterHz != 0 ? s_counterHz : readCounterHz();
+#else
+    uint64_t hz = NS_PER_SECOND;
+#endif
+    // Split so that neither product can overflow.
+    uint64_t seconds = ticks / hz;
+    uint64_t remainder = ticks % hz;
+    return (long long)(seconds * NS_PER_SECOND
+        + remainder * NS_PER_SECOND / hz);
+}
+
 void Timing_sleepForMS(long long delayMS)
 {
     long long delayNS = delayMS * NS_PER_MS;
@@ -28,3 +147,41 @@ void Timing_sleepForMS(long long delayMS)
     nanosleep(&reqDelay, (struct timespec *) NULL);
 }
 
+long long Timing_sleepUntilNS(long long deadlineNS)
+{
+    struct timespec deadline = {
+        deadlineNS / NS_PER_SECOND,
+        deadlineNS % NS_PER_SECOND
+    };
+
+    // An absolute deadline survives being interrupted: just go back to sleep.
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+    }
+
+    long long lateNS = Timing_getTimeNS() - deadlineNS;
+    return lateNS > 0 ? lateNS : 0;
+}
+
+void Timing_deadlineStart(Timing_deadline_t *pDeadline, long long periodNS)
+{
+    pDeadline->periodNS = periodNS;
+    pDeadline->nextNS = Timing_getTimeNS() + periodNS;
+    pDeadline->numOverruns = 0;
+    pDeadline->maxLateNS = 0;
+}
+
+long long Timing_deadlineWait(Timing_deadline_t *pDeadline)
+{
+    long long lateNS = Timing_sleepUntilNS(pDeadline->nextNS);
+    if (lateNS > pDeadline->maxLateNS) {
+        pDeadline->maxLateNS = lateNS;
+    }
+
+    // Skip the deadlines we slept (or worked) through rather than
+    // running several iterations back to back to catch up.
+    long long missed = lateNS / pDeadline->periodNS;
+    pDeadline->numOverruns += missed;
+    pDeadline->nextNS += (missed + 1) * pDeadline->periodNS;
+
+    return lateNS;
+}
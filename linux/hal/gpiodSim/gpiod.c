@@ -0,0 +1,177 @@
+// Stand-in for the part of libgpiod the HAL uses; see gpiod.h.
+#define _GNU_SOURCE     // ppoll()
+#include "gpiod.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/gpio.h>
+
+#include "lgGpioSim.h"
+
+struct gpiod_line {
+    struct gpiod_chip *chip;
+    unsigned int offset;
+    int fd;                     // its event request; -1 until requested
+};
+
+struct gpiod_chip {
+    int fd;
+    unsigned int numLines;
+    struct gpiod_line *lines;
+};
+
+struct gpiod_chip *gpiod_chip_open_by_name(const char *name)
+{
+    if (lgGpioSimStart() != 0) {
+        errno = ENODEV;
+        return NULL;
+    }
+
+    char path[64];
+    snprintf(path, sizeof(path), "/dev/%s", name);
+    int fd = lgSimOpen(path);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct gpiochip_info info;
+    if (lgSimIoctl(fd, GPIO_GET_CHIPINFO_IOCTL, &info) != 0) {
+        lgSimClose(fd);
+        return NULL;
+    }
+
+    struct gpiod_chip *chip = malloc(sizeof(*chip));
+    struct gpiod_line *lines = calloc(info.lines, sizeof(*lines));
+    if (chip == NULL || lines == NULL) {
+        free(chip);
+        free(lines);
+        lgSimClose(fd);
+        errno = ENOMEM;
+        return NULL;
+    }
+    chip->fd = fd;
+    chip->numLines = info.lines;
+    chip->lines = lines;
+    for (unsigned int i = 0; i < info.lines; i++) {
+        lines[i].chip = chip;
+        lines[i].offset = i;
+        lines[i].fd = -1;
+    }
+    return chip;
+}
+
+void gpiod_chip_close(struct gpiod_chip *chip)
+{
+    for (unsigned int i = 0; i < chip->numLines; i++) {
+        gpiod_line_release(&chip->lines[i]);
+    }
+    lgSimClose(chip->fd);
+    free(chip->lines);
+    free(chip);
+}
+
+struct gpiod_line *gpiod_chip_get_line(struct gpiod_chip *chip, unsigned int offset)
+{
+    if (offset >= chip->numLines) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return &chip->lines[offset];
+}
+
+unsigned int gpiod_line_offset(struct gpiod_line *line)
+{
+    return line->offset;
+}
+
+void gpiod_line_release(struct gpiod_line *line)
+{
+    if (line->fd >= 0) {
+        lgSimClose(line->fd);
+        line->fd = -1;
+    }
+}
+
+int gpiod_line_request_bulk_both_edges_events(struct gpiod_line_bulk *bulk,
+    const char *consumer)
+{
+    for (unsigned int i = 0; i < bulk->num_lines; i++) {
+        if (bulk->lines[i]->fd >= 0) {
+            errno = EBUSY;
+            return -1;
+        }
+    }
+
+    for (unsigned int i = 0; i < bulk->num_lines; i++) {
+        struct gpiod_line *line = bulk->lines[i];
+        struct gpio_v2_line_request req;
+        memset(&req, 0, sizeof(req));
+        req.num_lines = 1;
+        req.offsets[0] = line->offset;
+        req.config.flags = GPIO_V2_LINE_FLAG_INPUT
+            | GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING;
+        strncpy(req.consumer, consumer, sizeof(req.consumer) - 1);
+
+        if (lgSimIoctl(line->chip->fd, GPIO_V2_GET_LINE_IOCTL, &req) != 0) {
+            // All or none
+            int err = errno;
+            for (unsigned int j = 0; j < i; j++) {
+                gpiod_line_release(bulk->lines[j]);
+            }
+            errno = err;
+            return -1;
+        }
+        line->fd = req.fd;
+    }
+    return 0;
+}
+
+int gpiod_line_event_wait_bulk(struct gpiod_line_bulk *bulk, const struct timespec *timeout,
+    struct gpiod_line_bulk *event_bulk)
+{
+    struct pollfd fds[GPIOD_LINE_BULK_MAX_LINES];
+    for (unsigned int i = 0; i < bulk->num_lines; i++) {
+        fds[i].fd = bulk->lines[i]->fd;
+        fds[i].events = POLLIN | POLLPRI;
+        fds[i].revents = 0;
+    }
+
+    int ready = ppoll(fds, bulk->num_lines, timeout, NULL);
+    if (ready <= 0) {
+        return ready;
+    }
+
+    gpiod_line_bulk_init(event_bulk);
+    for (unsigned int i = 0; i < bulk->num_lines; i++) {
+        if (fds[i].revents) {
+            gpiod_line_bulk_add(event_bulk, bulk->lines[i]);
+        }
+    }
+    return 1;
+}
+
+int gpiod_line_event_read(struct gpiod_line *line, struct gpiod_line_event *event)
+{
+    struct gpio_v2_line_event ev;
+    size_t got = 0;
+    while (got < sizeof(ev)) {
+        ssize_t n = read(line->fd, (char *)&ev + got, sizeof(ev) - got);
+        if (n <= 0) {
+            if (n == 0) {
+                errno = EIO;
+            }
+            return -1;
+        }
+        got += n;
+    }
+
+    event->ts.tv_sec = ev.timestamp_ns / 1000000000ULL;
+    event->ts.tv_nsec = ev.timestamp_ns % 1000000000ULL;
+    event->event_type = ev.id == GPIO_V2_LINE_EVENT_RISING_EDGE
+        ? GPIOD_LINE_EVENT_RISING_EDGE : GPIOD_LINE_EVENT_FALLING_EDGE;
+    return 0;
+}
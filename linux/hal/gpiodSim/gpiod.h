@@ -0,0 +1,76 @@
+// Stand-in for the part of libgpiod (v1) the HAL uses, driving lgpio's
+// simulated GPIO chips (lgGpioSim.h) so the HAL builds and runs with
+// neither libgpiod nor GPIO hardware. Built in place of libgpiod when
+// HAL_GPIO_SIM is on (see hal/CMakeLists.txt).
+// Opening a chip starts the simulator; drive the lines' inputs with
+// lgGpioSimSetInput() or lgGpioSimScript().
+// Each line requested for events gets its own request, as in libgpiod
+// v1, with a queue of 16 events; when it's full the oldest are lost.
+#ifndef _GPIOD_H_
+#define _GPIOD_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+#define GPIOD_LINE_BULK_MAX_LINES 64
+
+struct gpiod_chip;
+struct gpiod_line;
+
+struct gpiod_line_bulk {
+    struct gpiod_line *lines[GPIOD_LINE_BULK_MAX_LINES];
+    unsigned int num_lines;
+};
+
+enum {
+    GPIOD_LINE_EVENT_RISING_EDGE = 1,
+    GPIOD_LINE_EVENT_FALLING_EDGE,
+};
+
+struct gpiod_line_event {
+    struct timespec ts;         // CLOCK_MONOTONIC
+    int event_type;
+};
+
+static inline void gpiod_line_bulk_init(struct gpiod_line_bulk *bulk)
+{
+    bulk->num_lines = 0;
+}
+
+static inline void gpiod_line_bulk_add(struct gpiod_line_bulk *bulk, struct gpiod_line *line)
+{
+    bulk->lines[bulk->num_lines++] = line;
+}
+
+static inline struct gpiod_line *gpiod_line_bulk_get_line(struct gpiod_line_bulk *bulk,
+    unsigned int offset)
+{
+    return bulk->lines[offset];
+}
+
+static inline unsigned int gpiod_line_bulk_num_lines(struct gpiod_line_bulk *bulk)
+{
+    return bulk->num_lines;
+}
+
+// NULL (errno set) on failure
+struct gpiod_chip *gpiod_chip_open_by_name(const char *name);
+void gpiod_chip_close(struct gpiod_chip *chip);
+struct gpiod_line *gpiod_chip_get_line(struct gpiod_chip *chip, unsigned int offset);
+
+unsigned int gpiod_line_offset(struct gpiod_line *line);
+void gpiod_line_release(struct gpiod_line *line);
+
+// -1 (errno EBUSY) if a line is already requested
+int gpiod_line_request_bulk_both_edges_events(struct gpiod_line_bulk *bulk,
+    const char *consumer);
+
+// 1 with the lines which have events in event_bulk, 0 on timeout
+// (NULL waits forever), -1 on error
+int gpiod_line_event_wait_bulk(struct gpiod_line_bulk *bulk, const struct timespec *timeout,
+    struct gpiod_line_bulk *event_bulk);
+// Blocks until the line has an event
+int gpiod_line_event_read(struct gpiod_line *line, struct gpiod_line_event *event);
+
+#endif
@@ -16,10 +16,20 @@ typedef struct {
     double y;
 } coordinates;
 
+// The newest reading and when it was taken
+typedef struct {
+    coordinates coords;
+    long long sampleNS;     // Timing_getCounterNS() when it was read
+} accel_snapshot_t;
+
 // returns a struct of x, y, z acceleration data
 
 coordinates Accel_getCurrentCoords();
 
+// The newest reading with its time, for measuring how old what is
+// shown is; sampleNS is 0 until the first reading.
+accel_snapshot_t Accel_getSnapshot(void);
+
 void Accel_getTiming(accel_stats_t* stats);
 
 void Accel_init(void);
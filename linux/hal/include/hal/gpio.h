@@ -1,8 +1,8 @@
 // Low-level GPIO access using gpiod.
 // Modified code from gpio_statemachine_demo.
 
-#ifndef _GPIO_H_
-#define _GPIO_H_
+#ifndef _HAL_GPIO_H_
+#define _HAL_GPIO_H_
 
 #include <stdbool.h>
 #include <gpiod.h>
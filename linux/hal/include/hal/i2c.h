@@ -1,12 +1,31 @@
 // Manage certain hardware with I2C
+// Transfers go to a backend: the Linux i2c-dev driver unless another,
+// such as the simulator in hal/i2cSim.h, is set with set_i2c_backend().
 
 #ifndef _I2C_H_
 #define _I2C_H_
 
 #include <stdint.h>
 
-// initializes I2C device
+typedef struct {
+    const char *name;
+    // Returns a handle for the device at `address` on `bus`, or -1
+    int (*open)(const char *bus, int address);
+    void (*close)(int handle);
+    // Each is one transfer; returns the bytes moved, or -1
+    int (*write)(int handle, const uint8_t *pData, int len);
+    int (*read)(int handle, uint8_t *pData, int len);
+} I2c_backend_t;
+
+// set the backend for buses opened after this; NULL for i2c-dev
+void set_i2c_backend(const I2c_backend_t *pBackend);
+
+// initializes I2C device; the handle returned (not a file descriptor)
+// keeps the backend that was set when it was opened
 int init_i2c_bus(char* bus, int address);
+// closes what init_i2c_bus() opened
+void close_i2c_bus(int i2c_file_desc);
+
 // write to 16 bit i2c register
 void write_i2c_reg16(int i2c_file_desc, uint8_t reg_addr, uint16_t value);
 // read val from 16 bit i2c register
@@ -17,4 +36,8 @@ void write_i2c_reg8(int i2c_file_desc, uint8_t reg_addr, uint8_t value);
 // read val from 8 bit i2c register
 uint8_t read_i2c_reg8(int i2c_file_desc, uint8_t reg_addr);
 
+// read len bytes starting at reg_addr in one transfer; the device
+// must step through its registers (on the LIS3DH, set bit 7 of reg_addr)
+void read_i2c_block(int i2c_file_desc, uint8_t reg_addr, uint8_t *pData, int len);
+
 #endif
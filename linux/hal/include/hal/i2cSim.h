@@ -0,0 +1,52 @@
+// Register-level simulator of the board's I2C devices, as an I2C
+// backend, so the drivers run without hardware:
+//  - LIS3DH accelerometer: output registers, STATUS_REG data-ready and
+//    overrun, the 32-sample FIFO (bypass, FIFO and stream modes), and
+//    auto-increment (bit 7 of the register address), which wraps from
+//    OUT_Z_H back to OUT_X_L while the FIFO is on so it can be drained
+//    in one read.
+//  - TLA2024 ADC: single-shot and continuous conversions which take
+//    1/DR, the OS bit while converting, MUX and PGA.
+// Both keep to the real clock: the LIS3DH makes a sample every 1/ODR,
+// and each transfer holds the bus for the configured latency.
+// Usage:
+//  1. Call I2cSim_init(), then set_i2c_backend(I2cSim_getBackend())
+//     before a driver opens the bus. The devices answer on any bus.
+//  2. Set what the sensors see with I2cSim_setAcceleration() and
+//     I2cSim_setAnalogInput(); they may change at any time.
+#ifndef _I2C_SIM_H_
+#define _I2C_SIM_H_
+
+#include "hal/i2c.h"
+
+#define I2C_SIM_LIS3DH_ADDRESS 0x19
+#define I2C_SIM_TLA2024_ADDRESS 0x48
+
+// Default latency: a 100kHz bus, where a byte takes 9 clocks, plus the
+// start, stop and the kernel's share of a transfer.
+#define I2C_SIM_DEFAULT_TRANSFER_NS 60000LL
+#define I2C_SIM_DEFAULT_BYTE_NS 90000LL
+
+typedef struct {
+    long long numTransfers;
+    long long numBytes;         // Including each transfer's address byte
+    long long busyNS;           // Time the bus was held
+} I2cSim_stats_t;
+
+void I2cSim_init(void);
+void I2cSim_cleanup(void);
+const I2c_backend_t *I2cSim_getBackend(void);
+
+// Each transfer holds the bus for transferNS, plus byteNS for each byte
+// (address byte included); 0 for both makes the bus instant.
+void I2cSim_setBusLatency(long long transferNS, long long byteNS);
+
+// Acceleration on each axis, in g
+void I2cSim_setAcceleration(double x, double y, double z);
+// Voltage on TLA2024 input AIN0 to AIN3
+void I2cSim_setAnalogInput(int channel, double volts);
+
+// Bus use since the last call
+void I2cSim_getStatsAndClear(I2cSim_stats_t *pStats);
+
+#endif
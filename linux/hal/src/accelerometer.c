@@ -52,10 +52,27 @@ static bool isRunning = false;
 static pthread_t mainThreadID;
 static int i2c_file_desc;
 
-coordinates currentCoords;
+// Written by the update thread, read by any; both coordinates and the
+// time they were read are taken together.
+static pthread_mutex_t s_snapshotLock = PTHREAD_MUTEX_INITIALIZER;
+static accel_snapshot_t s_snapshot;
 
 coordinates Accel_getCurrentCoords() {
-    return currentCoords;
+    return Accel_getSnapshot().coords;
+}
+
+accel_snapshot_t Accel_getSnapshot(void)
+{
+    pthread_mutex_lock(&s_snapshotLock);
+    accel_snapshot_t snapshot = s_snapshot;
+    pthread_mutex_unlock(&s_snapshotLock);
+    return snapshot;
+}
+
+// Accel_cleanup() cancels the thread, usually mid-read
+static void closeBusOnCancel(void *pFileDesc)
+{
+    close_i2c_bus(*(int *)pFileDesc);
 }
 
 static void *accelUpdateThread(void *args)
@@ -65,6 +82,7 @@ static void *accelUpdateThread(void *args)
     printf("Reading Accelerometer Data...\n");
 
     i2c_file_desc = init_i2c_bus(I2CDRV_LINUX_BUS, I2C_DEVICE_ADDRESS);
+    pthread_cleanup_push(closeBusOnCancel, &i2c_file_desc);
     
     // Configure accelerometer
     write_i2c_reg8(i2c_file_desc, REG_CONFIGURATION, 0x46);    
@@ -73,13 +91,15 @@ static void *accelUpdateThread(void *args)
         do_state();
     }
 
-    close(i2c_file_desc);
+    pthread_cleanup_pop(1);
 
     return NULL;
 }
 
 static void do_state() { 
 
+    // Timed from before the reads, so ages err on the long side
+    long long sampleNS = Timing_getCounterNS();
     int16_t raw_x = read_axis(i2c_file_desc, REG_OUT_X_L, REG_OUT_X_H);
     int16_t raw_y = read_axis(i2c_file_desc, REG_OUT_Y_L, REG_OUT_Y_H);
 
@@ -88,8 +108,11 @@ static void do_state() {
     float gy = raw_x / SCALE;
     float gx = raw_y / SCALE;
 
-    currentCoords.x = -1 * gx;
-    currentCoords.y = -1 * gy;
+    pthread_mutex_lock(&s_snapshotLock);
+    s_snapshot.coords.x = -1 * gx;
+    s_snapshot.coords.y = -1 * gy;
+    s_snapshot.sampleNS = sampleNS;
+    pthread_mutex_unlock(&s_snapshotLock);
 }
 
 static int16_t read_axis(int i2c_file_desc, uint8_t reg_l, uint8_t reg_h) {
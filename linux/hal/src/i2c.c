@@ -11,24 +11,134 @@
 #include <linux/i2c-dev.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <errno.h>
+#include <pthread.h>
+
+// Open buses; init_i2c_bus() returns the index
+#define MAX_BUSES 8
+
+// The Linux i2c-dev backend: a handle is the bus's file descriptor.
+static int linuxOpen(const char *bus, int address)
+{
+    int fd = open(bus, O_RDWR);
+    if (fd == -1) {
+        printf("I2C DRV: Unable to open bus for read/write (%s)\n", bus);
+        return -1;
+    }
+    if (ioctl(fd, I2C_SLAVE, address) == -1) {
+        printf("I2C DRV: Unable to set I2C device to slave address 0x%02x.\n", address);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void linuxClose(int handle)
+{
+    close(handle);
+}
+
+static int linuxWrite(int handle, const uint8_t *pData, int len)
+{
+    return write(handle, pData, len);
+}
+
+static int linuxRead(int handle, uint8_t *pData, int len)
+{
+    return read(handle, pData, len);
+}
+
+static const I2c_backend_t s_linuxBackend = {
+    "i2c-dev", linuxOpen, linuxClose, linuxWrite, linuxRead
+};
+static const I2c_backend_t *s_pBackend = &s_linuxBackend;
+
+// Each bus keeps the backend it was opened with, so changing the backend
+// leaves open buses alone. Modules start concurrently, so opening and
+// closing take the lock.
+typedef struct {
+    const I2c_backend_t *pBackend;  // NULL if free
+    int handle;                     // The backend's handle
+} bus_t;
+static bus_t s_buses[MAX_BUSES];
+static pthread_mutex_t s_busesLock = PTHREAD_MUTEX_INITIALIZER;
+
+void set_i2c_backend(const I2c_backend_t *pBackend)
+{
+    pthread_mutex_lock(&s_busesLock);
+    s_pBackend = pBackend != NULL ? pBackend : &s_linuxBackend;
+    pthread_mutex_unlock(&s_busesLock);
+}
+
+static bus_t *getBus(int i2c_file_desc)
+{
+    assert(i2c_file_desc >= 0 && i2c_file_desc < MAX_BUSES);
+    assert(s_buses[i2c_file_desc].pBackend != NULL);
+    return &s_buses[i2c_file_desc];
+}
+
+// Threads reading the bus are stopped with pthread_cancel(), and the
+// backend's open() and close() are cancellation points: a cancel there
+// would leave s_busesLock held and the slot taken, so opening and
+// closing can't be cancelled.
 
 // initializes I2C device
 int init_i2c_bus(char* bus, int address)
 {
-    int i2c_file_desc = open(bus, O_RDWR);
+    int cancelState;
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cancelState);
+    pthread_mutex_lock(&s_busesLock);
+    int i2c_file_desc = -1;
+    for (int i = 0; i < MAX_BUSES && i2c_file_desc < 0; i++) {
+        if (s_buses[i].pBackend == NULL) {
+            i2c_file_desc = i;
+        }
+    }
     if (i2c_file_desc == -1) {
-        printf("I2C DRV: Unable to open bus for read/write (%s)\n", bus);
-        perror("Error is:");
-        exit(EXIT_FAILURE);
+        errno = EMFILE;
+    } else {
+        int handle = s_pBackend->open(bus, address);
+        if (handle == -1) {
+            i2c_file_desc = -1;
+        } else {
+            s_buses[i2c_file_desc].pBackend = s_pBackend;
+            s_buses[i2c_file_desc].handle = handle;
+        }
     }
+    pthread_mutex_unlock(&s_busesLock);
 
-    if (ioctl(i2c_file_desc, I2C_SLAVE, address) == -1) {
-        perror("Unable to set I2C device to slave address.");
+    if (i2c_file_desc == -1) {
+        perror("Error is:");
         exit(EXIT_FAILURE);
     }
+    pthread_setcancelstate(cancelState, NULL);
     return i2c_file_desc;
 }
 
+void close_i2c_bus(int i2c_file_desc)
+{
+    int cancelState;
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cancelState);
+    pthread_mutex_lock(&s_busesLock);
+    bus_t *pBus = getBus(i2c_file_desc);
+    pBus->pBackend->close(pBus->handle);
+    pBus->pBackend = NULL;
+    pthread_mutex_unlock(&s_busesLock);
+    pthread_setcancelstate(cancelState, NULL);
+}
+
+static int busWrite(int i2c_file_desc, const uint8_t *pData, int len)
+{
+    bus_t *pBus = getBus(i2c_file_desc);
+    return pBus->pBackend->write(pBus->handle, pData, len);
+}
+
+static int busRead(int i2c_file_desc, uint8_t *pData, int len)
+{
+    bus_t *pBus = getBus(i2c_file_desc);
+    return pBus->pBackend->read(pBus->handle, pData, len);
+}
+
 void write_i2c_reg16(int i2c_file_desc, uint8_t reg_addr, uint16_t value)
 {
     int tx_size = 1 + sizeof(value);
@@ -36,7 +146,7 @@ void write_i2c_reg16(int i2c_file_desc, uint8_t reg_addr, uint16_t value)
     buff[0] = reg_addr;
     buff[1] = (value & 0xFF);
     buff[2] = (value & 0xFF00) >> 8;
-    int bytes_written = write(i2c_file_desc, buff, tx_size);
+    int bytes_written = busWrite(i2c_file_desc, buff, tx_size);
     if (bytes_written != tx_size) {
         perror("Unable to write i2c register");
         exit(EXIT_FAILURE);
@@ -46,7 +156,7 @@ void write_i2c_reg16(int i2c_file_desc, uint8_t reg_addr, uint16_t value)
 uint16_t read_i2c_reg16(int i2c_file_desc, uint8_t reg_addr)
 {
     // To read a register, must first write the address
-    int bytes_written = write(i2c_file_desc, &reg_addr, sizeof(reg_addr));
+    int bytes_written = busWrite(i2c_file_desc, &reg_addr, sizeof(reg_addr));
     if (bytes_written != sizeof(reg_addr)) {
         perror("Unable to write i2c register.");
         exit(EXIT_FAILURE);
@@ -54,7 +164,7 @@ uint16_t read_i2c_reg16(int i2c_file_desc, uint8_t reg_addr)
 
     // Now read the value and return it
     uint16_t value = 0;
-    int bytes_read = read(i2c_file_desc, &value, sizeof(value));
+    int bytes_read = busRead(i2c_file_desc, (uint8_t *)&value, sizeof(value));
     if (bytes_read != sizeof(value)) {
         perror("Unable to read i2c register");
         exit(EXIT_FAILURE);
@@ -65,7 +175,7 @@ uint16_t read_i2c_reg16(int i2c_file_desc, uint8_t reg_addr)
 void write_i2c_reg8(int i2c_file_desc, uint8_t reg_addr, uint8_t value)
 {
     uint8_t buff[2] = {reg_addr, value};
-    if (write(i2c_file_desc, buff, 2) != 2) {
+    if (busWrite(i2c_file_desc, buff, 2) != 2) {
         perror("Error writing to I2C register");
         exit(EXIT_FAILURE);
     }
@@ -73,14 +183,26 @@ void write_i2c_reg8(int i2c_file_desc, uint8_t reg_addr, uint8_t value)
 
 uint8_t read_i2c_reg8(int i2c_file_desc, uint8_t reg_addr)
 {
-    if (write(i2c_file_desc, &reg_addr, 1) != 1) {
+    if (busWrite(i2c_file_desc, &reg_addr, 1) != 1) {
         perror("Error writing register address");
         exit(EXIT_FAILURE);
     }
     uint8_t value;
-    if (read(i2c_file_desc, &value, 1) != 1) {
+    if (busRead(i2c_file_desc, &value, 1) != 1) {
         perror("Error reading I2C register");
         exit(EXIT_FAILURE);
     }
     return value;
 }
+
+void read_i2c_block(int i2c_file_desc, uint8_t reg_addr, uint8_t *pData, int len)
+{
+    if (busWrite(i2c_file_desc, &reg_addr, 1) != 1) {
+        perror("Error writing register address");
+        exit(EXIT_FAILURE);
+    }
+    if (busRead(i2c_file_desc, pData, len) != len) {
+        perror("Error reading I2C registers");
+        exit(EXIT_FAILURE);
+    }
+}
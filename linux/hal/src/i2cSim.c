@@ -0,0 +1,577 @@
+// Register-level simulator of the board's I2C devices
+#include "hal/i2cSim.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common/timing.h"
+
+#define MAX_HANDLES 16
+
+// LIS3DH registers
+#define LIS3DH_WHO_AM_I 0x0F
+#define LIS3DH_WHO_AM_I_VALUE 0x33
+#define LIS3DH_CTRL_REG1 0x20
+#define LIS3DH_CTRL_REG4 0x23
+#define LIS3DH_CTRL_REG5 0x24
+#define LIS3DH_STATUS_REG 0x27
+#define LIS3DH_OUT_X_L 0x28
+#define LIS3DH_OUT_Z_H 0x2D
+#define LIS3DH_FIFO_CTRL_REG 0x2E
+#define LIS3DH_FIFO_SRC_REG 0x2F
+#define LIS3DH_NUM_REGS 0x40
+#define LIS3DH_AUTO_INCREMENT 0x80
+#define LIS3DH_FIFO_SIZE 32
+
+#define LIS3DH_CTRL1_LPEN 0x08
+#define LIS3DH_CTRL1_AXES 0x07
+#define LIS3DH_CTRL4_HR 0x08
+#define LIS3DH_CTRL5_FIFO_EN 0x40
+#define LIS3DH_FIFO_MODE_BYPASS 0
+#define LIS3DH_FIFO_MODE_FIFO 1
+
+#define LIS3DH_STATUS_ZYXDA 0x0F    // ZYXDA and each axis' DA
+#define LIS3DH_STATUS_ZYXOR 0xF0
+#define LIS3DH_FIFO_SRC_WTM 0x80
+#define LIS3DH_FIFO_SRC_OVRN 0x40
+#define LIS3DH_FIFO_SRC_EMPTY 0x20
+
+// TLA2024 registers and configuration fields
+#define TLA2024_REG_CONVERSION 0
+#define TLA2024_REG_CONFIG 1
+#define TLA2024_CONFIG_RESET 0x8583
+#define TLA2024_CONFIG_OS 0x8000
+#define TLA2024_CONFIG_MODE 0x0100  // 1: single-shot
+#define TLA2024_NUM_INPUTS 4
+
+typedef struct {
+    uint8_t regs[LIS3DH_NUM_REGS];
+    uint8_t pointer;
+    bool isAutoIncrement;
+
+    // When the next sample is due; 0 while powered down
+    long long nextSampleNS;
+
+    // Output registers, in bypass mode
+    int16_t out[3];
+    bool isDataReady;
+    bool isOverrun;
+
+    // Oldest sample first
+    int16_t fifo[LIS3DH_FIFO_SIZE][3];
+    int fifoHead;
+    int fifoCount;
+    bool isFifoOverrun;
+} lis3dh_t;
+
+typedef struct {
+    uint8_t pointer;
+    uint16_t config;
+    uint16_t conversion;
+
+    // The conversion under way: when it ends, and what it converts
+    bool isConverting;
+    long long conversionEndNS;
+    uint16_t conversionConfig;
+} tla2024_t;
+
+typedef struct {
+    bool isOpen;
+    int address;
+} handle_t;
+
+static bool isInitialized = false;
+
+// The bus; held for the whole of each transfer, as the wires would be.
+static pthread_mutex_t s_busLock = PTHREAD_MUTEX_INITIALIZER;
+static handle_t s_handles[MAX_HANDLES];
+static long long s_transferNS;
+static long long s_byteNS;
+static I2cSim_stats_t s_stats;
+
+static lis3dh_t s_lis3dh;
+static tla2024_t s_tla2024;
+static double s_acceleration[3];
+static double s_analogInputs[TLA2024_NUM_INPUTS];
+
+
+/*
+ * LIS3DH
+ */
+
+// ODR[3:0] of CTRL_REG1 to samples a second; 0 is power down. The top
+// two depend on low-power mode.
+static double lis3dhRateHz(void)
+{
+    static const double ratesHz[16] = {0, 1, 10, 25, 50, 100, 200, 400, 1620, 1344};
+    uint8_t ctrl1 = s_lis3dh.regs[LIS3DH_CTRL_REG1];
+    int odr = ctrl1 >> 4;
+    if ((ctrl1 & LIS3DH_CTRL1_AXES) == 0) {
+        return 0;
+    }
+    if (odr == 9 && (ctrl1 & LIS3DH_CTRL1_LPEN)) {
+        return 5376;
+    }
+    return ratesHz[odr];
+}
+
+// Left-justified, as wide as the mode's resolution and scaled to the
+// full scale in CTRL_REG4.
+static int16_t lis3dhRaw(double g)
+{
+    static const double fullScaleG[4] = {2, 4, 8, 16};
+    uint8_t ctrl4 = s_lis3dh.regs[LIS3DH_CTRL_REG4];
+    int bits = 10;
+    if (s_lis3dh.regs[LIS3DH_CTRL_REG1] & LIS3DH_CTRL1_LPEN) {
+        bits = 8;
+    } else if (ctrl4 & LIS3DH_CTRL4_HR) {
+        bits = 12;
+    }
+
+    double scaled = g / fullScaleG[(ctrl4 >> 4) & 0x03] * 32768.0;
+    if (scaled > INT16_MAX) scaled = INT16_MAX;
+    if (scaled < INT16_MIN) scaled = INT16_MIN;
+    uint16_t mask = (uint16_t)(0xFFFF << (16 - bits));
+    return (int16_t)((uint16_t)(int16_t)scaled & mask);
+}
+
+static bool lis3dhIsFifoOn(void)
+{
+    return (s_lis3dh.regs[LIS3DH_CTRL_REG5] & LIS3DH_CTRL5_FIFO_EN)
+        && (s_lis3dh.regs[LIS3DH_FIFO_CTRL_REG] >> 6) != LIS3DH_FIFO_MODE_BYPASS;
+}
+
+static void lis3dhSample(void)
+{
+    int16_t sample[3];
+    uint8_t axes = s_lis3dh.regs[LIS3DH_CTRL_REG1] & LIS3DH_CTRL1_AXES;
+    for (int axis = 0; axis < 3; axis++) {
+        sample[axis] = (axes & (1 << axis)) ? lis3dhRaw(s_acceleration[axis]) : 0;
+    }
+
+    if (!lis3dhIsFifoOn()) {
+        s_lis3dh.isOverrun = s_lis3dh.isDataReady;
+        s_lis3dh.isDataReady = true;
+        memcpy(s_lis3dh.out, sample, sizeof(sample));
+        return;
+    }
+
+    // Full: FIFO mode stops, the stream modes drop the oldest.
+    if (s_lis3dh.fifoCount == LIS3DH_FIFO_SIZE) {
+        s_lis3dh.isFifoOverrun = true;
+        if ((s_lis3dh.regs[LIS3DH_FIFO_CTRL_REG] >> 6) == LIS3DH_FIFO_MODE_FIFO) {
+            return;
+        }
+        s_lis3dh.fifoHead = (s_lis3dh.fifoHead + 1) % LIS3DH_FIFO_SIZE;
+        s_lis3dh.fifoCount--;
+    }
+    int tail = (s_lis3dh.fifoHead + s_lis3dh.fifoCount) % LIS3DH_FIFO_SIZE;
+    memcpy(s_lis3dh.fifo[tail], sample, sizeof(sample));
+    s_lis3dh.fifoCount++;
+}
+
+// Make the samples due by now.
+static void lis3dhCatchUp(long long nowNS)
+{
+    double rateHz = lis3dhRateHz();
+    if (rateHz == 0) {
+        s_lis3dh.nextSampleNS = 0;
+        return;
+    }
+    long long periodNS = (long long)(TIMING_NS_PER_SECOND / rateHz);
+    if (s_lis3dh.nextSampleNS == 0) {
+        s_lis3dh.nextSampleNS = nowNS + periodNS;
+        return;
+    }
+    if (nowNS < s_lis3dh.nextSampleNS) {
+        return;
+    }
+
+    // Beyond a FIFO's worth, earlier samples would all be lost anyway.
+    long long numDue = (nowNS - s_lis3dh.nextSampleNS) / periodNS + 1;
+    int numToMake = numDue > LIS3DH_FIFO_SIZE + 1 ? LIS3DH_FIFO_SIZE + 1 : (int)numDue;
+    if (numDue > numToMake) {
+        s_lis3dh.isOverrun = true;
+        s_lis3dh.isFifoOverrun = lis3dhIsFifoOn();
+    }
+    for (int i = 0; i < numToMake; i++) {
+        lis3dhSample();
+    }
+    s_lis3dh.nextSampleNS += numDue * periodNS;
+}
+
+static uint8_t lis3dhRead(uint8_t reg)
+{
+    bool isFifoOn = lis3dhIsFifoOn();
+
+    if (reg >= LIS3DH_OUT_X_L && reg <= LIS3DH_OUT_Z_H) {
+        const int16_t *pSample = s_lis3dh.out;
+        if (isFifoOn) {
+            pSample = s_lis3dh.fifo[s_lis3dh.fifoHead];
+        }
+        int offset = reg - LIS3DH_OUT_X_L;
+        uint16_t value = (uint16_t)pSample[offset / 2];
+        uint8_t byte = (offset & 1) ? value >> 8 : value & 0xFF;
+
+        // Reading the last byte takes the sample.
+        if (reg == LIS3DH_OUT_Z_H) {
+            if (isFifoOn && s_lis3dh.fifoCount > 0) {
+                s_lis3dh.fifoHead = (s_lis3dh.fifoHead + 1) % LIS3DH_FIFO_SIZE;
+                s_lis3dh.fifoCount--;
+                s_lis3dh.isFifoOverrun = false;
+            }
+            s_lis3dh.isDataReady = false;
+            s_lis3dh.isOverrun = false;
+        }
+        return byte;
+    }
+
+    switch (reg) {
+    case LIS3DH_WHO_AM_I:
+        return LIS3DH_WHO_AM_I_VALUE;
+    case LIS3DH_STATUS_REG:
+        if (isFifoOn) {
+            return (s_lis3dh.fifoCount > 0 ? LIS3DH_STATUS_ZYXDA : 0)
+                | (s_lis3dh.isFifoOverrun ? LIS3DH_STATUS_ZYXOR : 0);
+        }
+        return (s_lis3dh.isDataReady ? LIS3DH_STATUS_ZYXDA : 0)
+            | (s_lis3dh.isOverrun ? LIS3DH_STATUS_ZYXOR : 0);
+    case LIS3DH_FIFO_SRC_REG: {
+        int threshold = s_lis3dh.regs[LIS3DH_FIFO_CTRL_REG] & 0x1F;
+        int count = s_lis3dh.fifoCount;
+        return (count > threshold ? LIS3DH_FIFO_SRC_WTM : 0)
+            | (s_lis3dh.isFifoOverrun ? LIS3DH_FIFO_SRC_OVRN : 0)
+            | (count == 0 ? LIS3DH_FIFO_SRC_EMPTY : 0)
+            | (count > 0x1F ? 0x1F : count);
+    }
+    default:
+        return s_lis3dh.regs[reg];
+    }
+}
+
+static void lis3dhWrite(uint8_t reg, uint8_t value, long long nowNS)
+{
+    bool isReadOnly = reg == LIS3DH_WHO_AM_I || reg == LIS3DH_FIFO_SRC_REG
+        || (reg >= LIS3DH_STATUS_REG && reg <= LIS3DH_OUT_Z_H);
+    if (isReadOnly) {
+        return;
+    }
+    s_lis3dh.regs[reg] = value;
+
+    switch (reg) {
+    case LIS3DH_CTRL_REG1:
+        // A new rate starts from now
+        s_lis3dh.nextSampleNS = 0;
+        lis3dhCatchUp(nowNS);
+        break;
+    case LIS3DH_CTRL_REG5:
+    case LIS3DH_FIFO_CTRL_REG:
+        // Bypass mode empties the FIFO
+        if (!lis3dhIsFifoOn()) {
+            s_lis3dh.fifoHead = 0;
+            s_lis3dh.fifoCount = 0;
+            s_lis3dh.isFifoOverrun = false;
+        }
+        break;
+    }
+}
+
+// The register after reg, for auto-increment
+static uint8_t lis3dhNext(uint8_t reg)
+{
+    if (reg == LIS3DH_OUT_Z_H && lis3dhIsFifoOn()) {
+        return LIS3DH_OUT_X_L;
+    }
+    return (reg + 1) % LIS3DH_NUM_REGS;
+}
+
+static void lis3dhTransfer(bool isRead, uint8_t *pData, int len, long long nowNS)
+{
+    lis3dhCatchUp(nowNS);
+
+    int i = 0;
+    if (!isRead) {
+        // The first byte written is the register address.
+        s_lis3dh.pointer = pData[0] & (LIS3DH_NUM_REGS - 1);
+        s_lis3dh.isAutoIncrement = (pData[0] & LIS3DH_AUTO_INCREMENT) != 0;
+        i = 1;
+    }
+    for (; i < len; i++) {
+        if (isRead) {
+            pData[i] = lis3dhRead(s_lis3dh.pointer);
+        } else {
+            lis3dhWrite(s_lis3dh.pointer, pData[i], nowNS);
+        }
+        if (s_lis3dh.isAutoIncrement) {
+            s_lis3dh.pointer = lis3dhNext(s_lis3dh.pointer);
+        }
+    }
+}
+
+
+/*
+ * TLA2024
+ */
+
+static long long tla2024ConversionNS(uint16_t config)
+{
+    static const int ratesSPS[8] = {128, 250, 490, 920, 1600, 2400, 3300, 3300};
+    return TIMING_NS_PER_SECOND / ratesSPS[(config >> 5) & 0x07];
+}
+
+// 12-bit result, left-justified, of the input MUX selects
+static uint16_t tla2024Convert(uint16_t config)
+{
+    static const double fullScaleV[8] = {6.144, 4.096, 2.048, 1.024, 0.512, 0.256, 0.256, 0.256};
+    // MUX: AIN0-AIN1, AIN0-AIN3, AIN1-AIN3, AIN2-AIN3, then each to GND
+    static const int positive[8] = {0, 0, 1, 2, 0, 1, 2, 3};
+    static const int negative[8] = {1, 3, 3, 3, -1, -1, -1, -1};
+
+    int mux = (config >> 12) & 0x07;
+    double volts = s_analogInputs[positive[mux]];
+    if (negative[mux] >= 0) {
+        volts -= s_analogInputs[negative[mux]];
+    }
+
+    long code = lround(volts / fullScaleV[(config >> 9) & 0x07] * 2048);
+    if (code > 2047) code = 2047;
+    if (code < -2048) code = -2048;
+    return (uint16_t)(code << 4);
+}
+
+static void tla2024Start(long long startNS)
+{
+    s_tla2024.isConverting = true;
+    s_tla2024.conversionConfig = s_tla2024.config;
+    s_tla2024.conversionEndNS = startNS + tla2024ConversionNS(s_tla2024.config);
+}
+
+// Finish the conversions done by now; continuous mode starts the next
+// as each ends.
+static void tla2024CatchUp(long long nowNS)
+{
+    if (!s_tla2024.isConverting || nowNS < s_tla2024.conversionEndNS) {
+        return;
+    }
+    if (s_tla2024.config & TLA2024_CONFIG_MODE) {
+        s_tla2024.conversion = tla2024Convert(s_tla2024.conversionConfig);
+        s_tla2024.isConverting = false;
+        return;
+    }
+
+    // Only the latest result is kept; inputs are read as they are now.
+    long long periodNS = tla2024ConversionNS(s_tla2024.config);
+    long long numDone = (nowNS - s_tla2024.conversionEndNS) / periodNS + 1;
+    s_tla2024.conversion = tla2024Convert(s_tla2024.config);
+    tla2024Start(s_tla2024.conversionEndNS + (numDone - 1) * periodNS);
+}
+
+static uint16_t tla2024ReadRegister(uint8_t reg)
+{
+    if (reg == TLA2024_REG_CONVERSION) {
+        return s_tla2024.conversion;
+    }
+    // OS reads 1 when no conversion is under way
+    uint16_t config = s_tla2024.config & ~TLA2024_CONFIG_OS;
+    return config | (s_tla2024.isConverting ? 0 : TLA2024_CONFIG_OS);
+}
+
+static void tla2024Transfer(bool isRead, uint8_t *pData, int len, long long nowNS)
+{
+    tla2024CatchUp(nowNS);
+
+    if (isRead) {
+        // Registers are 16 bits, most significant byte first.
+        uint16_t value = tla2024ReadRegister(s_tla2024.pointer);
+        for (int i = 0; i < len; i++) {
+            pData[i] = (i & 1) ? value & 0xFF : value >> 8;
+        }
+        return;
+    }
+
+    s_tla2024.pointer = pData[0] & 0x01;
+    if (len < 3 || s_tla2024.pointer != TLA2024_REG_CONFIG) {
+        return;
+    }
+    uint16_t value = (uint16_t)(pData[1] << 8 | pData[2]);
+    s_tla2024.config = value & ~TLA2024_CONFIG_OS;
+
+    if (!(value & TLA2024_CONFIG_MODE)) {
+        // Continuous: restart with the new configuration
+        tla2024Start(nowNS);
+    } else if ((value & TLA2024_CONFIG_OS) && !s_tla2024.isConverting) {
+        tla2024Start(nowNS);
+    }
+}
+
+
+/*
+ * Bus
+ */
+
+static void lis3dhReset(void)
+{
+    memset(&s_lis3dh, 0, sizeof(s_lis3dh));
+    // Power-on: powered down, all axes enabled
+    s_lis3dh.regs[LIS3DH_CTRL_REG1] = LIS3DH_CTRL1_AXES;
+}
+
+static void tla2024Reset(void)
+{
+    memset(&s_tla2024, 0, sizeof(s_tla2024));
+    s_tla2024.config = TLA2024_CONFIG_RESET & ~TLA2024_CONFIG_OS;
+}
+
+// One transfer: hold the bus for its time on the wires, and address
+// the device. Without one at the address, it is not acknowledged.
+static int transfer(int handle, bool isRead, uint8_t *pData, int len)
+{
+    assert(isInitialized);
+    if (handle < 0 || handle >= MAX_HANDLES || !s_handles[handle].isOpen || len <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pthread_mutex_lock(&s_busLock);
+    long long startNS = Timing_getTimeNS();
+    long long busyNS = s_transferNS + s_byteNS * (len + 1);
+
+    int result = len;
+    switch (s_handles[handle].address) {
+    case I2C_SIM_LIS3DH_ADDRESS:
+        lis3dhTransfer(isRead, pData, len, startNS);
+        break;
+    case I2C_SIM_TLA2024_ADDRESS:
+        tla2024Transfer(isRead, pData, len, startNS);
+        break;
+    default:
+        // Only the address byte goes out before the NACK
+        busyNS = s_transferNS + s_byteNS;
+        errno = EREMOTEIO;
+        result = -1;
+        break;
+    }
+
+    if (busyNS > 0) {
+        Timing_sleepUntilNS(startNS + busyNS);
+    }
+    s_stats.numTransfers++;
+    s_stats.numBytes += result < 0 ? 1 : len + 1;
+    s_stats.busyNS += Timing_getTimeNS() - startNS;
+    pthread_mutex_unlock(&s_busLock);
+
+    return result;
+}
+
+static int simOpen(const char *bus, int address)
+{
+    (void)bus;
+    assert(isInitialized);
+
+    pthread_mutex_lock(&s_busLock);
+    int handle = -1;
+    for (int i = 0; i < MAX_HANDLES && handle < 0; i++) {
+        if (!s_handles[i].isOpen) {
+            s_handles[i].isOpen = true;
+            s_handles[i].address = address;
+            handle = i;
+        }
+    }
+    pthread_mutex_unlock(&s_busLock);
+
+    if (handle < 0) {
+        errno = EMFILE;
+    }
+    return handle;
+}
+
+static void simClose(int handle)
+{
+    pthread_mutex_lock(&s_busLock);
+    if (handle >= 0 && handle < MAX_HANDLES) {
+        s_handles[handle].isOpen = false;
+    }
+    pthread_mutex_unlock(&s_busLock);
+}
+
+static int simWrite(int handle, const uint8_t *pData, int len)
+{
+    // Writes never change the caller's bytes.
+    return transfer(handle, false, (uint8_t *)pData, len);
+}
+
+static int simRead(int handle, uint8_t *pData, int len)
+{
+    return transfer(handle, true, pData, len);
+}
+
+static const I2c_backend_t s_simBackend = {
+    "simulator", simOpen, simClose, simWrite, simRead
+};
+
+void I2cSim_init(void)
+{
+    assert(!isInitialized);
+
+    memset(s_handles, 0, sizeof(s_handles));
+    memset(&s_stats, 0, sizeof(s_stats));
+    memset(s_acceleration, 0, sizeof(s_acceleration));
+    memset(s_analogInputs, 0, sizeof(s_analogInputs));
+    s_transferNS = I2C_SIM_DEFAULT_TRANSFER_NS;
+    s_byteNS = I2C_SIM_DEFAULT_BYTE_NS;
+    lis3dhReset();
+    tla2024Reset();
+
+    isInitialized = true;
+}
+
+void I2cSim_cleanup(void)
+{
+    assert(isInitialized);
+    isInitialized = false;
+}
+
+const I2c_backend_t *I2cSim_getBackend(void)
+{
+    return &s_simBackend;
+}
+
+void I2cSim_setBusLatency(long long transferNS, long long byteNS)
+{
+    pthread_mutex_lock(&s_busLock);
+    s_transferNS = transferNS;
+    s_byteNS = byteNS;
+    pthread_mutex_unlock(&s_busLock);
+}
+
+void I2cSim_setAcceleration(double x, double y, double z)
+{
+    pthread_mutex_lock(&s_busLock);
+    s_acceleration[0] = x;
+    s_acceleration[1] = y;
+    s_acceleration[2] = z;
+    pthread_mutex_unlock(&s_busLock);
+}
+
+void I2cSim_setAnalogInput(int channel, double volts)
+{
+    assert(channel >= 0 && channel < TLA2024_NUM_INPUTS);
+
+    pthread_mutex_lock(&s_busLock);
+    s_analogInputs[channel] = volts;
+    pthread_mutex_unlock(&s_busLock);
+}
+
+void I2cSim_getStatsAndClear(I2cSim_stats_t *pStats)
+{
+    pthread_mutex_lock(&s_busLock);
+    *pStats = s_stats;
+    memset(&s_stats, 0, sizeof(s_stats));
+    pthread_mutex_unlock(&s_busLock);
+}
@@ -73,17 +73,25 @@ void Joystick_init(void)
     }
 }
 
+// Joystick_cleanup() cancels the thread, maybe mid-sample
+static void closeBusOnCancel(void *pFileDesc)
+{
+    close_i2c_bus(*(int *)pFileDesc);
+}
+
 static void do_state(void) {
 
     // read Y direction
+    uint16_t value_Y;
     int i2c_file_desc_Y = init_i2c_bus(I2CDRV_LINUX_BUS, I2C_DEVICE_ADDRESS);
+    pthread_cleanup_push(closeBusOnCancel, &i2c_file_desc_Y);
     write_i2c_reg16(i2c_file_desc_Y, REG_CONFIGURATION, TLA2024_CHANNEL_CONF_0);
     usleep(USLEEP_DELAY);
 
     uint16_t raw_read_Y = read_i2c_reg16(i2c_file_desc_Y, REG_DATA);
-    uint16_t value_Y = ((raw_read_Y & 0xFF) << 8) | ((raw_read_Y & 0xFF00) >> 8);
+    value_Y = ((raw_read_Y & 0xFF) << 8) | ((raw_read_Y & 0xFF00) >> 8);
     value_Y = value_Y >> 4;
-    close(i2c_file_desc_Y);
+    pthread_cleanup_pop(1);
 
     // if joystick is pushed up or down over threshold, return up or down
     
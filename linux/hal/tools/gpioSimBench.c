@@ -0,0 +1,226 @@
+// Benchmark of the GPIO paths on lgpio's simulated GPIO chips
+// (lgGpioSim.h), so it needs no board:
+//  - Alerts: time from an input's edge to lgpio's alert callback.
+//  - Soft PWM: error in the period and high time of lgTxPwm() edges, as
+//    recorded by the simulator.
+//  - Rotary encoder: hal/rotaryEncoder.c, on the libgpiod stand-in,
+//    decoding scripted quadrature at up to 100k edges a second; counts
+//    the detents lost and the events the full line queues dropped.
+// Usage: gpiosimbench [SECONDS PER TEST]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "lgpio.h"
+#include "lgGpioSim.h"
+#include "common/timing.h"
+#include "hal/gpio.h"
+#include "hal/rotaryEncoder.h"
+
+#define LGPIO_CHIP 0
+#define ALERT_LINE 16
+#define PWM_LINE 17
+#define ALERT_INTERVAL_MS 1
+
+// As rotaryEncoder.c
+#define ENCODER_CHIP 2
+#define ENCODER_LINE_A 7
+#define ENCODER_LINE_B 8
+#define ENCODER_SETTLE_MS 50
+
+#define MAX_SAMPLES 100000
+
+static long long s_testNS = TIMING_NS_PER_SECOND;
+
+// Filled by the alert callback, on lgpio's alert thread
+static long long s_latenciesNS[MAX_SAMPLES];
+static volatile int s_numLatencies = 0;
+
+static lgSimWrite_t s_writes[LG_SIM_WRITE_BUF];
+static long long s_errorsNS[MAX_SAMPLES];
+
+static int compareLongLong(const void *pA, const void *pB)
+{
+    long long a = *(const long long *)pA;
+    long long b = *(const long long *)pB;
+    return (a > b) - (a < b);
+}
+
+// Sorts the samples
+static void printDistribution(const char *name, long long *pSamplesNS, int count)
+{
+    if (count == 0) {
+        printf("  %-24s no samples\n", name);
+        return;
+    }
+    qsort(pSamplesNS, count, sizeof(pSamplesNS[0]), compareLongLong);
+    long long sumNS = 0;
+    for (int i = 0; i < count; i++) {
+        sumNS += pSamplesNS[i];
+    }
+    printf("  %-24s %6d samples  mean %7.1f us  p50 %7.1f us  p99 %7.1f us  max %7.1f us\n",
+        name, count, sumNS / 1000.0 / count, pSamplesNS[count / 2] / 1000.0,
+        pSamplesNS[count * 99 / 100] / 1000.0, pSamplesNS[count - 1] / 1000.0);
+}
+
+static void onAlerts(int numAlerts, lgGpioAlert_p pAlerts, void *pUserdata)
+{
+    (void)pUserdata;
+    long long nowNS = Timing_getTimeNS();
+    for (int i = 0; i < numAlerts && s_numLatencies < MAX_SAMPLES; i++) {
+        s_latenciesNS[s_numLatencies++] = nowNS - (long long)pAlerts[i].report.timestamp;
+    }
+}
+
+static void benchAlerts(int handle)
+{
+    printf("lgpio alerts: edge to callback, an edge every %dms\n", ALERT_INTERVAL_MS);
+    lgGpioSetAlertsFunc(handle, ALERT_LINE, onAlerts, NULL);
+    if (lgGpioClaimAlert(handle, 0, LG_BOTH_EDGES, ALERT_LINE, -1) != LG_OKAY) {
+        printf("  failed to claim the alert\n");
+        exit(EXIT_FAILURE);
+    }
+
+    s_numLatencies = 0;
+    int level = 1;
+    Timing_deadline_t deadline;
+    Timing_deadlineStart(&deadline, ALERT_INTERVAL_MS * TIMING_NS_PER_MS);
+    long long startNS = Timing_getTimeNS();
+    while (Timing_getTimeNS() - startNS < s_testNS) {
+        level = !level;
+        lgGpioSimSetInput(LGPIO_CHIP, ALERT_LINE, level);
+        Timing_deadlineWait(&deadline);
+    }
+    Timing_sleepForMS(10);
+
+    int count = s_numLatencies;
+    printDistribution("latency", s_latenciesNS, count);
+    lgGpioFree(handle, ALERT_LINE);
+}
+
+// Collect the periods and high times of the PWM's recorded edges
+static void benchPwm(int handle, float frequencyHz)
+{
+    long long periodNS = (long long)(TIMING_NS_PER_SECOND / frequencyHz);
+    printf("lgpio soft PWM: %.0fHz, 50%%\n", frequencyHz);
+
+    lgGpioSimReadWrites(s_writes, LG_SIM_WRITE_BUF);
+    lgTxPwm(handle, PWM_LINE, frequencyHz, 50, 0, 0);
+    Timing_sleepForMS(s_testNS / TIMING_NS_PER_MS);
+    lgTxPwm(handle, PWM_LINE, 0, 0, 0, 0);
+    Timing_sleepForMS(10);
+    int numWrites = lgGpioSimReadWrites(s_writes, LG_SIM_WRITE_BUF);
+
+    long long lastRiseNS = -1;
+    int lastLevel = -1;
+    int numPeriods = 0;
+    int numHighs = 0;
+    static long long highErrorsNS[MAX_SAMPLES];
+    for (int i = 0; i < numWrites; i++) {
+        lgSimWrite_t *pWrite = &s_writes[i];
+        if (pWrite->chip != LGPIO_CHIP || pWrite->gpio != PWM_LINE || pWrite->level == lastLevel) {
+            continue;
+        }
+        long long timeNS = (long long)pWrite->timestamp;
+        if (pWrite->level) {
+            if (lastRiseNS >= 0 && numPeriods < MAX_SAMPLES) {
+                s_errorsNS[numPeriods++] = llabs(timeNS - lastRiseNS - periodNS);
+            }
+            lastRiseNS = timeNS;
+        } else if (lastRiseNS >= 0 && numHighs < MAX_SAMPLES) {
+            highErrorsNS[numHighs++] = llabs(timeNS - lastRiseNS - periodNS / 2);
+        }
+        lastLevel = pWrite->level;
+    }
+    printDistribution("period error", s_errorsNS, numPeriods);
+    printDistribution("high time error", highErrorsNS, numHighs);
+    lgGpioFree(handle, PWM_LINE);
+}
+
+// One detent clockwise, as rotaryEncoder.c decodes it: A falls, B falls,
+// A rises, B rises.
+static void benchEncoder(int edgesPerSecond)
+{
+    long long stepNS = TIMING_NS_PER_SECOND / edgesPerSecond;
+    int numDetents = (int)(s_testNS / stepNS / 4);
+    lgSimStep_t steps[] = {
+        {stepNS, ENCODER_LINE_A, 0},
+        {stepNS, ENCODER_LINE_B, 0},
+        {stepNS, ENCODER_LINE_A, 1},
+        {stepNS, ENCODER_LINE_B, 1},
+    };
+
+    lgGpioSimStats(NULL, 1);
+    int startValue = RotaryEncoder_getValue();
+    long long startNS = Timing_getTimeNS();
+    int script = lgGpioSimScript(ENCODER_CHIP, 4, steps, numDetents);
+    if (script < 0) {
+        printf("  failed to start the script\n");
+        exit(EXIT_FAILURE);
+    }
+    while (lgGpioSimScriptBusy(script)) {
+        Timing_sleepForMS(1);
+    }
+
+    // Until the decoder has caught up: no change for a while
+    int value = RotaryEncoder_getValue();
+    long long doneNS = Timing_getTimeNS();
+    long long quietSinceNS = doneNS;
+    while (Timing_getTimeNS() - quietSinceNS < ENCODER_SETTLE_MS * TIMING_NS_PER_MS) {
+        Timing_sleepForMS(1);
+        int newValue = RotaryEncoder_getValue();
+        if (newValue != value) {
+            value = newValue;
+            doneNS = Timing_getTimeNS();
+            quietSinceNS = doneNS;
+        }
+    }
+
+    lgSimStats_t stats;
+    lgGpioSimStats(&stats, 1);
+    int numDecoded = value - startValue;
+    printf("  %6d edges/s  %6d detents  %6d decoded  %5.1f%% lost  %7llu events dropped"
+        "  %7.1f ms behind  script late by %5.1f us at worst\n",
+        edgesPerSecond, numDetents, numDecoded, 100.0 * (numDetents - numDecoded) / numDetents,
+        (unsigned long long)stats.eventsDropped,
+        (doneNS - startNS - numDetents * 4 * stepNS) / 1e6, stats.scriptLateMax / 1000.0);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1) {
+        s_testNS = (long long)(atof(argv[1]) * TIMING_NS_PER_SECOND);
+    }
+
+    if (lgGpioSimStart() != LG_OKAY) {
+        printf("Failed to start the GPIO simulator\n");
+        return EXIT_FAILURE;
+    }
+
+    int handle = lgGpiochipOpen(LGPIO_CHIP);
+    if (handle < 0) {
+        printf("Failed to open gpiochip%d: %s\n", LGPIO_CHIP, lguErrorText(handle));
+        return EXIT_FAILURE;
+    }
+    benchAlerts(handle);
+    benchPwm(handle, 1000);
+    benchPwm(handle, 5000);
+    lgGpiochipClose(handle);
+
+    printf("Rotary encoder: scripted quadrature, %.1fs each\n", s_testNS / 1e9);
+    Gpio_initialize();
+    RotaryEncoder_init();
+    RotaryEncoder_setMaxValue(INT32_MAX);
+    const int rates[] = {1000, 10000, 50000, 100000};
+    for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        benchEncoder(rates[i]);
+    }
+    RotaryEncoder_cleanup();
+    Gpio_cleanup();
+
+    lgGpioSimStop();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,273 @@
+// Benchmark of the ways to drive the I2C devices, run on the simulator
+// (hal/i2cSim.h) so it needs no board; at its default latency the
+// timings are close to a 100kHz bus.
+//  - LIS3DH: a register per transfer (as accelerometer.c reads), against
+//    one burst read of all six output registers.
+//  - LIS3DH at 400Hz: polling STATUS_REG for each sample, against
+//    draining the FIFO; shows which keep up, and the samples lost.
+//  - TLA2024: a single-shot conversion per read (as joystick.c reads),
+//    against reading the result of continuous conversions.
+// Each also checks the values read against what the sensors were set to.
+// Usage: i2csimbench [SECONDS PER TEST] [BYTE NS]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "common/timing.h"
+#include "hal/i2c.h"
+#include "hal/i2cSim.h"
+
+#define BUS "/dev/i2c-1"
+
+#define LIS3DH_CTRL_REG1 0x20
+#define LIS3DH_CTRL_REG4 0x23
+#define LIS3DH_CTRL_REG5 0x24
+#define LIS3DH_STATUS_REG 0x27
+#define LIS3DH_OUT_X_L 0x28
+#define LIS3DH_FIFO_CTRL_REG 0x2E
+#define LIS3DH_FIFO_SRC_REG 0x2F
+#define LIS3DH_AUTO_INCREMENT 0x80
+
+#define LIS3DH_100HZ_XYZ 0x57
+#define LIS3DH_400HZ_XYZ 0x77
+#define ACCEL_STREAM_HZ 400
+#define LIS3DH_2G_HR 0x08
+#define LIS3DH_FIFO_EN 0x40
+#define LIS3DH_FIFO_STREAM 0x80
+#define LIS3DH_STATUS_ZYXDA 0x08
+#define LIS3DH_STATUS_ZYXOR 0x80
+#define LIS3DH_FIFO_OVRN 0x40
+#define LIS3DH_FIFO_FSS 0x1F
+
+#define TLA2024_REG_CONVERSION 0x00
+#define TLA2024_REG_CONFIG 0x01
+// AIN0, +-4.096V, 1600SPS; as joystick.c, low byte first
+#define TLA2024_SINGLE_SHOT_AIN0 0x83C2
+#define TLA2024_CONTINUOUS_AIN0 0x82C2
+#define JOYSTICK_SETTLE_US 5000
+
+#define TEST_ACCEL_G 0.5
+#define TEST_EXPECTED_RAW 8192      // 0.5g at +-2g
+#define TEST_VOLTS 1.65
+#define TEST_EXPECTED_CODE 825      // 1.65V at +-4.096V, 12 bits
+
+static long long s_testNS = TIMING_NS_PER_SECOND;
+static bool s_isAllCorrect = true;
+
+static void check(const char *what, int value, int expected, int tolerance)
+{
+    if (abs(value - expected) > tolerance) {
+        printf("  WRONG: %s read %d, expected %d\n", what, value, expected);
+        s_isAllCorrect = false;
+    }
+}
+
+static void printResult(const char *name, long long numReads, long long elapsedNS)
+{
+    I2cSim_stats_t stats;
+    I2cSim_getStatsAndClear(&stats);
+    double seconds = (double)elapsedNS / TIMING_NS_PER_SECOND;
+    printf("  %-28s %8.0f reads/s %7.1f us/read %6.1f transfers/read %5.1f%% bus busy\n",
+        name, numReads / seconds, elapsedNS / 1000.0 / numReads,
+        (double)stats.numTransfers / numReads, 100.0 * stats.busyNS / elapsedNS);
+}
+
+static int16_t getS16(const uint8_t *p)
+{
+    return (int16_t)(p[1] << 8 | p[0]);
+}
+
+static void benchAccelReads(void)
+{
+    printf("LIS3DH: reading X, Y and Z\n");
+    int fd = init_i2c_bus(BUS, I2C_SIM_LIS3DH_ADDRESS);
+    write_i2c_reg8(fd, LIS3DH_CTRL_REG4, LIS3DH_2G_HR);
+    write_i2c_reg8(fd, LIS3DH_CTRL_REG1, LIS3DH_100HZ_XYZ);
+    Timing_sleepForMS(20);
+
+    // A register per transfer
+    I2cSim_getStatsAndClear(&(I2cSim_stats_t){0});
+    long long numReads = 0;
+    long long startNS = Timing_getTimeNS();
+    uint8_t out[6];
+    while (Timing_getTimeNS() - startNS < s_testNS) {
+        for (int i = 0; i < 6; i++) {
+            out[i] = read_i2c_reg8(fd, LIS3DH_OUT_X_L + i);
+        }
+        numReads++;
+    }
+    printResult("register at a time", numReads, Timing_getTimeNS() - startNS);
+    check("per-register X", getS16(&out[0]), TEST_EXPECTED_RAW, 16);
+
+    // All six in one transfer
+    numReads = 0;
+    startNS = Timing_getTimeNS();
+    while (Timing_getTimeNS() - startNS < s_testNS) {
+        read_i2c_block(fd, LIS3DH_OUT_X_L | LIS3DH_AUTO_INCREMENT, out, sizeof(out));
+        numReads++;
+    }
+    printResult("burst read", numReads, Timing_getTimeNS() - startNS);
+    check("burst X", getS16(&out[0]), TEST_EXPECTED_RAW, 16);
+    check("burst Y", getS16(&out[2]), -TEST_EXPECTED_RAW, 16);
+    check("burst Z", getS16(&out[4]), 2 * TEST_EXPECTED_RAW, 16);
+
+    write_i2c_reg8(fd, LIS3DH_CTRL_REG1, 0);
+    close_i2c_bus(fd);
+}
+
+static void printSampling(const char *name, long long numSamples, long long numOverruns,
+    long long elapsedNS)
+{
+    I2cSim_stats_t stats;
+    I2cSim_getStatsAndClear(&stats);
+    double seconds = (double)elapsedNS / TIMING_NS_PER_SECOND;
+    long long numLost = (long long)(ACCEL_STREAM_HZ * seconds) - numSamples;
+    printf("  %-28s %6.0f samples/s %5lld lost %4lld overruns %5.1f transfers/sample %5.1f%% bus busy\n",
+        name, numSamples / seconds, numLost > 0 ? numLost : 0, numOverruns,
+        numSamples ? (double)stats.numTransfers / numSamples : 0,
+        100.0 * stats.busyNS / elapsedNS);
+}
+
+static void benchAccelStream(void)
+{
+    printf("LIS3DH: keeping up with 400Hz\n");
+    int fd = init_i2c_bus(BUS, I2C_SIM_LIS3DH_ADDRESS);
+    write_i2c_reg8(fd, LIS3DH_CTRL_REG4, LIS3DH_2G_HR);
+
+    // Poll STATUS_REG, then read each sample a register at a time
+    write_i2c_reg8(fd, LIS3DH_CTRL_REG1, LIS3DH_400HZ_XYZ);
+    I2cSim_getStatsAndClear(&(I2cSim_stats_t){0});
+    long long numSamples = 0;
+    long long numOverruns = 0;
+    long long startNS = Timing_getTimeNS();
+    while (Timing_getTimeNS() - startNS < s_testNS) {
+        uint8_t status = read_i2c_reg8(fd, LIS3DH_STATUS_REG);
+        if (!(status & LIS3DH_STATUS_ZYXDA)) {
+            continue;
+        }
+        numOverruns += (status & LIS3DH_STATUS_ZYXOR) != 0;
+        for (int i = 0; i < 6; i++) {
+            read_i2c_reg8(fd, LIS3DH_OUT_X_L + i);
+        }
+        numSamples++;
+    }
+    printSampling("poll, register at a time", numSamples, numOverruns, Timing_getTimeNS() - startNS);
+
+    // Poll STATUS_REG, then burst read each sample
+    numSamples = 0;
+    numOverruns = 0;
+    startNS = Timing_getTimeNS();
+    while (Timing_getTimeNS() - startNS < s_testNS) {
+        uint8_t status = read_i2c_reg8(fd, LIS3DH_STATUS_REG);
+        if (!(status & LIS3DH_STATUS_ZYXDA)) {
+            continue;
+        }
+        numOverruns += (status & LIS3DH_STATUS_ZYXOR) != 0;
+        uint8_t out[6];
+        read_i2c_block(fd, LIS3DH_OUT_X_L | LIS3DH_AUTO_INCREMENT, out, sizeof(out));
+        numSamples++;
+    }
+    printSampling("poll, burst read", numSamples, numOverruns, Timing_getTimeNS() - startNS);
+
+    // Stream into the FIFO; every 20ms read what's there in one transfer
+    write_i2c_reg8(fd, LIS3DH_CTRL_REG5, LIS3DH_FIFO_EN);
+    write_i2c_reg8(fd, LIS3DH_FIFO_CTRL_REG, LIS3DH_FIFO_STREAM);
+    I2cSim_getStatsAndClear(&(I2cSim_stats_t){0});
+    numSamples = 0;
+    numOverruns = 0;
+    uint8_t fifo[LIS3DH_FIFO_FSS * 6];
+    Timing_deadline_t deadline;
+    Timing_deadlineStart(&deadline, 20 * TIMING_NS_PER_MS);
+    startNS = Timing_getTimeNS();
+    while (Timing_getTimeNS() - startNS < s_testNS) {
+        Timing_deadlineWait(&deadline);
+        uint8_t src = read_i2c_reg8(fd, LIS3DH_FIFO_SRC_REG);
+        int count = src & LIS3DH_FIFO_FSS;
+        numOverruns += (src & LIS3DH_FIFO_OVRN) != 0;
+        if (count > 0) {
+            read_i2c_block(fd, LIS3DH_OUT_X_L | LIS3DH_AUTO_INCREMENT, fifo, count * 6);
+            numSamples += count;
+        }
+    }
+    printSampling("FIFO drained every 20ms", numSamples, numOverruns, Timing_getTimeNS() - startNS);
+    check("FIFO X", getS16(&fifo[0]), TEST_EXPECTED_RAW, 16);
+    check("FIFO Z", getS16(&fifo[4]), 2 * TEST_EXPECTED_RAW, 16);
+
+    write_i2c_reg8(fd, LIS3DH_FIFO_CTRL_REG, 0);
+    write_i2c_reg8(fd, LIS3DH_CTRL_REG5, 0);
+    write_i2c_reg8(fd, LIS3DH_CTRL_REG1, 0);
+    close_i2c_bus(fd);
+}
+
+// As joystick.c: the result comes back high byte first
+static int readConversion(int fd)
+{
+    uint16_t raw = read_i2c_reg16(fd, TLA2024_REG_CONVERSION);
+    uint16_t value = ((raw & 0xFF) << 8) | ((raw & 0xFF00) >> 8);
+    return (int16_t)value >> 4;
+}
+
+static void benchJoystick(void)
+{
+    printf("TLA2024: reading AIN0\n");
+    I2cSim_getStatsAndClear(&(I2cSim_stats_t){0});
+
+    // Open, start a conversion, wait for it, read and close each time
+    long long numReads = 0;
+    int value = 0;
+    long long startNS = Timing_getTimeNS();
+    while (Timing_getTimeNS() - startNS < s_testNS) {
+        int fd = init_i2c_bus(BUS, I2C_SIM_TLA2024_ADDRESS);
+        write_i2c_reg16(fd, TLA2024_REG_CONFIG, TLA2024_SINGLE_SHOT_AIN0);
+        usleep(JOYSTICK_SETTLE_US);
+        value = readConversion(fd);
+        close_i2c_bus(fd);
+        numReads++;
+    }
+    printResult("single-shot, as joystick.c", numReads, Timing_getTimeNS() - startNS);
+    check("single-shot", value, TEST_EXPECTED_CODE, 1);
+
+    // Configure once; each read takes the latest conversion
+    int fd = init_i2c_bus(BUS, I2C_SIM_TLA2024_ADDRESS);
+    write_i2c_reg16(fd, TLA2024_REG_CONFIG, TLA2024_CONTINUOUS_AIN0);
+    usleep(1000);
+    I2cSim_getStatsAndClear(&(I2cSim_stats_t){0});
+    numReads = 0;
+    startNS = Timing_getTimeNS();
+    while (Timing_getTimeNS() - startNS < s_testNS) {
+        value = readConversion(fd);
+        numReads++;
+    }
+    printResult("continuous", numReads, Timing_getTimeNS() - startNS);
+    check("continuous", value, TEST_EXPECTED_CODE, 1);
+    close_i2c_bus(fd);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1) {
+        s_testNS = (long long)(atof(argv[1]) * TIMING_NS_PER_SECOND);
+    }
+
+    I2cSim_init();
+    set_i2c_backend(I2cSim_getBackend());
+    if (argc > 2) {
+        long long byteNS = atoll(argv[2]);
+        I2cSim_setBusLatency(I2C_SIM_DEFAULT_TRANSFER_NS, byteNS);
+    }
+    I2cSim_setAcceleration(TEST_ACCEL_G, -TEST_ACCEL_G, 2 * TEST_ACCEL_G);
+    I2cSim_setAnalogInput(0, TEST_VOLTS);
+
+    benchAccelReads();
+    benchAccelStream();
+    benchJoystick();
+
+    set_i2c_backend(NULL);
+    I2cSim_cleanup();
+
+    printf(s_isAllCorrect ? "All values read correctly\n" : "Some values were WRONG\n");
+    return s_isAllCorrect ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -11,6 +11,9 @@
 ******************************************************************************/
 #include "DEV_Config.h"
 
+#include <time.h>
+#include <fcntl.h>
+
 #if USE_DEV_LIB
 #include <lgpio.h>
 
@@ -22,15 +25,17 @@ typedef struct {
     int gpiochip;   // The GPIO chip number (e.g., 1, 2)
     int handle;     // The GPIO handle, after being claimed
     int line;       // The line number within the gpiochip
+    int level;      // Last level written, -1 if unknown
+    int groupBit;   // Bit within the control group, -1 if not grouped
 } DEV_GPIO_Pin;
 
 // Define the GPIO pins based on your BeagleY-AI mappings
 // DEV_GPIO_Pin LCD_DC_PIN  = {1, -1, 42}; // DS is GPIO25 on gpiochip1 line 42
 // DEV_GPIO_Pin LCD_RST_PIN = {1, -1, 33}; // RST is GPIO27 on gpiochip1 line 33
 // DEV_GPIO_Pin LCD_BL_PIN  = {2, -1, 11}; // BL is GPIO18 on gpiochip2 line 11
-DEV_GPIO_Pin LCD_DC_PIN  = {1, -1, 33}; // DS  is GPIO27 on gpiochip1 line 33
-DEV_GPIO_Pin LCD_RST_PIN = {1, -1, 41}; // RST is GPIO22 on gpiochip1 line 41
-DEV_GPIO_Pin LCD_BL_PIN  = {2, -1, 18}; // BL  is GPIO13 on gpiochip2 line 18
+DEV_GPIO_Pin LCD_DC_PIN  = {1, -1, 33, -1, -1}; // DS  is GPIO27 on gpiochip1 line 33
+DEV_GPIO_Pin LCD_RST_PIN = {1, -1, 41, -1, -1}; // RST is GPIO22 on gpiochip1 line 41
+DEV_GPIO_Pin LCD_BL_PIN  = {2, -1, 18, -1, -1}; // BL  is GPIO13 on gpiochip2 line 18
 
 
 // Define the Pin constants
@@ -41,12 +46,163 @@ DEV_GPIO_Pin LCD_BL_PIN  = {2, -1, 18}; // BL  is GPIO13 on gpiochip2 line 18
 // Array to map Pin constants to DEV_GPIO_Pin structures
 DEV_GPIO_Pin* DEV_GPIOS[4]; // Index 0 unused
 
+// Control lines which share a gpiochip are claimed as one group
+// (leader first) so they can be changed with a single ioctl.
+#define DEV_GROUP_MAX 3
+static int DEV_GroupHandle = -1;
+static int DEV_GroupSize = 0;
+static int DEV_GroupLines[DEV_GROUP_MAX];
+
+// Backlight PWM: software PWM on LCD_BL unless DEV_BL_PWM_CHIP and
+// DEV_BL_PWM_CHANNEL name the sysfs channel routed to it. The channel is
+// board specific, so none is assumed.
+#ifndef DEV_BL_PWM_CHIP
+#define DEV_BL_PWM_CHIP -1
 #endif
+#ifndef DEV_BL_PWM_CHANNEL
+#define DEV_BL_PWM_CHANNEL 0
+#endif
+#define DEV_BL_PWM_PERIOD_NS 1000000    // 1kHz
+#define DEV_BL_SOFT_PWM_HZ   200        // lgTxPwm() toggles from a thread
+
+static int DEV_BL_DutyFd = -1;          // pwmN/duty_cycle, on hardware PWM
+static int DEV_BL_SoftPwm = 0;          // lgTxPwm() running on LCD_BL
+static int DEV_BL_Value = -1;           // Last value set, -1 if unknown
+
+#endif
+
+/**
+ * Write Value to a sysfs attribute; 0 on success
+**/
+static int DEV_Sysfs_Write(const char *Path, const char *Value)
+{
+    int fd = open(Path, O_WRONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    int len = strlen(Value);
+    int written = write(fd, Value, len);
+    close(fd);
+    return written == len ? 0 : -1;
+}
 
+/**
+ * Claim the hardware PWM channel, if configured, off. Without one,
+ * DEV_SetBacklight() falls back to software PWM.
+**/
+static void DEV_Backlight_Init(void)
+{
+#ifdef USE_DEV_LIB
+    char path[64];
+    char value[16];
+
+    DEV_BL_DutyFd = -1;
+    DEV_BL_SoftPwm = 0;
+    DEV_BL_Value = -1;
+    if (DEV_BL_PWM_CHIP < 0) {
+        return;
+    }
+
+    snprintf(path, sizeof(path), "/sys/class/pwm/pwmchip%d/pwm%d",
+             DEV_BL_PWM_CHIP, DEV_BL_PWM_CHANNEL);
+    if (access(path, F_OK) != 0) {
+        char exportPath[64];
+        snprintf(exportPath, sizeof(exportPath), "/sys/class/pwm/pwmchip%d/export",
+                 DEV_BL_PWM_CHIP);
+        snprintf(value, sizeof(value), "%d", DEV_BL_PWM_CHANNEL);
+        DEV_Sysfs_Write(exportPath, value);
+    }
+
+    // The duty cycle may never exceed the period, so it goes to 0 first.
+    char attrPath[80];
+    snprintf(attrPath, sizeof(attrPath), "%s/duty_cycle", path);
+    int ok = DEV_Sysfs_Write(attrPath, "0") == 0;
+    snprintf(attrPath, sizeof(attrPath), "%s/period", path);
+    snprintf(value, sizeof(value), "%d", DEV_BL_PWM_PERIOD_NS);
+    ok = ok && DEV_Sysfs_Write(attrPath, value) == 0;
+    snprintf(attrPath, sizeof(attrPath), "%s/enable", path);
+    ok = ok && DEV_Sysfs_Write(attrPath, "1") == 0;
+    if (ok) {
+        snprintf(attrPath, sizeof(attrPath), "%s/duty_cycle", path);
+        DEV_BL_DutyFd = open(attrPath, O_WRONLY);
+    }
+    if (DEV_BL_DutyFd < 0) {
+        printf("No backlight PWM at %s, using software PWM\n", path);
+        return;
+    }
+    // The PWM has the backlight now; the GPIO mustn't hold it on.
+    DEV_Digital_Write(LCD_BL, 0);
+#endif
+}
+
+static void DEV_Backlight_Exit(void)
+{
+#ifdef USE_DEV_LIB
+    if (DEV_BL_DutyFd >= 0) {
+        char path[80];
+        snprintf(path, sizeof(path), "/sys/class/pwm/pwmchip%d/pwm%d/enable",
+                 DEV_BL_PWM_CHIP, DEV_BL_PWM_CHANNEL);
+        DEV_Sysfs_Write(path, "0");
+        close(DEV_BL_DutyFd);
+        DEV_BL_DutyFd = -1;
+    }
+    if (DEV_BL_SoftPwm) {
+        lgTxPwm(LCD_BL_PIN.handle, LCD_BL_PIN.line, 0, 0, 0, 0);
+        DEV_BL_SoftPwm = 0;
+    }
+    DEV_BL_Value = -1;
+#endif
+}
+
+/**
+ * Set the backlight's brightness.
+ * parameter:
+ *     Value: 0 (off) to DEV_BACKLIGHT_MAX
+ * Software PWM is only used between off and full: those are held with
+ * the pin. A grouped pin can't be pulsed, so is only switched.
+**/
 void DEV_SetBacklight(UWORD Value)
 {
 #ifdef USE_DEV_LIB
-    DEV_Digital_Write(LCD_BL, Value);
+    if (Value > DEV_BACKLIGHT_MAX) {
+        Value = DEV_BACKLIGHT_MAX;
+    }
+    if (Value == DEV_BL_Value) {
+        return;
+    }
+    DEV_BL_Value = Value;
+
+    if (DEV_BL_DutyFd >= 0) {
+        // LCD_Panel_Init() switches the GPIO on; it stays off under PWM.
+        DEV_Digital_Write(LCD_BL, 0);
+        char duty[16];
+        int len = snprintf(duty, sizeof(duty), "%lu",
+                           (unsigned long)DEV_BL_PWM_PERIOD_NS * Value / DEV_BACKLIGHT_MAX);
+        if (pwrite(DEV_BL_DutyFd, duty, len, 0) != len) {
+            DEV_BL_Value = -1;
+        }
+        return;
+    }
+
+    if (Value == 0 || Value == DEV_BACKLIGHT_MAX || LCD_BL_PIN.groupBit >= 0) {
+        if (DEV_BL_SoftPwm) {
+            lgTxPwm(LCD_BL_PIN.handle, LCD_BL_PIN.line, 0, 0, 0, 0);
+            DEV_BL_SoftPwm = 0;
+            // The pulses left the pin at either level
+            LCD_BL_PIN.level = -1;
+        }
+        DEV_Digital_Write(LCD_BL, Value != 0);
+        return;
+    }
+
+    // A new setting replaces the running one at the end of its cycle
+    if (lgTxPwm(LCD_BL_PIN.handle, LCD_BL_PIN.line, DEV_BL_SOFT_PWM_HZ,
+                100.0f * Value / DEV_BACKLIGHT_MAX, 0, 0) >= 0) {
+        DEV_BL_SoftPwm = 1;
+        LCD_BL_PIN.level = -1;
+    } else {
+        DEV_BL_Value = -1;
+    }
 #endif
 }
 
@@ -61,7 +217,58 @@ void DEV_Digital_Write(UWORD Pin, UBYTE Value)
         printf("Invalid GPIO Pin: %d\n", Pin);
         return;
     }
-    lgGpioWrite(gpio_pin->handle, gpio_pin->line, Value);
+    Value = Value ? 1 : 0;
+    // Skip the ioctl when the line is already at the requested level
+    if (gpio_pin->level == Value) {
+        return;
+    }
+    if (lgGpioWrite(gpio_pin->handle, gpio_pin->line, Value) == LG_OKAY) {
+        gpio_pin->level = Value;
+    } else {
+        gpio_pin->level = -1;
+    }
+#endif
+}
+
+/**
+ * Write several control pins at once.
+ * Mask/Levels hold one bit per pin constant (LCD_DC_MASK etc.).
+ * Pins already at the requested level are skipped, grouped pins
+ * go out in one lgGroupWrite() and the rest one at a time.
+**/
+void DEV_Digital_WriteMask(UBYTE Mask, UBYTE Levels)
+{
+#ifdef USE_DEV_LIB
+    uint64_t groupBits = 0;
+    uint64_t groupMask = 0;
+    UWORD Pin;
+
+    for (Pin = 1; Pin < 4; Pin++) {
+        DEV_GPIO_Pin* gpio_pin = DEV_GPIOS[Pin];
+        int Value = (Levels >> Pin) & 1;
+        if (!(Mask & (1 << Pin)) || gpio_pin == NULL || gpio_pin->level == Value) {
+            continue;
+        }
+        if (gpio_pin->groupBit >= 0) {
+            groupMask |= (uint64_t)1 << gpio_pin->groupBit;
+            if (Value) {
+                groupBits |= (uint64_t)1 << gpio_pin->groupBit;
+            }
+        } else {
+            DEV_Digital_Write(Pin, Value);
+        }
+    }
+
+    if (groupMask) {
+        int status = lgGroupWrite(DEV_GroupHandle, DEV_GroupLines[0], groupBits, groupMask);
+        for (Pin = 1; Pin < 4; Pin++) {
+            DEV_GPIO_Pin* gpio_pin = DEV_GPIOS[Pin];
+            if (gpio_pin != NULL && gpio_pin->groupBit >= 0
+                    && (groupMask & ((uint64_t)1 << gpio_pin->groupBit))) {
+                gpio_pin->level = (status < 0) ? -1 : (int)((groupBits >> gpio_pin->groupBit) & 1);
+            }
+        }
+    }
 #endif
 }
 
@@ -87,10 +294,13 @@ void DEV_GPIO_Mode(UWORD Pin, UWORD Mode)
         printf("Invalid GPIO Pin: %d\n", Pin);
         return;
     }
+    gpio_pin->groupBit = -1;
     if(Mode == 0 || Mode == LG_SET_INPUT){
         lgGpioClaimInput(gpio_pin->handle, LFLAGS, gpio_pin->line);
+        gpio_pin->level = -1;
     } else {
         lgGpioClaimOutput(gpio_pin->handle, LFLAGS, gpio_pin->line, LG_LOW);
+        gpio_pin->level = 0;
     }
 #endif   
 }
@@ -101,15 +311,73 @@ void DEV_GPIO_Mode(UWORD Pin, UWORD Mode)
 void DEV_Delay_ms(UDOUBLE xms)
 {
 #ifdef USE_DEV_LIB  
-    lguSleep(xms/1000.0);
+    DEV_Delay_Until(DEV_Deadline_ms(xms));
 #endif
 }
 
+/**
+ * deadline x ms from now (monotonic ns), for DEV_Delay_Until()
+**/
+uint64_t DEV_Deadline_ms(UDOUBLE xms)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec
+        + (uint64_t)xms * 1000000;
+}
+
+/**
+ * delay until a deadline from DEV_Deadline_ms();
+ * work done since taking the deadline comes off the delay
+**/
+void DEV_Delay_Until(uint64_t Deadline)
+{
+    struct timespec ts = {
+        Deadline / 1000000000,
+        Deadline % 1000000000
+    };
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
 static void DEV_GPIO_Init(void)
 {
-    DEV_GPIO_Mode(LCD_RST, 1);
-    DEV_GPIO_Mode(LCD_DC, 1);
-    DEV_GPIO_Mode(LCD_BL, 1);
+#ifdef USE_DEV_LIB
+    // Group every output pin on the DC pin's chip (DC leads the group)
+    static const UWORD groupOrder[] = {LCD_DC, LCD_RST, LCD_BL};
+    int levels[DEV_GROUP_MAX] = {0};
+    DEV_GPIO_Pin* members[DEV_GROUP_MAX];
+    UWORD i;
+
+    DEV_GroupHandle = LCD_DC_PIN.handle;
+    DEV_GroupSize = 0;
+    for (i = 0; i < sizeof(groupOrder) / sizeof(groupOrder[0]); i++) {
+        DEV_GPIO_Pin* gpio_pin = DEV_GPIOS[groupOrder[i]];
+        if (gpio_pin->gpiochip == LCD_DC_PIN.gpiochip) {
+            members[DEV_GroupSize] = gpio_pin;
+            DEV_GroupLines[DEV_GroupSize] = gpio_pin->line;
+            DEV_GroupSize++;
+        }
+    }
+
+    if (DEV_GroupSize > 1 &&
+            lgGroupClaimOutput(DEV_GroupHandle, LFLAGS, DEV_GroupSize,
+                               DEV_GroupLines, levels) == LG_OKAY) {
+        for (i = 0; i < DEV_GroupSize; i++) {
+            members[i]->groupBit = i;
+            members[i]->level = 0;
+        }
+    } else {
+        DEV_GroupSize = 0;
+        DEV_GPIO_Mode(LCD_RST, 1);
+        DEV_GPIO_Mode(LCD_DC, 1);
+    }
+
+    if (LCD_BL_PIN.groupBit < 0) {
+        DEV_GPIO_Mode(LCD_BL, 1);
+    }
+#endif
 }
 
 UBYTE DEV_ModuleInit(void)
@@ -156,6 +424,7 @@ UBYTE DEV_ModuleInit(void)
         return -1;
     }
     DEV_GPIO_Init();
+    DEV_Backlight_Init();
 
 #else
     printf("  --> OOPS!\n");
@@ -172,18 +441,62 @@ void DEV_SPI_WriteByte(uint8_t Value)
 #endif
 }
 
+/**
+ * Write Len bytes, as few transfers as spidev allows
+**/
 void DEV_SPI_Write_nByte(uint8_t *pData, uint32_t Len)
 {
 #ifdef USE_DEV_LIB 
-    lgSpiWrite(SPI_Handle, (char*)pData, Len);
+    while (Len > 0) {
+        uint32_t Chunk = Len < DEV_SPI_MAX_LEN ? Len : DEV_SPI_MAX_LEN;
+        lgSpiWrite(SPI_Handle, (char*)pData, Chunk);
+        pData += Chunk;
+        Len -= Chunk;
+    }
 #endif
 }
 
+/**
+ * Send a command byte (DC low), then all its parameters (DC high) in a
+ * second SPI transfer. DC is a GPIO, so it can't change within one.
+**/
+void DEV_SPI_WriteCommand(UBYTE Cmd, const UBYTE *pData, UDOUBLE Len)
+{
+    DEV_Digital_Write(LCD_DC, 0);
+    DEV_SPI_WriteByte(Cmd);
+    if (Len > 0) {
+        DEV_Digital_Write(LCD_DC, 1);
+        DEV_SPI_Write_nByte((uint8_t *)pData, Len);
+    }
+}
+
+/**
+ * Run a command stream (see DEV_CMD_DELAY in DEV_Config.h).
+**/
+void DEV_SPI_WriteCommandStream(const UBYTE *pStream, UDOUBLE Len)
+{
+    const UBYTE *pEnd = pStream + Len;
+    while (pStream < pEnd) {
+        UBYTE Count = pStream[1] & ~DEV_CMD_DELAY;
+        DEV_SPI_WriteCommand(pStream[0], &pStream[2], Count);
+        if (pStream[1] & DEV_CMD_DELAY) {
+            DEV_Delay_ms(pStream[2 + Count]);
+            pStream++;
+        }
+        pStream += 2 + Count;
+    }
+}
+
 void DEV_ModuleExit(void)
 {
 #ifdef USE_DEV_LIB 
+    DEV_Backlight_Exit();
     lgSpiClose(SPI_Handle);
     lgGpiochipClose(GPIO_Handle1);
     lgGpiochipClose(GPIO_Handle2);
+
+    LCD_DC_PIN.level = LCD_RST_PIN.level = LCD_BL_PIN.level = -1;
+    LCD_DC_PIN.groupBit = LCD_RST_PIN.groupBit = LCD_BL_PIN.groupBit = -1;
+    DEV_GroupSize = 0;
 #endif
 }
@@ -57,8 +57,27 @@ Define the pin constants to match those in DEV_Config.c
 #define LCD_BL_0        DEV_Digital_Write(LCD_BL, 0)
 #define LCD_BL_1        DEV_Digital_Write(LCD_BL, 1)
 
-// Backlight control
+// Masks for DEV_Digital_WriteMask(), one bit per pin constant
+#define LCD_RST_MASK    (1 << LCD_RST)
+#define LCD_DC_MASK     (1 << LCD_DC)
+#define LCD_BL_MASK     (1 << LCD_BL)
+
+// Backlight control: 0 is off, DEV_BACKLIGHT_MAX full brightness.
+// Driven by lgpio's software PWM on LCD_BL, or by a hardware PWM channel
+// (/sys/class/pwm) when DEV_BL_PWM_CHIP is set to the one wired to it.
 #define LCD_SetBacklight(Value) DEV_SetBacklight(Value)
+#define DEV_BACKLIGHT_MAX 1023
+
+// Command stream for DEV_SPI_WriteCommandStream():
+//   each entry is CMD, N, then N parameter bytes;
+//   with DEV_CMD_DELAY in N, a byte of MS follows the parameters
+//   and the command is followed by a pause of MS milliseconds.
+// The stream's length ends it, so any byte may be a command.
+#define DEV_CMD_DELAY    0x80
+
+// Largest single SPI transfer: spidev's default bufsiz.
+// DEV_SPI_Write_nByte() splits longer writes.
+#define DEV_SPI_MAX_LEN  4096
 
 /*------------------------------------------------------------------------------------------------------*/
 UBYTE DEV_ModuleInit(void);
@@ -66,11 +85,16 @@ void DEV_ModuleExit(void);
 
 void DEV_GPIO_Mode(UWORD Pin, UWORD Mode);
 void DEV_Digital_Write(UWORD Pin, UBYTE Value);
+void DEV_Digital_WriteMask(UBYTE Mask, UBYTE Levels);
 UBYTE DEV_Digital_Read(UWORD Pin);
 void DEV_Delay_ms(UDOUBLE xms);
+uint64_t DEV_Deadline_ms(UDOUBLE xms);
+void DEV_Delay_Until(uint64_t Deadline);
 
 void DEV_SPI_WriteByte(UBYTE Value);
 void DEV_SPI_Write_nByte(uint8_t *pData, uint32_t Len);
+void DEV_SPI_WriteCommand(UBYTE Cmd, const UBYTE *pData, UDOUBLE Len);
+void DEV_SPI_WriteCommandStream(const UBYTE *pStream, UDOUBLE Len);
 void DEV_SetBacklight(UWORD Value);
 
 #endif
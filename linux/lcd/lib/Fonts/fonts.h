@@ -51,12 +51,37 @@
 /* Includes ------------------------------------------------------------------*/
 #include <stdint.h>
 
+//Glyph of a packed font: the box around its set pixels, bit-packed row
+//after row with no padding, starting on a byte of its own
+typedef struct
+{
+  uint16_t Offset;      //First byte of the glyph in Data
+  uint8_t Left;         //Top left of the box in the Width x Height cell
+  uint8_t Top;
+  uint8_t Columns;      //0 for a blank glyph or one left out of the font
+  uint8_t Rows;
+} sGLYPH;
+
+//Largest glyph a packed font may have
+#define PACKED_FONT_MAX_WIDTH   32
+#define PACKED_FONT_MAX_HEIGHT  64
+
+//Font packed at build time by tools/fontpack.c, decoded by GUI_Font.c
+typedef struct
+{
+  const uint8_t *Data;
+  const sGLYPH *Glyphs;   //One for each character from First to Last
+  uint8_t First;
+  uint8_t Last;
+} sFONT_PACKED;
+
 //ASCII
 typedef struct _tFont
 {    
   const uint8_t *table;
   uint16_t Width;
   uint16_t Height;
+  const sFONT_PACKED *Packed;   //Used instead of table when set
   
 } sFONT;
 
@@ -84,6 +109,33 @@ extern sFONT Font20;
 extern sFONT Font16;
 extern sFONT Font12;
 extern sFONT Font8;
+extern sFONT Font48;
+extern sFONT Font50;
+
+//Packed copies of the fonts above, generated when the library is built
+//(see LCD_PACKED_FONTS and LCD_FONT_CHARS in lcd/CMakeLists.txt, which
+//defines LCD_HAS_FONTNN_PACKED for each one generated)
+#ifdef LCD_HAS_FONT50_PACKED
+extern sFONT Font50_Packed;
+#endif
+#ifdef LCD_HAS_FONT48_PACKED
+extern sFONT Font48_Packed;
+#endif
+#ifdef LCD_HAS_FONT24_PACKED
+extern sFONT Font24_Packed;
+#endif
+#ifdef LCD_HAS_FONT20_PACKED
+extern sFONT Font20_Packed;
+#endif
+#ifdef LCD_HAS_FONT16_PACKED
+extern sFONT Font16_Packed;
+#endif
+#ifdef LCD_HAS_FONT12_PACKED
+extern sFONT Font12_Packed;
+#endif
+#ifdef LCD_HAS_FONT8_PACKED
+extern sFONT Font8_Packed;
+#endif
 
 extern cFONT Font12CN;
 extern cFONT Font24CN;
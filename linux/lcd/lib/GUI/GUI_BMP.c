@@ -3,7 +3,7 @@
 * | Author      :   Waveshare team
 * | Function    :   Hardware underlying interface
 * | Info        :
-*                Used to shield the underlying layers of each master 
+*                Used to shield the underlying layers of each master
 *                and enhance portability
 *----------------
 * |	This version:   V1.0
@@ -12,140 +12,274 @@
 *
 ******************************************************************************/
 #include "GUI_BMP.h"
-#include <stdio.h>	//fseek fread
+#include <stdio.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <stdint.h>
-#include <stdlib.h>	//memset
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 #include "GUI_Paint.h"
 // #include "GUI_Cache.h"
 
+#define BMP_TYPE            0x4D42  //"BM"
+#define BMP_BI_RGB          0
+#define BMP_BI_BITFIELDS    3
+#define BMP_MAX_SIZE        4096    //Widest or tallest image read
 
-UBYTE GUI_ReadBmp(const char *path)
+/*
+ * Rows are converted to panel-native RGB565: the big-endian byte order
+ * the frame buffer holds (see Paint_SetPixel) and the panel is sent.
+ */
+static inline UWORD BMP_Native(UBYTE r, UBYTE g, UBYTE b)
+{
+    UWORD Color = RGB(r, g, b);
+    return ((Color << 8) & 0xff00) | (Color >> 8);
+}
+
+static inline UWORD BMP_Swap(UWORD Color)
+{
+    return ((Color << 8) & 0xff00) | (Color >> 8);
+}
+
+/******************************************************************************
+function:	Convert one row of pixels to panel-native RGB565
+parameter:
+    pDst    :   Converted pixels
+    pSrc    :   Row in the file
+    Count   :   Number of pixels, from the start of the row
+******************************************************************************/
+static void BMP_Row24(UWORD *pDst, const UBYTE *pSrc, UDOUBLE Count)
 {
-    FILE *fp;                     //Define a file pointer 
-    BMPFILEHEADER bmpFileHeader;  //Define a bmp file header structure
-    BMPINF bmpInfoHeader;         //Define a bmp bitmap header structure 
-	//UBYTE rgbReversed;
-    // Binary file open
-    if((fp = fopen(path, "rb")) == NULL) { 	// fp = 0x00426aa0
+    UDOUBLE i = 0;
+#if defined(__ARM_NEON)
+    // 16 pixels at a time: deinterleave B,G,R, build each byte of the
+    // big-endian pixel, and interleave them back.
+    for (; i + 16 <= Count; i += 16) {
+        uint8x16x3_t bgr = vld3q_u8(pSrc + i * 3);
+        uint8x16x2_t out;
+        out.val[0] = vorrq_u8(vandq_u8(bgr.val[2], vdupq_n_u8(0xF8)),
+                              vshrq_n_u8(bgr.val[1], 5));
+        out.val[1] = vorrq_u8(vandq_u8(vshlq_n_u8(bgr.val[1], 3), vdupq_n_u8(0xE0)),
+                              vshrq_n_u8(bgr.val[0], 3));
+        vst2q_u8((uint8_t *)(pDst + i), out);
+    }
+#endif
+    for (; i < Count; i++) {
+        pDst[i] = BMP_Native(pSrc[i * 3 + 2], pSrc[i * 3 + 1], pSrc[i * 3]);
+    }
+}
+
+static void BMP_Row32(UWORD *pDst, const UBYTE *pSrc, UDOUBLE Count)
+{
+    UDOUBLE i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 16 <= Count; i += 16) {
+        uint8x16x4_t bgra = vld4q_u8(pSrc + i * 4);
+        uint8x16x2_t out;
+        out.val[0] = vorrq_u8(vandq_u8(bgra.val[2], vdupq_n_u8(0xF8)),
+                              vshrq_n_u8(bgra.val[1], 5));
+        out.val[1] = vorrq_u8(vandq_u8(vshlq_n_u8(bgra.val[1], 3), vdupq_n_u8(0xE0)),
+                              vshrq_n_u8(bgra.val[0], 3));
+        vst2q_u8((uint8_t *)(pDst + i), out);
+    }
+#endif
+    //The alpha (or padding) byte is dropped
+    for (; i < Count; i++) {
+        pDst[i] = BMP_Native(pSrc[i * 4 + 2], pSrc[i * 4 + 1], pSrc[i * 4]);
+    }
+}
+
+static void BMP_Row16(UWORD *pDst, const UBYTE *pSrc, UDOUBLE Count, UBYTE Is565)
+{
+    UDOUBLE i;
+    for (i = 0; i < Count; i++) {
+        UWORD data = pSrc[i * 2] | (pSrc[i * 2 + 1] << 8);
+        if (!Is565) {
+            //XRGB1555: widen green to 6 bits
+            UWORD g = (data >> 5) & 0x1f;
+            data = ((data & 0x7C00) << 1) | (((g << 1) | (g >> 4)) << 5) | (data & 0x1f);
+        }
+        pDst[i] = BMP_Swap(data);
+    }
+}
+
+static void BMP_RowPalette(UWORD *pDst, const UBYTE *pSrc, UDOUBLE Count,
+                           UWORD BitCount, const UWORD *pPalette)
+{
+    UDOUBLE i;
+    for (i = 0; i < Count; i++) {
+        UBYTE index;
+        if (BitCount == 8) {
+            index = pSrc[i];
+        } else if (BitCount == 4) {
+            index = (pSrc[i / 2] >> ((i & 1) ? 0 : 4)) & 0x0f;
+        } else {
+            index = (pSrc[i / 8] >> (7 - (i & 7))) & 0x01;
+        }
+        pDst[i] = pPalette[index];
+    }
+}
+
+/******************************************************************************
+function:	Draw a BMP file into the selected image, its top left corner at
+            (Xstart, Ystart); whatever falls outside the image is clipped.
+            1/4/8-bit palettized, 16-bit (RGB565 or XRGB1555), 24-bit and
+            32-bit images, stored bottom-up or top-down, are supported.
+parameter:
+    path    :   File to read
+    Xstart  :   X coordinate of the image's left edge
+    Ystart  :   Y coordinate of the image's top edge
+return:     0 on success, 1 if the file can't be read or isn't supported
+******************************************************************************/
+UBYTE GUI_ReadBmp_Offset(const char *path, UWORD Xstart, UWORD Ystart)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
         DEBUG("Cann't open the file!\n");
+        return 1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)(sizeof(BMPFILEHEADER) + sizeof(BMPINF))) {
+        DEBUG("Not a BMP file: %s\n", path);
+        close(fd);
+        return 1;
+    }
+
+    size_t size = st.st_size;
+    const UBYTE *pFile = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (pFile == MAP_FAILED) {
+        DEBUG("Cann't map the file!\n");
+        return 1;
+    }
+
+    BMPFILEHEADER bmpFileHeader;
+    BMPINF bmpInfoHeader;
+    memcpy(&bmpFileHeader, pFile, sizeof(bmpFileHeader));
+    memcpy(&bmpInfoHeader, pFile + sizeof(bmpFileHeader), sizeof(bmpInfoHeader));
+
+    int32_t Width = (int32_t)bmpInfoHeader.bWidth;
+    int32_t Height = (int32_t)bmpInfoHeader.bHeight;
+    UWORD BitCount = bmpInfoHeader.bBitCount;
+
+    //A negative height means the rows are stored top-down
+    UBYTE TopDown = Height < 0;
+    if (TopDown) {
+        Height = -Height;
+    }
+
+    UBYTE Supported =
+        bmpFileHeader.bType == BMP_TYPE &&
+        bmpInfoHeader.bInfoSize >= sizeof(BMPINF) &&
+        Width > 0 && Width <= BMP_MAX_SIZE && Height > 0 && Height <= BMP_MAX_SIZE &&
+        (BitCount == 1 || BitCount == 4 || BitCount == 8 ||
+         BitCount == 16 || BitCount == 24 || BitCount == 32) &&
+        (bmpInfoHeader.bCompression == BMP_BI_RGB ||
+         (bmpInfoHeader.bCompression == BMP_BI_BITFIELDS && BitCount >= 16));
+
+    //In Windows each row data must be divisible by 4 byte
+    size_t Stride = (((size_t)Width * BitCount + 31) / 32) * 4;
+    if (!Supported ||
+            bmpFileHeader.bOffset > size ||
+            Stride * Height > size - bmpFileHeader.bOffset) {
+        DEBUG("Unsupported or truncated BMP file: %s\n", path);
+        munmap((void *)pFile, size);
+        return 1;
+    }
+
+    //Palette, converted once, Max 256 color information
+    UWORD Palette[256] = {0};
+    if (BitCount <= 8) {
+        size_t PaletteAt = sizeof(BMPFILEHEADER) + bmpInfoHeader.bInfoSize;
+        UDOUBLE Colors = bmpInfoHeader.bClrUsed ? bmpInfoHeader.bClrUsed : (1u << BitCount);
+        if (Colors > 256) {
+            Colors = 256;
+        }
+        UDOUBLE i;
+        for (i = 0; i < Colors && PaletteAt + i * 4 + 3 <= size; i++) {
+            const UBYTE *pQuad = pFile + PaletteAt + i * 4;
+            Palette[i] = BMP_Native(pQuad[2], pQuad[1], pQuad[0]);
+        }
+    }
+
+    //16-bit: the masks say which of RGB565 and XRGB1555 it is
+    UBYTE Is565 = 0;
+    if (BitCount == 16) {
+        if (bmpInfoHeader.bCompression == BMP_BI_BITFIELDS) {
+            size_t MasksAt = sizeof(BMPFILEHEADER) + sizeof(BMPINF);
+            UDOUBLE GreenMask = 0;
+            if (MasksAt + 8 <= size) {
+                memcpy(&GreenMask, pFile + MasksAt + 4, sizeof(GreenMask));
+            }
+            Is565 = GreenMask == 0x07E0;
+        } else {
+            //A V3 header (0x38) has only been seen with RGB565
+            Is565 = bmpInfoHeader.bInfoSize == 0x38;
+        }
+    }
+
+    //Clip to the selected image
+    int32_t Columns = Width;
+    if (Xstart >= Paint.Width || Ystart >= Paint.Height) {
+        munmap((void *)pFile, size);
         return 0;
     }
-    printf("open:%s \n",path);
-    
-    fseek(fp, 0, SEEK_SET); 								//Set the file pointer from the beginning	
-    fread(&bmpFileHeader, sizeof(BMPFILEHEADER), 1, fp);	//Gets the BMP file header
-	fread(&bmpInfoHeader, sizeof(BMPINF), 1, fp);			//Gets BMP Info Header
-	printf("bBitCount=%d \n",bmpInfoHeader.bBitCount);		//Print a pixel takes several bit!!!
-	
-	
-	//Get palette information, Max 256 color information
-	//You can use the malloc function to reduce the memory required to run this program
-	/*
-			bBitCount	RGBPAD
-				1		   2
-				4		  16
-				8		 256
-	 */
-	RGBQUAD RGBPAD[256];	
-	if(bmpInfoHeader.bBitCount<16)
-	{	
-		
-		uint16_t i=0;
-		for(i=0;i<(1<<(bmpInfoHeader.bBitCount));i++)
-		{
-			fseek(fp,(0X36)+(i*4), SEEK_SET);
-			fread(&RGBPAD[i], sizeof(RGBQUAD), 1, fp);			
-		}
-	}
-	
-	//In Windows each row data must be divisible by 4 byte
-	//Calculate how many bytes per row of data need to be indented
-
-	int32_t  indent;
-	if(bmpInfoHeader.bBitCount<8)	indent=(4-((bmpInfoHeader.bWidth/(8/bmpInfoHeader.bBitCount))%4))%4;
-	else 							indent=(4-((bmpInfoHeader.bWidth*(bmpInfoHeader.bBitCount/8))%4))%4;
-	
-	
-	int 		row, col; 	
-    short 		data;			//All data formats are converted to RGB565 format
-	char		pixels,temp;		
-	int len  = 	bmpInfoHeader.bBitCount / 8;
-	ARGBQUAD 	argb;
-	/*
-	fseek(fp, bmpFileHeader.bOffset, SEEK_SET);
-	printf("frist add:0x%x \r\n",bmpFileHeader.bOffset);
-	printf("BMP height:%d\r\n",bmpInfoHeader.bHeight);
-	printf("BMP width :%d\r\n",bmpInfoHeader.bWidth);
-	*/
-	// get bmp data and show
-	for(row = 0; row < bmpInfoHeader.bHeight;row++) 
-	{		
-		for(col = 0; col < bmpInfoHeader.bWidth; ) 
-		{
-			if(bmpInfoHeader.bBitCount==16)
-			{
-				if(fread((char *)&data, 1, len, fp) != len)
-				{
-					perror("get bmpdata:\r\n");
-					break;
-				}  
-				//ARGB4444 format cannot be recognized for the time being. It can only be used to identify RGB565 format information!!
-				if(bmpInfoHeader.bInfoSize==0x38)
-				{	
-					Paint_SetPixel(col, bmpInfoHeader.bHeight - row - 1, data);
-				}
-				//Used to identify the XRGB1555 format
-				else if((bmpInfoHeader.bInfoSize==0x28)&&(bmpInfoHeader.bCompression==0x00))
-				{
-					data=((((long)((data>>5)&0x1f)*0X3F)/0X1F)<<5)+(data&0x1f)+((data&0xEC00)<<1);
-					Paint_SetPixel(col, bmpInfoHeader.bHeight - row - 1, data);
-				}
-				col++;
-			}
-			//For RGB888 ARGB8888 XRGB8888 format uniform compression and removal of alpha
-			else if(bmpInfoHeader.bBitCount>16)
-			{
-				if(fread((char *)&argb, 1, len, fp) != len)
-				{
-					printf("x:%d,y:%d\r\n",col,row);
-					perror("get bmpdata: \r\n");
-					break;
-				}
-				data = RGB((argb.rgbRed), (argb.rgbGreen), (argb.rgbBlue));
-				Paint_SetPixel(col, bmpInfoHeader.bHeight - row - 1, data);
-				col++;
-			}	
-			//bBitCount<8 format
-			else		
-			{
-				if(fread((char *)&pixels, 1, 1, fp) != 1)
-				{
-					perror("get bmpdata:\r\n");
-					break;
-				}
-				for(temp=0;(temp<(8/bmpInfoHeader.bBitCount))&&(col < bmpInfoHeader.bWidth);temp++,col++)
-				{
-					if(bmpInfoHeader.bBitCount==1){
-						data=(pixels<<temp)>>7;
-						data&=0x01;
-					}
-					else if(bmpInfoHeader.bBitCount==4){	
-						data=(pixels<<(temp*4))>>4;
-						data&=0x0f;					
-					}
-					else {data=pixels;}
-					data=RGB((RGBPAD[data].rgbRed), (RGBPAD[data].rgbGreen), (RGBPAD[data].rgbBlue));					
-					Paint_SetPixel(col, bmpInfoHeader.bHeight - row - 1, data);
-				}				
-			}	
-		}
-		//indent!4 byte alignment
-		fseek(fp, indent, SEEK_CUR);
-	}
-	
-	fclose(fp);
+    if (Columns > Paint.Width - Xstart) {
+        Columns = Paint.Width - Xstart;
+    }
+    int32_t Rows = Height;
+    if (Rows > Paint.Height - Ystart) {
+        Rows = Paint.Height - Ystart;
+    }
+
+    //Rows go straight into the frame buffer unless it is rotated or mirrored
+    UBYTE Direct = Paint.Rotate == ROTATE_0 && Paint.Mirror == MIRROR_NONE && Paint.Depth == 16;
+
+    UWORD RowBuf[BMP_MAX_SIZE];
+    const UBYTE *pData = pFile + bmpFileHeader.bOffset;
+    int32_t y;
+    for (y = 0; y < Rows; y++) {
+        const UBYTE *pRow = pData + Stride * (TopDown ? y : Height - 1 - y);
+        UWORD *pDst = Direct
+            ? Paint.Image + (UDOUBLE)(Ystart + y) * Paint.WidthByte + Xstart
+            : RowBuf;
+
+        switch (BitCount) {
+        case 32:
+            BMP_Row32(pDst, pRow, Columns);
+            break;
+        case 24:
+            BMP_Row24(pDst, pRow, Columns);
+            break;
+        case 16:
+            BMP_Row16(pDst, pRow, Columns, Is565);
+            break;
+        default:
+            BMP_RowPalette(pDst, pRow, Columns, BitCount, Palette);
+            break;
+        }
+
+        if (!Direct) {
+            int32_t x;
+            for (x = 0; x < Columns; x++) {
+                Paint_SetPixel(Xstart + x, Ystart + y, BMP_Swap(RowBuf[x]));
+            }
+        }
+    }
+
+    munmap((void *)pFile, size);
     return 0;
+}
+
+UBYTE GUI_ReadBmp(const char *path)
+{
+    return GUI_ReadBmp_Offset(path, 0, 0);
 }
\ No newline at end of file
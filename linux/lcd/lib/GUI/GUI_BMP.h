@@ -65,5 +65,7 @@ typedef struct ARGB_QUAD {
 } __attribute__ ((packed)) ARGBQUAD;
 /**************************************** end ***********************************************/
 
+//Draw a BMP file into the selected image; 0 on success, 1 on error
 UBYTE GUI_ReadBmp(const char *path);
+UBYTE GUI_ReadBmp_Offset(const char *path, UWORD Xstart, UWORD Ystart);
 #endif
\ No newline at end of file
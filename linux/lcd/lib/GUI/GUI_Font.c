@@ -0,0 +1,93 @@
+/*****************************************************************************
+* | File      	:   GUI_Font.c
+* | Function    :   Glyphs of the ASCII fonts, packed or not
+* | Info        :
+*                Like the rest of GUI_Paint, not thread safe: the cache is
+*                shared by everything that draws text.
+*----------------
+* |	This version:   V1.0
+* | Info        :   Basic version
+*
+******************************************************************************/
+#include "GUI_Font.h"
+
+#include <string.h>
+
+#define GUI_FONT_MAX_GLYPH_BYTES (PACKED_FONT_MAX_HEIGHT * (PACKED_FONT_MAX_WIDTH / 8))
+
+typedef struct {
+    const sFONT *Font;          //NULL while the slot is empty
+    char Ascii_Char;
+    UBYTE Glyph[GUI_FONT_MAX_GLYPH_BYTES];
+} GUI_FONT_SLOT;
+
+static GUI_FONT_SLOT GUI_Font_Cache[GUI_FONT_CACHE_SLOTS];
+
+//Drawn for characters a font doesn't have
+static const UBYTE GUI_Font_Blank[GUI_FONT_MAX_GLYPH_BYTES];
+
+/******************************************************************************
+function:	Decode a glyph of a packed font into the layout of an sFONT
+            table: Height rows, each padded to a whole byte
+parameter:
+    pOut    :   WidthByte x Height bytes
+    pGlyph  :   Glyph to decode
+    pData   :   Data of the font
+******************************************************************************/
+static void GUI_Font_Decode(UBYTE *pOut, const sGLYPH *pGlyph, const uint8_t *pData,
+                            UWORD WidthByte, UWORD Height)
+{
+    memset(pOut, 0, (UDOUBLE)WidthByte * Height);
+
+    const uint8_t *pBits = pData + pGlyph->Offset;
+    UDOUBLE Bit = 0;
+    UWORD Row, Column;
+    for (Row = 0; Row < pGlyph->Rows; Row++) {
+        UBYTE *pRow = pOut + (UDOUBLE)(pGlyph->Top + Row) * WidthByte;
+        for (Column = 0; Column < pGlyph->Columns; Column++, Bit++) {
+            if (pBits[Bit / 8] & (0x80 >> (Bit % 8))) {
+                UWORD X = pGlyph->Left + Column;
+                pRow[X / 8] |= 0x80 >> (X % 8);
+            }
+        }
+    }
+}
+
+/******************************************************************************
+function:	Find a glyph of a font
+parameter:
+    Font        :   Font to draw with
+    Ascii_Char  :   Character to draw
+return:     Font->Height rows of Font->Width pixels, each row padded to a
+            whole byte, most significant bit first. A glyph of a packed
+            font stays valid until GUI_FONT_CACHE_SLOTS more are looked up.
+******************************************************************************/
+const UBYTE *GUI_Font_GetGlyph(const sFONT *Font, char Ascii_Char)
+{
+    UWORD WidthByte = Font->Width / 8 + (Font->Width % 8 ? 1 : 0);
+    UBYTE Code = (UBYTE)Ascii_Char;
+
+    const sFONT_PACKED *Packed = Font->Packed;
+    if (Packed == NULL) {
+        //The tables hold ' ' to '~'
+        if (Code < ' ' || Code > '~') {
+            return GUI_Font_Blank;
+        }
+        return &Font->table[(UDOUBLE)(Code - ' ') * Font->Height * WidthByte];
+    }
+
+    if (Code < Packed->First || Code > Packed->Last
+            || Font->Width > PACKED_FONT_MAX_WIDTH || Font->Height > PACKED_FONT_MAX_HEIGHT) {
+        return GUI_Font_Blank;
+    }
+
+    //Direct mapped; the same character of two fonts goes to different slots
+    GUI_FONT_SLOT *pSlot = &GUI_Font_Cache[(Code + Font->Height) % GUI_FONT_CACHE_SLOTS];
+    if (pSlot->Font != Font || pSlot->Ascii_Char != Ascii_Char) {
+        GUI_Font_Decode(pSlot->Glyph, &Packed->Glyphs[Code - Packed->First],
+                        Packed->Data, WidthByte, Font->Height);
+        pSlot->Font = Font;
+        pSlot->Ascii_Char = Ascii_Char;
+    }
+    return pSlot->Glyph;
+}
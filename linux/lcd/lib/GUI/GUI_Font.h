@@ -0,0 +1,23 @@
+/*****************************************************************************
+* | File      	:   GUI_Font.h
+* | Function    :   Glyphs of the ASCII fonts, packed or not
+* | Info        :
+*                Glyphs of packed fonts are decoded the first time they are
+*                drawn into a small cache, in the layout of an sFONT table.
+*----------------
+* |	This version:   V1.0
+* | Info        :   Basic version
+*
+******************************************************************************/
+#ifndef __GUI_FONT_H
+#define __GUI_FONT_H
+
+#include "DEV_Config.h"
+#include "../Fonts/fonts.h"
+
+//Glyphs kept decoded at once
+#define GUI_FONT_CACHE_SLOTS    32
+
+const UBYTE *GUI_Font_GetGlyph(const sFONT *Font, char Ascii_Char);
+
+#endif
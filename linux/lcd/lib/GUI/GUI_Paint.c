@@ -35,11 +35,13 @@
 *
 ******************************************************************************/
 #include "GUI_Paint.h"
+#include "GUI_Font.h"
 
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h> //memset()
 #include <math.h>
+#include <limits.h>
 
 PAINT Paint;
 
@@ -127,18 +129,15 @@ void Paint_SetMirroring(UBYTE mirror)
 }
 
 /******************************************************************************
-function: Draw Pixels
+function: Map a point of the (rotated, mirrored) picture to the memory
 parameter:
     Xpoint : At point X
     Ypoint : At point Y
-    Color  : Painted colors
+    pX, pY : Where it is in Paint.Image
+return:    0 if the rotation or mirroring is unknown
 ******************************************************************************/
-void Paint_SetPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color)
+static UBYTE Paint_MapPoint(UWORD Xpoint, UWORD Ypoint, UWORD *pX, UWORD *pY)
 {
-    if(Xpoint > Paint.Width || Ypoint > Paint.Height){
-       // DEBUG("Exceeding display boundaries\r\n");
-        return;
-    }      
     UWORD X, Y;
 
     switch(Paint.Rotate) {
@@ -159,7 +158,7 @@ void Paint_SetPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color)
         Y = Paint.HeightMemory - Xpoint - 1;
         break;
     default:
-        return;
+        return 0;
     }
     
     switch(Paint.Mirror) {
@@ -176,6 +175,29 @@ void Paint_SetPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color)
         Y = Paint.HeightMemory - Y - 1;
         break;
     default:
+        return 0;
+    }
+
+    *pX = X;
+    *pY = Y;
+    return 1;
+}
+
+/******************************************************************************
+function: Draw Pixels
+parameter:
+    Xpoint : At point X
+    Ypoint : At point Y
+    Color  : Painted colors
+******************************************************************************/
+void Paint_SetPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color)
+{
+    if(Xpoint > Paint.Width || Ypoint > Paint.Height){
+       // DEBUG("Exceeding display boundaries\r\n");
+        return;
+    }      
+    UWORD X, Y;
+    if (!Paint_MapPoint(Xpoint, Ypoint, &X, &Y)) {
         return;
     }
 
@@ -199,6 +221,62 @@ void Paint_SetPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color)
     }
 }
 
+/******************************************************************************
+function: Fill a horizontal span of the picture, clipped to the picture;
+          every filled shape is drawn as spans, so each pixel is written once
+parameter:
+    Xstart : First X of the span
+    Xend   : Last X of the span (inclusive)
+    Ypoint : Y of the span
+    Color  : Painted colors
+******************************************************************************/
+void Paint_FillSpan(int Xstart, int Xend, int Ypoint, UWORD Color)
+{
+    if (Ypoint < 0 || Ypoint >= Paint.Height) {
+        return;
+    }
+    if (Xstart < 0) {
+        Xstart = 0;
+    }
+    if (Xend >= Paint.Width) {
+        Xend = Paint.Width - 1;
+    }
+    if (Xstart > Xend) {
+        return;
+    }
+
+    if (Paint.Depth == 1) {
+        int X;
+        for (X = Xstart; X <= Xend; X++) {
+            Paint_SetPixel(X, Ypoint, Color);
+        }
+        return;
+    }
+
+    //A span is a row or, rotated by 90 or 270, a column of the memory
+    UWORD X0, Y0, X1, Y1;
+    if (!Paint_MapPoint(Xstart, Ypoint, &X0, &Y0) ||
+        !Paint_MapPoint(Xend, Ypoint, &X1, &Y1)) {
+        return;
+    }
+    UWORD Native = ((Color<<8)&0xff00)|(Color>>8);
+
+    if (Y0 == Y1) {
+        UWORD *pPixel = Paint.Image + (UDOUBLE)Y0 * Paint.WidthByte + (X0 < X1 ? X0 : X1);
+        UWORD *pEnd = pPixel + (X0 < X1 ? X1 - X0 : X0 - X1);
+        while (pPixel <= pEnd) {
+            *pPixel++ = Native;
+        }
+    } else {
+        UWORD *pPixel = Paint.Image + (UDOUBLE)(Y0 < Y1 ? Y0 : Y1) * Paint.WidthByte + X0;
+        UWORD Count = (Y0 < Y1 ? Y1 - Y0 : Y0 - Y1) + 1;
+        while (Count--) {
+            *pPixel = Native;
+            pPixel += Paint.WidthByte;
+        }
+    }
+}
+
 /******************************************************************************
 function: Clear the color of the picture
 parameter:
@@ -225,11 +303,12 @@ parameter:
 ******************************************************************************/
 void Paint_ClearWindow(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color)
 {
-    UWORD X, Y;
+    UWORD Y;
+    if (Xstart >= Xend) {
+        return;
+    }
     for (Y = Ystart; Y < Yend; Y++) {
-        for (X = Xstart; X < Xend; X++) {//8 pixel =  1 byte
-            Paint_SetPixel(X, Y, Color);
-        }
+        Paint_FillSpan(Xstart, Xend - 1, Y, Color);
     }
 }
 
@@ -272,6 +351,94 @@ void Paint_DrawPoint(UWORD Xpoint, UWORD Ypoint, UWORD Color,
 	 
 }
 
+/******************************************************************************
+function: Fill a thick solid line as spans. Like Paint_DrawPoint, each
+          point of the line covers [X - Width, X + Width - 2] in both
+          directions; on any row those points are consecutive, so their
+          union is a single span.
+parameter:
+    Xstart, Ystart, Xend, Yend : The line
+    Width  : Line width (Dot_Pixel)
+    Color  : Painted color
+******************************************************************************/
+static void Paint_FillLine(int Xstart, int Ystart, int Xend, int Yend, int Width, UWORD Color)
+{
+    //Only the line's rows which reach the picture matter
+    int First = Ystart < Yend ? Ystart : Yend;
+    int Last = Ystart < Yend ? Yend : Ystart;
+    if (First < 2 - Width) {
+        First = 2 - Width;
+    }
+    if (Last > Paint.Height - 1 + Width) {
+        Last = Paint.Height - 1 + Width;
+    }
+    if (First > Last) {
+        return;
+    }
+
+    int Rows = Last - First + 1;
+    int *pMin = malloc(2 * Rows * sizeof(int));
+    if (pMin == NULL) {
+        return;
+    }
+    int *pMax = pMin + Rows;
+    int i;
+    for (i = 0; i < Rows; i++) {
+        pMin[i] = INT_MAX;
+        pMax[i] = INT_MIN;
+    }
+
+    //The same walk as Paint_DrawLine, recording each row's extent
+    int Xpoint = Xstart;
+    int Ypoint = Ystart;
+    int dx = Xend - Xstart >= 0 ? Xend - Xstart : Xstart - Xend;
+    int dy = Yend - Ystart <= 0 ? Yend - Ystart : Ystart - Yend;
+    int XAddway = Xstart < Xend ? 1 : -1;
+    int YAddway = Ystart < Yend ? 1 : -1;
+    int Esp = dx + dy;
+
+    for (;;) {
+        if (Ypoint >= First && Ypoint <= Last) {
+            i = Ypoint - First;
+            if (Xpoint < pMin[i]) pMin[i] = Xpoint;
+            if (Xpoint > pMax[i]) pMax[i] = Xpoint;
+        }
+        if (2 * Esp >= dy) {
+            if (Xpoint == Xend)
+                break;
+            Esp += dy;
+            Xpoint += XAddway;
+        }
+        if (2 * Esp <= dx) {
+            if (Ypoint == Yend)
+                break;
+            Esp += dx;
+            Ypoint += YAddway;
+        }
+    }
+
+    //Row Y is covered by the points on rows [Y - Width + 2, Y + Width]
+    int Y;
+    int YFirst = First - Width > 0 ? First - Width : 0;
+    int YLast = Last + Width - 2 < Paint.Height - 1 ? Last + Width - 2 : Paint.Height - 1;
+    for (Y = YFirst; Y <= YLast; Y++) {
+        int Lo = INT_MAX, Hi = INT_MIN;
+        int Row;
+        for (Row = Y - Width + 2; Row <= Y + Width; Row++) {
+            if (Row < First || Row > Last) {
+                continue;
+            }
+            if (pMin[Row - First] < Lo) Lo = pMin[Row - First];
+            if (pMax[Row - First] > Hi) Hi = pMax[Row - First];
+        }
+        if (Lo <= Hi) {
+            Paint_FillSpan(Lo - Width, Hi + Width - 2, Y, Color);
+        }
+    }
+
+    free(pMin);
+}
+
 /******************************************************************************
 function: Draw a line of arbitrary slope
 parameter:
@@ -286,9 +453,8 @@ parameter:
 void Paint_DrawLine(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
                     UWORD Color, DOT_PIXEL Line_width, LINE_STYLE Line_Style)
 {
-    if (Xstart > Paint.Width || Ystart > Paint.Height ||
-        Xend > Paint.Width || Yend > Paint.Height) {
-        DEBUG("Paint_DrawLine Input exceeds the normal display range\r\n");
+    if (Line_Style == LINE_STYLE_SOLID) {
+        Paint_FillLine(Xstart, Ystart, Xend, Yend, Line_width, Color);
         return;
     }
 
@@ -308,7 +474,7 @@ void Paint_DrawLine(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
     for (;;) {
         Dotted_Len++;
         //Painted dotted line, 2 point is really virtual
-        if (Line_Style == LINE_STYLE_DOTTED && Dotted_Len % 3 == 0) {
+        if (Dotted_Len % 3 == 0) {
             //DEBUG("LINE_DOTTED\r\n");
             Paint_DrawPoint(Xpoint, Ypoint, IMAGE_BACKGROUND, Line_width, DOT_STYLE_DFT);
             Dotted_Len = 0;
@@ -344,22 +510,66 @@ parameter:
 void Paint_DrawRectangle(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
                          UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
 {
-    if (Xstart > Paint.Width || Ystart > Paint.Height ||
-        Xend > Paint.Width || Yend > Paint.Height) {
-        DEBUG("Input exceeds the normal display range\r\n");
-        return;
-    }
+    //Each edge is a line of Line_width points, see Paint_FillLine
+    int W = Line_width;
+    int Left = (Xstart < Xend ? Xstart : Xend) - W;
+    int Right = (Xstart < Xend ? Xend : Xstart) + W - 2;
+    int Y;
 
     if (Draw_Fill) {
-        UWORD Ypoint;
-        for(Ypoint = Ystart; Ypoint < Yend; Ypoint++) {
-            Paint_DrawLine(Xstart, Ypoint, Xend, Ypoint, Color , Line_width, LINE_STYLE_SOLID);
+        //A line on each row from Ystart up to (not including) Yend
+        if (Ystart >= Yend) {
+            return;
+        }
+        for (Y = Ystart - W; Y <= Yend + W - 3; Y++) {
+            Paint_FillSpan(Left, Right, Y, Color);
         }
     } else {
-        Paint_DrawLine(Xstart, Ystart, Xend, Ystart, Color, Line_width, LINE_STYLE_SOLID);
-        Paint_DrawLine(Xstart, Ystart, Xstart, Yend, Color, Line_width, LINE_STYLE_SOLID);
-        Paint_DrawLine(Xend, Yend, Xend, Ystart, Color, Line_width, LINE_STYLE_SOLID);
-        Paint_DrawLine(Xend, Yend, Xstart, Yend, Color, Line_width, LINE_STYLE_SOLID);
+        int Top = (Ystart < Yend ? Ystart : Yend);
+        int Bottom = (Ystart < Yend ? Yend : Ystart);
+        for (Y = Top - W; Y <= Bottom + W - 2; Y++) {
+            if (Y <= Top + W - 2 || Y >= Bottom - W) {
+                Paint_FillSpan(Left, Right, Y, Color);
+            } else {
+                Paint_FillSpan(Left, Left + 2 * W - 2, Y, Color);
+                Paint_FillSpan(Right - 2 * W + 2, Right, Y, Color);
+            }
+        }
+    }
+}
+
+/******************************************************************************
+function: Half widths of a filled circle, as drawn by the 8-point method
+parameter:
+    Radius : circle Radius
+    pHalf  : Radius + 1 entries; row R above or below the center covers
+             [X - pHalf[R], X + pHalf[R]]
+******************************************************************************/
+static void Paint_CircleSpans(int Radius, int *pHalf)
+{
+    int XCurrent = 0;
+    int YCurrent = Radius;
+    int Esp = 3 - (Radius << 1);
+    int Row;
+
+    for (Row = 0; Row <= Radius; Row++) {
+        pHalf[Row] = 0;
+    }
+
+    //Every step (X, Y) fills rows X..Y out to X, and row X out to Y
+    while (XCurrent <= YCurrent) {
+        for (Row = XCurrent; Row <= YCurrent; Row++) {
+            if (XCurrent > pHalf[Row]) pHalf[Row] = XCurrent;
+        }
+        if (YCurrent > pHalf[XCurrent]) pHalf[XCurrent] = YCurrent;
+
+        if (Esp < 0 )
+            Esp += 4 * XCurrent + 6;
+        else {
+            Esp += 10 + 4 * (XCurrent - YCurrent );
+            YCurrent --;
+        }
+        XCurrent ++;
     }
 }
 
@@ -377,60 +587,144 @@ parameter:
 void Paint_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius,
                       UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
 {
-    if (X_Center > Paint.Width || Y_Center >= Paint.Height) {
-        DEBUG("Paint_DrawCircle Input exceeds the normal display range\r\n");
+    //Points are drawn as by Paint_DrawPoint, one up and left of the center
+    int X = X_Center - 1;
+    int Y = Y_Center - 1;
+    int R = Radius;
+    int Row;
+
+    if (Draw_Fill == DRAW_FILL_FULL) {
+        int *pHalf = malloc((R + 1) * sizeof(int));
+        if (pHalf == NULL) {
+            return;
+        }
+        Paint_CircleSpans(R, pHalf);
+        for (Row = -R; Row <= R; Row++) {
+            int Half = pHalf[Row < 0 ? -Row : Row];
+            Paint_FillSpan(X - Half, X + Half, Y + Row, Color);
+        }
+        free(pHalf);
         return;
     }
 
-    //Draw a circle from(0, R) as a starting point
-    int16_t XCurrent, YCurrent;
-    XCurrent = 0;
-    YCurrent = Radius;
+    //Draw a hollow circle: the points on the right half of each row,
+    //widened by the line width; the left half is its mirror image
+    int Extra = Line_width - 1;
+    int *pMin = malloc(2 * (R + 1) * sizeof(int));
+    if (pMin == NULL) {
+        return;
+    }
+    int *pMax = pMin + R + 1;
+    for (Row = 0; Row <= R; Row++) {
+        pMin[Row] = INT_MAX;
+        pMax[Row] = INT_MIN;
+    }
 
-    //Cumulative error,judge the next point of the logo
-    int16_t Esp = 3 - (Radius << 1 );
+    int XCurrent = 0;
+    int YCurrent = R;
+    int Esp = 3 - (R << 1);
+    while (XCurrent <= YCurrent) {
+        //(XCurrent, YCurrent) and (YCurrent, XCurrent)
+        if (XCurrent < pMin[YCurrent]) pMin[YCurrent] = XCurrent;
+        if (XCurrent > pMax[YCurrent]) pMax[YCurrent] = XCurrent;
+        if (YCurrent < pMin[XCurrent]) pMin[XCurrent] = YCurrent;
+        if (YCurrent > pMax[XCurrent]) pMax[XCurrent] = YCurrent;
 
-    int16_t sCountY;
-    if (Draw_Fill == DRAW_FILL_FULL) {
-        while (XCurrent <= YCurrent ) { //Realistic circles
-            for (sCountY = XCurrent; sCountY <= YCurrent; sCountY ++ ) {
-                Paint_DrawPoint(X_Center + XCurrent, Y_Center + sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//1
-                Paint_DrawPoint(X_Center - XCurrent, Y_Center + sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//2
-                Paint_DrawPoint(X_Center - sCountY, Y_Center + XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//3
-                Paint_DrawPoint(X_Center - sCountY, Y_Center - XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//4
-                Paint_DrawPoint(X_Center - XCurrent, Y_Center - sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//5
-                Paint_DrawPoint(X_Center + XCurrent, Y_Center - sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//6
-                Paint_DrawPoint(X_Center + sCountY, Y_Center - XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//7
-                Paint_DrawPoint(X_Center + sCountY, Y_Center + XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-            }
-            if (Esp < 0 )
-                Esp += 4 * XCurrent + 6;
-            else {
-                Esp += 10 + 4 * (XCurrent - YCurrent );
-                YCurrent --;
-            }
-            XCurrent ++;
+        if (Esp < 0 )
+            Esp += 4 * XCurrent + 6;
+        else {
+            Esp += 10 + 4 * (XCurrent - YCurrent );
+            YCurrent --;
         }
-    } else { //Draw a hollow circle
-        while (XCurrent <= YCurrent ) {
-            Paint_DrawPoint(X_Center + XCurrent, Y_Center + YCurrent, Color, Line_width, DOT_STYLE_DFT);//1
-            Paint_DrawPoint(X_Center - XCurrent, Y_Center + YCurrent, Color, Line_width, DOT_STYLE_DFT);//2
-            Paint_DrawPoint(X_Center - YCurrent, Y_Center + XCurrent, Color, Line_width, DOT_STYLE_DFT);//3
-            Paint_DrawPoint(X_Center - YCurrent, Y_Center - XCurrent, Color, Line_width, DOT_STYLE_DFT);//4
-            Paint_DrawPoint(X_Center - XCurrent, Y_Center - YCurrent, Color, Line_width, DOT_STYLE_DFT);//5
-            Paint_DrawPoint(X_Center + XCurrent, Y_Center - YCurrent, Color, Line_width, DOT_STYLE_DFT);//6
-            Paint_DrawPoint(X_Center + YCurrent, Y_Center - XCurrent, Color, Line_width, DOT_STYLE_DFT);//7
-            Paint_DrawPoint(X_Center + YCurrent, Y_Center + XCurrent, Color, Line_width, DOT_STYLE_DFT);//0
-
-            if (Esp < 0 )
-                Esp += 4 * XCurrent + 6;
-            else {
-                Esp += 10 + 4 * (XCurrent - YCurrent );
-                YCurrent --;
+        XCurrent ++;
+    }
+
+    for (Row = -R - Extra; Row <= R + Extra; Row++) {
+        int Lo = INT_MAX, Hi = INT_MIN;
+        int Near;
+        for (Near = Row - Extra; Near <= Row + Extra; Near++) {
+            if (Near < -R || Near > R) {
+                continue;
             }
-            XCurrent ++;
+            int Abs = Near < 0 ? -Near : Near;
+            if (pMin[Abs] < Lo) Lo = pMin[Abs];
+            if (pMax[Abs] > Hi) Hi = pMax[Abs];
+        }
+        if (Lo > Hi) {
+            continue;
+        }
+        Lo -= Extra;
+        Hi += Extra;
+        if (Lo <= 0) {
+            Paint_FillSpan(X - Hi, X + Hi, Y + Row, Color);
+        } else {
+            Paint_FillSpan(X - Hi, X - Lo, Y + Row, Color);
+            Paint_FillSpan(X + Lo, X + Hi, Y + Row, Color);
+        }
+    }
+    free(pMin);
+}
+
+//How far row Y of a rounded rectangle is inset by its corners
+static int Paint_RoundInset(int Y, int Top, int Bottom, int Radius, const int *pHalf)
+{
+    if (Y < Top + Radius) {
+        return Radius - pHalf[Top + Radius - Y];
+    }
+    if (Y > Bottom - Radius) {
+        return Radius - pHalf[Y - (Bottom - Radius)];
+    }
+    return 0;
+}
+
+/******************************************************************************
+function: Draw a rectangle with rounded corners; unlike Paint_DrawRectangle
+          it covers exactly [Xstart, Xend] x [Ystart, Yend], and an outline
+          is Line_width pixels wide, inside that
+parameter:
+    Xstart ：Left
+    Ystart ：Top
+    Xend   ：Right (inclusive)
+    Yend   ：Bottom (inclusive)
+    Radius ：Corner radius
+    Color  ：The color of the Rectangular segment
+    Line_width: Line width
+    Draw_Fill : Whether to fill the inside of the rectangle
+******************************************************************************/
+void Paint_DrawRoundRectangle(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+                              UWORD Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    int Left = Xstart < Xend ? Xstart : Xend;
+    int Right = Xstart < Xend ? Xend : Xstart;
+    int Top = Ystart < Yend ? Ystart : Yend;
+    int Bottom = Ystart < Yend ? Yend : Ystart;
+    int R = Radius;
+    if (2 * R > Right - Left) R = (Right - Left) / 2;
+    if (2 * R > Bottom - Top) R = (Bottom - Top) / 2;
+
+    //Both profiles in one allocation: the outer corner's, then the inner's
+    int W = Draw_Fill ? 0 : Line_width;
+    int InnerR = R - W > 0 ? R - W : 0;
+    int *pHalf = malloc((R + 1 + InnerR + 1) * sizeof(int));
+    if (pHalf == NULL) {
+        return;
+    }
+    int *pInnerHalf = pHalf + R + 1;
+    Paint_CircleSpans(R, pHalf);
+    Paint_CircleSpans(InnerR, pInnerHalf);
+
+    int Y;
+    for (Y = Top; Y <= Bottom; Y++) {
+        int Inset = Paint_RoundInset(Y, Top, Bottom, R, pHalf);
+        if (Draw_Fill || Y < Top + W || Y > Bottom - W || Right - Left < 2 * W) {
+            Paint_FillSpan(Left + Inset, Right - Inset, Y, Color);
+            continue;
         }
+        int InnerInset = Paint_RoundInset(Y, Top + W, Bottom - W, InnerR, pInnerHalf);
+        Paint_FillSpan(Left + Inset, Left + W + InnerInset - 1, Y, Color);
+        Paint_FillSpan(Right - W - InnerInset + 1, Right - Inset, Y, Color);
     }
+    free(pHalf);
 }
 
 /******************************************************************************
@@ -453,8 +747,7 @@ void Paint_DrawChar(UWORD Xpoint, UWORD Ypoint, const char Acsii_Char,
         return;
     }
 
-    uint32_t Char_Offset = (Acsii_Char - ' ') * Font->Height * (Font->Width / 8 + (Font->Width % 8 ? 1 : 0));
-    const unsigned char *ptr = &Font->table[Char_Offset];
+    const unsigned char *ptr = GUI_Font_GetGlyph(Font, Acsii_Char);
 
     for (Page = 0; Page < Font->Height; Page ++ ) {
         for (Column = 0; Column < Font->Width; Column ++ ) {
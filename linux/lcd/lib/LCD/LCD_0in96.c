@@ -28,144 +28,49 @@
 #
 ******************************************************************************/
 #include "LCD_0in96.h"
+#include "LCD_Panel.h"
 #include <stdlib.h>		//itoa()
-/*******************************************************************************
-function:
-	Hardware reset
-*******************************************************************************/
-static void LCD_0IN96_Reset(void)
-{
-	DEV_Delay_ms(200);
-	DEV_Digital_Write(LCD_RST, 0);
-	DEV_Delay_ms(200);
-	DEV_Digital_Write(LCD_RST, 1);
-	DEV_Delay_ms(200);
-}
-
-/*******************************************************************************
-function:
-		Write data and commands
-*******************************************************************************/
-static void LCD_0IN96_Write_Command(UBYTE data)	 
-{	
-	DEV_Digital_Write(LCD_DC, 0);
-	DEV_SPI_WriteByte(data);
-}
-
-static void LCD_0IN96_WriteData_Byte(UBYTE data) 
-{	
-	DEV_Digital_Write(LCD_DC, 1);
-	DEV_SPI_WriteByte(data);  
-}  
-
-void LCD_0IN96_WriteData_Word(UWORD data)
-{
-	DEV_Digital_Write(LCD_DC, 1);
-	DEV_SPI_WriteByte((data>>8) & 0xff);
-	DEV_SPI_WriteByte(data);
-}	  
-
 /******************************************************************************
 function:	
 		Common register initialization
 ******************************************************************************/
+static const UBYTE LCD_0IN96_InitSeq[] = {
+    0x11, 0 | DEV_CMD_DELAY, 120,       //Sleep exit
+    0x21, 0,
+    0x21, 0,
+    0xB1, 3, 0x05, 0x3A, 0x3A,
+    0xB2, 3, 0x05, 0x3A, 0x3A,
+    0xB3, 6, 0x05, 0x3A, 0x3A, 0x05, 0x3A, 0x3A,
+    0xB4, 1, 0x03,
+    0xC0, 3, 0x62, 0x02, 0x04,
+    0xC1, 1, 0xC0,
+    0xC2, 2, 0x0D, 0x00,
+    0xC3, 2, 0x8D, 0x6A,
+    0xC4, 2, 0x8D, 0xEE,
+    0xC5, 1, 0x0E,
+    0xE0, 16, 0x10, 0x0E, 0x02, 0x03, 0x0E, 0x07, 0x02,
+              0x07, 0x0A, 0x12, 0x27, 0x37, 0x00, 0x0D,
+              0x0E, 0x10,
+    0xE1, 16, 0x10, 0x0E, 0x03, 0x03, 0x0F, 0x06, 0x02,
+              0x08, 0x0A, 0x13, 0x26, 0x36, 0x00, 0x0D,
+              0x0E, 0x10,
+    0x3A, 1, 0x05,
+    0x29, 0,
+};
+
+static const LCD_PANEL_SCAN LCD_0IN96_Scan[] = {
+    {0xA0, 1, 26},
+};
+
+//80 x 160, turned on its side by its one scan direction
+static const LCD_PANEL LCD_0IN96_Panel = {
+    "0.96inch ST7735S", LCD_0IN96_HEIGHT, LCD_0IN96_WIDTH, LCD_PANEL_BGR, 200,
+    LCD_0IN96_InitSeq, sizeof(LCD_0IN96_InitSeq), LCD_0IN96_Scan, 1,
+};
+
 void LCD_0IN96_Init(void)
 {
-	LCD_0IN96_Reset();
-
-	//************* Start Initial Sequence **********// 
-	LCD_0IN96_Write_Command(0x11);//Sleep exit 
-	DEV_Delay_ms (120);
-	LCD_0IN96_Write_Command(0x21); 
-	LCD_0IN96_Write_Command(0x21); 
-
-	LCD_0IN96_Write_Command(0xB1); 
-	LCD_0IN96_WriteData_Byte(0x05);
-	LCD_0IN96_WriteData_Byte(0x3A);
-	LCD_0IN96_WriteData_Byte(0x3A);
-
-	LCD_0IN96_Write_Command(0xB2);
-	LCD_0IN96_WriteData_Byte(0x05);
-	LCD_0IN96_WriteData_Byte(0x3A);
-	LCD_0IN96_WriteData_Byte(0x3A);
-
-	LCD_0IN96_Write_Command(0xB3); 
-	LCD_0IN96_WriteData_Byte(0x05);  
-	LCD_0IN96_WriteData_Byte(0x3A);
-	LCD_0IN96_WriteData_Byte(0x3A);
-	LCD_0IN96_WriteData_Byte(0x05);
-	LCD_0IN96_WriteData_Byte(0x3A);
-	LCD_0IN96_WriteData_Byte(0x3A);
-
-	LCD_0IN96_Write_Command(0xB4);
-	LCD_0IN96_WriteData_Byte(0x03);
-
-	LCD_0IN96_Write_Command(0xC0);
-	LCD_0IN96_WriteData_Byte(0x62);
-	LCD_0IN96_WriteData_Byte(0x02);
-	LCD_0IN96_WriteData_Byte(0x04);
-
-	LCD_0IN96_Write_Command(0xC1);
-	LCD_0IN96_WriteData_Byte(0xC0);
-
-	LCD_0IN96_Write_Command(0xC2);
-	LCD_0IN96_WriteData_Byte(0x0D);
-	LCD_0IN96_WriteData_Byte(0x00);
-
-	LCD_0IN96_Write_Command(0xC3);
-	LCD_0IN96_WriteData_Byte(0x8D);
-	LCD_0IN96_WriteData_Byte(0x6A);   
-
-	LCD_0IN96_Write_Command(0xC4);
-	LCD_0IN96_WriteData_Byte(0x8D); 
-	LCD_0IN96_WriteData_Byte(0xEE); 
-
-	LCD_0IN96_Write_Command(0xC5);  /*VCOM*/
-	LCD_0IN96_WriteData_Byte(0x0E);    
-
-	LCD_0IN96_Write_Command(0xE0);
-	LCD_0IN96_WriteData_Byte(0x10);
-	LCD_0IN96_WriteData_Byte(0x0E);
-	LCD_0IN96_WriteData_Byte(0x02);
-	LCD_0IN96_WriteData_Byte(0x03);
-	LCD_0IN96_WriteData_Byte(0x0E);
-	LCD_0IN96_WriteData_Byte(0x07);
-	LCD_0IN96_WriteData_Byte(0x02);
-	LCD_0IN96_WriteData_Byte(0x07);
-	LCD_0IN96_WriteData_Byte(0x0A);
-	LCD_0IN96_WriteData_Byte(0x12);
-	LCD_0IN96_WriteData_Byte(0x27);
-	LCD_0IN96_WriteData_Byte(0x37);
-	LCD_0IN96_WriteData_Byte(0x00);
-	LCD_0IN96_WriteData_Byte(0x0D);
-	LCD_0IN96_WriteData_Byte(0x0E);
-	LCD_0IN96_WriteData_Byte(0x10);
-
-	LCD_0IN96_Write_Command(0xE1);
-	LCD_0IN96_WriteData_Byte(0x10);
-	LCD_0IN96_WriteData_Byte(0x0E);
-	LCD_0IN96_WriteData_Byte(0x03);
-	LCD_0IN96_WriteData_Byte(0x03);
-	LCD_0IN96_WriteData_Byte(0x0F);
-	LCD_0IN96_WriteData_Byte(0x06);
-	LCD_0IN96_WriteData_Byte(0x02);
-	LCD_0IN96_WriteData_Byte(0x08);
-	LCD_0IN96_WriteData_Byte(0x0A);
-	LCD_0IN96_WriteData_Byte(0x13);
-	LCD_0IN96_WriteData_Byte(0x26);
-	LCD_0IN96_WriteData_Byte(0x36);
-	LCD_0IN96_WriteData_Byte(0x00);
-	LCD_0IN96_WriteData_Byte(0x0D);
-	LCD_0IN96_WriteData_Byte(0x0E);
-	LCD_0IN96_WriteData_Byte(0x10);
-
-	LCD_0IN96_Write_Command(0x3A); 
-	LCD_0IN96_WriteData_Byte(0x05);
-
-	LCD_0IN96_Write_Command(0x36);
-	LCD_0IN96_WriteData_Byte(0xA8);
-
-	LCD_0IN96_Write_Command(0x29);
+    LCD_Panel_Init(&LCD_0IN96_Panel, 0);
 }
 
 /*******************************************************************************
@@ -179,34 +84,26 @@ void LCD_0IN96_SetBackLight(UWORD Value)
 	// DEV_Set_PWM(Value);
 }
 
+/*******************************************************************************
+function:
+		Write data and commands
+*******************************************************************************/
+void LCD_0IN96_WriteData_Word(UWORD data)
+{
+    LCD_Panel_FillPixels(data, 1);
+}
+
 /******************************************************************************
 function:	Set the cursor position
 parameter	:
 	  Xstart: 	Start UWORD x coordinate
 	  Ystart:	Start UWORD y coordinate
-	  Xend  :	End UWORD coordinates
-	  Yend  :	End UWORD coordinatesen
+	  Xend  :	End UWORD coordinates, inclusive
+	  Yend  :	End UWORD coordinates, inclusive
 ******************************************************************************/
 void LCD_0IN96_SetWindow(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD  Yend)
 { 
-	Xstart = Xstart + 1;
-	Xend = Xend + 1;
-	Ystart = Ystart + 26;
-	Yend = Yend+26;
-	
-	LCD_0IN96_Write_Command(0x2a);
-	LCD_0IN96_WriteData_Byte(Xstart >> 8);
-	LCD_0IN96_WriteData_Byte(Xstart);
-	LCD_0IN96_WriteData_Byte(Xend >> 8);
-	LCD_0IN96_WriteData_Byte(Xend );
-
-	LCD_0IN96_Write_Command(0x2b);
-	LCD_0IN96_WriteData_Byte(Ystart >> 8);
-	LCD_0IN96_WriteData_Byte(Ystart);
-	LCD_0IN96_WriteData_Byte(Yend >> 8);
-	LCD_0IN96_WriteData_Byte(Yend);
-
-	LCD_0IN96_Write_Command(0x2C);
+    LCD_Panel_SetWindows(Xstart, Ystart, Xend + 1, Yend + 1);
 }
 
 /******************************************************************************
@@ -214,26 +111,10 @@ function:	Settings window
 parameter	:
 	  Xstart: 	Start UWORD x coordinate
 	  Ystart:	Start UWORD y coordinate
-
 ******************************************************************************/
 void LCD_0IN96_SetCursor(UWORD X, UWORD Y)
 { 
-	X = X + 1;
-	Y = Y + 26;
-	
-	LCD_0IN96_Write_Command(0x2a);
-	LCD_0IN96_WriteData_Byte(X >> 8);
-	LCD_0IN96_WriteData_Byte(X);
-	LCD_0IN96_WriteData_Byte(X >> 8);
-	LCD_0IN96_WriteData_Byte(X);
-
-	LCD_0IN96_Write_Command(0x2b);
-	LCD_0IN96_WriteData_Byte(Y >> 8);
-	LCD_0IN96_WriteData_Byte(Y);
-	LCD_0IN96_WriteData_Byte(Y >> 8);
-	LCD_0IN96_WriteData_Byte(Y);
-
-	LCD_0IN96_Write_Command(0x2C);
+    LCD_Panel_SetWindows(X, Y, X + 1, Y + 1);
 }
 
 /******************************************************************************
@@ -243,20 +124,7 @@ parameter	:
 ******************************************************************************/
 void LCD_0IN96_Clear(UWORD Color)
 {
-	unsigned int i,j;  
-	Color = 0xffff;
-    UWORD Image[LCD_0IN96_WIDTH*LCD_0IN96_HEIGHT];
-    
-    Color = ((Color<<8)&0xff00)|(Color>>8);
-   
-    for (j = 0; j < LCD_0IN96_HEIGHT*LCD_0IN96_WIDTH; j++) {
-        Image[j] = Color;
-    }
-	LCD_0IN96_SetWindow(0, 0, LCD_0IN96_WIDTH-1, LCD_0IN96_HEIGHT-1);
-	DEV_Digital_Write(LCD_DC, 1);
-	for(i = 0; i < LCD_0IN96_HEIGHT; i++){
-        DEV_SPI_Write_nByte((uint8_t *)&Image[i*LCD_0IN96_WIDTH], LCD_0IN96_WIDTH*2); 
-	 }
+    LCD_Panel_Clear(Color);
 }
 
 /******************************************************************************
@@ -270,13 +138,7 @@ parameter	:
 ******************************************************************************/
 void LCD_0IN96_ClearWindow(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,UWORD color)
 {          
-	UWORD i,j; 
-	LCD_0IN96_SetWindow(Xstart, Ystart, Xend-1,Yend-1);
-	for(i = Ystart; i <= Yend-1; i++){
-		for(j = Xstart; j <= Xend-1; j++){
-			LCD_0IN96_WriteData_Word(color);
-		}
-	}
+    LCD_FillRect(Xstart, Ystart, Xend, Yend, color);
 }
 
 /******************************************************************************
@@ -288,8 +150,7 @@ parameter	:
 ******************************************************************************/
 void LCD_0IN96_DrawPaint(UWORD x, UWORD y, UWORD Color)
 {
-	LCD_0IN96_SetCursor(x, y);
-	LCD_0IN96_WriteData_Word(Color); 	    
+    LCD_Panel_DisplayPoint(x, y, Color);
 }
 
 /******************************************************************************
@@ -298,26 +159,13 @@ parameter:
 ******************************************************************************/
 void LCD_0IN96_Display(UWORD *Image)
 {
-    UWORD j;
-    LCD_0IN96_SetWindow(0, 0, LCD_0IN96_WIDTH-1, LCD_0IN96_HEIGHT-1);
-    DEV_Digital_Write(LCD_DC, 1);
-    for (j = 0; j < LCD_0IN96_HEIGHT; j++) {
-        DEV_SPI_Write_nByte((uint8_t *)&Image[j*LCD_0IN96_WIDTH], LCD_0IN96_WIDTH*2);
-    }
+    LCD_Panel_Display(Image);
 }
 
 void LCD_0IN96_DisplayWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD *Image)
 {
-    // display
-    UDOUBLE Addr = 0;
-
-    UWORD j;
-    LCD_0IN96_SetWindow(Xstart, Ystart, Xend-1 , Yend-1);
-    DEV_Digital_Write(LCD_DC, 1);
-    for (j = Ystart; j < Yend - 1; j++) {
-        Addr = Xstart + j * LCD_0IN96_WIDTH ;
-        DEV_SPI_Write_nByte((uint8_t *)&Image[Addr], (Xend-Xstart-1)*2);
-    }
+    LCD_Panel_DisplayWindows(Xstart, Ystart, Xend, Yend,
+        Image + (UDOUBLE)Ystart * LCD_Panel.WIDTH + Xstart, LCD_Panel.WIDTH);
 }
 
 void  Handler_0IN96_LCD(int signo)
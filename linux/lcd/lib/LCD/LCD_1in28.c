@@ -12,7 +12,7 @@
 *
 ******************************************************************************/
 #include "LCD_1in28.h"
-#include "DEV_Config.h"
+#include "LCD_Panel.h"
 
 #include <stdlib.h>		//itoa()
 #include <stdio.h>
@@ -20,323 +20,76 @@
 LCD_1IN28_ATTRIBUTES LCD_1IN28;
 
 
-/******************************************************************************
-function :	Hardware reset
-parameter:
-******************************************************************************/
-static void LCD_1IN28_Reset(void)
-{
-    LCD_1IN28_RST_1;
-    DEV_Delay_ms(100);
-    LCD_1IN28_RST_0;
-    DEV_Delay_ms(100);
-    LCD_1IN28_RST_1;
-    DEV_Delay_ms(100);
-}
-
-/******************************************************************************
-function :	send command
-parameter:
-     Reg : Command register
-******************************************************************************/
-static void LCD_1IN28_SendCommand(UBYTE Reg)
-{
-    LCD_1IN28_DC_0;
-    DEV_SPI_WriteByte(Reg);
-}
-
-/******************************************************************************
-function :	send data
-parameter:
-    Data : Write data
-******************************************************************************/
-static void LCD_1IN28_SendData_8Bit(UBYTE Data)
-{
-    LCD_1IN28_DC_1;
-    DEV_SPI_WriteByte(Data);
-}
-
-/******************************************************************************
-function :	send data
-parameter:
-    Data : Write data
-******************************************************************************/
-static void LCD_1IN28_SendData_16Bit(UWORD Data)
-{
-    LCD_1IN28_DC_1;
-    DEV_SPI_WriteByte(Data >> 8);
-    DEV_SPI_WriteByte(Data);
-}
-
 /******************************************************************************
 function :	Initialize the lcd register
 parameter:
 ******************************************************************************/
-static void LCD_1IN28_InitReg(void)
-{
-    LCD_1IN28_SendCommand(0xEF);
-	LCD_1IN28_SendCommand(0xEB);
-	LCD_1IN28_SendData_8Bit(0x14); 
-	
-    LCD_1IN28_SendCommand(0xFE);			 
-	LCD_1IN28_SendCommand(0xEF); 
-
-	LCD_1IN28_SendCommand(0xEB);	
-	LCD_1IN28_SendData_8Bit(0x14); 
-
-	LCD_1IN28_SendCommand(0x84);			
-	LCD_1IN28_SendData_8Bit(0x40); 
-
-	LCD_1IN28_SendCommand(0x85);			
-	LCD_1IN28_SendData_8Bit(0xFF); 
-
-	LCD_1IN28_SendCommand(0x86);			
-	LCD_1IN28_SendData_8Bit(0xFF); 
-
-	LCD_1IN28_SendCommand(0x87);			
-	LCD_1IN28_SendData_8Bit(0xFF);
-
-	LCD_1IN28_SendCommand(0x88);			
-	LCD_1IN28_SendData_8Bit(0x0A);
-
-	LCD_1IN28_SendCommand(0x89);			
-	LCD_1IN28_SendData_8Bit(0x21); 
-
-	LCD_1IN28_SendCommand(0x8A);			
-	LCD_1IN28_SendData_8Bit(0x00); 
-
-	LCD_1IN28_SendCommand(0x8B);			
-	LCD_1IN28_SendData_8Bit(0x80); 
-
-	LCD_1IN28_SendCommand(0x8C);			
-	LCD_1IN28_SendData_8Bit(0x01); 
-
-	LCD_1IN28_SendCommand(0x8D);			
-	LCD_1IN28_SendData_8Bit(0x01); 
-
-	LCD_1IN28_SendCommand(0x8E);			
-	LCD_1IN28_SendData_8Bit(0xFF); 
-
-	LCD_1IN28_SendCommand(0x8F);			
-	LCD_1IN28_SendData_8Bit(0xFF); 
-
-
-	LCD_1IN28_SendCommand(0xB6);
-	LCD_1IN28_SendData_8Bit(0x00);
-	LCD_1IN28_SendData_8Bit(0x20);
-
-	LCD_1IN28_SendCommand(0x36);
-	LCD_1IN28_SendData_8Bit(0x08);//Set as vertical screen
-
-	LCD_1IN28_SendCommand(0x3A);			
-	LCD_1IN28_SendData_8Bit(0x05); 
-
-
-	LCD_1IN28_SendCommand(0x90);			
-	LCD_1IN28_SendData_8Bit(0x08);
-	LCD_1IN28_SendData_8Bit(0x08);
-	LCD_1IN28_SendData_8Bit(0x08);
-	LCD_1IN28_SendData_8Bit(0x08); 
-
-	LCD_1IN28_SendCommand(0xBD);			
-	LCD_1IN28_SendData_8Bit(0x06);
-	
-	LCD_1IN28_SendCommand(0xBC);			
-	LCD_1IN28_SendData_8Bit(0x00);	
-
-	LCD_1IN28_SendCommand(0xFF);			
-	LCD_1IN28_SendData_8Bit(0x60);
-	LCD_1IN28_SendData_8Bit(0x01);
-	LCD_1IN28_SendData_8Bit(0x04);
-
-	LCD_1IN28_SendCommand(0xC3);			
-	LCD_1IN28_SendData_8Bit(0x13);
-	LCD_1IN28_SendCommand(0xC4);			
-	LCD_1IN28_SendData_8Bit(0x13);
-
-	LCD_1IN28_SendCommand(0xC9);			
-	LCD_1IN28_SendData_8Bit(0x22);
-
-	LCD_1IN28_SendCommand(0xBE);			
-	LCD_1IN28_SendData_8Bit(0x11); 
-
-	LCD_1IN28_SendCommand(0xE1);			
-	LCD_1IN28_SendData_8Bit(0x10);
-	LCD_1IN28_SendData_8Bit(0x0E);
-
-	LCD_1IN28_SendCommand(0xDF);			
-	LCD_1IN28_SendData_8Bit(0x21);
-	LCD_1IN28_SendData_8Bit(0x0c);
-	LCD_1IN28_SendData_8Bit(0x02);
-
-	LCD_1IN28_SendCommand(0xF0);   
-	LCD_1IN28_SendData_8Bit(0x45);
-	LCD_1IN28_SendData_8Bit(0x09);
-	LCD_1IN28_SendData_8Bit(0x08);
-	LCD_1IN28_SendData_8Bit(0x08);
-	LCD_1IN28_SendData_8Bit(0x26);
- 	LCD_1IN28_SendData_8Bit(0x2A);
-
- 	LCD_1IN28_SendCommand(0xF1);    
- 	LCD_1IN28_SendData_8Bit(0x43);
- 	LCD_1IN28_SendData_8Bit(0x70);
- 	LCD_1IN28_SendData_8Bit(0x72);
- 	LCD_1IN28_SendData_8Bit(0x36);
- 	LCD_1IN28_SendData_8Bit(0x37);  
- 	LCD_1IN28_SendData_8Bit(0x6F);
-
-
- 	LCD_1IN28_SendCommand(0xF2);   
- 	LCD_1IN28_SendData_8Bit(0x45);
- 	LCD_1IN28_SendData_8Bit(0x09);
- 	LCD_1IN28_SendData_8Bit(0x08);
- 	LCD_1IN28_SendData_8Bit(0x08);
- 	LCD_1IN28_SendData_8Bit(0x26);
- 	LCD_1IN28_SendData_8Bit(0x2A);
-
- 	LCD_1IN28_SendCommand(0xF3);   
- 	LCD_1IN28_SendData_8Bit(0x43);
- 	LCD_1IN28_SendData_8Bit(0x70);
- 	LCD_1IN28_SendData_8Bit(0x72);
- 	LCD_1IN28_SendData_8Bit(0x36);
- 	LCD_1IN28_SendData_8Bit(0x37); 
- 	LCD_1IN28_SendData_8Bit(0x6F);
-
-	LCD_1IN28_SendCommand(0xED);	
-	LCD_1IN28_SendData_8Bit(0x1B); 
-	LCD_1IN28_SendData_8Bit(0x0B); 
-
-	LCD_1IN28_SendCommand(0xAE);			
-	LCD_1IN28_SendData_8Bit(0x77);
-	
-	LCD_1IN28_SendCommand(0xCD);			
-	LCD_1IN28_SendData_8Bit(0x63);		
-
-
-	LCD_1IN28_SendCommand(0x70);			
-	LCD_1IN28_SendData_8Bit(0x07);
-	LCD_1IN28_SendData_8Bit(0x07);
-	LCD_1IN28_SendData_8Bit(0x04);
-	LCD_1IN28_SendData_8Bit(0x0E); 
-	LCD_1IN28_SendData_8Bit(0x0F); 
-	LCD_1IN28_SendData_8Bit(0x09);
-	LCD_1IN28_SendData_8Bit(0x07);
-	LCD_1IN28_SendData_8Bit(0x08);
-	LCD_1IN28_SendData_8Bit(0x03);
-
-	LCD_1IN28_SendCommand(0xE8);			
-	LCD_1IN28_SendData_8Bit(0x34);
-
-	LCD_1IN28_SendCommand(0x62);			
-	LCD_1IN28_SendData_8Bit(0x18);
-	LCD_1IN28_SendData_8Bit(0x0D);
-	LCD_1IN28_SendData_8Bit(0x71);
-	LCD_1IN28_SendData_8Bit(0xED);
-	LCD_1IN28_SendData_8Bit(0x70); 
-	LCD_1IN28_SendData_8Bit(0x70);
-	LCD_1IN28_SendData_8Bit(0x18);
-	LCD_1IN28_SendData_8Bit(0x0F);
-	LCD_1IN28_SendData_8Bit(0x71);
-	LCD_1IN28_SendData_8Bit(0xEF);
-	LCD_1IN28_SendData_8Bit(0x70); 
-	LCD_1IN28_SendData_8Bit(0x70);
-
-	LCD_1IN28_SendCommand(0x63);			
-	LCD_1IN28_SendData_8Bit(0x18);
-	LCD_1IN28_SendData_8Bit(0x11);
-	LCD_1IN28_SendData_8Bit(0x71);
-	LCD_1IN28_SendData_8Bit(0xF1);
-	LCD_1IN28_SendData_8Bit(0x70); 
-	LCD_1IN28_SendData_8Bit(0x70);
-	LCD_1IN28_SendData_8Bit(0x18);
-	LCD_1IN28_SendData_8Bit(0x13);
-	LCD_1IN28_SendData_8Bit(0x71);
-	LCD_1IN28_SendData_8Bit(0xF3);
-	LCD_1IN28_SendData_8Bit(0x70); 
-	LCD_1IN28_SendData_8Bit(0x70);
-
-	LCD_1IN28_SendCommand(0x64);			
-	LCD_1IN28_SendData_8Bit(0x28);
-	LCD_1IN28_SendData_8Bit(0x29);
-	LCD_1IN28_SendData_8Bit(0xF1);
-	LCD_1IN28_SendData_8Bit(0x01);
-	LCD_1IN28_SendData_8Bit(0xF1);
-	LCD_1IN28_SendData_8Bit(0x00);
-	LCD_1IN28_SendData_8Bit(0x07);
-
-	LCD_1IN28_SendCommand(0x66);			
-	LCD_1IN28_SendData_8Bit(0x3C);
-	LCD_1IN28_SendData_8Bit(0x00);
-	LCD_1IN28_SendData_8Bit(0xCD);
-	LCD_1IN28_SendData_8Bit(0x67);
-	LCD_1IN28_SendData_8Bit(0x45);
-	LCD_1IN28_SendData_8Bit(0x45);
-	LCD_1IN28_SendData_8Bit(0x10);
-	LCD_1IN28_SendData_8Bit(0x00);
-	LCD_1IN28_SendData_8Bit(0x00);
-	LCD_1IN28_SendData_8Bit(0x00);
-
-	LCD_1IN28_SendCommand(0x67);			
-	LCD_1IN28_SendData_8Bit(0x00);
-	LCD_1IN28_SendData_8Bit(0x3C);
-	LCD_1IN28_SendData_8Bit(0x00);
-	LCD_1IN28_SendData_8Bit(0x00);
-	LCD_1IN28_SendData_8Bit(0x00);
-	LCD_1IN28_SendData_8Bit(0x01);
-	LCD_1IN28_SendData_8Bit(0x54);
-	LCD_1IN28_SendData_8Bit(0x10);
-	LCD_1IN28_SendData_8Bit(0x32);
-	LCD_1IN28_SendData_8Bit(0x98);
-
-	LCD_1IN28_SendCommand(0x74);			
-	LCD_1IN28_SendData_8Bit(0x10);	
-	LCD_1IN28_SendData_8Bit(0x85);	
-	LCD_1IN28_SendData_8Bit(0x80);
-	LCD_1IN28_SendData_8Bit(0x00); 
-	LCD_1IN28_SendData_8Bit(0x00); 
-	LCD_1IN28_SendData_8Bit(0x4E);
-	LCD_1IN28_SendData_8Bit(0x00);					
-	
-    LCD_1IN28_SendCommand(0x98);			
-	LCD_1IN28_SendData_8Bit(0x3e);
-	LCD_1IN28_SendData_8Bit(0x07);
-
-	LCD_1IN28_SendCommand(0x35);	
-	LCD_1IN28_SendCommand(0x21);
-
-	LCD_1IN28_SendCommand(0x11);
-	DEV_Delay_ms(120);
-	LCD_1IN28_SendCommand(0x29);
-	DEV_Delay_ms(20);
-}
-
-/********************************************************************************
-function:	Set the resolution and scanning method of the screen
-parameter:
-		Scan_dir:   Scan direction
-********************************************************************************/
-static void LCD_1IN28_SetAttributes(UBYTE Scan_dir)
-{
-    //Get the screen scan direction
-    LCD_1IN28.SCAN_DIR = Scan_dir;
-    UBYTE MemoryAccessReg = 0x08;
-
-    //Get GRAM and LCD width and height
-    if(Scan_dir == HORIZONTAL) {
-        LCD_1IN28.HEIGHT	= LCD_1IN28_HEIGHT;
-        LCD_1IN28.WIDTH   = LCD_1IN28_WIDTH;
-        MemoryAccessReg = 0Xc8;
-    } else {
-        LCD_1IN28.HEIGHT	= LCD_1IN28_WIDTH;
-        LCD_1IN28.WIDTH   = LCD_1IN28_HEIGHT;
-        MemoryAccessReg = 0X68;
-    }
-
-    // Set the read / write scan direction of the frame memory
-    LCD_1IN28_SendCommand(0x36); //MX, MY, RGB mode
-    //LCD_1IN28_SendData_8Bit(MemoryAccessReg);	//0x08 set RGB
-	LCD_1IN28_SendData_8Bit(MemoryAccessReg);	//0x08 set RGB
-}
+static const UBYTE LCD_1IN28_InitSeq[] = {
+    0xEF, 0,
+    0xEB, 1, 0x14,
+    0xFE, 0,
+    0xEF, 0,
+    0xEB, 1, 0x14,
+    0x84, 1, 0x40,
+    0x85, 1, 0xFF,
+    0x86, 1, 0xFF,
+    0x87, 1, 0xFF,
+    0x88, 1, 0x0A,
+    0x89, 1, 0x21,
+    0x8A, 1, 0x00,
+    0x8B, 1, 0x80,
+    0x8C, 1, 0x01,
+    0x8D, 1, 0x01,
+    0x8E, 1, 0xFF,
+    0x8F, 1, 0xFF,
+    0xB6, 2, 0x00, 0x20,
+    0x3A, 1, 0x05,
+    0x90, 4, 0x08, 0x08, 0x08, 0x08,
+    0xBD, 1, 0x06,
+    0xBC, 1, 0x00,
+    0xFF, 3, 0x60, 0x01, 0x04,
+    0xC3, 1, 0x13,
+    0xC4, 1, 0x13,
+    0xC9, 1, 0x22,
+    0xBE, 1, 0x11,
+    0xE1, 2, 0x10, 0x0E,
+    0xDF, 3, 0x21, 0x0C, 0x02,
+    0xF0, 6, 0x45, 0x09, 0x08, 0x08, 0x26, 0x2A,
+    0xF1, 6, 0x43, 0x70, 0x72, 0x36, 0x37, 0x6F,
+    0xF2, 6, 0x45, 0x09, 0x08, 0x08, 0x26, 0x2A,
+    0xF3, 6, 0x43, 0x70, 0x72, 0x36, 0x37, 0x6F,
+    0xED, 2, 0x1B, 0x0B,
+    0xAE, 1, 0x77,
+    0xCD, 1, 0x63,
+    0x70, 9, 0x07, 0x07, 0x04, 0x0E, 0x0F, 0x09, 0x07,
+              0x08, 0x03,
+    0xE8, 1, 0x34,
+    0x62, 12, 0x18, 0x0D, 0x71, 0xED, 0x70, 0x70, 0x18,
+              0x0F, 0x71, 0xEF, 0x70, 0x70,
+    0x63, 12, 0x18, 0x11, 0x71, 0xF1, 0x70, 0x70, 0x18,
+              0x13, 0x71, 0xF3, 0x70, 0x70,
+    0x64, 7, 0x28, 0x29, 0xF1, 0x01, 0xF1, 0x00, 0x07,
+    0x66, 10, 0x3C, 0x00, 0xCD, 0x67, 0x45, 0x45, 0x10,
+              0x00, 0x00, 0x00,
+    0x67, 10, 0x00, 0x3C, 0x00, 0x00, 0x00, 0x01, 0x54,
+              0x10, 0x32, 0x98,
+    0x74, 7, 0x10, 0x85, 0x80, 0x00, 0x00, 0x4E, 0x00,
+    0x98, 2, 0x3E, 0x07,
+    0x35, 0,
+    0x21, 0,
+    0x11, 0 | DEV_CMD_DELAY, 120,
+    0x29, 0 | DEV_CMD_DELAY, 20,
+};
+
+static const LCD_PANEL_SCAN LCD_1IN28_Scan[] = {
+    [HORIZONTAL] = {0xC0, 0, 0},
+    [VERTICAL]   = {0x60, 0, 0},
+};
+
+static const LCD_PANEL LCD_1IN28_Panel = {
+    "1.28inch GC9A01", LCD_1IN28_WIDTH, LCD_1IN28_HEIGHT, LCD_PANEL_BGR, 100,
+    LCD_1IN28_InitSeq, sizeof(LCD_1IN28_InitSeq), LCD_1IN28_Scan, 2,
+};
 
 /********************************************************************************
 function :	Initialize the lcd
@@ -344,16 +97,11 @@ parameter:
 ********************************************************************************/
 void LCD_1IN28_Init(UBYTE Scan_dir)
 {
-    //Turn on the backlight
-    LCD_1IN28_BL_1;
-    //Hardware reset
-    LCD_1IN28_Reset();
+    LCD_Panel_Init(&LCD_1IN28_Panel, Scan_dir);
 
-    //Set the resolution and scanning method of the screen
-    LCD_1IN28_SetAttributes(Scan_dir);
-    
-    //Set the initialization register
-    LCD_1IN28_InitReg();
+    LCD_1IN28.SCAN_DIR = Scan_dir;
+    LCD_1IN28.WIDTH = LCD_Panel.WIDTH;
+    LCD_1IN28.HEIGHT = LCD_Panel.HEIGHT;
 }
 
 /********************************************************************************
@@ -366,21 +114,7 @@ parameter:
 ********************************************************************************/
 void LCD_1IN28_SetWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend)
 {
-    //set the X coordinates
-    LCD_1IN28_SendCommand(0x2A);
-    LCD_1IN28_SendData_8Bit(0x00);
-    LCD_1IN28_SendData_8Bit(Xstart);
-	LCD_1IN28_SendData_8Bit((Xend-1)>>8);
-    LCD_1IN28_SendData_8Bit(Xend-1);
-
-    //set the Y coordinates
-    LCD_1IN28_SendCommand(0x2B);
-    LCD_1IN28_SendData_8Bit(0x00);
-	LCD_1IN28_SendData_8Bit(Ystart);
-	LCD_1IN28_SendData_8Bit((Yend-1)>>8);
-    LCD_1IN28_SendData_8Bit(Yend-1);
-
-    LCD_1IN28_SendCommand(0X2C);
+    LCD_Panel_SetWindows(Xstart, Ystart, Xend, Yend);
 }
 
 /******************************************************************************
@@ -389,20 +123,7 @@ parameter:
 ******************************************************************************/
 void LCD_1IN28_Clear(UWORD Color)
 {
-    UWORD j;
-    UWORD Image[LCD_1IN28_WIDTH*LCD_1IN28_HEIGHT];
-    
-    Color = ((Color<<8)&0xff00)|(Color>>8);
-   
-    for (j = 0; j < LCD_1IN28_HEIGHT*LCD_1IN28_WIDTH; j++) {
-        Image[j] = Color;
-    }
-    
-    LCD_1IN28_SetWindows(0, 0, LCD_1IN28_WIDTH, LCD_1IN28_HEIGHT);
-    LCD_1IN28_DC_1;
-    for(j = 0; j < LCD_1IN28_HEIGHT; j++){
-        DEV_SPI_Write_nByte((uint8_t *)&Image[j*LCD_1IN28_WIDTH], LCD_1IN28_WIDTH*2);
-    }
+    LCD_Panel_Clear(Color);
 }
 
 /******************************************************************************
@@ -411,33 +132,18 @@ parameter:
 ******************************************************************************/
 void LCD_1IN28_Display(UWORD *Image)
 {
-    UWORD j;
-    LCD_1IN28_SetWindows(0, 0, LCD_1IN28_WIDTH, LCD_1IN28_HEIGHT);
-    LCD_1IN28_DC_1;
-    for (j = 0; j < LCD_1IN28_HEIGHT; j++) {
-        DEV_SPI_Write_nByte((uint8_t *)&Image[j*LCD_1IN28_WIDTH], LCD_1IN28_WIDTH*2);
-    }
+    LCD_Panel_Display(Image);
 }
 
 void LCD_1IN28_DisplayWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD *Image)
 {
-    // display
-    UDOUBLE Addr = 0;
-
-    UWORD j;
-    LCD_1IN28_SetWindows(Xstart, Ystart, Xend , Yend);
-    LCD_1IN28_DC_1;
-    for (j = Ystart; j < Yend - 1; j++) {
-        Addr = Xstart + j * LCD_1IN28_WIDTH ;
-        DEV_SPI_Write_nByte((uint8_t *)&Image[Addr], (Xend-Xstart)*2);
-    }
+    LCD_Panel_DisplayWindows(Xstart, Ystart, Xend, Yend,
+        Image + (UDOUBLE)Ystart * LCD_Panel.WIDTH + Xstart, LCD_Panel.WIDTH);
 }
 
-
 void LCD_1IN28_DisplayPoint(UWORD X, UWORD Y, UWORD Color)
 {
-    LCD_1IN28_SetWindows(X,Y,X,Y);
-    LCD_1IN28_SendData_16Bit(Color);
+    LCD_Panel_DisplayPoint(X, Y, Color);
 }
 
 void  Handler_1IN28_LCD(int signo)
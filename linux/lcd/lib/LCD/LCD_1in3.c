@@ -12,7 +12,7 @@
 *
 ******************************************************************************/
 #include "LCD_1in3.h"
-#include "DEV_Config.h"
+#include "LCD_Panel.h"
 
 #include <stdlib.h>		//itoa()
 #include <stdio.h>
@@ -20,158 +20,39 @@
 LCD_1IN3_ATTRIBUTES LCD;
 
 
-/******************************************************************************
-function :	Hardware reset
-parameter:
-******************************************************************************/
-static void LCD_1IN3_Reset(void)
-{
-    LCD_1IN3_RST_1;
-    DEV_Delay_ms(100);
-    LCD_1IN3_RST_0;
-    DEV_Delay_ms(100);
-    LCD_1IN3_RST_1;
-    DEV_Delay_ms(100);
-}
-
-/******************************************************************************
-function :	send command
-parameter:
-     Reg : Command register
-******************************************************************************/
-static void LCD_1IN3_SendCommand(UBYTE Reg)
-{
-    LCD_1IN3_DC_0;
-    DEV_SPI_WriteByte(Reg);
-}
-
-/******************************************************************************
-function :	send data
-parameter:
-    Data : Write data
-******************************************************************************/
-static void LCD_1IN3_SendData_8Bit(UBYTE Data)
-{
-    LCD_1IN3_DC_1;
-    DEV_SPI_WriteByte(Data);
-}
-
-/******************************************************************************
-function :	send data
-parameter:
-    Data : Write data
-******************************************************************************/
-static void LCD_1IN3_SendData_16Bit(UWORD Data)
-{
-    LCD_1IN3_DC_1;
-    DEV_SPI_WriteByte((Data >> 8) & 0xFF);
-    DEV_SPI_WriteByte(Data & 0xFF);
-}
-
 /******************************************************************************
 function :	Initialize the lcd register
 parameter:
 ******************************************************************************/
-static void LCD_1IN3_InitReg(void)
-{
-    LCD_1IN3_SendCommand(0x3A);
-    LCD_1IN3_SendData_8Bit(0x05);
-
-    LCD_1IN3_SendCommand(0xB2);
-    LCD_1IN3_SendData_8Bit(0x0C);
-    LCD_1IN3_SendData_8Bit(0x0C);
-    LCD_1IN3_SendData_8Bit(0x00);
-    LCD_1IN3_SendData_8Bit(0x33);
-    LCD_1IN3_SendData_8Bit(0x33);
-
-    LCD_1IN3_SendCommand(0xB7);  //Gate Control
-    LCD_1IN3_SendData_8Bit(0x35);
-
-    LCD_1IN3_SendCommand(0xBB);  //VCOM Setting
-    LCD_1IN3_SendData_8Bit(0x19);
-
-    LCD_1IN3_SendCommand(0xC0); //LCM Control     
-    LCD_1IN3_SendData_8Bit(0x2C);
-
-    LCD_1IN3_SendCommand(0xC2);  //VDV and VRH Command Enable
-    LCD_1IN3_SendData_8Bit(0x01);
-    LCD_1IN3_SendCommand(0xC3);  //VRH Set
-    LCD_1IN3_SendData_8Bit(0x12);
-    LCD_1IN3_SendCommand(0xC4);  //VDV Set
-    LCD_1IN3_SendData_8Bit(0x20);
-
-    LCD_1IN3_SendCommand(0xC6);  //Frame Rate Control in Normal Mode
-    LCD_1IN3_SendData_8Bit(0x0F);
-    
-    LCD_1IN3_SendCommand(0xD0);  // Power Control 1
-    LCD_1IN3_SendData_8Bit(0xA4);
-    LCD_1IN3_SendData_8Bit(0xA1);
-
-    LCD_1IN3_SendCommand(0xE0);  //Positive Voltage Gamma Control
-    LCD_1IN3_SendData_8Bit(0xD0);
-    LCD_1IN3_SendData_8Bit(0x04);
-    LCD_1IN3_SendData_8Bit(0x0D);
-    LCD_1IN3_SendData_8Bit(0x11);
-    LCD_1IN3_SendData_8Bit(0x13);
-    LCD_1IN3_SendData_8Bit(0x2B);
-    LCD_1IN3_SendData_8Bit(0x3F);
-    LCD_1IN3_SendData_8Bit(0x54);
-    LCD_1IN3_SendData_8Bit(0x4C);
-    LCD_1IN3_SendData_8Bit(0x18);
-    LCD_1IN3_SendData_8Bit(0x0D);
-    LCD_1IN3_SendData_8Bit(0x0B);
-    LCD_1IN3_SendData_8Bit(0x1F);
-    LCD_1IN3_SendData_8Bit(0x23);
-
-    LCD_1IN3_SendCommand(0xE1);  //Negative Voltage Gamma Control
-    LCD_1IN3_SendData_8Bit(0xD0);
-    LCD_1IN3_SendData_8Bit(0x04);
-    LCD_1IN3_SendData_8Bit(0x0C);
-    LCD_1IN3_SendData_8Bit(0x11);
-    LCD_1IN3_SendData_8Bit(0x13);
-    LCD_1IN3_SendData_8Bit(0x2C);
-    LCD_1IN3_SendData_8Bit(0x3F);
-    LCD_1IN3_SendData_8Bit(0x44);
-    LCD_1IN3_SendData_8Bit(0x51);
-    LCD_1IN3_SendData_8Bit(0x2F);
-    LCD_1IN3_SendData_8Bit(0x1F);
-    LCD_1IN3_SendData_8Bit(0x1F);
-    LCD_1IN3_SendData_8Bit(0x20);
-    LCD_1IN3_SendData_8Bit(0x23);
-
-    LCD_1IN3_SendCommand(0x21);  //Display Inversion On
-
-    LCD_1IN3_SendCommand(0x11);  //Sleep Out
-
-    LCD_1IN3_SendCommand(0x29);  //Display On
-}
-
-/********************************************************************************
-function:	Set the resolution and scanning method of the screen
-parameter:
-		Scan_dir:   Scan direction
-********************************************************************************/
-static void LCD_1IN3_SetAttributes(UBYTE Scan_dir)
-{
-    //Get the screen scan direction
-    LCD.SCAN_DIR = Scan_dir;
-    UBYTE MemoryAccessReg = 0x00;
-
-    //Get GRAM and LCD width and height
-    if(Scan_dir == HORIZONTAL) {
-        LCD.HEIGHT	= LCD_1IN3_HEIGHT;
-        LCD.WIDTH   = LCD_1IN3_WIDTH;
-        MemoryAccessReg = 0X70;
-    } else {
-        LCD.HEIGHT	= LCD_1IN3_WIDTH;
-        LCD.WIDTH   = LCD_1IN3_HEIGHT;
-        MemoryAccessReg = 0X00;
-    }
-
-    // Set the read / write scan direction of the frame memory
-    LCD_1IN3_SendCommand(0x36); //MX, MY, RGB mode
-    LCD_1IN3_SendData_8Bit(MemoryAccessReg);	//0x08 set RGB
-}
+static const UBYTE LCD_1IN3_InitSeq[] = {
+    0x3A, 1, 0x05,
+    0xB2, 5, 0x0C, 0x0C, 0x00, 0x33, 0x33,
+    0xB7, 1, 0x35,                      //Gate Control
+    0xBB, 1, 0x19,                      //VCOM Setting
+    0xC0, 1, 0x2C,                      //LCM Control
+    0xC2, 1, 0x01,                      //VDV and VRH Command Enable
+    0xC3, 1, 0x12,                      //VRH Set
+    0xC4, 1, 0x20,                      //VDV Set
+    0xC6, 1, 0x0F,                      //Frame Rate Control in Normal Mode
+    0xD0, 2, 0xA4, 0xA1,                //Power Control 1
+    0xE0, 14, 0xD0, 0x04, 0x0D, 0x11, 0x13, 0x2B, 0x3F,   //Positive Voltage Gamma Control
+              0x54, 0x4C, 0x18, 0x0D, 0x0B, 0x1F, 0x23,
+    0xE1, 14, 0xD0, 0x04, 0x0C, 0x11, 0x13, 0x2C, 0x3F,   //Negative Voltage Gamma Control
+              0x44, 0x51, 0x2F, 0x1F, 0x1F, 0x20, 0x23,
+    0x21, 0,                            //Display Inversion On
+    0x11, 0,                            //Sleep Out
+    0x29, 0,                            //Display On
+};
+
+static const LCD_PANEL_SCAN LCD_1IN3_Scan[] = {
+    [HORIZONTAL] = {0x70, 0, 0},
+    [VERTICAL]   = {0x00, 0, 0},
+};
+
+static const LCD_PANEL LCD_1IN3_Panel = {
+    "1.3inch ST7789", LCD_1IN3_WIDTH, LCD_1IN3_HEIGHT, LCD_PANEL_RGB, 100,
+    LCD_1IN3_InitSeq, sizeof(LCD_1IN3_InitSeq), LCD_1IN3_Scan, 2,
+};
 
 /********************************************************************************
 function :	Initialize the lcd
@@ -179,17 +60,11 @@ parameter:
 ********************************************************************************/
 void LCD_1IN3_Init(UBYTE Scan_dir)
 {
-    //Turn on the backlight
-    LCD_1IN3_BL_1;
-
-    //Hardware reset
-    LCD_1IN3_Reset();
+    LCD_Panel_Init(&LCD_1IN3_Panel, Scan_dir);
 
-    //Set the resolution and scanning method of the screen
-    LCD_1IN3_SetAttributes(Scan_dir);
-    
-    //Set the initialization register
-    LCD_1IN3_InitReg();
+    LCD.SCAN_DIR = Scan_dir;
+    LCD.WIDTH = LCD_Panel.WIDTH;
+    LCD.HEIGHT = LCD_Panel.HEIGHT;
 }
 
 /********************************************************************************
@@ -202,21 +77,7 @@ parameter:
 ********************************************************************************/
 void LCD_1IN3_SetWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend)
 {
-    //set the X coordinates
-    LCD_1IN3_SendCommand(0x2A);
-    LCD_1IN3_SendData_8Bit((Xstart >> 8) & 0xFF);
-    LCD_1IN3_SendData_8Bit(Xstart & 0xFF);
-    LCD_1IN3_SendData_8Bit(((Xend  - 1) >> 8) & 0xFF);
-    LCD_1IN3_SendData_8Bit((Xend  - 1) & 0xFF);
-
-    //set the Y coordinates
-    LCD_1IN3_SendCommand(0x2B);
-    LCD_1IN3_SendData_8Bit((Ystart >> 8) & 0xFF);
-    LCD_1IN3_SendData_8Bit(Ystart & 0xFF);
-    LCD_1IN3_SendData_8Bit(((Yend  - 1) >> 8) & 0xFF);
-    LCD_1IN3_SendData_8Bit((Yend  - 1) & 0xFF);
-
-    LCD_1IN3_SendCommand(0X2C);
+    LCD_Panel_SetWindows(Xstart, Ystart, Xend, Yend);
 }
 
 /******************************************************************************
@@ -225,20 +86,7 @@ parameter:
 ******************************************************************************/
 void LCD_1IN3_Clear(UWORD Color)
 {
-    UWORD j;
-    UWORD Image[LCD_1IN3_WIDTH*LCD_1IN3_HEIGHT];
-    
-    Color = ((Color<<8)&0xff00)|(Color>>8);
-   
-    for (j = 0; j < LCD_1IN3_HEIGHT*LCD_1IN3_WIDTH; j++) {
-        Image[j] = Color;
-    }
-    
-    LCD_1IN3_SetWindows(0, 0, LCD_1IN3_WIDTH, LCD_1IN3_HEIGHT);
-    LCD_1IN3_DC_1;
-    for(j = 0; j < LCD_1IN3_HEIGHT; j++){
-        DEV_SPI_Write_nByte((uint8_t *)&Image[j*LCD_1IN3_WIDTH], LCD_1IN3_WIDTH*2);
-    }
+    LCD_Panel_Clear(Color);
 }
 
 /******************************************************************************
@@ -247,32 +95,18 @@ parameter:
 ******************************************************************************/
 void LCD_1IN3_Display(UWORD *Image)
 {
-    UWORD j;
-    LCD_1IN3_SetWindows(0, 0, LCD_1IN3_WIDTH, LCD_1IN3_HEIGHT);
-    LCD_1IN3_DC_1;
-    for (j = 0; j < LCD_1IN3_HEIGHT; j++) {
-        DEV_SPI_Write_nByte((uint8_t *)&Image[j*LCD_1IN3_WIDTH], LCD_1IN3_WIDTH*2);
-    }
+    LCD_Panel_Display(Image);
 }
 
 void LCD_1IN3_DisplayWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD *Image)
 {
-    // display
-    UDOUBLE Addr = 0;
-
-    UWORD j;
-    LCD_1IN3_SetWindows(Xstart, Ystart, Xend , Yend);
-    LCD_1IN3_DC_1;
-    for (j = Ystart; j < Yend - 1; j++) {
-        Addr = Xstart + j * LCD_1IN3_WIDTH ;
-        DEV_SPI_Write_nByte((uint8_t *)&Image[Addr], (Xend-Xstart)*2);
-    }
+    LCD_Panel_DisplayWindows(Xstart, Ystart, Xend, Yend,
+        Image + (UDOUBLE)Ystart * LCD_Panel.WIDTH + Xstart, LCD_Panel.WIDTH);
 }
 
 void LCD_1IN3_DisplayPoint(UWORD X, UWORD Y, UWORD Color)
 {
-    LCD_1IN3_SetWindows(X,Y,X,Y);
-    LCD_1IN3_SendData_16Bit(Color);
+    LCD_Panel_DisplayPoint(X, Y, Color);
 }
 
 void  Handler_1IN3_LCD(int signo)
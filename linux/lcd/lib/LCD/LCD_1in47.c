@@ -12,177 +12,48 @@
  *
  ******************************************************************************/
 #include "LCD_1in47.h"
-#include "DEV_Config.h"
+#include "LCD_Panel.h"
 
 #include <stdlib.h> //itoa()
 #include <stdio.h>
 
 LCD_1IN47_ATTRIBUTES LCD_1IN47;
 
-/******************************************************************************
-function :	Hardware reset
-parameter:
-******************************************************************************/
-static void LCD_1IN47_Reset(void)
-{
-	LCD_1IN47_RST_1;
-	DEV_Delay_ms(100);
-	LCD_1IN47_RST_0;
-	DEV_Delay_ms(100);
-	LCD_1IN47_RST_1;
-	DEV_Delay_ms(100);
-}
-
-/******************************************************************************
-function :	send command
-parameter:
-	 Reg : Command register
-******************************************************************************/
-static void LCD_1IN47_SendCommand(UBYTE Reg)
-{
-	LCD_1IN47_DC_0;
-	DEV_SPI_WriteByte(Reg);
-}
-
-/******************************************************************************
-function :	send data
-parameter:
-	Data : Write data
-******************************************************************************/
-static void LCD_1IN47_SendData_8Bit(UBYTE Data)
-{
-	LCD_1IN47_DC_1;
-	DEV_SPI_WriteByte(Data);
-}
-
-/******************************************************************************
-function :	send data
-parameter:
-	Data : Write data
-******************************************************************************/
-static void LCD_1IN47_SendData_16Bit(UWORD Data)
-{
-	LCD_1IN47_DC_1;
-	DEV_SPI_WriteByte(Data >> 8);
-	DEV_SPI_WriteByte(Data);
-}
-
 /******************************************************************************
 function :	Initialize the lcd register
 parameter:
 ******************************************************************************/
-static void LCD_1IN47_InitReg(void)
-{
-	LCD_1IN47_SendCommand(0x11);
-	DEV_Delay_ms(120);
-
-	LCD_1IN47_SendCommand(0x3A);
-	LCD_1IN47_SendData_8Bit(0x05);
-
-	LCD_1IN47_SendCommand(0xB2);
-	LCD_1IN47_SendData_8Bit(0x0C);
-	LCD_1IN47_SendData_8Bit(0x0C);
-	LCD_1IN47_SendData_8Bit(0x00);
-	LCD_1IN47_SendData_8Bit(0x33);
-	LCD_1IN47_SendData_8Bit(0x33);
-
-	LCD_1IN47_SendCommand(0xB7);
-	LCD_1IN47_SendData_8Bit(0x35);
-
-	LCD_1IN47_SendCommand(0xBB);
-	LCD_1IN47_SendData_8Bit(0x35);
-
-	LCD_1IN47_SendCommand(0xC0);
-	LCD_1IN47_SendData_8Bit(0x2C);
-
-	LCD_1IN47_SendCommand(0xC2);
-	LCD_1IN47_SendData_8Bit(0x01);
-
-	LCD_1IN47_SendCommand(0xC3);
-	LCD_1IN47_SendData_8Bit(0x13);
-
-	LCD_1IN47_SendCommand(0xC4);
-	LCD_1IN47_SendData_8Bit(0x20);
-
-	LCD_1IN47_SendCommand(0xC6);
-	LCD_1IN47_SendData_8Bit(0x0F);
-
-	LCD_1IN47_SendCommand(0xD0);
-	LCD_1IN47_SendData_8Bit(0xA4);
-	LCD_1IN47_SendData_8Bit(0xA1);
-
-	LCD_1IN47_SendCommand(0xD6);
-	LCD_1IN47_SendData_8Bit(0xA1);
-
-	LCD_1IN47_SendCommand(0xE0);
-	LCD_1IN47_SendData_8Bit(0xF0);
-	LCD_1IN47_SendData_8Bit(0x00);
-	LCD_1IN47_SendData_8Bit(0x04);
-	LCD_1IN47_SendData_8Bit(0x04);
-	LCD_1IN47_SendData_8Bit(0x04);
-	LCD_1IN47_SendData_8Bit(0x05);
-	LCD_1IN47_SendData_8Bit(0x29);
-	LCD_1IN47_SendData_8Bit(0x33);
-	LCD_1IN47_SendData_8Bit(0x3E);
-	LCD_1IN47_SendData_8Bit(0x38);
-	LCD_1IN47_SendData_8Bit(0x12);
-	LCD_1IN47_SendData_8Bit(0x12);
-	LCD_1IN47_SendData_8Bit(0x28);
-	LCD_1IN47_SendData_8Bit(0x30);
-
-	LCD_1IN47_SendCommand(0xE1);
-	LCD_1IN47_SendData_8Bit(0xF0);
-	LCD_1IN47_SendData_8Bit(0x07);
-	LCD_1IN47_SendData_8Bit(0x0A);
-	LCD_1IN47_SendData_8Bit(0x0D);
-	LCD_1IN47_SendData_8Bit(0x0B);
-	LCD_1IN47_SendData_8Bit(0x07);
-	LCD_1IN47_SendData_8Bit(0x28);
-	LCD_1IN47_SendData_8Bit(0x33);
-	LCD_1IN47_SendData_8Bit(0x3E);
-	LCD_1IN47_SendData_8Bit(0x36);
-	LCD_1IN47_SendData_8Bit(0x14);
-	LCD_1IN47_SendData_8Bit(0x14);
-	LCD_1IN47_SendData_8Bit(0x29);
-	LCD_1IN47_SendData_8Bit(0x32);
-
-	LCD_1IN47_SendCommand(0x21);
-
-	LCD_1IN47_SendCommand(0x11);
-	DEV_Delay_ms(120);
-	LCD_1IN47_SendCommand(0x29);
-}
-
-/********************************************************************************
-function:	Set the resolution and scanning method of the screen
-parameter:
-		Scan_dir:   Scan direction
-********************************************************************************/
-static void LCD_1IN47_SetAttributes(UBYTE Scan_dir)
-{
-	// Get the screen scan direction
-	LCD_1IN47.SCAN_DIR = Scan_dir;
-	UBYTE MemoryAccessReg = 0x00;
-
-	// Get GRAM and LCD width and height
-	if (Scan_dir == HORIZONTAL)
-	{
-		LCD_1IN47.HEIGHT = LCD_1IN47_WIDTH;
-		LCD_1IN47.WIDTH = LCD_1IN47_HEIGHT;
-		MemoryAccessReg = 0X00;
-	}
-	else
-	{
-		LCD_1IN47.HEIGHT = LCD_1IN47_HEIGHT;
-		LCD_1IN47.WIDTH = LCD_1IN47_WIDTH;		
-		MemoryAccessReg = 0X70;
-	}
-
-	// Set the read / write scan direction of the frame memory
-	LCD_1IN47_SendCommand(0x36); // MX, MY, RGB mode
-	// LCD_1IN47_SendData_8Bit(MemoryAccessReg);	//0x08 set RGB
-	LCD_1IN47_SendData_8Bit(MemoryAccessReg); // 0x08 set RGB
-}
+static const UBYTE LCD_1IN47_InitSeq[] = {
+    0x11, 0 | DEV_CMD_DELAY, 120,
+    0x3A, 1, 0x05,
+    0xB2, 5, 0x0C, 0x0C, 0x00, 0x33, 0x33,
+    0xB7, 1, 0x35,
+    0xBB, 1, 0x35,
+    0xC0, 1, 0x2C,
+    0xC2, 1, 0x01,
+    0xC3, 1, 0x13,
+    0xC4, 1, 0x20,
+    0xC6, 1, 0x0F,
+    0xD0, 2, 0xA4, 0xA1,
+    0xD6, 1, 0xA1,
+    0xE0, 14, 0xF0, 0x00, 0x04, 0x04, 0x04, 0x05, 0x29,
+              0x33, 0x3E, 0x38, 0x12, 0x12, 0x28, 0x30,
+    0xE1, 14, 0xF0, 0x07, 0x0A, 0x0D, 0x0B, 0x07, 0x28,
+              0x33, 0x3E, 0x36, 0x14, 0x14, 0x29, 0x32,
+    0x21, 0,
+    0x11, 0 | DEV_CMD_DELAY, 120,
+    0x29, 0,
+};
+
+static const LCD_PANEL_SCAN LCD_1IN47_Scan[] = {
+    [HORIZONTAL] = {0x00, 34, 0},
+    [VERTICAL]   = {0x70, 0, 34},
+};
+
+static const LCD_PANEL LCD_1IN47_Panel = {
+    "1.47inch ST7789", LCD_1IN47_WIDTH, LCD_1IN47_HEIGHT, LCD_PANEL_RGB, 100,
+    LCD_1IN47_InitSeq, sizeof(LCD_1IN47_InitSeq), LCD_1IN47_Scan, 2,
+};
 
 /********************************************************************************
 function :	Initialize the lcd
@@ -190,14 +61,12 @@ parameter:
 ********************************************************************************/
 void LCD_1IN47_Init(UBYTE Scan_dir)
 {
-	// Hardware reset
-	LCD_1IN47_Reset();
-
-	// Set the resolution and scanning method of the screen
-	LCD_1IN47_SetAttributes(Scan_dir);
+    LCD_Panel_Init(&LCD_1IN47_Panel, Scan_dir);
 
-	// Set the initialization register
-	LCD_1IN47_InitReg();
+    //Reported as this driver always has: the other way round
+    LCD_1IN47.SCAN_DIR = Scan_dir;
+    LCD_1IN47.WIDTH = LCD_Panel.HEIGHT;
+    LCD_1IN47.HEIGHT = LCD_Panel.WIDTH;
 }
 
 /********************************************************************************
@@ -210,41 +79,7 @@ parameter:
 ********************************************************************************/
 void LCD_1IN47_SetWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend)
 {
-	if (LCD_1IN47.SCAN_DIR == HORIZONTAL)
-	{ 
-		
-		// set the X coordinates
-		LCD_1IN47_SendCommand(0x2A);
-		LCD_1IN47_SendData_8Bit(0x00);
-		LCD_1IN47_SendData_8Bit(Xstart + 0x22);
-		LCD_1IN47_SendData_8Bit(((Xend + 0x22) - 1) >> 8);
-		LCD_1IN47_SendData_8Bit((Xend + 0x22) - 1);
-
-		// set the Y coordinates
-		LCD_1IN47_SendCommand(0x2B);
-		LCD_1IN47_SendData_8Bit(0x00);
-		LCD_1IN47_SendData_8Bit(Ystart);
-		LCD_1IN47_SendData_8Bit((Yend - 1) >> 8);
-		LCD_1IN47_SendData_8Bit(Yend - 1);
-	}
-	else
-	{ 
-		// set the X coordinates
-		LCD_1IN47_SendCommand(0x2A);
-		LCD_1IN47_SendData_8Bit(Xstart >> 8);
-		LCD_1IN47_SendData_8Bit(Xstart);
-		LCD_1IN47_SendData_8Bit((Xend - 1) >> 8);
-		LCD_1IN47_SendData_8Bit(Xend - 1);
-
-		// set the Y coordinates
-		LCD_1IN47_SendCommand(0x2B);
-		LCD_1IN47_SendData_8Bit(Ystart >> 8);
-		LCD_1IN47_SendData_8Bit(Ystart + 0x22);
-		LCD_1IN47_SendData_8Bit((Yend - 1 + 0x22) >> 8);
-		LCD_1IN47_SendData_8Bit(Yend - 1 + 0x22);
-	}
-
-	LCD_1IN47_SendCommand(0X2C);
+    LCD_Panel_SetWindows(Xstart, Ystart, Xend, Yend);
 }
 
 /******************************************************************************
@@ -253,22 +88,7 @@ parameter:
 ******************************************************************************/
 void LCD_1IN47_Clear(UWORD Color)
 {
-	UWORD j;
-	UWORD Image[LCD_1IN47_WIDTH * LCD_1IN47_HEIGHT];
-
-	Color = ((Color << 8) & 0xff00) | (Color >> 8);
-
-	for (j = 0; j < LCD_1IN47_HEIGHT * LCD_1IN47_WIDTH; j++)
-	{
-		Image[j] = Color;
-	}
-
-	LCD_1IN47_SetWindows(0, 0, LCD_1IN47.HEIGHT, LCD_1IN47.WIDTH);
-	LCD_1IN47_DC_1;
-	for (j = 0; j < LCD_1IN47.WIDTH; j++)
-	{
-		DEV_SPI_Write_nByte((uint8_t *)&Image[j * LCD_1IN47.HEIGHT], LCD_1IN47.HEIGHT * 2);
-	}
+    LCD_Panel_Clear(Color);
 }
 
 /******************************************************************************
@@ -277,40 +97,24 @@ parameter:
 ******************************************************************************/
 void LCD_1IN47_Display(UWORD *Image)
 {
-	UWORD j;
-	LCD_1IN47_SetWindows(0, 0, LCD_1IN47.HEIGHT, LCD_1IN47.WIDTH);
-	LCD_1IN47_DC_1;
-	for (j = 0; j < LCD_1IN47.WIDTH; j++)
-	{
-		DEV_SPI_Write_nByte((uint8_t *)&Image[j * LCD_1IN47.HEIGHT], LCD_1IN47.HEIGHT * 2);
-	}
-
+    LCD_Panel_Display(Image);
 }
 
 void LCD_1IN47_DisplayWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD *Image)
 {
-	// display
-	UDOUBLE Addr = 0;
-	UWORD j;
-	LCD_1IN47_SetWindows(Xstart, Ystart, Xend, Yend);
-	LCD_1IN47_DC_1;
-	for (j = Ystart; j < Yend - 1; j++)
-	{
-		Addr = Xstart + j * LCD_1IN47.HEIGHT;
-		DEV_SPI_Write_nByte((uint8_t *)&Image[Addr], (Xend - Xstart) * 2);
-	}
+    LCD_Panel_DisplayWindows(Xstart, Ystart, Xend, Yend,
+        Image + (UDOUBLE)Ystart * LCD_Panel.WIDTH + Xstart, LCD_Panel.WIDTH);
 }
 
 void LCD_1IN47_DisplayPoint(UWORD X, UWORD Y, UWORD Color)
 {
-	LCD_1IN47_SetWindows(X, Y, X, Y);
-	LCD_1IN47_SendData_16Bit(Color);
+    LCD_Panel_DisplayPoint(X, Y, Color);
 }
 
-void Handler_1IN47_LCD(int signo)
+void  Handler_1IN47_LCD(int signo)
 {
-	// System Exit
-	printf("\r\nHandler:Program stop\r\n");
-	DEV_ModuleExit();
+    //System Exit
+    printf("\r\nHandler:Program stop\r\n");     
+    DEV_ModuleExit();
 	exit(0);
 }
\ No newline at end of file
@@ -10,7 +10,7 @@
  *
  ******************************************************************************/
 #include "LCD_1in69.h"
-#include "DEV_Config.h"
+#include "LCD_Panel.h"
 
 #include <stdlib.h> //itoa()
 #include <stdio.h>
@@ -18,290 +18,104 @@
 LCD_1IN69_ATTRIBUTES LCD_1IN69;
 
 /******************************************************************************
-function :  Hardware reset
+function :	Initialize the lcd register
 parameter:
 ******************************************************************************/
-static void LCD_1IN69_Reset(void)
-{
-    LCD_1IN69_RST_1;
-    DEV_Delay_ms(100);
-    LCD_1IN69_RST_0;
-    DEV_Delay_ms(100);
-    LCD_1IN69_RST_1;
-    DEV_Delay_ms(100);
-}
-
-/******************************************************************************
-function :  send command
-parameter:
-     Reg : Command register
-******************************************************************************/
-static void LCD_1IN69_SendCommand(UBYTE Reg)
-{
-    LCD_1IN69_DC_0;
-    DEV_SPI_WriteByte(Reg);
-}
-
-/******************************************************************************
-function :  send data
-parameter:
-    Data : Write data
-******************************************************************************/
-static void LCD_1IN69_SendData_8Bit(UBYTE Data)
-{
-    LCD_1IN69_DC_1;
-    DEV_SPI_WriteByte(Data);
-}
-
-/******************************************************************************
-function :  send data
-parameter:
-    Data : Write data
-******************************************************************************/
-static void LCD_1IN69_SendData_16Bit(UWORD Data)
-{
-    LCD_1IN69_DC_1;
-    DEV_SPI_WriteByte((Data >> 8) & 0xFF);
-    DEV_SPI_WriteByte(Data & 0xFF);
-}
-
-/******************************************************************************
-function :  Initialize the lcd register
-parameter:
-******************************************************************************/
-static void LCD_1IN69_InitReg(void)
-{
-    DEV_SPI_WriteByte(0xaa);
-    DEV_SPI_WriteByte(0xaa);
-    DEV_SPI_WriteByte(0xaa);
-    LCD_1IN69_SendCommand(0x36);
-    LCD_1IN69_SendData_8Bit(0x00);
-
-    LCD_1IN69_SendCommand(0x3A);
-    LCD_1IN69_SendData_8Bit(0x05);
-
-    LCD_1IN69_SendCommand(0xB2);
-    LCD_1IN69_SendData_8Bit(0x0B);
-    LCD_1IN69_SendData_8Bit(0x0B);
-    LCD_1IN69_SendData_8Bit(0x00);
-    LCD_1IN69_SendData_8Bit(0x33);
-    LCD_1IN69_SendData_8Bit(0x35);
-
-    LCD_1IN69_SendCommand(0xB7);
-    LCD_1IN69_SendData_8Bit(0x11);
-
-    LCD_1IN69_SendCommand(0xBB);
-    LCD_1IN69_SendData_8Bit(0x35);
-
-    LCD_1IN69_SendCommand(0xC0);
-    LCD_1IN69_SendData_8Bit(0x2C);
-
-    LCD_1IN69_SendCommand(0xC2);
-    LCD_1IN69_SendData_8Bit(0x01);
-
-    LCD_1IN69_SendCommand(0xC3);
-    LCD_1IN69_SendData_8Bit(0x0D);
-
-    LCD_1IN69_SendCommand(0xC4);
-    LCD_1IN69_SendData_8Bit(0x20);
-
-    LCD_1IN69_SendCommand(0xC6);
-    LCD_1IN69_SendData_8Bit(0x13);
-
-    LCD_1IN69_SendCommand(0xD0);
-    LCD_1IN69_SendData_8Bit(0xA4);
-    LCD_1IN69_SendData_8Bit(0xA1);
-
-    LCD_1IN69_SendCommand(0xD6);
-    LCD_1IN69_SendData_8Bit(0xA1);
-
-    LCD_1IN69_SendCommand(0xE0);
-    LCD_1IN69_SendData_8Bit(0xF0);
-    LCD_1IN69_SendData_8Bit(0x06);
-    LCD_1IN69_SendData_8Bit(0x0B);
-    LCD_1IN69_SendData_8Bit(0x0A);
-    LCD_1IN69_SendData_8Bit(0x09);
-    LCD_1IN69_SendData_8Bit(0x26);
-    LCD_1IN69_SendData_8Bit(0x29);
-    LCD_1IN69_SendData_8Bit(0x33);
-    LCD_1IN69_SendData_8Bit(0x41);
-    LCD_1IN69_SendData_8Bit(0x18);
-    LCD_1IN69_SendData_8Bit(0x16);
-    LCD_1IN69_SendData_8Bit(0x15);
-    LCD_1IN69_SendData_8Bit(0x29);
-    LCD_1IN69_SendData_8Bit(0x2D);
-
-    LCD_1IN69_SendCommand(0xE1);
-    LCD_1IN69_SendData_8Bit(0xF0);
-    LCD_1IN69_SendData_8Bit(0x04);
-    LCD_1IN69_SendData_8Bit(0x08);
-    LCD_1IN69_SendData_8Bit(0x08);
-    LCD_1IN69_SendData_8Bit(0x07);
-    LCD_1IN69_SendData_8Bit(0x03);
-    LCD_1IN69_SendData_8Bit(0x28);
-    LCD_1IN69_SendData_8Bit(0x32);
-    LCD_1IN69_SendData_8Bit(0x40);
-    LCD_1IN69_SendData_8Bit(0x3B);
-    LCD_1IN69_SendData_8Bit(0x19);
-    LCD_1IN69_SendData_8Bit(0x18);
-    LCD_1IN69_SendData_8Bit(0x2A);
-    LCD_1IN69_SendData_8Bit(0x2E);
-
-    LCD_1IN69_SendCommand(0xE4);
-    LCD_1IN69_SendData_8Bit(0x25);
-    LCD_1IN69_SendData_8Bit(0x00);
-    LCD_1IN69_SendData_8Bit(0x00);
-
-    LCD_1IN69_SendCommand(0x21);
-
-    LCD_1IN69_SendCommand(0x11);
-    DEV_Delay_ms(120);
-    LCD_1IN69_SendCommand(0x29);
-}
-
-/********************************************************************************
-function:   Set the resolution and scanning method of the screen
-parameter:
-        Scan_dir:   Scan direction
-********************************************************************************/
-static void LCD_1IN69_SetAttributes(UBYTE Scan_dir)
-{
-    // Get the screen scan direction
-    LCD_1IN69.SCAN_DIR = Scan_dir;
-    UBYTE MemoryAccessReg = 0x00;
-
-    // Get GRAM and LCD width and height
-    if (Scan_dir == HORIZONTAL) {
-        LCD_1IN69.HEIGHT = LCD_1IN69_WIDTH;
-        LCD_1IN69.WIDTH = LCD_1IN69_HEIGHT;
-        MemoryAccessReg = 0X70;
-    }
-    else {
-        LCD_1IN69.HEIGHT = LCD_1IN69_HEIGHT;
-        LCD_1IN69.WIDTH = LCD_1IN69_WIDTH;      
-        MemoryAccessReg = 0X00;
-    }
-
-    // Set the read / write scan direction of the frame memory
-    LCD_1IN69_SendCommand(0x36); // MX, MY, RGB mode
-    LCD_1IN69_SendData_8Bit(MemoryAccessReg); // 0x08 set RGB
-}
+static const UBYTE LCD_1IN69_InitSeq[] = {
+    0x3A, 1, 0x05,
+    0xB2, 5, 0x0B, 0x0B, 0x00, 0x33, 0x35,
+    0xB7, 1, 0x11,
+    0xBB, 1, 0x35,
+    0xC0, 1, 0x2C,
+    0xC2, 1, 0x01,
+    0xC3, 1, 0x0D,
+    0xC4, 1, 0x20,
+    0xC6, 1, 0x13,
+    0xD0, 2, 0xA4, 0xA1,
+    0xD6, 1, 0xA1,
+    0xE0, 14, 0xF0, 0x06, 0x0B, 0x0A, 0x09, 0x26, 0x29,
+              0x33, 0x41, 0x18, 0x16, 0x15, 0x29, 0x2D,
+    0xE1, 14, 0xF0, 0x04, 0x08, 0x08, 0x07, 0x03, 0x28,
+              0x32, 0x40, 0x3B, 0x19, 0x18, 0x2A, 0x2E,
+    0xE4, 3, 0x25, 0x00, 0x00,
+    0x21, 0,
+    0x11, 0 | DEV_CMD_DELAY, 120,
+    0x29, 0,
+};
+
+static const LCD_PANEL_SCAN LCD_1IN69_Scan[] = {
+    [HORIZONTAL] = {0x70, 20, 0},
+    [VERTICAL]   = {0x00, 0, 20},
+};
+
+static const LCD_PANEL LCD_1IN69_Panel = {
+    "1.69inch ST7789", LCD_1IN69_WIDTH, LCD_1IN69_HEIGHT, LCD_PANEL_RGB, 100,
+    LCD_1IN69_InitSeq, sizeof(LCD_1IN69_InitSeq), LCD_1IN69_Scan, 2,
+};
 
 /********************************************************************************
-function :  Initialize the lcd
+function :	Initialize the lcd
 parameter:
 ********************************************************************************/
 void LCD_1IN69_Init(UBYTE Scan_dir)
 {
-    // Hardware reset
-    LCD_1IN69_Reset();
-
-    // Set the resolution and scanning method of the screen
-    LCD_1IN69_SetAttributes(Scan_dir);
+    LCD_Panel_Init(&LCD_1IN69_Panel, Scan_dir);
 
-    // Set the initialization register
-    LCD_1IN69_InitReg();
+    LCD_1IN69.SCAN_DIR = Scan_dir;
+    LCD_1IN69.WIDTH = LCD_Panel.WIDTH;
+    LCD_1IN69.HEIGHT = LCD_Panel.HEIGHT;
 }
 
 /********************************************************************************
-function:   Sets the start position and size of the display area
+function:	Sets the start position and size of the display area
 parameter:
-        Xstart  :   X direction Start coordinates
-        Ystart  :   Y direction Start coordinates
-        Xend    :   X direction end coordinates
-        Yend    :   Y direction end coordinates
+		Xstart 	:   X direction Start coordinates
+		Ystart  :   Y direction Start coordinates
+		Xend    :   X direction end coordinates
+		Yend    :   Y direction end coordinates
 ********************************************************************************/
 void LCD_1IN69_SetWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend)
-{    
-    if (LCD_1IN69.SCAN_DIR == VERTICAL) { 
-        // set the X coordinates
-        LCD_1IN69_SendCommand(0x2A);
-        LCD_1IN69_SendData_8Bit(Xstart >> 8);
-        LCD_1IN69_SendData_8Bit(Xstart);
-        LCD_1IN69_SendData_8Bit((Xend-1) >> 8);
-        LCD_1IN69_SendData_8Bit(Xend-1);
-
-        // set the Y coordinates
-        LCD_1IN69_SendCommand(0x2B);
-        LCD_1IN69_SendData_8Bit((Ystart+20) >> 8);
-        LCD_1IN69_SendData_8Bit(Ystart+20);
-        LCD_1IN69_SendData_8Bit((Yend+20-1) >> 8);
-        LCD_1IN69_SendData_8Bit(Yend+20-1);
-    }
-    else { 
-        // set the X coordinates
-        LCD_1IN69_SendCommand(0x2A);
-        LCD_1IN69_SendData_8Bit((Xstart+20) >> 8);
-        LCD_1IN69_SendData_8Bit(Xstart+20);
-        LCD_1IN69_SendData_8Bit((Xend+20-1) >> 8);
-        LCD_1IN69_SendData_8Bit(Xend+20-1);
-
-        // set the Y coordinates
-        LCD_1IN69_SendCommand(0x2B);
-        LCD_1IN69_SendData_8Bit(Ystart >> 8);
-        LCD_1IN69_SendData_8Bit(Ystart);
-        LCD_1IN69_SendData_8Bit((Yend-1) >> 8);
-        LCD_1IN69_SendData_8Bit(Yend-1);
-    }
-    LCD_1IN69_SendCommand(0x2C);   
+{
+    LCD_Panel_SetWindows(Xstart, Ystart, Xend, Yend);
 }
 
 /******************************************************************************
-function :  Clear screen
+function :	Clear screen
 parameter:
 ******************************************************************************/
 void LCD_1IN69_Clear(UWORD Color)
 {
-    UWORD j;
-    UWORD Image[LCD_1IN69_WIDTH];
-    for (j=0; j<LCD_1IN69_WIDTH; j++) {
-        Image[j] = Color;
-    }
-
-    LCD_1IN69_SetWindows(0, 0, LCD_1IN69.WIDTH, LCD_1IN69.HEIGHT);
-    LCD_1IN69_DC_1;
-    for (j=0; j<LCD_1IN69.HEIGHT; j++) {
-        DEV_SPI_Write_nByte((uint8_t *)&Image, LCD_1IN69.WIDTH * 2);
-    }
-
+    LCD_Panel_Clear(Color);
 }
 
 /******************************************************************************
-function :  Sends the image buffer in RAM to displays
+function :	Sends the image buffer in RAM to displays
 parameter:
 ******************************************************************************/
 void LCD_1IN69_Display(UWORD *Image)
 {
-    UWORD j;
-    
-    LCD_1IN69_SetWindows(0, 0, LCD_1IN69.WIDTH, LCD_1IN69.HEIGHT);
-    LCD_1IN69_DC_1;
-    for (j=0; j<LCD_1IN69.HEIGHT; j++) {
-        DEV_SPI_Write_nByte((uint8_t *)&Image[j * LCD_1IN69.WIDTH], LCD_1IN69.WIDTH * 2);
-    }
+    LCD_Panel_Display(Image);
 }
 
+/******************************************************************************
+function :	Sends an image the size of the window to it
+parameter:
+    Image  :   (Xend - Xstart) x (Yend - Ystart) pixels
+******************************************************************************/
 void LCD_1IN69_DisplayWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD *Image)
 {
-    UWORD j;
-    
-    LCD_1IN69_SetWindows(Xstart, Ystart, Xend, Yend);
-    LCD_1IN69_DC_1;
-    for (j=0; j<Yend-Ystart; j++) {
-        DEV_SPI_Write_nByte((uint8_t *)&Image[j * (Xend-Xstart)], (Xend-Xstart) * 2);
-    }
+    LCD_Panel_DisplayWindows(Xstart, Ystart, Xend, Yend, Image, Xend - Xstart);
 }
 
 void LCD_1IN69_DrawPoint(UWORD X, UWORD Y, UWORD Color)
 {
-    LCD_1IN69_SetWindows(X, Y, X, Y);
-    LCD_1IN69_SendData_16Bit(Color);
+    LCD_Panel_DisplayPoint(X, Y, Color);
 }
 
-void Handler_1IN69_LCD(int signo)
+void  Handler_1IN69_LCD(int signo)
 {
-    // System Exit
-    printf("\r\nHandler:Program stop\r\n");
+    //System Exit
+    printf("\r\nHandler:Program stop\r\n");     
     DEV_ModuleExit();
-    exit(0);
+	exit(0);
 }
\ No newline at end of file
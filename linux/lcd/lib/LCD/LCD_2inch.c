@@ -28,147 +28,57 @@
 #
 ******************************************************************************/
 #include "LCD_2inch.h"
+#include "LCD_Panel.h"
 #include <string.h>
 #include <stdlib.h>		//itoa()
-/*******************************************************************************
-function:
-	Hardware reset
-*******************************************************************************/
-static void LCD_2IN_Reset(void)
+/******************************************************************************
+function:	
+		Common register initialization
+******************************************************************************/
+static const UBYTE LCD_2IN_InitSeq[] = {
+    0x3A, 1, 0x05,
+    0x21, 0,
+    0x2A, 4, 0x00, 0x00, 0x01, 0x3F,
+    0x2B, 4, 0x00, 0x00, 0x00, 0xEF,
+    0xB2, 5, 0x0C, 0x0C, 0x00, 0x33, 0x33,
+    0xB7, 1, 0x35,
+    0xBB, 1, 0x1F,
+    0xC0, 1, 0x2C,
+    0xC2, 1, 0x01,
+    0xC3, 1, 0x12,
+    0xC4, 1, 0x20,
+    0xC6, 1, 0x0F,
+    0xD0, 2, 0xA4, 0xA1,
+    0xE0, 14, 0xD0, 0x08, 0x11, 0x08, 0x0C, 0x15, 0x39,
+              0x33, 0x50, 0x36, 0x13, 0x14, 0x29, 0x2D,
+    0xE1, 14, 0xD0, 0x08, 0x10, 0x08, 0x06, 0x06, 0x39,
+              0x44, 0x51, 0x0B, 0x16, 0x14, 0x2F, 0x31,
+    0x21, 0,
+    0x11, 0,
+    0x29, 0,
+};
+
+static const LCD_PANEL_SCAN LCD_2IN_Scan[] = {
+    {0x00, 0, 0},
+};
+
+static const LCD_PANEL LCD_2IN_Panel = {
+    "2inch ST7789", LCD_2IN_WIDTH, LCD_2IN_HEIGHT, LCD_PANEL_RGB, 100,
+    LCD_2IN_InitSeq, sizeof(LCD_2IN_InitSeq), LCD_2IN_Scan, 1,
+};
+
+void LCD_2IN_Init(void)
 {
-	// DEV_Digital_Write(LCD_CS, 1);
-	DEV_Delay_ms(100);
-	DEV_Digital_Write(LCD_RST, 0);
-	DEV_Delay_ms(100);
-	DEV_Digital_Write(LCD_RST, 1);
-	DEV_Delay_ms(100);
+    LCD_Panel_Init(&LCD_2IN_Panel, 0);
 }
 
 /*******************************************************************************
 function:
 		Write data and commands
 *******************************************************************************/
-static void LCD_2IN_Write_Command(UBYTE data)	 
-{	
-	// DEV_Digital_Write(LCD_CS, 0);
-	DEV_Digital_Write(LCD_DC, 0);
-	DEV_SPI_WriteByte(data);
-}
-
-static void LCD_2IN_WriteData_Byte(UBYTE data) 
-{	
-	// DEV_Digital_Write(LCD_CS, 0);
-	DEV_Digital_Write(LCD_DC, 1);
-	DEV_SPI_WriteByte(data);  
-	// DEV_Digital_Write(LCD_CS,1);
-}  
-
 void LCD_2IN_WriteData_Word(UWORD data)
 {
-	// DEV_Digital_Write(LCD_CS, 0);
-	DEV_Digital_Write(LCD_DC, 1);
-	DEV_SPI_WriteByte((data>>8) & 0xff);
-	DEV_SPI_WriteByte(data);
-	// DEV_Digital_Write(LCD_CS, 1);
-}	  
-
-
-/******************************************************************************
-function:	
-		Common register initialization
-******************************************************************************/
-void LCD_2IN_Init(void)
-{
-	LCD_2IN_Reset();
-
-	LCD_2IN_Write_Command(0x36);
-	LCD_2IN_WriteData_Byte(0x00); 
-
-	LCD_2IN_Write_Command(0x3A); 
-	LCD_2IN_WriteData_Byte(0x05);
-
-	LCD_2IN_Write_Command(0x21); 
-
-	LCD_2IN_Write_Command(0x2A);
-	LCD_2IN_WriteData_Byte(0x00);
-	LCD_2IN_WriteData_Byte(0x00);
-	LCD_2IN_WriteData_Byte(0x01);
-	LCD_2IN_WriteData_Byte(0x3F);
-
-	LCD_2IN_Write_Command(0x2B);
-	LCD_2IN_WriteData_Byte(0x00);
-	LCD_2IN_WriteData_Byte(0x00);
-	LCD_2IN_WriteData_Byte(0x00);
-	LCD_2IN_WriteData_Byte(0xEF);
-
-	LCD_2IN_Write_Command(0xB2);
-	LCD_2IN_WriteData_Byte(0x0C);
-	LCD_2IN_WriteData_Byte(0x0C);
-	LCD_2IN_WriteData_Byte(0x00);
-	LCD_2IN_WriteData_Byte(0x33);
-	LCD_2IN_WriteData_Byte(0x33);
-
-	LCD_2IN_Write_Command(0xB7);
-	LCD_2IN_WriteData_Byte(0x35); 
-
-	LCD_2IN_Write_Command(0xBB);
-	LCD_2IN_WriteData_Byte(0x1F);
-
-	LCD_2IN_Write_Command(0xC0);
-	LCD_2IN_WriteData_Byte(0x2C);
-
-	LCD_2IN_Write_Command(0xC2);
-	LCD_2IN_WriteData_Byte(0x01);
-
-	LCD_2IN_Write_Command(0xC3);
-	LCD_2IN_WriteData_Byte(0x12);   
-
-	LCD_2IN_Write_Command(0xC4);
-	LCD_2IN_WriteData_Byte(0x20);
-
-	LCD_2IN_Write_Command(0xC6);
-	LCD_2IN_WriteData_Byte(0x0F); 
-
-	LCD_2IN_Write_Command(0xD0);
-	LCD_2IN_WriteData_Byte(0xA4);
-	LCD_2IN_WriteData_Byte(0xA1);
-
-	LCD_2IN_Write_Command(0xE0);
-	LCD_2IN_WriteData_Byte(0xD0);
-	LCD_2IN_WriteData_Byte(0x08);
-	LCD_2IN_WriteData_Byte(0x11);
-	LCD_2IN_WriteData_Byte(0x08);
-	LCD_2IN_WriteData_Byte(0x0C);
-	LCD_2IN_WriteData_Byte(0x15);
-	LCD_2IN_WriteData_Byte(0x39);
-	LCD_2IN_WriteData_Byte(0x33);
-	LCD_2IN_WriteData_Byte(0x50);
-	LCD_2IN_WriteData_Byte(0x36);
-	LCD_2IN_WriteData_Byte(0x13);
-	LCD_2IN_WriteData_Byte(0x14);
-	LCD_2IN_WriteData_Byte(0x29);
-	LCD_2IN_WriteData_Byte(0x2D);
-
-	LCD_2IN_Write_Command(0xE1);
-	LCD_2IN_WriteData_Byte(0xD0);
-	LCD_2IN_WriteData_Byte(0x08);
-	LCD_2IN_WriteData_Byte(0x10);
-	LCD_2IN_WriteData_Byte(0x08);
-	LCD_2IN_WriteData_Byte(0x06);
-	LCD_2IN_WriteData_Byte(0x06);
-	LCD_2IN_WriteData_Byte(0x39);
-	LCD_2IN_WriteData_Byte(0x44);
-	LCD_2IN_WriteData_Byte(0x51);
-	LCD_2IN_WriteData_Byte(0x0B);
-	LCD_2IN_WriteData_Byte(0x16);
-	LCD_2IN_WriteData_Byte(0x14);
-	LCD_2IN_WriteData_Byte(0x2F);
-	LCD_2IN_WriteData_Byte(0x31);
-	LCD_2IN_Write_Command(0x21);
-
-	LCD_2IN_Write_Command(0x11);
-
-	LCD_2IN_Write_Command(0x29);
+    LCD_Panel_FillPixels(data, 1);
 }
 
 /******************************************************************************
@@ -176,24 +86,12 @@ function:	Set the cursor position
 parameter	:
 	  Xstart: 	Start UWORD x coordinate
 	  Ystart:	Start UWORD y coordinate
-	  Xend  :	End UWORD coordinates
-	  Yend  :	End UWORD coordinatesen
+	  Xend  :	End UWORD coordinates, exclusive
+	  Yend  :	End UWORD coordinates, exclusive
 ******************************************************************************/
 void LCD_2IN_SetWindow(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD  Yend)
 { 
-	LCD_2IN_Write_Command(0x2a);
-	LCD_2IN_WriteData_Byte(Xstart >>8);
-	LCD_2IN_WriteData_Byte(Xstart & 0xff);
-	LCD_2IN_WriteData_Byte((Xend - 1) >> 8);
-	LCD_2IN_WriteData_Byte((Xend - 1) & 0xff);
-
-	LCD_2IN_Write_Command(0x2b);
-	LCD_2IN_WriteData_Byte(Ystart >>8);
-	LCD_2IN_WriteData_Byte(Ystart & 0xff);
-	LCD_2IN_WriteData_Byte((Yend - 1) >> 8);
-	LCD_2IN_WriteData_Byte((Yend - 1) & 0xff);
-
-	LCD_2IN_Write_Command(0x2C);
+    LCD_Panel_SetWindows(Xstart, Ystart, Xend, Yend);
 }
 
 /******************************************************************************
@@ -201,23 +99,10 @@ function:	Settings window
 parameter	:
 	  Xstart: 	Start UWORD x coordinate
 	  Ystart:	Start UWORD y coordinate
-
 ******************************************************************************/
 void LCD_2IN_SetCursor(UWORD X, UWORD Y)
 { 
-	LCD_2IN_Write_Command(0x2a);
-	LCD_2IN_WriteData_Byte(X >> 8);
-	LCD_2IN_WriteData_Byte(X);
-	LCD_2IN_WriteData_Byte(X >> 8);
-	LCD_2IN_WriteData_Byte(X);
-
-	LCD_2IN_Write_Command(0x2b);
-	LCD_2IN_WriteData_Byte(Y >> 8);
-	LCD_2IN_WriteData_Byte(Y);
-	LCD_2IN_WriteData_Byte(Y >> 8);
-	LCD_2IN_WriteData_Byte(Y);
-
-	LCD_2IN_Write_Command(0x2C);
+    LCD_Panel_SetWindows(X, Y, X + 1, Y + 1);
 }
 
 /******************************************************************************
@@ -227,23 +112,13 @@ parameter	:
 ******************************************************************************/
 void LCD_2IN_Clear(UWORD Color)
 {
-	UWORD i;
-	UWORD image[LCD_2IN_WIDTH];
-	for(i=0;i<LCD_2IN_WIDTH;i++){
-		image[i] = Color>>8 | (Color&0xff)<<8;
-	}
-	UBYTE *p = (UBYTE *)(image);
-	LCD_2IN_SetWindow(0, 0, LCD_2IN_WIDTH, LCD_2IN_HEIGHT);
-	DEV_Digital_Write(LCD_DC, 1);
-	for(i = 0; i < LCD_2IN_HEIGHT; i++){
-		DEV_SPI_Write_nByte(p,LCD_2IN_WIDTH*2);
-	}
+    LCD_Panel_Clear(Color);
 }
 
 /******************************************************************************
 function:	Refresh a certain area to the same color
 parameter	:
-	  Xstart: Start UWORD x coordinate
+	  Xstart: 	Start UWORD x coordinate
 	  Ystart:	Start UWORD y coordinate
 	  Xend  :	End UWORD coordinates
 	  Yend  :	End UWORD coordinates
@@ -251,28 +126,7 @@ parameter	:
 ******************************************************************************/
 void LCD_2IN_ClearWindow(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,UWORD color)
 {          
-	UWORD i,j; 
-	LCD_2IN_SetWindow(Xstart, Ystart, Xend-1,Yend-1);
-	for(i = Ystart; i <= Yend-1; i++){
-		for(j = Xstart; j <= Xend-1; j++){
-			LCD_2IN_WriteData_Word(color);
-		}
-	}
-}
-
-/******************************************************************************
-function: Show a picture
-parameter	:
-		image: Picture buffer
-******************************************************************************/
-void LCD_2IN_Display(UBYTE *image)
-{
-	UWORD i;
-	LCD_2IN_SetWindow(0, 0, LCD_2IN_WIDTH, LCD_2IN_HEIGHT);
-	DEV_Digital_Write(LCD_DC, 1);
-	for(i = 0; i < LCD_2IN_HEIGHT; i++){
-		DEV_SPI_Write_nByte((UBYTE *)image+LCD_2IN_WIDTH*2*i,LCD_2IN_WIDTH*2);
-	}
+    LCD_FillRect(Xstart, Ystart, Xend, Yend, color);
 }
 
 /******************************************************************************
@@ -284,8 +138,16 @@ parameter	:
 ******************************************************************************/
 void LCD_2IN_DrawPaint(UWORD x, UWORD y, UWORD Color)
 {
-	LCD_2IN_SetCursor(x, y);
-	LCD_2IN_WriteData_Word(Color); 	    
+    LCD_Panel_DisplayPoint(x, y, Color);
+}
+
+/******************************************************************************
+function :	Sends the image buffer in RAM to displays
+parameter:
+******************************************************************************/
+void LCD_2IN_Display(UBYTE *Image)
+{
+    LCD_Panel_Display((UWORD *)Image);
 }
 
 void  Handler_2IN_LCD(int signo)
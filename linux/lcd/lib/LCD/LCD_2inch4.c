@@ -28,145 +28,61 @@
 #
 ******************************************************************************/
 #include "LCD_2inch4.h"
+#include "LCD_Panel.h"
 #include <string.h>
 #include <stdlib.h>		//itoa()
-/*******************************************************************************
-function:
-	Hardware reset
-*******************************************************************************/
-static void LCD_2IN4_Reset(void)
+/******************************************************************************
+function:	
+		Common register initialization
+******************************************************************************/
+static const UBYTE LCD_2IN4_InitSeq[] = {
+    0x11, 0,                            //Sleep out
+    0xCF, 3, 0x00, 0xC1, 0x30,
+    0xED, 4, 0x64, 0x03, 0x12, 0x81,
+    0xE8, 3, 0x85, 0x00, 0x79,
+    0xCB, 5, 0x39, 0x2C, 0x00, 0x34, 0x02,
+    0xF7, 1, 0x20,
+    0xEA, 2, 0x00, 0x00,
+    0xC0, 1, 0x1D,                      //Power control
+    0xC1, 1, 0x12,                      //Power control
+    0xC5, 2, 0x33, 0x3F,                //VCM control
+    0xC7, 1, 0x92,                      //VCM control
+    0x3A, 1, 0x55,                      //Memory Access Control
+    0xB1, 2, 0x00, 0x12,
+    0xB6, 2, 0x0A, 0xA2,                //Display Function Control
+    0x44, 1, 0x02,
+    0xF2, 1, 0x00,                      //3Gamma Function Disable
+    0x26, 1, 0x01,                      //Gamma curve selected
+    0xE0, 15, 0x0F, 0x22, 0x1C, 0x1B, 0x08, 0x0F, 0x48,   //Set Gamma
+              0xB8, 0x34, 0x05, 0x0C, 0x09, 0x0F, 0x07,
+              0x00,
+    0xE1, 15, 0x00, 0x23, 0x24, 0x07, 0x10, 0x07, 0x38,   //Set Gamma
+              0x47, 0x4B, 0x0A, 0x13, 0x06, 0x30, 0x38,
+              0x0F,
+    0x29, 0,                            //Display on
+};
+
+static const LCD_PANEL_SCAN LCD_2IN4_Scan[] = {
+    {0x00, 0, 0},
+};
+
+static const LCD_PANEL LCD_2IN4_Panel = {
+    "2.4inch ILI9341", LCD_2IN4_WIDTH, LCD_2IN4_HEIGHT, LCD_PANEL_BGR, 100,
+    LCD_2IN4_InitSeq, sizeof(LCD_2IN4_InitSeq), LCD_2IN4_Scan, 1,
+};
+
+void LCD_2IN4_Init(void)
 {
-	// DEV_Digital_Write(LCD_CS, 1);
-	DEV_Delay_ms(100);
-	DEV_Digital_Write(LCD_RST, 0);
-	DEV_Delay_ms(100);
-	DEV_Digital_Write(LCD_RST, 1);
-	DEV_Delay_ms(100);
+    LCD_Panel_Init(&LCD_2IN4_Panel, 0);
 }
 
 /*******************************************************************************
 function:
 		Write data and commands
 *******************************************************************************/
-static void LCD_2IN4_Write_Command(UBYTE data)	 
-{	
-	// DEV_Digital_Write(LCD_CS, 0);
-	DEV_Digital_Write(LCD_DC, 0);
-	DEV_SPI_WriteByte(data);
-}
-
-static void LCD_2IN4_WriteData_Byte(UBYTE data) 
-{	
-	// DEV_Digital_Write(LCD_CS, 0);
-	DEV_Digital_Write(LCD_DC, 1);
-	DEV_SPI_WriteByte(data);  
-	// DEV_Digital_Write(LCD_CS,1);
-}  
-
 void LCD_2IN4_WriteData_Word(UWORD data)
 {
-	// DEV_Digital_Write(LCD_CS, 0);
-	DEV_Digital_Write(LCD_DC, 1);
-	DEV_SPI_WriteByte((data>>8) & 0xff);
-	DEV_SPI_WriteByte(data);
-	// DEV_Digital_Write(LCD_CS, 1);
-}	  
-
-
-/******************************************************************************
-function:	
-		Common register initialization
-******************************************************************************/
-void LCD_2IN4_Init(void)
-{
-	LCD_2IN4_Reset();
-
-	LCD_2IN4_Write_Command(0x11); //Sleep out
-	
-	LCD_2IN4_Write_Command(0xCF);
-	LCD_2IN4_WriteData_Byte(0x00);
-	LCD_2IN4_WriteData_Byte(0xC1);
-	LCD_2IN4_WriteData_Byte(0X30);
-	LCD_2IN4_Write_Command(0xED);
-	LCD_2IN4_WriteData_Byte(0x64);
-	LCD_2IN4_WriteData_Byte(0x03);
-	LCD_2IN4_WriteData_Byte(0X12);
-	LCD_2IN4_WriteData_Byte(0X81);
-	LCD_2IN4_Write_Command(0xE8);
-	LCD_2IN4_WriteData_Byte(0x85);
-	LCD_2IN4_WriteData_Byte(0x00);
-	LCD_2IN4_WriteData_Byte(0x79);
-	LCD_2IN4_Write_Command(0xCB);
-	LCD_2IN4_WriteData_Byte(0x39);
-	LCD_2IN4_WriteData_Byte(0x2C);
-	LCD_2IN4_WriteData_Byte(0x00);
-	LCD_2IN4_WriteData_Byte(0x34);
-	LCD_2IN4_WriteData_Byte(0x02);
-	LCD_2IN4_Write_Command(0xF7);
-	LCD_2IN4_WriteData_Byte(0x20);
-	LCD_2IN4_Write_Command(0xEA);
-	LCD_2IN4_WriteData_Byte(0x00);
-	LCD_2IN4_WriteData_Byte(0x00);
-	LCD_2IN4_Write_Command(0xC0); //Power control
-	LCD_2IN4_WriteData_Byte(0x1D); //VRH[5:0]
-	LCD_2IN4_Write_Command(0xC1); //Power control
-	LCD_2IN4_WriteData_Byte(0x12); //SAP[2:0];BT[3:0]
-	LCD_2IN4_Write_Command(0xC5); //VCM control
-	LCD_2IN4_WriteData_Byte(0x33);
-	LCD_2IN4_WriteData_Byte(0x3F);
-	LCD_2IN4_Write_Command(0xC7); //VCM control
-	LCD_2IN4_WriteData_Byte(0x92);
-	LCD_2IN4_Write_Command(0x3A); // Memory Access Control
-	LCD_2IN4_WriteData_Byte(0x55);
-	LCD_2IN4_Write_Command(0x36); // Memory Access Control
-	LCD_2IN4_WriteData_Byte(0x08);
-	LCD_2IN4_Write_Command(0xB1);
-	LCD_2IN4_WriteData_Byte(0x00);
-	LCD_2IN4_WriteData_Byte(0x12);
-	LCD_2IN4_Write_Command(0xB6); // Display Function Control
-	LCD_2IN4_WriteData_Byte(0x0A);
-	LCD_2IN4_WriteData_Byte(0xA2);
-
-	LCD_2IN4_Write_Command(0x44);
-	LCD_2IN4_WriteData_Byte(0x02);
-
-	LCD_2IN4_Write_Command(0xF2); // 3Gamma Function Disable
-	LCD_2IN4_WriteData_Byte(0x00);
-	LCD_2IN4_Write_Command(0x26); //Gamma curve selected
-	LCD_2IN4_WriteData_Byte(0x01);
-	LCD_2IN4_Write_Command(0xE0); //Set Gamma
-	LCD_2IN4_WriteData_Byte(0x0F);
-	LCD_2IN4_WriteData_Byte(0x22);
-	LCD_2IN4_WriteData_Byte(0x1C);
-	LCD_2IN4_WriteData_Byte(0x1B);
-	LCD_2IN4_WriteData_Byte(0x08);
-	LCD_2IN4_WriteData_Byte(0x0F);
-	LCD_2IN4_WriteData_Byte(0x48);
-	LCD_2IN4_WriteData_Byte(0xB8);
-	LCD_2IN4_WriteData_Byte(0x34);
-	LCD_2IN4_WriteData_Byte(0x05);
-	LCD_2IN4_WriteData_Byte(0x0C);
-	LCD_2IN4_WriteData_Byte(0x09);
-	LCD_2IN4_WriteData_Byte(0x0F);
-	LCD_2IN4_WriteData_Byte(0x07);
-	LCD_2IN4_WriteData_Byte(0x00);
-	LCD_2IN4_Write_Command(0XE1); //Set Gamma
-	LCD_2IN4_WriteData_Byte(0x00);
-	LCD_2IN4_WriteData_Byte(0x23);
-	LCD_2IN4_WriteData_Byte(0x24);
-	LCD_2IN4_WriteData_Byte(0x07);
-	LCD_2IN4_WriteData_Byte(0x10);
-	LCD_2IN4_WriteData_Byte(0x07);
-	LCD_2IN4_WriteData_Byte(0x38);
-	LCD_2IN4_WriteData_Byte(0x47);
-	LCD_2IN4_WriteData_Byte(0x4B);
-	LCD_2IN4_WriteData_Byte(0x0A);
-	LCD_2IN4_WriteData_Byte(0x13);
-	LCD_2IN4_WriteData_Byte(0x06);
-	LCD_2IN4_WriteData_Byte(0x30);
-	LCD_2IN4_WriteData_Byte(0x38);
-	LCD_2IN4_WriteData_Byte(0x0F);
-	LCD_2IN4_Write_Command(0x29); //Display on
+    LCD_Panel_FillPixels(data, 1);
 }
 
 /******************************************************************************
@@ -174,24 +90,12 @@ function:	Set the cursor position
 parameter	:
 	  Xstart: 	Start UWORD x coordinate
 	  Ystart:	Start UWORD y coordinate
-	  Xend  :	End UWORD coordinates
-	  Yend  :	End UWORD coordinatesen
+	  Xend  :	End UWORD coordinates, exclusive
+	  Yend  :	End UWORD coordinates, exclusive
 ******************************************************************************/
 void LCD_2IN4_SetWindow(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD  Yend)
 { 
-	LCD_2IN4_Write_Command(0x2a);
-	LCD_2IN4_WriteData_Byte(Xstart >>8);
-	LCD_2IN4_WriteData_Byte(Xstart & 0xff);
-	LCD_2IN4_WriteData_Byte((Xend - 1) >> 8);
-	LCD_2IN4_WriteData_Byte((Xend - 1) & 0xff);
-
-	LCD_2IN4_Write_Command(0x2b);
-	LCD_2IN4_WriteData_Byte(Ystart >>8);
-	LCD_2IN4_WriteData_Byte(Ystart & 0xff);
-	LCD_2IN4_WriteData_Byte((Yend - 1) >> 8);
-	LCD_2IN4_WriteData_Byte((Yend - 1) & 0xff);
-
-	LCD_2IN4_Write_Command(0x2C);
+    LCD_Panel_SetWindows(Xstart, Ystart, Xend, Yend);
 }
 
 /******************************************************************************
@@ -199,23 +103,10 @@ function:	Settings window
 parameter	:
 	  Xstart: 	Start UWORD x coordinate
 	  Ystart:	Start UWORD y coordinate
-
 ******************************************************************************/
 void LCD_2IN4_SetCursor(UWORD X, UWORD Y)
 { 
-	LCD_2IN4_Write_Command(0x2a);
-	LCD_2IN4_WriteData_Byte(X >> 8);
-	LCD_2IN4_WriteData_Byte(X);
-	LCD_2IN4_WriteData_Byte(X >> 8);
-	LCD_2IN4_WriteData_Byte(X);
-
-	LCD_2IN4_Write_Command(0x2b);
-	LCD_2IN4_WriteData_Byte(Y >> 8);
-	LCD_2IN4_WriteData_Byte(Y);
-	LCD_2IN4_WriteData_Byte(Y >> 8);
-	LCD_2IN4_WriteData_Byte(Y);
-
-	LCD_2IN4_Write_Command(0x2C);
+    LCD_Panel_SetWindows(X, Y, X + 1, Y + 1);
 }
 
 /******************************************************************************
@@ -225,23 +116,13 @@ parameter	:
 ******************************************************************************/
 void LCD_2IN4_Clear(UWORD Color)
 {
-	UWORD i;
-	UWORD image[LCD_2IN4_WIDTH];
-	for(i=0;i<LCD_2IN4_WIDTH;i++){
-		image[i] = Color>>8 | (Color&0xff)<<8;
-	}
-	UBYTE *p = (UBYTE *)(image);
-	LCD_2IN4_SetWindow(0, 0, LCD_2IN4_WIDTH, LCD_2IN4_HEIGHT);
-	DEV_Digital_Write(LCD_DC, 1);
-	for(i = 0; i < LCD_2IN4_HEIGHT; i++){
-		DEV_SPI_Write_nByte(p,LCD_2IN4_WIDTH*2);
-	}
+    LCD_Panel_Clear(Color);
 }
 
 /******************************************************************************
 function:	Refresh a certain area to the same color
 parameter	:
-	  Xstart: Start UWORD x coordinate
+	  Xstart: 	Start UWORD x coordinate
 	  Ystart:	Start UWORD y coordinate
 	  Xend  :	End UWORD coordinates
 	  Yend  :	End UWORD coordinates
@@ -249,28 +130,7 @@ parameter	:
 ******************************************************************************/
 void LCD_2IN4_ClearWindow(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,UWORD color)
 {          
-	UWORD i,j; 
-	LCD_2IN4_SetWindow(Xstart, Ystart, Xend-1,Yend-1);
-	for(i = Ystart; i <= Yend-1; i++){
-		for(j = Xstart; j <= Xend-1; j++){
-			LCD_2IN4_WriteData_Word(color);
-		}
-	}
-}
-
-/******************************************************************************
-function: Show a picture
-parameter	:
-		image: Picture buffer
-******************************************************************************/
-void LCD_2IN4_Display(UBYTE *image)
-{
-	UWORD i;
-	LCD_2IN4_SetWindow(0, 0, LCD_2IN4_WIDTH, LCD_2IN4_HEIGHT);
-	DEV_Digital_Write(LCD_DC, 1);
-	for(i = 0; i < LCD_2IN4_HEIGHT; i++){
-		DEV_SPI_Write_nByte((UBYTE *)image+LCD_2IN4_WIDTH*2*i,LCD_2IN4_WIDTH*2);
-	}
+    LCD_FillRect(Xstart, Ystart, Xend, Yend, color);
 }
 
 /******************************************************************************
@@ -282,8 +142,16 @@ parameter	:
 ******************************************************************************/
 void LCD_2IN4_DrawPaint(UWORD x, UWORD y, UWORD Color)
 {
-	LCD_2IN4_SetCursor(x, y);
-	LCD_2IN4_WriteData_Word(Color); 	    
+    LCD_Panel_DisplayPoint(x, y, Color);
+}
+
+/******************************************************************************
+function :	Sends the image buffer in RAM to displays
+parameter:
+******************************************************************************/
+void LCD_2IN4_Display(UBYTE *Image)
+{
+    LCD_Panel_Display((UWORD *)Image);
 }
 
 void  Handler_2IN4_LCD(int signo)
@@ -291,5 +159,5 @@ void  Handler_2IN4_LCD(int signo)
     //System Exit
     printf("\r\nHandler:Program stop\r\n");     
     DEV_ModuleExit();
-    exit(0);
+	exit(0);
 }
\ No newline at end of file
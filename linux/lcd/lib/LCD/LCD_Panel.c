@@ -0,0 +1,285 @@
+/*****************************************************************************
+* | File      	:	LCD_Panel.c
+* | Function    :	Table-driven driver for MIPI DCS panel controllers
+* | Info        :
+*                The per-panel files (LCD_1in54.c, ...) hold an LCD_PANEL
+*                and keep their own API on top of this one.
+*----------------
+* |	This version:   V1.0
+* | Info        :   Basic version
+*
+******************************************************************************/
+#include "LCD_Panel.h"
+
+#include <string.h>
+
+LCD_PANEL_ATTRIBUTES LCD_Panel;
+
+//Window last sent to the controller, in controller coordinates,
+//so one which hasn't changed isn't sent again
+#define LCD_PANEL_NO_WINDOW 0xFFFF
+static UWORD LCD_Panel_Columns[2] = {LCD_PANEL_NO_WINDOW, LCD_PANEL_NO_WINDOW};
+static UWORD LCD_Panel_Rows[2] = {LCD_PANEL_NO_WINDOW, LCD_PANEL_NO_WINDOW};
+
+/******************************************************************************
+function :	Hardware reset
+parameter:
+    Ms   :  Length of each step
+******************************************************************************/
+static void LCD_Panel_Reset(UWORD Ms)
+{
+    //RST is already high (see LCD_Panel_Init)
+    DEV_Delay_ms(Ms);
+    LCD_RST_0;
+    DEV_Delay_ms(Ms);
+    LCD_RST_1;
+    DEV_Delay_ms(Ms);
+}
+
+/******************************************************************************
+function :	Send one of the window commands, unless it already holds Start..End
+parameter:
+    Cmd    :   0x2A (columns) or 0x2B (rows)
+    pLast  :   What the controller holds
+******************************************************************************/
+static void LCD_Panel_SetRange(UBYTE Cmd, UWORD *pLast, UWORD Start, UWORD End)
+{
+    if (pLast[0] == Start && pLast[1] == End) {
+        return;
+    }
+    UBYTE Range[4] = {(Start >> 8) & 0xFF, Start & 0xFF, (End >> 8) & 0xFF, End & 0xFF};
+    DEV_SPI_WriteCommand(Cmd, Range, 4);
+    pLast[0] = Start;
+    pLast[1] = End;
+}
+
+/********************************************************************************
+function :	Initialize the lcd
+parameter:
+    pPanel   :   Panel to drive; must outlive its use
+    Scan_dir :   Index into pPanel->Scan
+********************************************************************************/
+void LCD_Panel_Init(const LCD_PANEL *pPanel, UBYTE Scan_dir)
+{
+    LCD_Panel.Panel = pPanel;
+    LCD_Panel_Columns[0] = LCD_Panel_Columns[1] = LCD_PANEL_NO_WINDOW;
+    LCD_Panel_Rows[0] = LCD_Panel_Rows[1] = LCD_PANEL_NO_WINDOW;
+
+    //Turn on the backlight (RST is driven high first thing in the reset)
+    DEV_Digital_WriteMask(LCD_BL_MASK | LCD_RST_MASK, LCD_BL_MASK | LCD_RST_MASK);
+
+    //Hardware reset
+    LCD_Panel_Reset(pPanel->ResetMs);
+
+    //Set the resolution and scanning method of the screen
+    LCD_Panel_SetScanDir(Scan_dir);
+
+    //Set the initialization register
+    DEV_SPI_WriteCommandStream(pPanel->InitSeq, pPanel->InitSeqLen);
+}
+
+/********************************************************************************
+function:	Set the resolution and scanning method of the screen
+parameter:
+		Scan_dir:   Index into the panel's Scan; out of range selects 0
+********************************************************************************/
+void LCD_Panel_SetScanDir(UBYTE Scan_dir)
+{
+    const LCD_PANEL *pPanel = LCD_Panel.Panel;
+    if (Scan_dir >= pPanel->NumScan) {
+        Scan_dir = 0;
+    }
+    const LCD_PANEL_SCAN *pScan = &pPanel->Scan[Scan_dir];
+
+    LCD_Panel.SCAN_DIR = Scan_dir;
+    if (pScan->Madctl & LCD_PANEL_MV) {
+        LCD_Panel.WIDTH = pPanel->Height;
+        LCD_Panel.HEIGHT = pPanel->Width;
+    } else {
+        LCD_Panel.WIDTH = pPanel->Width;
+        LCD_Panel.HEIGHT = pPanel->Height;
+    }
+
+    // Set the read / write scan direction of the frame memory
+    UBYTE MemoryAccessReg = pScan->Madctl | pPanel->ColorOrder;
+    DEV_SPI_WriteCommand(0x36, &MemoryAccessReg, 1);
+}
+
+/********************************************************************************
+function:	Sets the start position and size of the display area, and starts
+            writing pixels to it
+parameter:
+		Xstart 	:   X direction Start coordinates
+		Ystart  :   Y direction Start coordinates
+		Xend    :   X direction end coordinates, exclusive
+		Yend    :   Y direction end coordinates, exclusive
+********************************************************************************/
+void LCD_Panel_SetWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend)
+{
+    const LCD_PANEL_SCAN *pScan = &LCD_Panel.Panel->Scan[LCD_Panel.SCAN_DIR];
+
+    //set the X coordinates
+    LCD_Panel_SetRange(0x2A, LCD_Panel_Columns,
+        Xstart + pScan->Xoffset, Xend - 1 + pScan->Xoffset);
+
+    //set the Y coordinates
+    LCD_Panel_SetRange(0x2B, LCD_Panel_Rows,
+        Ystart + pScan->Yoffset, Yend - 1 + pScan->Yoffset);
+
+    //Memory write; starts again at the top left of the window
+    DEV_SPI_WriteCommand(0x2C, NULL, 0);
+}
+
+/******************************************************************************
+function :	Write a rectangle of pixels into the window
+parameter:
+    pImage :   First pixel, panel-native (big-endian) RGB565
+    Width  :   Pixels in each row
+    Height :   Rows
+    Stride :   Pixels from the start of one row to the next
+******************************************************************************/
+void LCD_Panel_WritePixels(const UWORD *pImage, UWORD Width, UWORD Height, UDOUBLE Stride)
+{
+    LCD_DC_1;
+
+    //Rows next to each other go out in as few transfers as possible
+    if (Stride == Width) {
+        DEV_SPI_Write_nByte((uint8_t *)pImage, (UDOUBLE)Width * Height * 2);
+        return;
+    }
+
+    //Otherwise as many rows as fit are gathered into each transfer
+    UBYTE Buffer[DEV_SPI_MAX_LEN];
+    UDOUBLE Used = 0;
+    UWORD j;
+    for (j = 0; j < Height; j++) {
+        const UBYTE *pRow = (const UBYTE *)(pImage + j * Stride);
+        UDOUBLE Left = (UDOUBLE)Width * 2;
+        while (Left > 0) {
+            UDOUBLE Len = DEV_SPI_MAX_LEN - Used;
+            if (Len > Left) {
+                Len = Left;
+            }
+            memcpy(Buffer + Used, pRow, Len);
+            Used += Len;
+            pRow += Len;
+            Left -= Len;
+            if (Used == DEV_SPI_MAX_LEN) {
+                DEV_SPI_Write_nByte(Buffer, Used);
+                Used = 0;
+            }
+        }
+    }
+    if (Used > 0) {
+        DEV_SPI_Write_nByte(Buffer, Used);
+    }
+}
+
+/******************************************************************************
+function :	Pattern of one color, panel-native, for the fills to send from.
+            It is filled only as far as a fill needs, and only again when
+            the color changes, so clearing the screen over and over formats
+            it once. Like the window cache, it belongs to whoever owns the bus.
+parameter:
+    Color  :   Panel-native (big-endian) RGB565
+    Len    :   Pixels needed, at most LCD_PANEL_PATTERN_LEN
+******************************************************************************/
+#define LCD_PANEL_PATTERN_LEN (DEV_SPI_MAX_LEN / 2)
+static UWORD LCD_Panel_Pattern[LCD_PANEL_PATTERN_LEN];
+static UWORD LCD_Panel_PatternColor;
+static UDOUBLE LCD_Panel_PatternFilled = 0;
+
+static const UWORD *LCD_Panel_GetPattern(UWORD Color, UDOUBLE Len)
+{
+    if (Color != LCD_Panel_PatternColor) {
+        LCD_Panel_PatternColor = Color;
+        LCD_Panel_PatternFilled = 0;
+    }
+    for (; LCD_Panel_PatternFilled < Len; LCD_Panel_PatternFilled++) {
+        LCD_Panel_Pattern[LCD_Panel_PatternFilled] = Color;
+    }
+    return LCD_Panel_Pattern;
+}
+
+/******************************************************************************
+function :	Write one color into the window, Count times
+parameter:
+    Color  :   RGB565
+******************************************************************************/
+void LCD_Panel_FillPixels(UWORD Color, UDOUBLE Count)
+{
+    //At most one transfer's worth, sent as many times as it takes
+    UDOUBLE Len = Count < LCD_PANEL_PATTERN_LEN ? Count : LCD_PANEL_PATTERN_LEN;
+    const UWORD *pPattern = LCD_Panel_GetPattern(((Color<<8)&0xff00)|(Color>>8), Len);
+
+    LCD_DC_1;
+    while (Count > 0) {
+        if (Len > Count) {
+            Len = Count;
+        }
+        DEV_SPI_Write_nByte((uint8_t *)pPattern, Len * 2);
+        Count -= Len;
+    }
+}
+
+/******************************************************************************
+function :	Clear screen
+parameter:
+******************************************************************************/
+void LCD_Panel_Clear(UWORD Color)
+{
+    LCD_FillRect(0, 0, LCD_Panel.WIDTH, LCD_Panel.HEIGHT, Color);
+}
+
+/******************************************************************************
+function :	Fill [Xstart, Xend) x [Ystart, Yend) of the panel with one color,
+            clipped to the panel. Nothing is read from or written to a frame
+            buffer, and nothing is allocated.
+parameter:
+    Color  :   RGB565
+******************************************************************************/
+void LCD_FillRect(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color)
+{
+    if (Xend > LCD_Panel.WIDTH) {
+        Xend = LCD_Panel.WIDTH;
+    }
+    if (Yend > LCD_Panel.HEIGHT) {
+        Yend = LCD_Panel.HEIGHT;
+    }
+    if (Xend <= Xstart || Yend <= Ystart) {
+        return;
+    }
+    LCD_Panel_SetWindows(Xstart, Ystart, Xend, Yend);
+    LCD_Panel_FillPixels(Color, (UDOUBLE)(Xend - Xstart) * (Yend - Ystart));
+}
+
+/******************************************************************************
+function :	Sends the image buffer in RAM to displays
+parameter:
+    Image  :   LCD_Panel.WIDTH x LCD_Panel.HEIGHT pixels
+******************************************************************************/
+void LCD_Panel_Display(const UWORD *Image)
+{
+    LCD_Panel_SetWindows(0, 0, LCD_Panel.WIDTH, LCD_Panel.HEIGHT);
+    LCD_Panel_WritePixels(Image, LCD_Panel.WIDTH, LCD_Panel.HEIGHT, LCD_Panel.WIDTH);
+}
+
+/******************************************************************************
+function :	Sends [Xstart, Xend) x [Ystart, Yend) of an image to the display
+parameter:
+    pImage :   Pixel (Xstart, Ystart) of the image
+    Stride :   Pixels from the start of one row of the image to the next
+******************************************************************************/
+void LCD_Panel_DisplayWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, const UWORD *pImage, UDOUBLE Stride)
+{
+    if (Xend <= Xstart || Yend <= Ystart) {
+        return;
+    }
+    LCD_Panel_SetWindows(Xstart, Ystart, Xend, Yend);
+    LCD_Panel_WritePixels(pImage, Xend - Xstart, Yend - Ystart, Stride);
+}
+
+void LCD_Panel_DisplayPoint(UWORD X, UWORD Y, UWORD Color)
+{
+    LCD_FillRect(X, Y, X + 1, Y + 1, Color);
+}
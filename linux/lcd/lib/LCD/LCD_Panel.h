@@ -0,0 +1,76 @@
+/*****************************************************************************
+* | File      	:	LCD_Panel.h
+* | Function    :	Table-driven driver for MIPI DCS panel controllers
+* | Info        :
+*                ST7789, ST7735, GC9A01 and ILI9341 share the commands
+*                which set the window (0x2A, 0x2B), write pixels (0x2C)
+*                and set the scan direction (0x36). Each panel is
+*                described by an LCD_PANEL, and drawn through these.
+*----------------
+* |	This version:   V1.0
+* | Info        :   Basic version
+*
+******************************************************************************/
+#ifndef __LCD_PANEL_H
+#define __LCD_PANEL_H
+
+#include "DEV_Config.h"
+#include <stdint.h>
+
+/********************************************************************************
+function:	Color order of the panel, the BGR bit of MADCTL
+********************************************************************************/
+#define LCD_PANEL_RGB   0x00
+#define LCD_PANEL_BGR   0x08
+
+//MADCTL bit which exchanges rows and columns
+#define LCD_PANEL_MV    0x20
+
+/********************************************************************************
+function:	One scan direction of a panel
+********************************************************************************/
+typedef struct {
+    UBYTE Madctl;           //MADCTL (0x36), without the color order bit
+    UWORD Xoffset;          //Controller column of the first visible column
+    UWORD Yoffset;          //Controller row of the first visible row
+} LCD_PANEL_SCAN;
+
+/********************************************************************************
+function:	Everything that differs between panels
+********************************************************************************/
+typedef struct {
+    const char *Name;
+    UWORD Width;                    //Visible size without LCD_PANEL_MV;
+    UWORD Height;                   //with it the two are exchanged
+    UBYTE ColorOrder;               //LCD_PANEL_RGB or LCD_PANEL_BGR
+    UWORD ResetMs;                  //Length of each step of the hardware reset
+    const UBYTE *InitSeq;           //Command stream, see DEV_CMD_DELAY
+    UWORD InitSeqLen;
+    const LCD_PANEL_SCAN *Scan;     //Indexed by scan direction
+    UBYTE NumScan;
+} LCD_PANEL;
+
+/********************************************************************************
+function:	The panel being driven
+********************************************************************************/
+typedef struct {
+    const LCD_PANEL *Panel;
+    UWORD WIDTH;                    //Visible size in this scan direction
+    UWORD HEIGHT;
+    UBYTE SCAN_DIR;
+} LCD_PANEL_ATTRIBUTES;
+extern LCD_PANEL_ATTRIBUTES LCD_Panel;
+
+void LCD_Panel_Init(const LCD_PANEL *pPanel, UBYTE Scan_dir);
+void LCD_Panel_SetScanDir(UBYTE Scan_dir);
+void LCD_Panel_SetWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend);
+void LCD_Panel_WritePixels(const UWORD *pImage, UWORD Width, UWORD Height, UDOUBLE Stride);
+void LCD_Panel_FillPixels(UWORD Color, UDOUBLE Count);
+
+void LCD_Panel_Clear(UWORD Color);
+void LCD_FillRect(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color);
+void LCD_Panel_Display(const UWORD *Image);
+void LCD_Panel_DisplayWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, const UWORD *pImage, UDOUBLE Stride);
+void LCD_Panel_DisplayPoint(UWORD X, UWORD Y, UWORD Color);
+
+#endif
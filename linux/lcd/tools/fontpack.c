@@ -0,0 +1,170 @@
+// Build-time converter from the sFONT tables in lib/Fonts to the packed
+// format of sFONT_PACKED (see fonts.h).
+// Each glyph is cut down to the box around its set pixels, and the box is
+// stored bit-packed with no row padding. Blank glyphs, and those left out
+// of a subset, take no data at all.
+// Usage: fontpack <font> <output.c> [characters to keep]
+//   e.g. fontpack Font20 font20_packed.c "0123456789:. "
+// Built for and run on the build machine, even when cross-compiling.
+#include "fonts.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#define FIRST_CHAR ' '
+#define LAST_CHAR '~'
+#define NUM_CHARS (LAST_CHAR - FIRST_CHAR + 1)
+#define MAX_DATA_BYTES 0xFFFF
+
+static const struct {
+    const char *name;
+    const sFONT *font;
+} s_fonts[] = {
+    {"Font8", &Font8},
+    {"Font12", &Font12},
+    {"Font16", &Font16},
+    {"Font20", &Font20},
+    {"Font24", &Font24},
+    {"Font48", &Font48},
+    {"Font50", &Font50},
+};
+
+static uint8_t s_data[MAX_DATA_BYTES];
+static size_t s_dataLen = 0;
+static sGLYPH s_glyphs[NUM_CHARS];
+
+static bool isSet(const uint8_t *pGlyph, int widthByte, int x, int y)
+{
+    return pGlyph[y * widthByte + x / 8] & (0x80 >> (x % 8));
+}
+
+static void packGlyph(const sFONT *pFont, int code, sGLYPH *pOut)
+{
+    int widthByte = (pFont->Width + 7) / 8;
+    const uint8_t *pGlyph = pFont->table + (size_t)(code - FIRST_CHAR) * pFont->Height * widthByte;
+
+    // Box around the set pixels
+    int left = pFont->Width, right = -1, top = pFont->Height, bottom = -1;
+    for (int y = 0; y < pFont->Height; y++) {
+        for (int x = 0; x < pFont->Width; x++) {
+            if (isSet(pGlyph, widthByte, x, y)) {
+                if (x < left) left = x;
+                if (x > right) right = x;
+                if (y < top) top = y;
+                if (y > bottom) bottom = y;
+            }
+        }
+    }
+    memset(pOut, 0, sizeof(*pOut));
+    if (right < 0) {
+        return;
+    }
+
+    int columns = right - left + 1;
+    int rows = bottom - top + 1;
+    size_t bytes = ((size_t)columns * rows + 7) / 8;
+    if (s_dataLen + bytes > MAX_DATA_BYTES) {
+        fprintf(stderr, "fontpack: font is too big to pack\n");
+        exit(EXIT_FAILURE);
+    }
+
+    pOut->Offset = (uint16_t)s_dataLen;
+    pOut->Left = (uint8_t)left;
+    pOut->Top = (uint8_t)top;
+    pOut->Columns = (uint8_t)columns;
+    pOut->Rows = (uint8_t)rows;
+
+    size_t bit = 0;
+    for (int y = top; y <= bottom; y++) {
+        for (int x = left; x <= right; x++, bit++) {
+            if (isSet(pGlyph, widthByte, x, y)) {
+                s_data[s_dataLen + bit / 8] |= 0x80 >> (bit % 8);
+            }
+        }
+    }
+    s_dataLen += bytes;
+}
+
+static void writeFont(FILE *pFile, const char *name, const sFONT *pFont, int first, int last)
+{
+    fprintf(pFile, "// Generated from %s by lcd/tools/fontpack.c; do not edit.\n", name);
+    fprintf(pFile, "#include \"fonts.h\"\n#include <stddef.h>\n\n");
+
+    // An array may not be empty, even if every glyph is blank
+    fprintf(pFile, "static const uint8_t %s_Packed_Data[] = {", name);
+    for (size_t i = 0; i < s_dataLen || i == 0; i++) {
+        fprintf(pFile, "%s0x%02X,", i % 16 ? " " : "\n    ", s_data[i]);
+    }
+    fprintf(pFile, "\n};\n\n");
+
+    fprintf(pFile, "static const sGLYPH %s_Packed_Glyphs[] = {\n", name);
+    for (int code = first; code <= last; code++) {
+        const sGLYPH *pGlyph = &s_glyphs[code - FIRST_CHAR];
+        fprintf(pFile, "    {%5u, %2u, %2u, %2u, %2u}, // '%c'\n",
+            pGlyph->Offset, pGlyph->Left, pGlyph->Top, pGlyph->Columns, pGlyph->Rows, code);
+    }
+    fprintf(pFile, "};\n\n");
+
+    fprintf(pFile, "static const sFONT_PACKED %s_Packed_Font = {\n", name);
+    fprintf(pFile, "    %s_Packed_Data, %s_Packed_Glyphs, %d, %d,\n};\n\n", name, name, first, last);
+
+    fprintf(pFile, "sFONT %s_Packed = {\n", name);
+    fprintf(pFile, "    NULL, %u, %u, &%s_Packed_Font,\n};\n", pFont->Width, pFont->Height, name);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3 || argc > 4) {
+        fprintf(stderr, "Usage: %s <font> <output.c> [characters to keep]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    const char *name = argv[1];
+    const char *keep = argc == 4 && argv[3][0] != '\0' ? argv[3] : NULL;
+
+    const sFONT *pFont = NULL;
+    for (size_t i = 0; i < sizeof(s_fonts) / sizeof(s_fonts[0]); i++) {
+        if (strcmp(s_fonts[i].name, name) == 0) {
+            pFont = s_fonts[i].font;
+        }
+    }
+    if (pFont == NULL) {
+        fprintf(stderr, "fontpack: unknown font %s\n", name);
+        return EXIT_FAILURE;
+    }
+    if (pFont->Width > PACKED_FONT_MAX_WIDTH || pFont->Height > PACKED_FONT_MAX_HEIGHT) {
+        fprintf(stderr, "fontpack: %s is bigger than a glyph may be\n", name);
+        return EXIT_FAILURE;
+    }
+
+    // Only the characters kept go in, and the index spans just those
+    int first = LAST_CHAR, last = FIRST_CHAR;
+    for (int code = FIRST_CHAR; code <= LAST_CHAR; code++) {
+        if (keep != NULL && strchr(keep, code) == NULL) {
+            continue;
+        }
+        packGlyph(pFont, code, &s_glyphs[code - FIRST_CHAR]);
+        if (code < first) first = code;
+        if (code > last) last = code;
+    }
+    if (first > last) {
+        fprintf(stderr, "fontpack: none of \"%s\" is in %s\n", keep, name);
+        return EXIT_FAILURE;
+    }
+
+    FILE *pFile = fopen(argv[2], "w");
+    if (pFile == NULL) {
+        perror("fontpack: failed to open output");
+        return EXIT_FAILURE;
+    }
+    writeFont(pFile, name, pFont, first, last);
+    if (fclose(pFile) != 0) {
+        perror("fontpack: failed to write output");
+        return EXIT_FAILURE;
+    }
+
+    size_t unpacked = (size_t)NUM_CHARS * pFont->Height * ((pFont->Width + 7) / 8);
+    printf("fontpack: %s packed from %zu to %zu bytes of glyphs\n", name, unpacked,
+        s_dataLen + (size_t)(last - first + 1) * sizeof(sGLYPH));
+    return EXIT_SUCCESS;
+}
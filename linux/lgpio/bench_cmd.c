@@ -0,0 +1,200 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+/*
+Measures the command parser on a generated corpus.
+
+bench_cmd [lines [passes]]
+
+The corpus holds lines of random commands and arguments with the
+command names in mixed case.  It is parsed a command at a time as
+rgs does and, restricted to the commands valid in a script, as one
+script by cmdParseScript.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#include "lgpio.h"
+#include "rgpiod.h"
+#include "lgCmd.h"
+
+typedef struct
+{
+   char *fmt;   /* command, %d argument */
+   int script;  /* valid in a script */
+} benchCmd_t;
+
+static benchCmd_t benchCmds[]=
+{
+   {"gr %d %d",                1},
+   {"gw %d %d %d",             1},
+   {"gsox %d %d %d %d",        1},
+   {"ggw %d %d %d",            1},
+   {"gpx %d %d %d %d %d %d",   1},
+   {"p %d %d %d.%d %d",        1},
+   {"i2crb %d %d",             1},
+   {"i2cwb %d %d %d",          1},
+   {"i2cwi %d %d %d %d %d %d", 0},
+   {"spiw %d %d %d %d %d",     0},
+   {"serwb %d 0x%x",           1},
+   {"mics %d",                 1},
+   {"ld v%d %d",               1},
+   {"add %d",                  1},
+   {"sta v%d",                 1},
+   {"cmp p%d",                 1},
+   {"jnz 0",                   1},
+   {"x v%d v%d",               1},
+   {"tick",                    1},
+   {"fo /tmp/file%d %d",       0},
+};
+
+#define BENCH_CMDS (sizeof(benchCmds)/sizeof(benchCmd_t))
+
+static double xNow(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+
+   return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+static void xReport(const char *what, int lines, int bytes, double secs)
+{
+   printf("%-16s %9d lines %8.3f s %11.0f lines/s %8.2f MB/s\n",
+      what, lines, secs, lines / secs, bytes / secs / 1e6);
+}
+
+static int xLine(char *buf, int script)
+{
+   benchCmd_t *c;
+   int i, len;
+
+   do c = &benchCmds[random() % BENCH_CMDS]; while (script && !c->script);
+
+   len = sprintf(buf, c->fmt,
+      random() % 10, random() % 100, random() % 100,
+      random() % 100, random() % 100, random() % 100);
+
+   /* vary the case of the command name */
+
+   for (i=0; buf[i] && (buf[i] != ' '); i++)
+   {
+      if (random() & 1) buf[i] = toupper((unsigned char)buf[i]);
+   }
+
+   buf[len++] = '\n';
+   buf[len] = 0;
+
+   return len;
+}
+
+int main(int argc, char *argv[])
+{
+   int lines, passes, i, p, len, bytes, bad, idx;
+   char **corpus, *script, line[256];
+   double t;
+   lgCmd_t *cmdBuf;
+   cmdCtl_t ctl;
+   cmdScript_t s;
+
+   lines  = (argc > 1) ? atoi(argv[1]) : 100000;
+   passes = (argc > 2) ? atoi(argv[2]) : 10;
+
+   if ((lines < 1) || (passes < 1))
+   {
+      fprintf(stderr, "usage: bench_cmd [lines [passes]]\n");
+      return 1;
+   }
+
+   srandom(1);
+
+   corpus = malloc(lines * sizeof(char *));
+   script = malloc(lines * sizeof(line));
+   cmdBuf = malloc(CMD_MAX_EXTENSION);
+
+   if (!corpus || !script || !cmdBuf) return 1;
+
+   bytes = 0;
+
+   for (i=0; i<lines; i++)
+   {
+      bytes += xLine(line, 0);
+      corpus[i] = strdup(line);
+   }
+
+   /* a command at a time as rgs */
+
+   bad = 0;
+
+   t = xNow();
+
+   for (p=0; p<passes; p++)
+   {
+      for (i=0; i<lines; i++)
+      {
+         ctl.inScript = 0;
+         ctl.eaten = 0;
+
+         idx = cmdParse(corpus[i], &ctl, cmdBuf, CMD_MAX_EXTENSION);
+
+         if (idx < 0) bad++;
+      }
+   }
+
+   xReport("cmdParse", lines * passes, bytes * passes, xNow() - t);
+
+   if (bad) printf("%d commands failed to parse\n", bad / passes);
+
+   /* one script, tagged so the jumps resolve */
+
+   len = sprintf(script, "tag 0\n");
+
+   for (i=0; i<lines; i++) len += xLine(script + len, 1);
+
+   bad = 0;
+
+   t = xNow();
+
+   for (p=0; p<passes; p++)
+   {
+      if (cmdParseScript(script, &s, 0)) bad++;
+      free(s.par);
+   }
+
+   xReport("cmdParseScript", lines * passes, len * passes, xNow() - t);
+
+   if (bad) printf("%d scripts failed to parse\n", bad);
+
+   return 0;
+}
+
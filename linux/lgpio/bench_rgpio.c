@@ -0,0 +1,180 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+/*
+Compares the cost of individual rgpio calls against the same
+commands sent as a batch.
+
+bench_rgpio [loops [batch [gpiochip gpio]]]
+
+The daemon is located via LG_ADDR/LG_PORT as for any rgpio client.
+If a gpiochip and gpio are given GPIO writes are also timed, the
+gpio is left low.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "rgpio.h"
+#include "rgpiod.h"
+
+static double xNow(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+
+   return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+static void xReport(const char *what, int ops, double secs)
+{
+   printf("%-24s %8d ops %8.3f s %10.0f ops/s %8.2f us/op\n",
+      what, ops, secs, ops / secs, secs * 1e6 / ops);
+}
+
+int main(int argc, char *argv[])
+{
+   int sbc, loops, size, i, j, n, h, gpio, idx, status;
+   double t;
+   char name[64];
+   batch_t *batch;
+
+   loops = (argc > 1) ? atoi(argv[1]) : 10000;
+   size  = (argc > 2) ? atoi(argv[2]) : 64;
+
+   if ((loops < 1) || (size < 1))
+   {
+      fprintf(stderr, "usage: bench_rgpio [loops [batch [gpiochip gpio]]]\n");
+      return 1;
+   }
+
+   sbc = rgpiod_start(NULL, NULL);
+
+   if (sbc < 0)
+   {
+      fprintf(stderr, "rgpiod_start failed (%s)\n", lgu_error_text(sbc));
+      return 1;
+   }
+
+   batch = batch_open(sbc);
+
+   if (batch == NULL)
+   {
+      fprintf(stderr, "batch_open failed\n");
+      rgpiod_stop(sbc);
+      return 1;
+   }
+
+   t = xNow();
+
+   for (i=0; i<loops; i++) lgu_get_sbc_name(sbc, name, sizeof(name));
+
+   xReport("get_sbc_name", loops, xNow() - t);
+
+   t = xNow();
+
+   for (i=0; i<loops; i+=size)
+   {
+      n = ((loops - i) < size) ? (loops - i) : size;
+
+      for (j=0; j<n; j++) batch_command(batch, LG_CMD_SBC, 0, NULL, NULL, NULL);
+
+      if (batch_flush(batch) != n)
+      {
+         fprintf(stderr, "batch_flush failed\n");
+         break;
+      }
+   }
+
+   xReport("batched get_sbc_name", loops, xNow() - t);
+
+   idx = batch_command(batch, LG_CMD_SBC, 0, NULL, NULL, NULL);
+   batch_flush(batch);
+   n = batch_data(batch, idx, name, sizeof(name) - 1);
+   name[(n > 0) ? n : 0] = 0;
+   printf("sbc name \"%s\"\n", name);
+
+   if (argc > 4)
+   {
+      h = gpiochip_open(sbc, atoi(argv[3]));
+      gpio = atoi(argv[4]);
+
+      if ((h >= 0) && (gpio_claim_output(sbc, h, 0, gpio, 0) >= 0))
+      {
+         status = 0;
+
+         t = xNow();
+
+         for (i=0; (i<loops) && (status >= 0); i++)
+            status = gpio_write(sbc, h, gpio, i & 1);
+
+         if (status >= 0) xReport("gpio_write", loops, xNow() - t);
+         else fprintf(stderr, "gpio_write failed (%s)\n",
+            lgu_error_text(status));
+
+         t = xNow();
+
+         for (i=0; (i<loops) && (status >= 0); i+=size)
+         {
+            n = ((loops - i) < size) ? (loops - i) : size;
+
+            for (j=0; j<n; j++) batch_gpio_write(batch, h, gpio, j & 1);
+
+            status = batch_flush(batch);
+
+            if (status == n)
+            {
+               /* a failed write must not be timed as a fast one */
+               for (j=0; (j<n) && (status >= 0); j++)
+                  status = batch_status(batch, j);
+            }
+            else if (status >= 0) status = lgif_bad_recv;
+         }
+
+         if (status >= 0) xReport("batched gpio_write", loops, xNow() - t);
+         else fprintf(stderr, "batched gpio_write failed (%s)\n",
+            lgu_error_text(status));
+
+         gpio_write(sbc, h, gpio, 0);
+         gpio_free(sbc, h, gpio);
+      }
+      else fprintf(stderr, "can't claim gpiochip %s gpio %s\n",
+         argv[3], argv[4]);
+
+      if (h >= 0) gpiochip_close(sbc, h);
+   }
+
+   batch_close(batch);
+
+   rgpiod_stop(sbc);
+
+   return 0;
+}
@@ -252,21 +252,103 @@ cmdInfo_t cmdInfo[]=
 
 };
 
-static int cmdMatch(char *str)
+/*
+Command names are found via a perfect hash of the cmdInfo table.
+The hash tables in lgCmdHash.h are generated by mkCmdHash (which
+includes this file with LG_CMD_TABLE_ONLY defined) whenever the
+table changes.
+*/
+
+#define CMD_HASH_INIT    2166136261U
+#define CMD_HASH_BUCKETS 64
+#define CMD_HASH_SLOTS   256
+
+static inline uint32_t cmdHashAdd(uint32_t hash, int c)
 {
-   int i;
+   /* FNV-1a on the name folded to upper case */
+
+   return (hash ^ (c & 0xDF)) * 16777619U;
+}
+
+static inline int cmdHashBucket(uint32_t hash)
+{
+   return (hash ^ (hash >> 16)) & (CMD_HASH_BUCKETS-1);
+}
+
+static inline int cmdHashSlot(uint32_t hash, int disp)
+{
+   hash += disp * 0x9E3779B9U;
+   hash ^= hash >> 16;
+   hash *= 0x85EBCA6BU;
+   hash ^= hash >> 13;
+
+   return hash & (CMD_HASH_SLOTS-1);
+}
+
+#ifndef LG_CMD_TABLE_ONLY
+
+#include "lgCmdHash.h"
+
+typedef char cmdHashStale_t
+   [(CMD_HASH_ENTRIES == sizeof(cmdInfo)/sizeof(cmdInfo_t)) ? 1 : -1];
+
+static int cmdMatch(char *str, uint32_t hash)
+{
+   int idx;
+
+   idx = cmdHashIdx[cmdHashSlot(hash, cmdHashDisp[cmdHashBucket(hash)])];
+
+   if ((idx >= 0) && (strcasecmp(str, cmdInfo[idx].name) == 0)) return idx;
+
+   return CMD_UNKNOWN_CMD;
+}
+
+static char *skipSpace(char *str)
+{
+   while (isspace((unsigned char)*str)) ++str;
+   return str;
+}
+
+static int getStr(char *str, int *n2)
+{
+   char *end;
 
-   for (i=0; i<(sizeof(cmdInfo)/sizeof(cmdInfo_t)); i++)
+   /*
+   Returns the offset just past the next word (0 if there is
+   none) and sets *n2 to the offset past any following space.
+   */
+
+   end = skipSpace(str);
+
+   if (!*end) return 0;
+
+   while (*end && !isspace((unsigned char)*end)) ++end;
+
+   *n2 = skipSpace(end) - str;
+
+   return end - str;
+}
+
+static char *xBareHex(char *str, char *end)
+{
+   char *digits;
+
+   /* like scanf a bare 0x prefix is taken as 0 */
+
+   if ((*end == 'x') || (*end == 'X'))
    {
-      if (strcasecmp(str, cmdInfo[i].name) == 0) return i;
+      digits = skipSpace(str);
+      if ((*digits == '+') || (*digits == '-')) ++digits;
+      if ((end == (digits + 1)) && (*digits == '0')) ++end;
    }
-   return CMD_UNKNOWN_CMD;
+
+   return end;
 }
 
 static int getNum(
    char *str, uintmax_t *val, int8_t *opt, uintmax_t max, int real)
 {
-   int m, n;
+   char *end, *num;
    uintmax_t v;
    float f;
 
@@ -274,46 +356,55 @@ static int getNum(
 
    if (real)
    {
-      m = sscanf(str, " %f %n", &f, &n);
+      f = strtof(str, &end);
+      end = xBareHex(str, end);
 
-      if (m == 1)
+      if (end != str)
       {
          *val = (f * 1000.0) + 0.5;
          *opt = CMD_NUMERIC;
          if (*val > max) *opt = -CMD_NUMERIC;
-         return n;
+         return skipSpace(end) - str;
       }
    }
 
-   m = sscanf(str, " %ji %n", &v, &n);
+   v = strtoimax(str, &end, 0);
+   end = xBareHex(str, end);
 
-   if (m == 1)
+   if (end != str)
    {
       if (real) v = v * 1000;
       *val = v;
       *opt = CMD_NUMERIC;
       if (v > max) *opt = -CMD_NUMERIC;
-      return n;
+      return skipSpace(end) - str;
    }
 
-   m = sscanf(str, " v%ji %n", &v, &n);
+   end = skipSpace(str);
 
-   if (m == 1)
+   if ((*end == 'v') || (*end == 'p'))
    {
-      *val = v;
-      if (v < LG_MAX_SCRIPT_VARS) *opt = CMD_VAR;
-      else *opt = -CMD_VAR;
-      return n;
-   }
+      num = end + 1;
 
-   m = sscanf(str, " p%ji %n", &v, &n);
+      v = strtoimax(num, &end, 0);
+      end = xBareHex(num, end);
 
-   if (m == 1)
-   {
-      *val = v;
-      if (v < LG_MAX_SCRIPT_PARAMS) *opt = CMD_PAR;
-      else *opt = -CMD_PAR;
-      return n;
+      if (end != num)
+      {
+         *val = v;
+
+         if (num[-1] == 'v')
+         {
+            if (v < LG_MAX_SCRIPT_VARS) *opt = CMD_VAR;
+            else *opt = -CMD_VAR;
+         }
+         else
+         {
+            if (v < LG_MAX_SCRIPT_PARAMS) *opt = CMD_PAR;
+            else *opt = -CMD_PAR;
+         }
+         return skipSpace(end) - str;
+      }
    }
 
    return 0;
@@ -475,8 +566,10 @@ int cmdScanf(char *text, cmdCtl_p ctlP, lgCmd_p cmdP, char *fmt, int *matched)
 
 int cmdParse(char *text, cmdCtl_p ctlP, lgCmd_p cmdP, int cmdBufSize)
 {
-   int m, valid, idx, pp, pars, n, n2;
+   int valid, idx, pp, pars, n, n2;
    int matches;
+   uint32_t hash;
+   char *str;
    uint32_t *arg=(uint32_t*)&cmdP[1];
    char *ext=(char*)&cmdP[1];
    uintmax_t var;
@@ -485,13 +578,25 @@ int cmdParse(char *text, cmdCtl_p ctlP, lgCmd_p cmdP, int cmdBufSize)
 
    bzero(&ctlP->opt, sizeof(ctlP->opt));
 
-   sscanf(text+ctlP->eaten, " %31s %n", intCmdStr, &pp);
+   /* copy and hash the command name in one pass */
+
+   str = skipSpace(text+ctlP->eaten);
+   hash = CMD_HASH_INIT;
+
+   for (pp=0; (pp<(sizeof(intCmdStr)-1)) && str[pp] &&
+              !isspace((unsigned char)str[pp]); pp++)
+   {
+      intCmdStr[pp] = str[pp];
+      hash = cmdHashAdd(hash, str[pp]);
+   }
+
+   intCmdStr[pp] = 0;
 
-   ctlP->eaten += pp;
+   ctlP->eaten = skipSpace(str+pp) - text;
 
    cmdP->cmd = -1;
 
-   idx = cmdMatch(intCmdStr);
+   idx = cmdMatch(intCmdStr, hash);
 
    intCmdIdx = idx;
 
@@ -677,8 +782,8 @@ int cmdParse(char *text, cmdCtl_p ctlP, lgCmd_p cmdP, int cmdBufSize)
                    FL FO
                    Two parameters, first a string, other positive.
                 */
-         m = sscanf(text+ctlP->eaten, " %*s%n %n", &n, &n2);
-         if ((m >= 0) && n)
+         n = getStr(text+ctlP->eaten, &n2);
+         if (n)
          {
             cmdP->size = n+4;
             ctlP->opt[1] = CMD_NUMERIC;
@@ -733,8 +838,8 @@ int cmdParse(char *text, cmdCtl_p ctlP, lgCmd_p cmdP, int cmdBufSize)
                    PASSW USER
                    One parameter, a string.
                 */
-         m = sscanf(text+ctlP->eaten, " %*s%n %n", &n, &n2);
-         if ((m >= 0) && n)
+         n = getStr(text+ctlP->eaten, &n2);
+         if (n)
          {
             cmdP->size = n;
             memcpy(ext, text+ctlP->eaten, n);
@@ -775,8 +880,8 @@ int cmdParse(char *text, cmdCtl_p ctlP, lgCmd_p cmdP, int cmdBufSize)
                    SERO
                    Three parameters, first a string, rest >=0
                 */
-         m = sscanf(text+ctlP->eaten, " %*s%n %n", &n, &n2);
-         if ((m >= 0) && n)
+         n = getStr(text+ctlP->eaten, &n2);
+         if (n)
          {
             cmdP->size = n+8;
             ctlP->opt[1] = CMD_NUMERIC;
@@ -803,9 +908,9 @@ int cmdParse(char *text, cmdCtl_p ctlP, lgCmd_p cmdP, int cmdBufSize)
                    Two string parameters, the first space teminated.
                    The second arbitrary.
                 */
-         m = sscanf(text+ctlP->eaten, " %*s%n %n", &n, &n2);
+         n = getStr(text+ctlP->eaten, &n2);
 
-         if ((m >= 0) && n)
+         if (n)
          {
             valid = 1;
 
@@ -904,8 +1009,8 @@ int cmdParse(char *text, cmdCtl_p ctlP, lgCmd_p cmdP, int cmdBufSize)
       case 206: /* 
                    One parameter, a string.
                 */
-         m = sscanf(text+ctlP->eaten, " %*s%n %n", &n, &n2);
-         if ((m >= 0) && n)
+         n = getStr(text+ctlP->eaten, &n2);
+         if (n)
          {
             cmdP->size = n;
             ctlP->opt[3] = CMD_NUMERIC;
@@ -976,7 +1081,7 @@ int cmdParseScript(char *script, cmdScript_t *s, int diags)
 
       if (idx >= 0)
       {
-         fprintf(stderr, "cmd=%d size=%d a0=%d a1=%d a2=%d a3=%d\n",
+         LG_DBG(LG_DEBUG_SCRIPT, "cmd=%d size=%d a0=%d a1=%d a2=%d a3=%d",
             cmdP->cmd, cmdP->size, arg[0], arg[1], arg[2], arg[3]);
          if (cmdP->size)
          {
@@ -1085,3 +1190,4 @@ int cmdParseScript(char *script, cmdScript_t *s, int diags)
    return status;
 }
 
+#endif /* LG_CMD_TABLE_ONLY */
@@ -36,6 +36,10 @@ For more information, please refer to <http://unlicense.org/>
 #define CMD_MAX_PARAM 512
 #define CMD_MAX_EXTENSION (1<<16)
 
+/* the largest extension rgpiod accepts with a command, the rest of
+   its command buffer holds the header */
+#define CMD_MAX_CMD_EXTENSION (CMD_MAX_EXTENSION - (int)sizeof(lgCmd_t) - 1)
+
 #define CMD_UNKNOWN_CMD   -1
 #define CMD_BAD_PARAMETER -2
 #define CMD_EXT_TOO_SMALL -3
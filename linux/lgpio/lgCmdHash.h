@@ -0,0 +1,31 @@
+/* generated by mkCmdHash from cmdInfo in lgCmd.c, do not edit */
+
+#define CMD_HASH_ENTRIES 146
+
+static const uint8_t cmdHashDisp[CMD_HASH_BUCKETS]=
+{
+     0,   0,   1,   0,   0,   1,   2,   1,   2,   1,   0,   3,   0,   1,   0,   3,
+     0,   7,   0,   2,   2,   0,   1,   0,   0,   0,   1,   0,   7,   0,   1,   0,
+     7,   0,   1,   2,   0,   1,   1,   0,   0,   1,   0,   0,   8,   0,   1,   3,
+     2,   0,   3,   1,   9,   3,   0,   0,   1,   0,   0,   1,   4,   2,   6,   0,
+};
+
+static const int16_t cmdHashIdx[CMD_HASH_SLOTS]=
+{
+    -1,   6,  -1,  -1, 104,  85,  -1,  62,  83,  -1,   4, 114,  -1,  -1,  47,  97,
+    -1, 127,  -1,   8,  -1, 102,  -1,  -1,  -1,  -1,  91,  -1, 117,  -1,  13,  -1,
+    -1,  28,  15,  -1,  66,  69, 128,  -1, 105,  -1,  -1, 141,  25, 119,  73,  -1,
+    19,  22,  89,  -1,  74,  -1,  -1, 101, 140,  96, 121,  -1, 118,  76,  79,  -1,
+    -1,   3,  71,  -1, 103,  -1,  52,  -1,  -1, 131,  55,  -1, 123,  -1,  35,  39,
+    -1,  48,  11,  -1,  -1,  75, 112,  77,  -1,  90,  93,  -1,  87,  -1, 115, 130,
+    -1,  -1, 124,  -1,  21,  -1,  -1,  -1,  -1,   2,  72,  63,  14,  60, 126,  -1,
+    -1, 108,  -1,  -1,   0, 109, 144,  -1,  -1, 125,  -1,   1,  -1, 133,  70,  -1,
+   116, 110,  67, 120,  -1,  -1, 138,  40,  31,  -1,  -1,  86,  -1, 143,  -1,  -1,
+   129, 136,  78,  46,  53,  36,  -1,  23,  68, 134,  -1, 142,  26,  44,  95,  -1,
+    -1,  -1,  56,  -1,  64, 113,  -1,  -1, 107,  -1,   5,  -1,  81,  17,  -1,  32,
+   145,  65, 132,  88,  58,  54,  -1,  57,  92,  -1,  -1,  41,  -1,  -1,  -1,  84,
+    -1,  42,  -1,  -1,  30,  59,  18,  -1,  -1, 106,  20,  37,  29,  38,  -1,  -1,
+    -1,  10,  27,  -1,   7, 135,  94,  -1, 122,  -1,  50,  -1,  -1,  99,  98,  43,
+    -1,  -1, 139,  -1,  12,  82,  -1, 100, 137,  -1,  45,  51,  61,  80,  49,  -1,
+     9,  16,  -1,  -1,  -1,  33,  -1,  -1,  34, 111,  -1,  24,  -1,  -1,  -1,  -1,
+};
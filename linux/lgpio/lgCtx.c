@@ -70,3 +70,16 @@ lgCtx_p lgCtxGet(void)
    return ctx;
 }
 
+/* make ctx the calling thread's context (used when one thread
+   serves several connections) */
+
+void lgCtxSet(lgCtx_p ctx)
+{
+   pthread_once(&xInited, xInit);
+
+   LG_DBG(LG_DEBUG_ALLOC, "thread=%llu ctx=%p",
+      (long long int)pthread_self(), (void*)ctx);
+
+   pthread_setspecific(slgGlobalKey, ctx);
+}
+
@@ -28,8 +28,35 @@ For more information, please refer to <http://unlicense.org/>
 #ifndef LG_CONTEXT_H
 #define LG_CONTEXT_H
 
+#include <stdint.h>
 #include <pthread.h>
 
+#define LG_PERMIT_DEVS     32  /* devices held in a permit map */
+#define LG_PERMIT_SUBDEVS 256  /* subdevices held per device */
+#define LG_PERMIT_GLOBS    32  /* serial patterns held per user */
+#define LG_PERMIT_GLOB_LEN 1024
+
+/* a gpio/i2c/spi permit compiled to bitmaps, dev bit d is set if
+   device d may be opened, sub[d] holds the permitted subdevices
+   (gpio lines, i2c addresses, spi channels) of device d */
+
+typedef struct lgPermitMap_s
+{
+   uint32_t dev;
+   uint32_t sub[LG_PERMIT_DEVS][LG_PERMIT_SUBDEVS/32];
+} lgPermitMap_t, *lgPermitMap_p;
+
+/* a serial permit split once into its patterns, literal patterns
+   are compared without fnmatch */
+
+typedef struct lgPermitGlobs_s
+{
+   int count;
+   char *glob[LG_PERMIT_GLOBS];
+   char literal[LG_PERMIT_GLOBS];
+   char buf[LG_PERMIT_GLOB_LEN];
+} lgPermitGlobs_t, *lgPermitGlobs_p;
+
 typedef struct lgPermit_s
 {
    char *files;
@@ -41,6 +68,11 @@ typedef struct lgPermit_s
    char *notify;
    char *debug;
    char *shell;
+   int generation;       /* config generation compiled from */
+   lgPermitMap_t gpioMap;
+   lgPermitMap_t i2cMap;
+   lgPermitMap_t spiMap;
+   lgPermitGlobs_t serialGlobs;
 } lgPermit_t, *lgPermit_p;
 
 typedef struct lgCtx_s
@@ -56,6 +88,7 @@ typedef struct lgCtx_s
 } lgCtx_t, *lgCtx_p;
 
 lgCtx_p lgCtxGet(void);
+void lgCtxSet(lgCtx_p ctx);
 
 #endif
 
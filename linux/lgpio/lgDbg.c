@@ -25,7 +25,14 @@ OTHER DEALINGS IN THE SOFTWARE.
 For more information, please refer to <http://unlicense.org/>
 */
 
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <ctype.h>
+#include <errno.h>
 #include <inttypes.h>
+#include <pthread.h>
 #include <time.h>
 #include <sys/time.h>
 
@@ -35,8 +42,80 @@ For more information, please refer to <http://unlicense.org/>
 
 #define LG_DBG_MAX_BUFS 8
 
+#define LG_DBG_TRACE_EVENTS 4096 /* default events per thread */
+#define LG_DBG_TRACE_MAX_EVENTS (1<<20)
+
+typedef struct
+{
+   uint64_t seq;  /* event number + 1, 0 while being written */
+   lgDbgSite_t *site;
+   lgDbgTraceRec_t rec;
+} lgDbgEvent_t;
+
+typedef struct lgDbgRing_s
+{
+   struct lgDbgRing_s *next;
+   int inUse;
+   uint32_t id;
+   uint64_t head;
+   uint64_t mask;
+   lgDbgEvent_t event[];
+} lgDbgRing_t;
+
+/* buffers given to the hex/int dump helpers when tracing */
+
+typedef struct
+{
+   int kind;
+   int len;
+   char data[LG_DBG_TRACE_STR];
+} lgDbgPending_t;
+
 uint64_t lgDbgLevel = LG_DEBUG_ALWAYS;
 
+int lgDbgTracing = 0;
+
+static pthread_mutex_t xTraceMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t xTraceInited = PTHREAD_ONCE_INIT;
+static pthread_key_t xRingKey;
+
+static lgDbgSite_t *xSites;
+static uint32_t xSiteCount;
+
+static lgDbgRing_t *xRings;
+static uint32_t xRingCount;
+static int xRingEvents = LG_DBG_TRACE_EVENTS;
+
+static __thread lgDbgRing_t *xRing;
+
+static char xMarks[LG_DBG_MAX_BUFS];
+static __thread lgDbgPending_t xPending[LG_DBG_MAX_BUFS];
+static __thread int xPendingNext;
+
+/* ----------------------------------------------------------------------- */
+
+static char *xPend(int kind, const void *buf, int len)
+{
+   lgDbgPending_t *p;
+   int which;
+
+   /* defer the dump, the mark is replaced when the event is recorded */
+
+   which = xPendingNext;
+   if (++xPendingNext >= LG_DBG_MAX_BUFS) xPendingNext = 0;
+
+   p = &xPending[which];
+
+   if (len < 0) len = 0;
+   if (len > sizeof(p->data)) len = sizeof(p->data);
+
+   p->kind = kind;
+   p->len = len;
+   if (len) memcpy(p->data, buf, len);
+
+   return &xMarks[which];
+}
+
 char *lgDbgStr2Hex(int count, const char *buf)
 {
    static char str[LG_DBG_MAX_BUFS][128];
@@ -44,6 +123,9 @@ char *lgDbgStr2Hex(int count, const char *buf)
 
    int i, c;
 
+   if (lgDbgTracing && buf)
+      return xPend(LG_DBG_STR_HEX, buf, (count > 40) ? 40 : count);
+
    if (++which >= LG_DBG_MAX_BUFS) which = 0;
 
    if (count && buf)
@@ -67,6 +149,9 @@ char *lgDbgInt2Str(int count, const int *buf)
 
    int i, pos;
 
+   if (lgDbgTracing && buf)
+      return xPend(LG_DBG_STR_INTS, buf, count * sizeof(int));
+
    if (++which >= LG_DBG_MAX_BUFS) which = 0;
 
    if (count && buf)
@@ -113,6 +198,9 @@ char *lgDbgBuf2Str(int count, const char *buf)
    static int which = 0;
    int i, c;
 
+   if (lgDbgTracing && buf)
+      return xPend(LG_DBG_STR_HEX, buf, (count > 40) ? 40 : count);
+
    if (++which >= LG_DBG_MAX_BUFS) which = 0;
 
    if (count && buf)
@@ -127,3 +215,440 @@ char *lgDbgBuf2Str(int count, const char *buf)
    return str[which];
 }
 
+/* ----------------------------------------------------------------------- */
+
+int lgDbgFormatArg(const char **format, int *stars)
+{
+   const char *p = *format + 1;
+   int len = 0; /* 1 h, 2 l, 3 ll, 4 j, 5 z, 6 t, 7 L */
+   int type;
+
+   *stars = 0;
+
+   if (*p == '%') {*format = p + 1; return LG_DBG_ARG_NONE;}
+
+   while (strchr("-+ #0'I", *p) && *p) ++p;
+
+   if (*p == '*') {++*stars; ++p;} else while (isdigit(*p)) ++p;
+
+   if (*p == '.')
+   {
+      ++p;
+      if (*p == '*') {++*stars; ++p;} else while (isdigit(*p)) ++p;
+   }
+
+   switch (*p)
+   {
+      case 'h': len = 1; ++p; if (*p == 'h') ++p; break;
+      case 'l': len = 2; ++p; if (*p == 'l') {len = 3; ++p;} break;
+      case 'q': len = 3; ++p; break;
+      case 'j': len = 4; ++p; break;
+      case 'z':
+      case 'Z': len = 5; ++p; break;
+      case 't': len = 6; ++p; break;
+      case 'L': len = 7; ++p; break;
+   }
+
+   switch (*p)
+   {
+      case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+         switch (len)
+         {
+            case 2:  type = LG_DBG_ARG_LONG;    break;
+            case 3:
+            case 7:  type = LG_DBG_ARG_LLONG;   break;
+            case 4:  type = LG_DBG_ARG_MAX;     break;
+            case 5:  type = LG_DBG_ARG_SIZE;    break;
+            case 6:  type = LG_DBG_ARG_PTRDIFF; break;
+            default: type = LG_DBG_ARG_INT;     break;
+         }
+         break;
+
+      case 'c':
+         type = LG_DBG_ARG_INT;
+         break;
+
+      case 'e': case 'E': case 'f': case 'F':
+      case 'g': case 'G': case 'a': case 'A':
+         type = (len == 7) ? LG_DBG_ARG_LDOUBLE : LG_DBG_ARG_DOUBLE;
+         break;
+
+      case 's':
+         type = (len == 2) ? LG_DBG_ARG_PTR : LG_DBG_ARG_STR;
+         break;
+
+      case 'p':
+      case 'n':
+         type = LG_DBG_ARG_PTR;
+         break;
+
+      case 'm':
+         type = LG_DBG_ARG_ERRNO;
+         break;
+
+      default:
+         type = LG_DBG_ARG_NONE;
+         break;
+   }
+
+   if (*p) ++p;
+
+   *format = p;
+
+   return type;
+}
+
+/* ----------------------------------------------------------------------- */
+
+static void xRingRelease(void *ring)
+{
+   __atomic_store_n(&((lgDbgRing_t *)ring)->inUse, 0, __ATOMIC_RELEASE);
+}
+
+static void xTraceInit(void)
+{
+   pthread_key_create(&xRingKey, xRingRelease);
+}
+
+static void xSiteInit(lgDbgSite_t *site)
+{
+   const char *p;
+   int type, stars;
+
+   pthread_mutex_lock(&xTraceMutex);
+
+   if (!site->id)
+   {
+      site->nargs = 0;
+
+      for (p=site->format; *p; )
+      {
+         if (*p != '%') {++p; continue;}
+
+         type = lgDbgFormatArg(&p, &stars);
+
+         while (stars-- && (site->nargs < LG_DBG_TRACE_ARGS))
+            site->type[site->nargs++] = LG_DBG_ARG_INT;
+
+         if (type && (site->nargs < LG_DBG_TRACE_ARGS))
+            site->type[site->nargs++] = type;
+      }
+
+      site->next = xSites;
+      xSites = site;
+
+      __atomic_store_n(&site->id, ++xSiteCount, __ATOMIC_RELEASE);
+   }
+
+   pthread_mutex_unlock(&xTraceMutex);
+}
+
+static lgDbgRing_t *xRingGet(void)
+{
+   lgDbgRing_t *ring;
+   uint64_t i;
+
+   pthread_mutex_lock(&xTraceMutex);
+
+   /* reuse the ring of an exited thread */
+
+   for (ring=xRings; ring; ring=ring->next)
+   {
+      if (!ring->inUse && ((ring->mask + 1) == xRingEvents)) break;
+   }
+
+   if (!ring)
+   {
+      ring = calloc(1, sizeof(lgDbgRing_t) + xRingEvents*sizeof(lgDbgEvent_t));
+
+      if (ring)
+      {
+         ring->id = ++xRingCount;
+         ring->mask = xRingEvents - 1;
+         ring->next = xRings;
+         xRings = ring;
+      }
+   }
+   else
+   {
+      /* a new thread, so a new id and none of the old thread's events */
+
+      ring->id = ++xRingCount;
+      ring->head = 0;
+
+      for (i=0; i<=ring->mask; i++) ring->event[i].seq = 0;
+   }
+
+   if (ring)
+   {
+      ring->inUse = 1;
+      pthread_setspecific(xRingKey, ring);
+   }
+
+   pthread_mutex_unlock(&xTraceMutex);
+
+   xRing = ring;
+
+   return ring;
+}
+
+static void xTraceStr(lgDbgTraceRec_t *rec, const char *str, uint64_t *arg)
+{
+   int kind = LG_DBG_STR_TEXT;
+   int len, off;
+
+   if ((str >= xMarks) && (str < (xMarks + LG_DBG_MAX_BUFS)))
+   {
+      lgDbgPending_t *p = &xPending[str - xMarks];
+
+      kind = p->kind;
+      len = p->len;
+      str = p->data;
+   }
+   else
+   {
+      if (!str) str = "(null)";
+      len = strnlen(str, LG_DBG_TRACE_STR);
+   }
+
+   off = rec->strLen;
+
+   if (len > (LG_DBG_TRACE_STR - off)) len = LG_DBG_TRACE_STR - off;
+
+   memcpy(rec->str + off, str, len);
+   rec->strLen += len;
+
+   *arg = LG_DBG_STR_ARG(off, len, kind);
+}
+
+void lgDbgTrace(lgDbgSite_t *site, ...)
+{
+   lgDbgRing_t *ring;
+   lgDbgEvent_t *ev;
+   lgDbgTraceRec_t *rec;
+   struct timespec ts;
+   uint64_t seq;
+   va_list ap;
+   double d;
+   int i, err;
+
+   err = errno;
+
+   if (!__atomic_load_n(&site->id, __ATOMIC_ACQUIRE)) xSiteInit(site);
+
+   ring = xRing;
+
+   if (!ring && !(ring = xRingGet())) return;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+
+   seq = ring->head;
+   ev = &ring->event[seq & ring->mask];
+   rec = &ev->rec;
+
+   /* the dump skips events being written */
+
+   __atomic_store_n(&ev->seq, 0, __ATOMIC_RELAXED);
+   __atomic_thread_fence(__ATOMIC_RELEASE);
+
+   ev->site = site;
+   rec->tick = (ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+   rec->strLen = 0;
+
+   va_start(ap, site);
+
+   for (i=0; i<site->nargs; i++)
+   {
+      switch (site->type[i])
+      {
+         case LG_DBG_ARG_INT:
+            rec->arg[i] = va_arg(ap, int);
+            break;
+
+         case LG_DBG_ARG_LONG:
+            rec->arg[i] = va_arg(ap, long);
+            break;
+
+         case LG_DBG_ARG_LLONG:
+            rec->arg[i] = va_arg(ap, long long);
+            break;
+
+         case LG_DBG_ARG_SIZE:
+            rec->arg[i] = va_arg(ap, size_t);
+            break;
+
+         case LG_DBG_ARG_MAX:
+            rec->arg[i] = va_arg(ap, intmax_t);
+            break;
+
+         case LG_DBG_ARG_PTRDIFF:
+            rec->arg[i] = va_arg(ap, ptrdiff_t);
+            break;
+
+         case LG_DBG_ARG_DOUBLE:
+            d = va_arg(ap, double);
+            memcpy(&rec->arg[i], &d, sizeof(d));
+            break;
+
+         case LG_DBG_ARG_LDOUBLE:
+            d = va_arg(ap, long double);
+            memcpy(&rec->arg[i], &d, sizeof(d));
+            break;
+
+         case LG_DBG_ARG_STR:
+            xTraceStr(rec, va_arg(ap, const char *), &rec->arg[i]);
+            break;
+
+         case LG_DBG_ARG_PTR:
+            rec->arg[i] = (uintptr_t)va_arg(ap, void *);
+            break;
+
+         case LG_DBG_ARG_ERRNO:
+            rec->arg[i] = err;
+            break;
+      }
+   }
+
+   va_end(ap);
+
+   __atomic_store_n(&ev->seq, seq + 1, __ATOMIC_RELEASE);
+   __atomic_store_n(&ring->head, seq + 1, __ATOMIC_RELEASE);
+
+   errno = err;
+}
+
+int lgDbgTraceStart(int events)
+{
+   int size;
+
+   if (events <= 0) events = LG_DBG_TRACE_EVENTS;
+
+   if (events > LG_DBG_TRACE_MAX_EVENTS) return LG_BAD_CONFIG_VALUE;
+
+   for (size=16; size<events; size<<=1);
+
+   pthread_once(&xTraceInited, xTraceInit);
+
+   pthread_mutex_lock(&xTraceMutex);
+   xRingEvents = size; /* applies to rings created from now on */
+   pthread_mutex_unlock(&xTraceMutex);
+
+   lgDbgTracing = 1;
+
+   return LG_OKAY;
+}
+
+void lgDbgTraceStop(void)
+{
+   lgDbgTracing = 0;
+}
+
+static int xRecCompare(const void *a, const void *b)
+{
+   const lgDbgTraceRec_t *ra = a, *rb = b;
+
+   if (ra->tick < rb->tick) return -1;
+   if (ra->tick > rb->tick) return 1;
+   return 0;
+}
+
+int lgDbgTraceDump(const char *file)
+{
+   FILE *f;
+   lgDbgRing_t *ring;
+   lgDbgEvent_t *ev;
+   lgDbgSite_t *site;
+   lgDbgTraceRec_t *recs;
+   struct timespec mono, real;
+   uint64_t head, first, seq, s;
+   uint32_t count, total;
+   uint16_t u16;
+   int64_t offset;
+   int err;
+
+   pthread_mutex_lock(&xTraceMutex);
+
+   total = 0;
+   for (ring=xRings; ring; ring=ring->next) total += ring->mask + 1;
+
+   recs = malloc((total ? total : 1) * sizeof(lgDbgTraceRec_t));
+
+   if (!recs)
+   {
+      pthread_mutex_unlock(&xTraceMutex);
+      return LG_NO_MEMORY;
+   }
+
+   count = 0;
+
+   for (ring=xRings; ring; ring=ring->next)
+   {
+      head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+      first = (head > ring->mask) ? (head - ring->mask) : 0;
+
+      for (seq=first; seq<head; seq++)
+      {
+         ev = &ring->event[seq & ring->mask];
+
+         s = __atomic_load_n(&ev->seq, __ATOMIC_ACQUIRE);
+         if (s != (seq + 1)) continue;
+
+         site = ev->site;
+         recs[count] = ev->rec;
+         __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+         /* overwritten while copied */
+         if (__atomic_load_n(&ev->seq, __ATOMIC_RELAXED) != s) continue;
+
+         recs[count].thread = ring->id;
+         recs[count].site = site->id;
+         ++count;
+      }
+   }
+
+   f = fopen(file, "w");
+
+   if (!f)
+   {
+      pthread_mutex_unlock(&xTraceMutex);
+      free(recs);
+      return LG_FILE_OPEN_FAILED;
+   }
+
+   qsort(recs, count, sizeof(lgDbgTraceRec_t), xRecCompare);
+
+   clock_gettime(CLOCK_MONOTONIC, &mono);
+   clock_gettime(CLOCK_REALTIME, &real);
+
+   offset = ((int64_t)(real.tv_sec - mono.tv_sec) * 1000000000LL) +
+      (real.tv_nsec - mono.tv_nsec);
+
+   fwrite(LG_DBG_TRACE_MAGIC, 8, 1, f);
+   fwrite(&offset, sizeof(offset), 1, f);
+   fwrite(&xSiteCount, sizeof(xSiteCount), 1, f);
+   fwrite(&count, sizeof(count), 1, f);
+
+   for (site=xSites; site; site=site->next)
+   {
+      fwrite(&site->id, sizeof(site->id), 1, f);
+      u16 = strlen(site->func);
+      fwrite(&u16, sizeof(u16), 1, f);
+      fwrite(site->func, u16, 1, f);
+      u16 = strlen(site->format);
+      fwrite(&u16, sizeof(u16), 1, f);
+      fwrite(site->format, u16, 1, f);
+   }
+
+   fwrite(recs, sizeof(lgDbgTraceRec_t), count, f);
+
+   pthread_mutex_unlock(&xTraceMutex);
+
+   err = ferror(f);
+
+   fclose(f);
+   free(recs);
+
+   if (err) return LG_FILE_OPEN_FAILED;
+
+   return count;
+}
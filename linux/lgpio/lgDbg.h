@@ -33,6 +33,7 @@ For more information, please refer to <http://unlicense.org/>
 
 extern uint64_t lgDbgLevel;
 extern int lgMinTxDelay;
+extern int lgDbgTracing;
 
 /* Debug constants
 */
@@ -52,12 +53,79 @@ extern int lgMinTxDelay;
 #define LG_DEBUG_INIT        (1<<11)
 #define LG_DEBUG_MAX_LEVEL   (1<<12) 
 
+/* Trace constants
+*/
+
+#define LG_DBG_TRACE_ARGS  12  /* arguments recorded per event */
+#define LG_DBG_TRACE_STR  134  /* string bytes recorded per event */
+
+#define LG_DBG_ARG_NONE    0
+#define LG_DBG_ARG_INT     1
+#define LG_DBG_ARG_LONG    2
+#define LG_DBG_ARG_LLONG   3
+#define LG_DBG_ARG_SIZE    4
+#define LG_DBG_ARG_MAX     5
+#define LG_DBG_ARG_PTRDIFF 6
+#define LG_DBG_ARG_DOUBLE  7
+#define LG_DBG_ARG_LDOUBLE 8
+#define LG_DBG_ARG_STR     9
+#define LG_DBG_ARG_PTR    10
+#define LG_DBG_ARG_ERRNO  11  /* %m, errno when recorded */
+
+/* string arguments are recorded as offset, length and kind */
+
+#define LG_DBG_STR_TEXT 0
+#define LG_DBG_STR_HEX  1  /* bytes from lgDbgBuf2Str/lgDbgStr2Hex */
+#define LG_DBG_STR_INTS 2  /* ints from lgDbgInt2Str */
+
+#define LG_DBG_STR_ARG(off, len, kind) \
+   (((uint64_t)(kind)<<32) | ((off)<<16) | (len))
+#define LG_DBG_STR_OFF(arg)  (((arg)>>16) & 0xffff)
+#define LG_DBG_STR_LEN(arg)  ((arg) & 0xffff)
+#define LG_DBG_STR_KIND(arg) ((int)((arg)>>32))
+
+typedef struct lgDbgSite_s
+{
+   const char *func;
+   const char *format;
+   struct lgDbgSite_s *next;
+   uint32_t id;      /* set when first traced */
+   uint8_t nargs;
+   uint8_t type[LG_DBG_TRACE_ARGS];
+} lgDbgSite_t;
+
+/* an event as written by lgDbgTraceDump */
+
+typedef struct
+{
+   uint64_t tick;    /* CLOCK_MONOTONIC nanoseconds */
+   uint32_t thread;
+   uint32_t site;
+   uint64_t arg[LG_DBG_TRACE_ARGS];
+   uint16_t strLen;
+   char str[LG_DBG_TRACE_STR];
+} lgDbgTraceRec_t;
+
+#define LG_DBG_TRACE_MAGIC "lgtrace1"
+
+/*
+When tracing each message which passes the level check is recorded
+unformatted in a ring of the calling thread.  The rings are written
+to a file by lgDbgTraceDump and rendered by lgtrace.
+*/
+
 #define LG_DBG(mask, format, arg...)                               \
    do                                                              \
    {                                                               \
       if ((lgDbgLevel & mask) == mask)                             \
-         fprintf(stderr, "%s %s: " format "\n" ,                   \
-            lgDbgTimeStamp(), __func__ , ## arg);              \
+      {                                                            \
+         static lgDbgSite_t lgDbgSite = {__func__, format};        \
+         if (lgDbgTracing)                                         \
+            lgDbgTrace(&lgDbgSite , ## arg);                       \
+         else                                                      \
+            fprintf(stderr, "%s %s: " format "\n" ,                \
+               lgDbgTimeStamp(), __func__ , ## arg);               \
+      }                                                            \
    }                                                               \
    while (0)
 
@@ -82,5 +150,11 @@ char *lgDbgInt2Str(int count, const int *buf);
 char *lgDbgStr2Hex(int count, const char *buf);
 char *lgDbgTimeStamp(void);
 
+int lgDbgFormatArg(const char **format, int *stars);
+void lgDbgTrace(lgDbgSite_t *site, ...);
+int lgDbgTraceStart(int events);
+void lgDbgTraceStop(void);
+int lgDbgTraceDump(const char *file);
+
 #endif
 
@@ -55,6 +55,8 @@ typedef enum
 
 static lgCfg_p Cfg;
 
+static int cfgGeneration;
+
 static pthread_once_t xInited = PTHREAD_ONCE_INIT;
 
 static uint64_t xMakeSalt(void)
@@ -76,6 +78,9 @@ static int xLoadConfig(void)
 
    Cfg = lgCfgRead(cfgFile);
 
+   /* contexts recompile their permits on next use */
+   ++cfgGeneration;
+
    if (Cfg) lgCfgPrint(Cfg, stderr);
 
    if (Cfg) return LG_OKAY; else return LG_BAD_CONFIG_FILE;
@@ -94,7 +99,6 @@ int xCheckDevSubdev(char *str, int dev, int subdev)
 
    while (1)
    {
-      printf("%c", *str);
       switch (*str)
       {
          case '0':
@@ -215,8 +219,254 @@ int xCheckDevSubdev(char *str, int dev, int subdev)
    return 0;
 }
 
+static void xSetUserPermits(lgCtx_p Ctx);
+
+static void xRefreshPermits(lgCtx_p Ctx)
+{
+   /* the permit strings belong to the config, pick up a reload */
+
+   if (Ctx->approved && (Ctx->permits.generation != cfgGeneration))
+      xSetUserPermits(Ctx);
+}
+
+static int xCheckDevSubdevList(char *permit, int dev, int subdev)
+{
+   char buf[LG_MAX_PATH];
+   char *str, *pos, *token;
+   const char *delim = ":";
+
+   if (!permit) return 0;
+
+   strncpy(buf, permit, sizeof(buf)-1);
+   buf[sizeof(buf)-1] = 0;
+
+   str = buf;
+   while ((token=lgCfgNextToken(&str, delim, &pos)))
+   {
+      if (xCheckDevSubdev(token, dev, subdev)) return 1;
+   }
+   return 0;
+}
+
+static void xMapDevs(lgPermitMap_p map, int first, int last)
+{
+   int dev;
+
+   if (first < 0) first = 0; /* an overlong number wrapped */
+   if (last >= LG_PERMIT_DEVS) last = LG_PERMIT_DEVS - 1;
+
+   for (dev=first; dev<=last; dev++) map->dev |= (1U<<dev);
+}
+
+static void xMapSubdevs(
+   lgPermitMap_p map, int firstDev, int lastDev, int first, int last)
+{
+   int dev, sub;
+
+   if (firstDev < 0) firstDev = 0;
+   if (lastDev >= LG_PERMIT_DEVS) lastDev = LG_PERMIT_DEVS - 1;
+   if (first < 0) first = 0;
+   if (last >= LG_PERMIT_SUBDEVS) last = LG_PERMIT_SUBDEVS - 1;
+
+   for (dev=firstDev; dev<=lastDev; dev++)
+   {
+      for (sub=first; sub<=last; sub++)
+         map->sub[dev][sub>>5] |= (1U<<(sub&31));
+   }
+}
+
+/* walk a token as xCheckDevSubdev does, marking everything it would
+   pass rather than testing one device and subdevice.  A pass depends
+   only on the devices selected before the dot, and a syntax error
+   ends the token, so the map agrees with xCheckDevSubdev exactly */
+
+static void xCompileToken(char *str, lgPermitMap_p map)
+{
+   int num;
+   int r1=0, firstDev=0, lastDev=-1;
+   checkDevSubdev_t expect=DEV;
+
+   while (1)
+   {
+      switch (*str)
+      {
+         case '0':
+         case '1':
+         case '2':
+         case '3':
+         case '4':
+         case '5':
+         case '6':
+         case '7':
+         case '8':
+         case '9':
+
+            num = 0;
+            while (isdigit(*str))
+               {num = (num * 10) + (*str) - '0'; ++str;}
+            --str;
+
+            if (expect == DEV)
+            {
+               r1 = num;
+               xMapDevs(map, r1, r1);
+               expect = DEVNEXT;
+            }
+            else if (expect == SUBDEV)
+            {
+               r1 = num;
+               xMapSubdevs(map, firstDev, lastDev, r1, r1);
+               expect = SUBDEVNEXT;
+            }
+            else if (expect == DEV2)
+            {
+               xMapDevs(map, r1, num);
+               firstDev = r1;
+               lastDev = num;
+               expect = DOT;
+            }
+            else if (expect == SUBDEV2)
+            {
+               xMapSubdevs(map, firstDev, lastDev, r1, num);
+               expect = COMMA;
+            }
+            else return;
+
+            break;
+
+         case '\0':
+            return;
+
+         case ' ':
+         case '\t':
+            break;
+
+         case '*':
+            if (expect == DEV)
+            {
+               xMapDevs(map, 0, LG_PERMIT_DEVS - 1);
+               firstDev = 0;
+               lastDev = LG_PERMIT_DEVS - 1;
+               expect = DOT;
+            }
+
+            else if (expect == SUBDEV)
+            {
+               xMapSubdevs(map, firstDev, lastDev, 0, LG_PERMIT_SUBDEVS - 1);
+               return;
+            }
+
+            else return;
+
+            break;
+
+         case '-':
+
+            if      (expect == DEVNEXT)    expect = DEV2;
+            else if (expect == SUBDEVNEXT) expect = SUBDEV2;
+            else return;
+
+            break;
+
+         case '.':
+
+            if (expect == DOT) expect = SUBDEV;
+
+            else if (expect == DEVNEXT)
+            {
+               firstDev = lastDev = r1;
+               expect = SUBDEV;
+            }
+
+            else return;
+
+            break;
+
+         case ',':
+
+            if ((expect == COMMA) || (expect == SUBDEVNEXT))
+            {
+               expect = SUBDEV;
+            }
+            else return;
+
+            break;
+
+         default:
+            return;
+      }
+      ++str;
+   }
+}
+
+static void xCompileMap(char *permit, lgPermitMap_p map)
+{
+   char buf[LG_MAX_PATH];
+   char *str, *pos, *token;
+   const char *delim = ":";
+
+   memset(map, 0, sizeof(*map));
+
+   if (!permit) return;
+
+   strncpy(buf, permit, sizeof(buf)-1);
+   buf[sizeof(buf)-1] = 0;
+
+   str = buf;
+   while ((token=lgCfgNextToken(&str, delim, &pos)))
+   {
+      LG_DBG(LG_DEBUG_TRACE, "compile %s", token);
+
+      xCompileToken(token, map);
+   }
+}
+
+static int xCheckMap(lgPermitMap_p map, char *permit, int dev, int subdev)
+{
+   if (!permit) return 0;
+
+   if ((dev >= 0) && (dev < LG_PERMIT_DEVS) && (subdev < LG_PERMIT_SUBDEVS))
+   {
+      if (subdev < 0) return (map->dev >> dev) & 1;
+
+      return (map->sub[dev][subdev>>5] >> (subdev&31)) & 1;
+   }
+
+   /* outside the map, check the permit string */
+
+   return xCheckDevSubdevList(permit, dev, subdev);
+}
+
+static void xCompileGlobs(char *permit, lgPermitGlobs_p globs)
+{
+   char *str, *pos, *token;
+   const char *delim = ":";
+
+   globs->count = 0;
+
+   if (!permit) return;
+
+   strncpy(globs->buf, permit, sizeof(globs->buf)-1);
+   globs->buf[sizeof(globs->buf)-1] = 0;
+
+   str = globs->buf;
+   while ((token=lgCfgNextToken(&str, delim, &pos)))
+   {
+      if (globs->count >= LG_PERMIT_GLOBS)
+      {
+         LG_DBG(LG_DEBUG_ALWAYS, "ignored, too many patterns: %s", token);
+         continue;
+      }
+
+      globs->literal[globs->count] = (strpbrk(token, "*?[\\") == NULL);
+      globs->glob[globs->count++] = token;
+   }
+}
+
 static int xCheckDebugPermissions(lgCtx_p Ctx)
 {
+   xRefreshPermits(Ctx);
+
    if (Ctx->permits.debug)
    {
       if ((strcmp(Ctx->permits.debug, "Y") == 0) ||
@@ -228,6 +478,8 @@ static int xCheckDebugPermissions(lgCtx_p Ctx)
 
 static int xCheckShellPermissions(lgCtx_p Ctx)
 {
+   xRefreshPermits(Ctx);
+
    if (Ctx->permits.shell)
    {
       if ((strcmp(Ctx->permits.shell, "Y") == 0) ||
@@ -239,6 +491,8 @@ static int xCheckShellPermissions(lgCtx_p Ctx)
 
 static int xCheckNotifyPermissions(lgCtx_p Ctx)
 {
+   xRefreshPermits(Ctx);
+
    if (Ctx->permits.notify)
    {
       if ((strcmp(Ctx->permits.notify, "Y") == 0) ||
@@ -251,6 +505,8 @@ static int xCheckNotifyPermissions(lgCtx_p Ctx)
 
 static int xCheckScriptPermissions(lgCtx_p Ctx)
 {
+   xRefreshPermits(Ctx);
+
    if (Ctx->permits.scripts)
    {
       if ((strcmp(Ctx->permits.scripts, "Y") == 0) ||
@@ -263,86 +519,44 @@ static int xCheckScriptPermissions(lgCtx_p Ctx)
 
 static int xCheckSerialPermissions(lgCtx_p Ctx, char *serDev)
 {
-   char buf[LG_MAX_PATH];
-   char *str, *pos, *token;
-   const char *delim = ":";
-
-   if (!Ctx->permits.serial) return 0;
+   lgPermitGlobs_p globs = &Ctx->permits.serialGlobs;
+   int i;
 
-   strncpy(buf, Ctx->permits.serial, sizeof(buf)-1);
-   buf[sizeof(buf)-1] = 0;
+   xRefreshPermits(Ctx);
 
-   str = buf;
-   while ((token=lgCfgNextToken(&str, delim, &pos)))
+   for (i=0; i<globs->count; i++)
    {
-      LG_DBG(LG_DEBUG_ALWAYS, "%s and %s", serDev, token);
-
-      if (fnmatch(token, serDev, 0) == 0) return 1;
+      if (globs->literal[i])
+      {
+         if (strcmp(globs->glob[i], serDev) == 0) return 1;
+      }
+      else if (fnmatch(globs->glob[i], serDev, 0) == 0) return 1;
    }
    return 0;
 }
 
 static int xCheckI2cPermissions(lgCtx_p Ctx, int i2cDev, int i2cAddr)
 {
-   char buf[LG_MAX_PATH];
-   char *str, *pos, *token;
-   const char *delim = ":";
-
-   if (!Ctx->permits.i2c) return 0;
-
-   strncpy(buf, Ctx->permits.i2c, sizeof(buf)-1);
-   buf[sizeof(buf)-1] = 0;
-
-   str = buf;
-   while ((token=lgCfgNextToken(&str, delim, &pos)))
-   {
-      LG_DBG(LG_DEBUG_ALWAYS, "%d.%d and %s", i2cDev, i2cAddr, token);
+   xRefreshPermits(Ctx);
 
-      if (xCheckDevSubdev(token, i2cDev, i2cAddr)) return 1;
-   }
-   return 0;
+   return xCheckMap(
+      &Ctx->permits.i2cMap, Ctx->permits.i2c, i2cDev, i2cAddr);
 }
 
 static int xCheckSpiPermissions(lgCtx_p Ctx, int spiDev, int spiChan)
 {
-   char buf[LG_MAX_PATH];
-   char *str, *pos, *token;
-   const char *delim = ":";
-
-   if (!Ctx->permits.spi) return 0;
-
-   strncpy(buf, Ctx->permits.spi, sizeof(buf)-1);
-   buf[sizeof(buf)-1] = 0;
-
-   str = buf;
-   while ((token=lgCfgNextToken(&str, delim, &pos)))
-   {
-      LG_DBG(LG_DEBUG_ALWAYS, "%d.%d and %s", spiDev, spiChan, token);
+   xRefreshPermits(Ctx);
 
-      if (xCheckDevSubdev(token, spiDev, spiChan)) return 1;
-   }
-   return 0;
+   return xCheckMap(
+      &Ctx->permits.spiMap, Ctx->permits.spi, spiDev, spiChan);
 }
 
 static int xCheckGpioPermissions(lgCtx_p Ctx, int gpioDev, int gpio)
 {
-   char buf[LG_MAX_PATH];
-   char *str, *pos, *token;
-   const char *delim = ":";
-
-   if (!Ctx->permits.gpio) return 0;
-
-   strncpy(buf, Ctx->permits.gpio, sizeof(buf)-1);
-   buf[sizeof(buf)-1] = 0;
-
-   str = buf;
-   while ((token=lgCfgNextToken(&str, delim, &pos)))
-   {
-      LG_DBG(LG_DEBUG_ALWAYS, "%d.%d and %s", gpioDev, gpio, token);
+   xRefreshPermits(Ctx);
 
-      if (xCheckDevSubdev(token, gpioDev, gpio)) return 1;
-   }
-   return 0;
+   return xCheckMap(
+      &Ctx->permits.gpioMap, Ctx->permits.gpio, gpioDev, gpio);
 }
 
 static int xSetGpioPermissions(lgCtx_p Ctx, int gpioDev, int handle)
@@ -383,6 +597,8 @@ static int xApprove(lgCtx_p Ctx, char *filename, int mode)
    const char *delim =":";
    int approve = 0;
 
+   xRefreshPermits(Ctx);
+
    if (!Ctx->permits.files) return 0;
 
    if (xPathBad(filename))  return 0;
@@ -475,8 +691,20 @@ static void xSetUserPermits(lgCtx_p Ctx)
       Ctx->permits.notify =  lgCfgGetValue(Cfg, "notify",  Ctx->user);
       Ctx->permits.debug =   lgCfgGetValue(Cfg, "debug",   Ctx->user);
       Ctx->permits.shell =   lgCfgGetValue(Cfg, "shell",   Ctx->user);
+
+      /* only consulted when permits are checked */
+
+      if (gPermits)
+      {
+         xCompileMap(Ctx->permits.gpio, &Ctx->permits.gpioMap);
+         xCompileMap(Ctx->permits.i2c,  &Ctx->permits.i2cMap);
+         xCompileMap(Ctx->permits.spi,  &Ctx->permits.spiMap);
+         xCompileGlobs(Ctx->permits.serial, &Ctx->permits.serialGlobs);
+      }
    }
    else xClearUserPermits(Ctx);
+
+   Ctx->permits.generation = cfgGeneration;
 }
 
 static int xSetUser(lgCtx_p Ctx, char *user, char *buf)
@@ -560,9 +788,28 @@ static int xPassword(lgCtx_p Ctx, char *hash)
    return result;
 }
 
-int lgExecCmd(lgCmd_p cmdP, int cmdBufSize)
+void lgExecCtxInit(lgCtx_p Ctx)
 {
    static int xPid = 0;
+
+   pthread_once(&xInited, xInit);
+
+   if (Ctx->owner == 0)
+   {
+      Ctx->owner = ++xPid;
+
+      /* set default user if no preset user */
+      if (!strlen(Ctx->user))
+         strncpy(Ctx->user, LG_DEFAULT_USER, LG_USER_LEN);
+
+      /* set permissions for user */
+      Ctx->approved = 1;
+      xSetUserPermits(Ctx);
+   }
+}
+
+int lgExecCmd(lgCmd_p cmdP, int cmdBufSize)
+{
    int res;
    uint32_t tmp1;
    int i;
@@ -575,24 +822,11 @@ int lgExecCmd(lgCmd_p cmdP, int cmdBufSize)
    uint32_t *argI=(uint32_t*)&cmdP[1];
    uint64_t *argQ=(uint64_t*)&cmdP[1];
 
-   pthread_once(&xInited, xInit);
-
    Ctx = lgCtxGet();
 
    if (Ctx == NULL) return LG_NO_MEMORY;
 
-   if (Ctx->owner == 0)
-   {
-      Ctx->owner = ++xPid;
-
-      /* set default user if no preset user */
-      if (!strlen(Ctx->user))
-         strncpy(Ctx->user, LG_DEFAULT_USER, LG_USER_LEN);
-
-      /* set permissions for user */
-      Ctx->approved = 1;
-      xSetUserPermits(Ctx);
-   }
+   lgExecCtxInit(Ctx);
 
    size = cmdP->size;
 
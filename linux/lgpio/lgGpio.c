@@ -46,6 +46,7 @@ For more information, please refer to <http://unlicense.org/>
 #include "lgHdl.h"
 #include "lgPthAlerts.h"
 #include "lgPthTx.h"
+#include "lgGpioSim.h"
 
 #define LG_CHIP_MODE_UNKNOWN  0
 
@@ -59,6 +60,29 @@ void xWrite(lgChipObj_p chip, int gpio, int value);
 callbk_t lgGpioSamplesFunc = NULL;
 void *lgGpioSamplesUserdata = NULL;
 
+/* chips and lines are the simulator's while it is running */
+
+static int xOpen(const char *chipName)
+{
+   if (lgGpioSimActive()) return lgSimOpen(chipName);
+
+   return open(chipName, O_RDWR | O_CLOEXEC);
+}
+
+static int xIoctl(int fd, unsigned long request, void *arg)
+{
+   if (lgSimOwns(fd)) return lgSimIoctl(fd, request, arg);
+
+   return ioctl(fd, request, arg);
+}
+
+static int xClose(int fd)
+{
+   if (lgSimOwns(fd)) return lgSimClose(fd);
+
+   return close(fd);
+}
+
 static inline void xSetBit(uint64_t *b, int n)
 {
    *b |= ((uint64_t)1 << n);
@@ -120,7 +144,7 @@ static void _lgGpiochipClose(void *objPtr)
             if (chip->LineInf[i].fd != -1)
             {
                LG_DBG(LG_DEBUG_ALLOC, "close fd: %d", chip->LineInf[i].fd);
-               close(chip->LineInf[i].fd);
+               xClose(chip->LineInf[i].fd);
                chip->LineInf[i].fd = -1;
             }
 
@@ -150,7 +174,7 @@ static void _lgGpiochipClose(void *objPtr)
 
    LG_DBG(LG_DEBUG_ALLOC, "close chip fd: %d", chip->fd);
 
-   close(chip->fd);
+   xClose(chip->fd);
 }
 
 static int xGpioHandleRequest(
@@ -167,7 +191,7 @@ static int xGpioHandleRequest(
       req->num_lines, req->config.flags, lgDbgInt2Str(req->num_lines,
       (int *)req->offsets));
 
-   status = ioctl(chip->fd, GPIO_V2_GET_LINE_IOCTL, req);
+   status = xIoctl(chip->fd, GPIO_V2_GET_LINE_IOCTL, req);
 
    if (status == 0)
    {
@@ -179,7 +203,7 @@ static int xGpioHandleRequest(
       {
          free(offsets_p); // passing NULL is legal
          free(values_p); // passing NULL is legal
-         close(req->fd);
+         xClose(req->fd);
          return LG_NOT_ENOUGH_MEMORY;
       }
 
@@ -368,7 +392,7 @@ static int xSetAsFree(lgChipObj_p chip, int gpio)
          if ((pEvt = lgGpioGetAlertRec(chip, gpio)) == NULL) break;
       }
 
-      close(GPIO->fd);
+      xClose(GPIO->fd);
 
       GPIO->mode = LG_CHIP_MODE_UNKNOWN;
 
@@ -390,13 +414,13 @@ static int xSetAsFree(lgChipObj_p chip, int gpio)
 
          if ((pTx = lgGpioGetTxRec(chip, g, LG_TX_PWM)) != NULL)
          {
-            pTx->active = 0;
+            lgPthTxCancel(pTx);
             LG_DBG(LG_DEBUG_ALLOC, "set PWM inactive: %d", gpio);
          }
 
          if ((pTx = lgGpioGetTxRec(chip, g, LG_TX_WAVE)) != NULL)
          {
-            pTx->active = 0;
+            lgPthTxCancel(pTx);
             LG_DBG(LG_DEBUG_ALLOC, "set PWM inactive: %d", gpio);
          }
 
@@ -409,7 +433,7 @@ static int xSetAsFree(lgChipObj_p chip, int gpio)
 
       LG_DBG(LG_DEBUG_ALLOC, "close fd: %d", GPIO->fd);
 
-      close(GPIO->fd);
+      xClose(GPIO->fd);
 
       LG_DBG(LG_DEBUG_ALLOC, "free offsets: *%p, values: *%p",
          (void*)GPIO->offsets_p, (void*)GPIO->values_p);
@@ -512,6 +536,7 @@ static int xSetAsPwm(
 {
    lgLineInf_p GPIO;
    lgTxRec_p p;
+   int slot;
    int zero = 0;
    int status = 0;
 
@@ -554,17 +579,19 @@ static int xSetAsPwm(
          {
             /* delete prior pending entry if it has infinite cycles */
 
-            if ((p->entries > 1) && (p->cycles[p->entries-1] == -1))
+            if ((p->entries > 1) &&
+                (p->cycles[LG_TX_SLOT(p, p->entries-1)] == -1))
             {
                --p->entries;
             }
 
             if (p->entries < LG_TX_BUF)
             {
-               p->micros_on[p->entries] = micros_on;
-               p->micros_off[p->entries] = micros_off;
-               if (cycles) p->cycles[p->entries] = cycles;
-               else p->cycles[p->entries] = -1;
+               slot = LG_TX_SLOT(p, p->entries);
+               p->micros_on[slot] = micros_on;
+               p->micros_off[slot] = micros_off;
+               if (cycles) p->cycles[slot] = cycles;
+               else p->cycles[slot] = -1;
                p->entries++;
                status = LG_TX_BUF - p->entries;
             }
@@ -574,7 +601,7 @@ static int xSetAsPwm(
       }
       else
       {
-         p->active = 0;
+         lgPthTxCancel(p);
       }
 
       lgPthTxUnlock();
@@ -637,8 +664,8 @@ static int xWave(
    {
       if (p->entries < LG_TX_BUF)
       {
-         p->pulses[p->entries] = pulsesTmp;
-         p->num_pulses[p->entries] = count;
+         p->pulses[LG_TX_SLOT(p, p->entries)] = pulsesTmp;
+         p->num_pulses[LG_TX_SLOT(p, p->entries)] = count;
          p->entries++;
          status = LG_TX_BUF - p->entries;
       }
@@ -677,7 +704,7 @@ void xWrite(lgChipObj_p chip, int gpio, int value)
    lv.mask = m;
    lv.bits = *GPIO->values_p;
 
-   ioctl(GPIO->fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &lv);
+   xIoctl(GPIO->fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &lv);
 }
 
 void xGroupWrite(
@@ -700,7 +727,7 @@ void xGroupWrite(
    lv.mask = groupMask;
    lv.bits = *GPIO->values_p;
 
-   ioctl(GPIO->fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &lv);
+   xIoctl(GPIO->fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &lv);
 }
 
 // public API
@@ -723,14 +750,14 @@ int lgGpiochipOpen(int gpioDev)
 
    sprintf(chipName, "/dev/gpiochip%d", gpioDev);
 
-   fd = open(chipName, O_RDWR | O_CLOEXEC);
+   fd = xOpen(chipName);
 
    if (fd < 0)
       PARAM_ERROR(LG_CANNOT_OPEN_CHIP, "can't open gpiochip (%s)", chipName);
 
-   if (ioctl(fd, GPIO_GET_CHIPINFO_IOCTL, &info))
+   if (xIoctl(fd, GPIO_GET_CHIPINFO_IOCTL, &info))
    {
-      close(fd);
+      xClose(fd);
       PARAM_ERROR(LG_NOT_A_GPIOCHIP, "ioct failed (%s)", chipName);
    }
 
@@ -739,7 +766,7 @@ int lgGpiochipOpen(int gpioDev)
 
    if (handle < 0)
    {
-      close(fd);
+      xClose(fd);
       return LG_NOT_ENOUGH_MEMORY;
    }
 
@@ -837,7 +864,7 @@ int lgGpioGetChipInfo(int handle, lgChipInfo_p chipInfo)
 
    if (status == LG_OKAY)
    {
-      status = ioctl(chip->fd, GPIO_GET_CHIPINFO_IOCTL, &cinfo);
+      status = xIoctl(chip->fd, GPIO_GET_CHIPINFO_IOCTL, &cinfo);
 
       if (status == 0)
       {
@@ -872,7 +899,7 @@ int lgGpioGetLineInfo(int handle, int gpio, lgLineInfo_p lineInfo)
       {
          linfo.offset = gpio;
 
-         status = ioctl(chip->fd, GPIO_V2_GET_LINEINFO_IOCTL, &linfo);
+         status = xIoctl(chip->fd, GPIO_V2_GET_LINEINFO_IOCTL, &linfo);
 
          if (status == 0)
          {
@@ -910,7 +937,7 @@ int lgGpioGetMode(int handle, int gpio)
       {
          linfo.offset = gpio;
 
-         status = ioctl(chip->fd, GPIO_V2_GET_LINEINFO_IOCTL, &linfo);
+         status = xIoctl(chip->fd, GPIO_V2_GET_LINEINFO_IOCTL, &linfo);
 
          if (status == 0)
          {
@@ -1114,7 +1141,7 @@ int lgGpioClaimAlert(
 
             LG_DBG(LG_DEBUG_TRACE, "flags %"PRIu64, flags);
 
-            status = ioctl(chip->fd, GPIO_V2_GET_LINE_IOCTL, &req);
+            status = xIoctl(chip->fd, GPIO_V2_GET_LINE_IOCTL, &req);
 
             if (status == 0)
             {
@@ -1122,7 +1149,7 @@ int lgGpioClaimAlert(
 
                if (offsets_p == NULL)
                {
-                  close(req.fd);
+                  xClose(req.fd);
                   return LG_NOT_ENOUGH_MEMORY;
                }
 
@@ -1135,7 +1162,7 @@ int lgGpioClaimAlert(
                   free(offsets_p);
                   chip->LineInf[gpio].offsets_p = NULL;
                   chip->LineInf[gpio].values_p = NULL;
-                  close(req.fd);
+                  xClose(req.fd);
                   return LG_NOT_ENOUGH_MEMORY;
                }
 
@@ -1382,7 +1409,7 @@ int lgGpioRead(int handle, int gpio)
 
             lv.mask = m;
 
-            status = ioctl(GPIO->fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &lv);
+            status = xIoctl(GPIO->fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &lv);
 
             if (status == 0)
                status = xTestBit(lv.bits, GPIO->offset);
@@ -1425,7 +1452,7 @@ int lgGpioWrite(int handle, int gpio, int value)
             lv.mask = m;
             lv.bits = *GPIO->values_p;
 
-            status = ioctl(
+            status = xIoctl(
                GPIO->fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &lv);
 
             if (status)
@@ -1478,7 +1505,7 @@ int lgGroupRead(
             if (GPIO->mode != LG_CHIP_MODE_UNKNOWN)
             {
                lv.mask = -1;
-               status = ioctl(GPIO->fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &lv);
+               status = xIoctl(GPIO->fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &lv);
 
                if (status == 0)
                {
@@ -1535,7 +1562,7 @@ int lgGroupWrite(
                lv.mask = groupMask;
                lv.bits = groupBits;
 
-               status = ioctl(GPIO->fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &lv);
+               status = xIoctl(GPIO->fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &lv);
 
                if (status == 0)
                {
@@ -0,0 +1,994 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <linux/gpio.h>
+
+#include "lgpio.h"
+
+#include "lgDbg.h"
+#include "lgGpioSim.h"
+
+#define SIM_FD_CHIP 1
+#define SIM_FD_REQUEST 2
+
+#define SIM_EVENT_SIZE (sizeof(struct gpio_v2_line_event))
+
+typedef struct
+{
+   int level;   /* on the pin */
+   int input;   /* driven from outside, the level when not an output */
+   int request; /* fd of the request holding the line, -1 if none */
+   int index;   /* position in that request */
+   uint64_t flags;
+   uint32_t line_seqno;
+   char consumer[GPIO_MAX_NAME_SIZE];
+} simLine_t, *simLine_p;
+
+typedef struct
+{
+   int type;
+   int chip;
+   int peer; /* requests: our end of the event socket */
+   uint32_t num_lines;
+   uint32_t offsets[GPIO_V2_LINES_MAX];
+   uint32_t capacity; /* events queued before the oldest are dropped */
+   uint32_t seqno;
+} simFd_t, *simFd_p;
+
+typedef struct
+{
+   int active;
+   int chip;
+   int count;
+   lgSimStep_p steps;
+   int repeats; /* 0 forever */
+   int repeat;
+   int pos;
+   uint64_t due; /* of steps[pos] */
+} simScript_t, *simScript_p;
+
+static pthread_mutex_t simMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t simCond;
+static pthread_t simThread;
+
+static int simActive = 0;
+static int simRunning = 0;
+static int simEnvChecked = 0;
+
+static simLine_t simLines[LG_SIM_CHIPS][LG_SIM_LINES];
+static simFd_p simFds[LG_SIM_MAX_FDS];
+static simScript_t simScripts[LG_SIM_MAX_SCRIPTS];
+
+static lgSimWrite_p simWrites = NULL;
+static int simWriteHead = 0;
+static int simWriteCount = 0;
+
+static lgSimStats_t simStats;
+
+static uint64_t xSimNow(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+
+   return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+/* call with simMutex held */
+
+static simFd_p xGetFd(int fd, int type)
+{
+   if ((fd < 0) || (fd >= LG_SIM_MAX_FDS)) return NULL;
+
+   if ((simFds[fd] == NULL) || (simFds[fd]->type != type)) return NULL;
+
+   return simFds[fd];
+}
+
+static int xLogical(simLine_p line)
+{
+   return line->level ^ ((line->flags & GPIO_V2_LINE_FLAG_ACTIVE_LOW) != 0);
+}
+
+/*
+Queue an edge on the line's request.  As the kernel does, a full
+request loses its oldest event, and sequence numbers count every
+event so a reader can see the gap.
+*/
+
+static void xQueueEvent(simLine_p line, int gpio, uint64_t timestamp)
+{
+   simFd_p req;
+   struct gpio_v2_line_event ev;
+   char discard[SIM_EVENT_SIZE];
+   int queued;
+
+   req = simFds[line->request];
+
+   memset(&ev, 0, sizeof(ev));
+
+   ev.timestamp_ns = timestamp;
+   ev.id = xLogical(line) ?
+      GPIO_V2_LINE_EVENT_RISING_EDGE : GPIO_V2_LINE_EVENT_FALLING_EDGE;
+   ev.offset = gpio;
+   ev.seqno = ++req->seqno;
+   ev.line_seqno = ++line->line_seqno;
+
+   if ((ioctl(line->request, FIONREAD, &queued) == 0) &&
+       (queued >= (int)(req->capacity * SIM_EVENT_SIZE)))
+   {
+      /* the reader's end, without waiting, as the kernel's kfifo_skip */
+
+      if (recv(line->request, discard, sizeof(discard), MSG_DONTWAIT) > 0)
+         simStats.eventsDropped++;
+   }
+
+   if (send(req->peer, &ev, sizeof(ev), MSG_DONTWAIT) == sizeof(ev))
+      simStats.events++;
+   else
+      simStats.eventsDropped++;
+}
+
+/* an input changing at timestamp */
+
+static void xDrive(int chip, int gpio, int level, uint64_t timestamp)
+{
+   simLine_p line;
+
+   line = &simLines[chip][gpio];
+
+   line->input = level;
+
+   /* an output holds the pin */
+
+   if (line->flags & GPIO_V2_LINE_FLAG_OUTPUT) return;
+
+   if (line->level == level) return;
+
+   line->level = level;
+
+   simStats.edges++;
+
+   if (line->request < 0) return;
+
+   if (xLogical(line))
+   {
+      if (line->flags & GPIO_V2_LINE_FLAG_EDGE_RISING)
+         xQueueEvent(line, gpio, timestamp);
+   }
+   else
+   {
+      if (line->flags & GPIO_V2_LINE_FLAG_EDGE_FALLING)
+         xQueueEvent(line, gpio, timestamp);
+   }
+}
+
+static void xRecordWrite(int chip, int gpio, int level, uint64_t timestamp)
+{
+   lgSimWrite_p w;
+
+   if (simWriteCount >= LG_SIM_WRITE_BUF)
+   {
+      simStats.writesLost++;
+      return;
+   }
+
+   w = &simWrites[(simWriteHead + simWriteCount) & (LG_SIM_WRITE_BUF-1)];
+
+   w->timestamp = timestamp;
+   w->chip = chip;
+   w->gpio = gpio;
+   w->level = level;
+
+   simWriteCount++;
+   simStats.writes++;
+}
+
+/* the values attribute (if any) for request index i, else -1 */
+
+static int xOutputValue(struct gpio_v2_line_config *config, int i)
+{
+   int a;
+   struct gpio_v2_line_config_attribute *ca;
+
+   for (a=0; (a<(int)config->num_attrs) && (a<GPIO_V2_LINE_NUM_ATTRS_MAX); a++)
+   {
+      ca = &config->attrs[a];
+
+      if ((ca->attr.id == GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES) &&
+          (ca->mask & ((uint64_t)1<<i)))
+      {
+         return (ca->attr.values >> i) & 1;
+      }
+   }
+
+   return -1;
+}
+
+static int xCheckFlags(uint64_t flags)
+{
+   uint64_t edges;
+
+   edges = GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING;
+
+   if ((flags & GPIO_V2_LINE_FLAG_INPUT) && (flags & GPIO_V2_LINE_FLAG_OUTPUT))
+      return 0;
+
+   if ((flags & edges) && !(flags & GPIO_V2_LINE_FLAG_INPUT)) return 0;
+
+   return 1;
+}
+
+/* set a line to flags (and an output to value), at timestamp */
+
+static void xConfigure(
+   int chip, int gpio, uint64_t flags, int value, uint64_t timestamp)
+{
+   simLine_p line;
+   int level;
+
+   line = &simLines[chip][gpio];
+
+   line->flags = flags;
+
+   if (flags & GPIO_V2_LINE_FLAG_OUTPUT)
+   {
+      if (value < 0) value = xLogical(line);
+
+      level = value ^ ((flags & GPIO_V2_LINE_FLAG_ACTIVE_LOW) != 0);
+
+      line->level = level;
+
+      xRecordWrite(chip, gpio, level, timestamp);
+   }
+   else line->level = line->input;
+}
+
+static void xRelease(int chip, int gpio)
+{
+   simLine_p line;
+
+   line = &simLines[chip][gpio];
+
+   line->request = -1;
+   line->flags = 0;
+   line->level = line->input;
+   line->consumer[0] = 0;
+}
+
+static int xChipInfo(simFd_p chip, struct gpiochip_info *info)
+{
+   memset(info, 0, sizeof(*info));
+
+   snprintf(info->name, sizeof(info->name), "gpiochip%d", chip->chip);
+   snprintf(info->label, sizeof(info->label), "lg-sim");
+   info->lines = LG_SIM_LINES;
+
+   return 0;
+}
+
+static int xLineInfo(simFd_p chip, struct gpio_v2_line_info *info)
+{
+   simLine_p line;
+   uint32_t offset;
+
+   offset = info->offset;
+
+   if (offset >= LG_SIM_LINES)
+   {
+      errno = EINVAL;
+      return -1;
+   }
+
+   line = &simLines[chip->chip][offset];
+
+   memset(info, 0, sizeof(*info));
+
+   snprintf(info->name, sizeof(info->name), "SIM%d_%u", chip->chip, offset);
+   info->offset = offset;
+
+   if (line->request >= 0)
+   {
+      snprintf(info->consumer, sizeof(info->consumer), "%s", line->consumer);
+      info->flags = line->flags | GPIO_V2_LINE_FLAG_USED;
+   }
+   else info->flags = GPIO_V2_LINE_FLAG_INPUT;
+
+   return 0;
+}
+
+static int xLineRequest(simFd_p chip, struct gpio_v2_line_request *req)
+{
+   simFd_p r;
+   uint32_t i, j, gpio;
+   int sv[2];
+   uint64_t now;
+
+   if ((req->num_lines == 0) || (req->num_lines > GPIO_V2_LINES_MAX) ||
+       !xCheckFlags(req->config.flags))
+   {
+      errno = EINVAL;
+      return -1;
+   }
+
+   for (i=0; i<req->num_lines; i++)
+   {
+      gpio = req->offsets[i];
+
+      if (gpio >= LG_SIM_LINES)
+      {
+         errno = EINVAL;
+         return -1;
+      }
+
+      for (j=0; j<i; j++)
+      {
+         if (req->offsets[j] == gpio)
+         {
+            errno = EINVAL;
+            return -1;
+         }
+      }
+
+      if (simLines[chip->chip][gpio].request >= 0)
+      {
+         errno = EBUSY;
+         return -1;
+      }
+   }
+
+   if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv)) return -1;
+
+   if (sv[0] >= LG_SIM_MAX_FDS) r = NULL;
+   else r = calloc(1, sizeof(simFd_t));
+
+   if (r == NULL)
+   {
+      close(sv[0]);
+      close(sv[1]);
+      errno = ENOMEM;
+      return -1;
+   }
+
+   r->type = SIM_FD_REQUEST;
+   r->chip = chip->chip;
+   r->peer = sv[1];
+   r->num_lines = req->num_lines;
+   memcpy(r->offsets, req->offsets, req->num_lines * sizeof(uint32_t));
+
+   if (req->event_buffer_size) r->capacity = req->event_buffer_size;
+   else r->capacity = 16 * req->num_lines;
+
+   simFds[sv[0]] = r;
+
+   now = xSimNow();
+
+   for (i=0; i<req->num_lines; i++)
+   {
+      gpio = req->offsets[i];
+
+      simLines[chip->chip][gpio].request = sv[0];
+      simLines[chip->chip][gpio].index = i;
+      /* the request's consumer need not be terminated */
+      snprintf(simLines[chip->chip][gpio].consumer, GPIO_MAX_NAME_SIZE,
+         "%.*s", GPIO_MAX_NAME_SIZE-1, req->consumer);
+
+      xConfigure(chip->chip, gpio, req->config.flags,
+         xOutputValue(&req->config, i), now);
+   }
+
+   req->fd = sv[0];
+
+   return 0;
+}
+
+static int xGetValues(simFd_p r, struct gpio_v2_line_values *lv)
+{
+   uint32_t i;
+   uint64_t bits = 0;
+
+   for (i=0; i<r->num_lines; i++)
+   {
+      if ((lv->mask & ((uint64_t)1<<i)) &&
+          xLogical(&simLines[r->chip][r->offsets[i]]))
+      {
+         bits |= (uint64_t)1<<i;
+      }
+   }
+
+   lv->bits = bits;
+
+   return 0;
+}
+
+static int xSetValues(simFd_p r, struct gpio_v2_line_values *lv)
+{
+   uint32_t i;
+   simLine_p line;
+   uint64_t now;
+   int level;
+
+   now = xSimNow();
+
+   for (i=0; i<r->num_lines; i++)
+   {
+      if (!(lv->mask & ((uint64_t)1<<i))) continue;
+
+      line = &simLines[r->chip][r->offsets[i]];
+
+      if (!(line->flags & GPIO_V2_LINE_FLAG_OUTPUT))
+      {
+         errno = EPERM;
+         return -1;
+      }
+   }
+
+   for (i=0; i<r->num_lines; i++)
+   {
+      if (!(lv->mask & ((uint64_t)1<<i))) continue;
+
+      line = &simLines[r->chip][r->offsets[i]];
+
+      level = ((lv->bits >> i) & 1) ^
+         ((line->flags & GPIO_V2_LINE_FLAG_ACTIVE_LOW) != 0);
+
+      line->level = level;
+
+      xRecordWrite(r->chip, r->offsets[i], level, now);
+   }
+
+   return 0;
+}
+
+static int xSetConfig(simFd_p r, struct gpio_v2_line_config *config)
+{
+   uint32_t i;
+   uint64_t now;
+
+   if (!xCheckFlags(config->flags))
+   {
+      errno = EINVAL;
+      return -1;
+   }
+
+   now = xSimNow();
+
+   for (i=0; i<r->num_lines; i++)
+   {
+      xConfigure(r->chip, r->offsets[i], config->flags,
+         xOutputValue(config, i), now);
+   }
+
+   return 0;
+}
+
+/* plays the scripts, sleeping until the next step is due */
+
+static void *xSimPlayer(void *arg)
+{
+   int i;
+   uint64_t now, next, late;
+   simScript_p s;
+   lgSimStep_p step;
+   struct timespec ts;
+
+   pthread_mutex_lock(&simMutex);
+
+   while (simRunning)
+   {
+      now = xSimNow();
+      next = UINT64_MAX;
+
+      for (i=0; i<LG_SIM_MAX_SCRIPTS; i++)
+      {
+         s = &simScripts[i];
+
+         while (s->active && (s->due <= now))
+         {
+            step = &s->steps[s->pos];
+
+            late = now - s->due;
+            if (late > simStats.scriptLateMax) simStats.scriptLateMax = late;
+
+            /* stamped when due, as the kernel would stamp the edge */
+            xDrive(s->chip, step->gpio, step->level, s->due);
+
+            if (++s->pos == s->count)
+            {
+               s->pos = 0;
+
+               if (s->repeats && (++s->repeat >= s->repeats))
+               {
+                  s->active = 0;
+                  free(s->steps);
+                  s->steps = NULL;
+                  break;
+               }
+            }
+
+            s->due += s->steps[s->pos].delay_ns;
+         }
+
+         if (s->active && (s->due < next)) next = s->due;
+      }
+
+      if (next == UINT64_MAX)
+      {
+         pthread_cond_wait(&simCond, &simMutex);
+      }
+      else
+      {
+         ts.tv_sec = next / 1000000000;
+         ts.tv_nsec = next % 1000000000;
+         pthread_cond_timedwait(&simCond, &simMutex, &ts);
+      }
+   }
+
+   pthread_mutex_unlock(&simMutex);
+
+   return NULL;
+}
+
+static void xCloseFd(int fd)
+{
+   simFd_p f;
+   uint32_t i;
+
+   f = simFds[fd];
+
+   if (f->type == SIM_FD_REQUEST)
+   {
+      for (i=0; i<f->num_lines; i++) xRelease(f->chip, f->offsets[i]);
+
+      close(f->peer);
+   }
+
+   free(f);
+   simFds[fd] = NULL;
+}
+
+// public API
+
+int lgGpioSimStart(void)
+{
+   int i, g;
+   pthread_condattr_t attr;
+
+   LG_DBG(LG_DEBUG_TRACE, "");
+
+   pthread_mutex_lock(&simMutex);
+
+   if (simActive)
+   {
+      pthread_mutex_unlock(&simMutex);
+      return LG_OKAY;
+   }
+
+   simWrites = calloc(LG_SIM_WRITE_BUF, sizeof(lgSimWrite_t));
+
+   if (simWrites == NULL)
+   {
+      pthread_mutex_unlock(&simMutex);
+      ALLOC_ERROR(LG_NOT_ENOUGH_MEMORY, "can't allocate write buffer");
+   }
+
+   simWriteHead = 0;
+   simWriteCount = 0;
+
+   memset(&simStats, 0, sizeof(simStats));
+   memset(simScripts, 0, sizeof(simScripts));
+
+   /* every line starts as a pulled up input */
+
+   for (i=0; i<LG_SIM_CHIPS; i++)
+   {
+      for (g=0; g<LG_SIM_LINES; g++)
+      {
+         memset(&simLines[i][g], 0, sizeof(simLine_t));
+         simLines[i][g].input = 1;
+         simLines[i][g].level = 1;
+         simLines[i][g].request = -1;
+      }
+   }
+
+   pthread_condattr_init(&attr);
+   pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+   pthread_cond_init(&simCond, &attr);
+   pthread_condattr_destroy(&attr);
+
+   simRunning = 1;
+
+   if (pthread_create(&simThread, NULL, xSimPlayer, NULL))
+   {
+      simRunning = 0;
+      free(simWrites);
+      simWrites = NULL;
+      pthread_mutex_unlock(&simMutex);
+      PARAM_ERROR(LG_INIT_FAILED, "can't start script thread");
+   }
+
+   simActive = 1;
+
+   pthread_mutex_unlock(&simMutex);
+
+   return LG_OKAY;
+}
+
+void lgGpioSimStop(void)
+{
+   int i;
+
+   LG_DBG(LG_DEBUG_TRACE, "");
+
+   pthread_mutex_lock(&simMutex);
+
+   if (!simActive)
+   {
+      pthread_mutex_unlock(&simMutex);
+      return;
+   }
+
+   simRunning = 0;
+   pthread_cond_signal(&simCond);
+   pthread_mutex_unlock(&simMutex);
+
+   pthread_join(simThread, NULL);
+
+   pthread_mutex_lock(&simMutex);
+
+   /* anything still open is closed */
+
+   for (i=0; i<LG_SIM_MAX_FDS; i++)
+   {
+      if (simFds[i] != NULL)
+      {
+         xCloseFd(i);
+         close(i);
+      }
+   }
+
+   for (i=0; i<LG_SIM_MAX_SCRIPTS; i++)
+   {
+      free(simScripts[i].steps);
+      simScripts[i].steps = NULL;
+      simScripts[i].active = 0;
+   }
+
+   free(simWrites);
+   simWrites = NULL;
+
+   pthread_cond_destroy(&simCond);
+
+   simActive = 0;
+
+   pthread_mutex_unlock(&simMutex);
+}
+
+int lgGpioSimActive(void)
+{
+   /* once, so the environment can select the simulator */
+
+   if (!simEnvChecked)
+   {
+      simEnvChecked = 1;
+
+      if (!simActive && (getenv(LG_ENVSIM) != NULL)) lgGpioSimStart();
+   }
+
+   return simActive;
+}
+
+int lgSimOwns(int fd)
+{
+   return (fd >= 0) && (fd < LG_SIM_MAX_FDS) && (simFds[fd] != NULL);
+}
+
+int lgSimOpen(const char *path)
+{
+   int chip, fd;
+   char tail;
+   simFd_p f;
+
+   if ((sscanf(path, "/dev/gpiochip%d%c", &chip, &tail) != 1) ||
+       (chip < 0) || (chip >= LG_SIM_CHIPS))
+   {
+      errno = ENOENT;
+      return -1;
+   }
+
+   fd = eventfd(0, EFD_CLOEXEC);
+
+   if (fd < 0) return -1;
+
+   if (fd >= LG_SIM_MAX_FDS) f = NULL;
+   else f = calloc(1, sizeof(simFd_t));
+
+   if (f == NULL)
+   {
+      close(fd);
+      errno = EMFILE;
+      return -1;
+   }
+
+   f->type = SIM_FD_CHIP;
+   f->chip = chip;
+
+   pthread_mutex_lock(&simMutex);
+   simFds[fd] = f;
+   pthread_mutex_unlock(&simMutex);
+
+   return fd;
+}
+
+int lgSimIoctl(int fd, unsigned long request, void *arg)
+{
+   simFd_p f;
+   int status;
+
+   pthread_mutex_lock(&simMutex);
+
+   switch (request)
+   {
+      case GPIO_GET_CHIPINFO_IOCTL:
+      case GPIO_V2_GET_LINEINFO_IOCTL:
+      case GPIO_V2_GET_LINE_IOCTL:
+         f = xGetFd(fd, SIM_FD_CHIP);
+         break;
+
+      default:
+         f = xGetFd(fd, SIM_FD_REQUEST);
+         break;
+   }
+
+   if (f == NULL)
+   {
+      pthread_mutex_unlock(&simMutex);
+      errno = EBADF;
+      return -1;
+   }
+
+   switch (request)
+   {
+      case GPIO_GET_CHIPINFO_IOCTL:
+         status = xChipInfo(f, arg);
+         break;
+
+      case GPIO_V2_GET_LINEINFO_IOCTL:
+         status = xLineInfo(f, arg);
+         break;
+
+      case GPIO_V2_GET_LINE_IOCTL:
+         status = xLineRequest(f, arg);
+         break;
+
+      case GPIO_V2_LINE_GET_VALUES_IOCTL:
+         status = xGetValues(f, arg);
+         break;
+
+      case GPIO_V2_LINE_SET_VALUES_IOCTL:
+         status = xSetValues(f, arg);
+         break;
+
+      case GPIO_V2_LINE_SET_CONFIG_IOCTL:
+         status = xSetConfig(f, arg);
+         break;
+
+      default:
+         errno = ENOTTY;
+         status = -1;
+         break;
+   }
+
+   pthread_mutex_unlock(&simMutex);
+
+   return status;
+}
+
+int lgSimClose(int fd)
+{
+   pthread_mutex_lock(&simMutex);
+
+   if (lgSimOwns(fd)) xCloseFd(fd);
+
+   pthread_mutex_unlock(&simMutex);
+
+   return close(fd);
+}
+
+int lgGpioSimSetInput(int gpioDev, int gpio, int level)
+{
+   LG_DBG(LG_DEBUG_TRACE, "gpioDev=%d gpio=%d level=%d", gpioDev, gpio, level);
+
+   if ((gpioDev < 0) || (gpioDev >= LG_SIM_CHIPS))
+      PARAM_ERROR(LG_BAD_GPIOCHIP, "bad gpioDev (%d)", gpioDev);
+
+   if ((gpio < 0) || (gpio >= LG_SIM_LINES))
+      PARAM_ERROR(LG_BAD_GPIO_NUMBER, "bad gpio (%d)", gpio);
+
+   pthread_mutex_lock(&simMutex);
+   xDrive(gpioDev, gpio, level != 0, xSimNow());
+   pthread_mutex_unlock(&simMutex);
+
+   return LG_OKAY;
+}
+
+int lgGpioSimScript(
+   int gpioDev, int count, const lgSimStep_t *steps, int repeats)
+{
+   int i, script;
+   uint64_t total = 0;
+   lgSimStep_p copy;
+
+   LG_DBG(LG_DEBUG_TRACE, "gpioDev=%d count=%d steps=*%p repeats=%d",
+      gpioDev, count, (void*)steps, repeats);
+
+   if ((gpioDev < 0) || (gpioDev >= LG_SIM_CHIPS))
+      PARAM_ERROR(LG_BAD_GPIOCHIP, "bad gpioDev (%d)", gpioDev);
+
+   if ((steps == NULL) || (count <= 0) || (repeats < 0))
+      PARAM_ERROR(LG_BAD_SCRIPT, "bad script (%d steps)", count);
+
+   for (i=0; i<count; i++)
+   {
+      if ((steps[i].gpio < 0) || (steps[i].gpio >= LG_SIM_LINES))
+         PARAM_ERROR(LG_BAD_GPIO_NUMBER, "bad gpio (%d)", steps[i].gpio);
+
+      total += steps[i].delay_ns;
+   }
+
+   /* forever needs time to pass */
+
+   if (!repeats && !total)
+      PARAM_ERROR(LG_BAD_SCRIPT, "script repeats forever in no time");
+
+   copy = malloc(count * sizeof(lgSimStep_t));
+
+   if (copy == NULL)
+      ALLOC_ERROR(LG_NOT_ENOUGH_MEMORY, "can't allocate script");
+
+   memcpy(copy, steps, count * sizeof(lgSimStep_t));
+
+   pthread_mutex_lock(&simMutex);
+
+   for (script=0; script<LG_SIM_MAX_SCRIPTS; script++)
+   {
+      if (!simScripts[script].active) break;
+   }
+
+   if (script == LG_SIM_MAX_SCRIPTS)
+   {
+      pthread_mutex_unlock(&simMutex);
+      free(copy);
+      PARAM_ERROR(LG_NO_HANDLE, "too many scripts");
+   }
+
+   free(simScripts[script].steps);
+
+   simScripts[script].chip = gpioDev;
+   simScripts[script].count = count;
+   simScripts[script].steps = copy;
+   simScripts[script].repeats = repeats;
+   simScripts[script].repeat = 0;
+   simScripts[script].pos = 0;
+   simScripts[script].due = xSimNow() + copy[0].delay_ns;
+   simScripts[script].active = 1;
+
+   pthread_cond_signal(&simCond);
+
+   pthread_mutex_unlock(&simMutex);
+
+   return script;
+}
+
+int lgGpioSimScriptBusy(int script)
+{
+   int busy;
+
+   if ((script < 0) || (script >= LG_SIM_MAX_SCRIPTS))
+      PARAM_ERROR(LG_BAD_HANDLE, "bad script (%d)", script);
+
+   pthread_mutex_lock(&simMutex);
+   busy = simScripts[script].active;
+   pthread_mutex_unlock(&simMutex);
+
+   return busy;
+}
+
+int lgGpioSimScriptStop(int script)
+{
+   if ((script < 0) || (script >= LG_SIM_MAX_SCRIPTS))
+      PARAM_ERROR(LG_BAD_HANDLE, "bad script (%d)", script);
+
+   pthread_mutex_lock(&simMutex);
+   simScripts[script].active = 0;
+   pthread_mutex_unlock(&simMutex);
+
+   return LG_OKAY;
+}
+
+int lgGpioSimGetLevel(int gpioDev, int gpio)
+{
+   int level;
+
+   if ((gpioDev < 0) || (gpioDev >= LG_SIM_CHIPS))
+      PARAM_ERROR(LG_BAD_GPIOCHIP, "bad gpioDev (%d)", gpioDev);
+
+   if ((gpio < 0) || (gpio >= LG_SIM_LINES))
+      PARAM_ERROR(LG_BAD_GPIO_NUMBER, "bad gpio (%d)", gpio);
+
+   pthread_mutex_lock(&simMutex);
+   level = simLines[gpioDev][gpio].level;
+   pthread_mutex_unlock(&simMutex);
+
+   return level;
+}
+
+int lgGpioSimReadWrites(lgSimWrite_t *writes, int max)
+{
+   int i, count;
+
+   if (writes == NULL) PARAM_ERROR(LG_BAD_POINTER, "writes is NULL");
+
+   pthread_mutex_lock(&simMutex);
+
+   count = (max < simWriteCount) ? max : simWriteCount;
+
+   for (i=0; i<count; i++)
+   {
+      writes[i] = simWrites[(simWriteHead + i) & (LG_SIM_WRITE_BUF-1)];
+   }
+
+   simWriteHead = (simWriteHead + count) & (LG_SIM_WRITE_BUF-1);
+   simWriteCount -= count;
+
+   pthread_mutex_unlock(&simMutex);
+
+   return count;
+}
+
+void lgGpioSimStats(lgSimStats_t *stats, int clear)
+{
+   pthread_mutex_lock(&simMutex);
+
+   if (stats != NULL) *stats = simStats;
+
+   if (clear) memset(&simStats, 0, sizeof(simStats));
+
+   pthread_mutex_unlock(&simMutex);
+}
@@ -0,0 +1,120 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+
+#ifndef LG_GPIO_SIM_H
+#define LG_GPIO_SIM_H
+
+#include <stdint.h>
+
+/*
+A simulation of the kernel's GPIO character device (the v2 uAPI) so
+that lgpio, and anything else speaking the uAPI, runs without GPIO
+hardware.
+
+While the simulator is started /dev/gpiochip0 to /dev/gpiochip<n-1>
+open as simulated chips.  Line requests get a real file descriptor
+which polls and reads as a line request would, each edge arriving as
+a struct gpio_v2_line_event with a CLOCK_MONOTONIC timestamp.  As in
+the kernel a request queues at most event_buffer_size events (16 per
+line by default), the oldest being dropped when it is full.
+
+Inputs are driven with lgGpioSimSetInput, now, or lgGpioSimScript,
+a waveform played on its own thread whose edges carry their scripted
+times however late the thread wakes.  Every write to an output is
+recorded with its time for lgGpioSimReadWrites.
+
+lgGpiochipOpen uses the simulator once lgGpioSimStart has been called,
+or if the LG_SIM environment variable is set when it first opens a
+chip.
+*/
+
+#define LG_ENVSIM "LG_SIM"
+
+#define LG_SIM_CHIPS          4 /* /dev/gpiochip0 .. 3 */
+#define LG_SIM_LINES         64 /* lines per chip */
+#define LG_SIM_MAX_FDS     1024 /* chip and request fds are below this */
+#define LG_SIM_MAX_SCRIPTS    8 /* scripts playing at once */
+#define LG_SIM_WRITE_BUF  65536 /* recorded writes, power of 2 */
+
+typedef struct lgSimStep_s
+{
+   uint64_t delay_ns; /* after the previous step (or the start) */
+   int gpio;
+   int level;
+} lgSimStep_t, *lgSimStep_p;
+
+typedef struct lgSimWrite_s
+{
+   uint64_t timestamp; /* CLOCK_MONOTONIC nanoseconds */
+   uint16_t chip;
+   uint16_t gpio;
+   uint16_t level;
+} lgSimWrite_t, *lgSimWrite_p;
+
+typedef struct lgSimStats_s
+{
+   uint64_t edges;         /* input level changes */
+   uint64_t events;        /* events queued to requests */
+   uint64_t eventsDropped; /* oldest events dropped by full requests */
+   uint64_t writes;        /* output writes recorded */
+   uint64_t writesLost;    /* writes not recorded, buffer full */
+   uint64_t scriptLateMax; /* worst lateness of a scripted edge, ns */
+} lgSimStats_t, *lgSimStats_p;
+
+int lgGpioSimStart(void);
+void lgGpioSimStop(void);
+int lgGpioSimActive(void);
+
+/* the uAPI; fd is a simulated chip or request unless lgSimOwns says not */
+
+int lgSimOwns(int fd);
+int lgSimOpen(const char *path);
+int lgSimIoctl(int fd, unsigned long request, void *arg);
+int lgSimClose(int fd);
+
+/* drive an input now, the edge being timestamped now */
+int lgGpioSimSetInput(int gpioDev, int gpio, int level);
+
+/*
+Play steps on the chip, starting now, repeats times (0 forever).
+Returns a script id for lgGpioSimScriptBusy and lgGpioSimScriptStop.
+*/
+int lgGpioSimScript(
+   int gpioDev, int count, const lgSimStep_t *steps, int repeats);
+int lgGpioSimScriptBusy(int script);
+int lgGpioSimScriptStop(int script);
+
+/* the level on a line, driven by an output or an input */
+int lgGpioSimGetLevel(int gpioDev, int gpio);
+
+/* take up to max of the recorded writes, oldest first */
+int lgGpioSimReadWrites(lgSimWrite_t *writes, int max);
+
+void lgGpioSimStats(lgSimStats_t *stats, int clear);
+
+#endif
@@ -76,19 +76,15 @@ static void _notifyClose(lgNotify_t *h)
 
 void lgNotifyCloseOrphans(int slot, int fd)
 {
-   static int *handles;
-   static int maxHandles = 20;
+   int handles[LG_HDL_SLOTS];
    int i, numHandles;
    lgNotify_t *h;
    int status;
 
    /* Check for and close any orphaned notifications. */
 
-   if (handles == NULL) handles = malloc(sizeof(int) * maxHandles);
-
-   numHandles = lgHdlGetHandlesForType(LG_HDL_TYPE_NOTIFY, handles, maxHandles);
-   
-   if (numHandles > maxHandles) numHandles = maxHandles;
+   numHandles = lgHdlGetHandlesForType(
+      LG_HDL_TYPE_NOTIFY, handles, LG_HDL_SLOTS);
 
    for (i=0; i<numHandles; i++)
    {
@@ -33,6 +33,7 @@ For more information, please refer to <http://unlicense.org/>
 #include <unistd.h>
 #include <string.h>
 #include <poll.h>
+#include <limits.h>
 
 #include "lgDbg.h"
 #include "lgHdl.h"
@@ -42,6 +43,14 @@ For more information, please refer to <http://unlicense.org/>
 #define LG_MAX_ALERTS 2000
 #define LG_GPIO_MAX_ALERTS_PER_READ 128
 
+/* each kernel event may produce a debounce, a watchdog, and an edge
+   report, plus one timeout pass per line */
+
+#define LG_ALERTS_PER_LINE_PASS ((3 * LG_GPIO_MAX_ALERTS_PER_READ) + 2)
+
+#define LG_MAX_POLL_LINES 64
+#define LG_MAX_MERGE_LINES 128
+
 pthread_t pthAlert;
 pthread_mutex_t lgAlertMutex = PTHREAD_MUTEX_INITIALIZER;
 volatile lgAlertRec_p alertRec = NULL;
@@ -49,7 +58,9 @@ pthread_mutex_t lgAlertCondMutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_cond_t lgAlertCond = PTHREAD_COND_INITIALIZER;
 int pthAlertRunning = LG_THREAD_NONE;
 
-lgGpioAlert_t aBuf[LG_MAX_ALERTS];
+lgGpioAlert_t aBuf[LG_MAX_ALERTS]; /* alerts due, in time order */
+
+static lgGpioAlert_t lBuf[LG_ALERTS_PER_LINE_PASS]; /* one line's new alerts */
 
 static void xWaitForSignal(pthread_cond_t *cond, pthread_mutex_t *mutex)
 {
@@ -65,14 +76,6 @@ void xSendUnwaitSignal(pthread_cond_t *cond, pthread_mutex_t *mutex)
    pthread_mutex_unlock(mutex);
 }
 
-int tscomp(const void *p1, const void *p2)
-{
-   const lgGpioAlert_t *e1 = p1;
-   const lgGpioAlert_t *e2 = p2;
-
-   return e1->report.timestamp - e2->report.timestamp;
-}
-
 uint64_t xMonotonicTimestamp(void)
 {
    struct timespec xts;
@@ -82,168 +85,279 @@ uint64_t xMonotonicTimestamp(void)
    return ((uint64_t)1E9 * xts.tv_sec) + xts.tv_nsec;
 }
 
-void emitNotifications(int count)
+/*
+Pending alerts are held per line in a ring ordered by timestamp.  Each
+line's events arrive from the kernel in time order so an append is
+almost always at the tail.  The rings are merged with a small heap
+into aBuf once their alerts are older than the reordering window.
+*/
+
+#define LG_RING_AT(p, i) ((p)->ring[((p)->ringHead + (i)) & (LG_ALERT_RING-1)])
+
+static void xRingPut(lgAlertRec_p p, lgGpioAlert_p a)
 {
-   static int maxHandles = 20;
-   static int *handles = NULL;
-   lgGpioReport_t report[LG_MAX_ALERTS];
-   int numHandles;
    int i;
-   int status;
-   lgNotify_t *h;
-   int emit;
-   int d;
-   int sent;
-   int max_emits;
-   int err;
 
-   if (handles == NULL) handles = malloc(sizeof(int) * maxHandles);
+   if (p->ringCount >= LG_ALERT_RING)
+   {
+      LG_DBG(LG_DEBUG_ALWAYS, "more than %d alerts for gpio %d",
+         LG_ALERT_RING, p->gpio);
+      return;
+   }
 
-   numHandles = lgHdlGetHandlesForType(
-      LG_HDL_TYPE_NOTIFY, handles, maxHandles);
-   
-   if (numHandles > maxHandles)
+   /* find the slot, from the tail back */
+
+   i = p->ringCount;
+
+   while ((i > 0) &&
+          (LG_RING_AT(p, i-1).report.timestamp > a->report.timestamp))
+   {
+      LG_RING_AT(p, i) = LG_RING_AT(p, i-1);
+      i--;
+   }
+
+   LG_RING_AT(p, i) = *a;
+
+   p->ringCount++;
+}
+
+static uint64_t xRingHeadTs(lgAlertRec_p p)
+{
+   return p->ring[p->ringHead].report.timestamp;
+}
+
+static void xHeapDown(lgAlertRec_p *heap, int n, int i)
+{
+   int c;
+   lgAlertRec_p t;
+
+   t = heap[i];
+
+   while ((c = (2*i) + 1) < n)
    {
-      LG_DBG(LG_DEBUG_ALWAYS, "too many notifications");
-      numHandles = maxHandles;
+      if (((c+1) < n) && (xRingHeadTs(heap[c+1]) < xRingHeadTs(heap[c]))) c++;
+
+      if (xRingHeadTs(t) <= xRingHeadTs(heap[c])) break;
+
+      heap[i] = heap[c];
+      i = c;
    }
 
-   for (i=0; i<numHandles; i++)
+   heap[i] = t;
+}
+
+/*
+Moves up to LG_MAX_ALERTS alerts with a timestamp no later than tmax
+from the line rings into aBuf in time order.  Returns the number moved.
+*/
+
+static int xMergeDue(lgAlertRec_p *rec, int recs, uint64_t tmax)
+{
+   lgAlertRec_p heap[LG_MAX_MERGE_LINES];
+   lgAlertRec_p p;
+   int i, n, count;
+
+   n = 0;
+
+   for (i=0; i<recs; i++)
    {
-      status = lgHdlGetLockedObjTrusted(
-         handles[i], LG_HDL_TYPE_NOTIFY, (void **)&h);
-      
-      if (status < 0) continue;
+      if (rec[i]->ringCount && (xRingHeadTs(rec[i]) <= tmax))
+         heap[n++] = rec[i];
+   }
 
-      if (h->state == LG_NOTIFY_CLOSING)
-      {
-         lgHdlFree(handles[i], LG_HDL_TYPE_NOTIFY);
-      }
-      else if (h->state >= LG_NOTIFY_RUNNING)
+   for (i=(n/2)-1; i>=0; i--) xHeapDown(heap, n, i);
+
+   count = 0;
+
+   while (n && (count < LG_MAX_ALERTS))
+   {
+      p = heap[0];
+
+      aBuf[count++] = p->ring[p->ringHead];
+
+      p->ringHead = (p->ringHead + 1) & (LG_ALERT_RING-1);
+      p->ringCount--;
+
+      if (!p->ringCount || (xRingHeadTs(p) > tmax)) heap[0] = heap[--n];
+
+      if (n) xHeapDown(heap, n, 0);
+   }
+
+   return count;
+}
+
+/*
+Alerts for a notify handle are appended to that handle's report buffer
+as they are emitted and the handles touched are listed, so the flush
+only visits subscribers which have something to send.  The buffers are
+only used by the alert thread and are kept between passes.
+*/
+
+typedef struct
+{
+   lgGpioReport_t *report;
+   int count;
+   int size;
+} lgNfySub_t;
+
+static lgNfySub_t nfySub[LG_HDL_SLOTS];
+static int nfyDirty[LG_HDL_SLOTS];
+static int nfyDirtyCount;
+
+static void xNfyQueue(int count)
+{
+   int i, hdl, size;
+   lgNfySub_t *sub;
+   lgGpioReport_t *tmp;
+
+   for (i=0; i<count; i++)
+   {
+      hdl = aBuf[i].nfyHandle;
+
+      if ((hdl < 0) || (hdl >= LG_HDL_SLOTS)) continue;
+
+      sub = &nfySub[hdl];
+
+      if (sub->count == sub->size)
       {
-         emit = 0;
+         size = sub->size ? sub->size * 2 : MAX_EMITS;
 
-         if (h->state == LG_NOTIFY_RUNNING)
+         tmp = realloc(sub->report, size * sizeof(lgGpioReport_t));
+
+         if (tmp == NULL)
          {
-            for (d=0; d<count; d++)
-            {
-               /* is this for this notify handle? */
-               if (handles[i] == aBuf[d].nfyHandle)
-               {
-                  report[emit] = aBuf[d].report;
-                  emit++;
-               }
-            }
+            LG_DBG(LG_DEBUG_ALWAYS, "no memory for notify %d", hdl);
+            continue;
          }
 
-         if (emit)
-         {
-            max_emits = h->max_emits;
+         sub->report = tmp;
+         sub->size = size;
+      }
 
-            sent = 0;
+      if (!sub->count) nfyDirty[nfyDirtyCount++] = hdl;
 
-            while (emit > 0)
-            {
-               if (emit > max_emits)
-               {
-                  err = write(h->fd,
-                           report+sent,
-                           max_emits*sizeof(lgGpioReport_t));
+      sub->report[sub->count++] = aBuf[i].report;
+   }
+}
 
-                  if (err != (max_emits*sizeof(lgGpioReport_t)))
-                  {
-                     if (err < 0)
-                     {
-                        if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
-                        {
-                           /* serious error, no point continuing */
+static void xNfyWrite(lgNotify_t *h, lgGpioReport_t *report, int emit)
+{
+   int sent;
+   int chunk;
+   int err;
 
-                           LG_DBG(LG_DEBUG_ALWAYS, "fd=%d err=%d errno=%d",
-                              h->fd, err, errno);
+   sent = 0;
 
-                           LG_DBG(LG_DEBUG_ALWAYS, "%s", strerror(errno));
+   /* a pipe write of up to max_emits reports is atomic */
 
-                           h->state = LG_NOTIFY_CLOSING;
-                           break;
-                        }
-                        //else gpioStats.wouldBlockPipeWrite++;
-                     }
-                     else
-                     {
-                        //gpioStats.shortPipeWrite++;
-                        LG_DBG(LG_DEBUG_ALWAYS, "sent %zd, asked for %d",
-                           err/sizeof(lgGpioReport_t), max_emits);
-                     }
-                  }
-                  else
-                  {
-                     //gpioStats.goodPipeWrite++;
-                  }
+   while (emit > 0)
+   {
+      chunk = (emit > h->max_emits) ? h->max_emits : emit;
 
-                  sent += max_emits;
-                  emit    -= max_emits;
-               }
-               else
-               {
-                  err = write(h->fd,
-                           report+sent,
-                           emit*sizeof(lgGpioReport_t));
+      err = write(h->fd, report+sent, chunk*sizeof(lgGpioReport_t));
 
-                  if (err != (emit*sizeof(lgGpioReport_t)))
-                  {
-                     if (err < 0)
-                     {
-                        if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
-                        {
-                           LG_DBG(LG_DEBUG_ALWAYS, "fd=%d err=%d errno=%d",
-                              h->fd, err, errno);
-
-                           LG_DBG(LG_DEBUG_ALWAYS, "%s", strerror(errno));
-
-                           /* serious error, no point continuing */
-                           h->state = LG_NOTIFY_CLOSING;
-                           break;
-                        }
-                        //else gpioStats.wouldBlockPipeWrite++;
-                     }
-                     else
-                     {
-                        //gpioStats.shortPipeWrite++;
-                        LG_DBG(LG_DEBUG_ALWAYS, "sent %zd, asked for %d",
-                           err/sizeof(lgGpioReport_t), emit);
-                     }
-                  }
-                  else
-                  {
-                     //gpioStats.goodPipeWrite++;
-                  }
+      if (err != (chunk*sizeof(lgGpioReport_t)))
+      {
+         if (err < 0)
+         {
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+            {
+               /* serious error, no point continuing */
 
-                  sent += emit;
-                  emit = 0;
-               }
+               LG_DBG(LG_DEBUG_ALWAYS, "fd=%d err=%d errno=%d",
+                  h->fd, err, errno);
+
+               LG_DBG(LG_DEBUG_ALWAYS, "%s", strerror(errno));
+
+               h->state = LG_NOTIFY_CLOSING;
+               break;
             }
          }
+         else
+         {
+            LG_DBG(LG_DEBUG_ALWAYS, "sent %zd, asked for %d",
+               err/sizeof(lgGpioReport_t), chunk);
+         }
       }
 
-      lgHdlUnlock(handles[i]);
+      sent += chunk;
+      emit -= chunk;
    }
 }
 
-int emit(int count, uint64_t tmax)
+static void xNfyFlush(void)
 {
-   int i;
+   int i, hdl;
+   int status;
+   lgNotify_t *h;
+   lgNfySub_t *sub;
 
-   for (i=0; i<count; i++)
+   for (i=0; i<nfyDirtyCount; i++)
    {
-      if (aBuf[i].report.timestamp > tmax) break;
+      hdl = nfyDirty[i];
+      sub = &nfySub[hdl];
+
+      status = lgHdlGetLockedObjTrusted(hdl, LG_HDL_TYPE_NOTIFY, (void **)&h);
+
+      if (status == LG_OKAY)
+      {
+         if (h->state == LG_NOTIFY_RUNNING)
+            xNfyWrite(h, sub->report, sub->count);
+
+         if (h->state == LG_NOTIFY_CLOSING)
+            lgHdlFree(hdl, LG_HDL_TYPE_NOTIFY);
+
+         lgHdlUnlock(hdl);
+      }
+
+      sub->count = 0;
    }
- 
+
+   nfyDirtyCount = 0;
+}
+
+void emitNotifications(int count)
+{
+   xNfyQueue(count);
+
+   xNfyFlush();
+}
+
+void emit(int count)
+{
    if (lgGpioSamplesFunc)
-      (lgGpioSamplesFunc)(i, aBuf, lgGpioSamplesUserdata);
-   
-   emitNotifications(i);
+      (lgGpioSamplesFunc)(count, aBuf, lgGpioSamplesUserdata);
+
+   emitNotifications(count);
+}
+
+/* merge and emit every pending alert no later than tmax */
 
-   return i;
+static void xEmitDue(lgAlertRec_p *rec, int recs, uint64_t tmax)
+{
+   int count;
+
+   do
+   {
+      count = xMergeDue(rec, recs, tmax);
+
+      if (count) emit(count);
+   }
+   while (count == LG_MAX_ALERTS);
+}
+
+/* hand one line's new alerts to its callback then queue them */
+
+static void xLineAlerts(lgAlertRec_p p, int count)
+{
+   int i;
+
+   if (!count) return;
+
+   if (p->state->alertFunc)
+      (p->state->alertFunc)(count, lBuf, p->state->userdata);
+
+   for (i=0; i<count; i++) xRingPut(p, &lBuf[i]);
 }
 
 void printbuf(int count, char *str)
@@ -319,14 +433,14 @@ void xDebWatEvt(
             LG_DBG(LG_DEBUG_ALWAYS, "g=%d(%d) diff=%"PRId64" deb=%"PRIu64" ts=%"PRIu64" lts=%"PRIu64"",
                p->gpio, p->last_evt_lv, nano_diff, p->debounce_nanos, ts/100000, p->last_evt_ts/100000);
             */
-            aBuf[*cp].report.timestamp = p->last_evt_ts + p->debounce_nanos;
-            aBuf[*cp].report.level = p->last_evt_lv;
-            aBuf[*cp].report.chip = p->chip->gpiochip;
-            aBuf[*cp].report.gpio = p->gpio;
-            aBuf[*cp].report.flags = 0;
-            aBuf[*cp].nfyHandle = p->nfyHandle;
-
-            if (++(*cp) < LG_MAX_ALERTS)
+            lBuf[*cp].report.timestamp = p->last_evt_ts + p->debounce_nanos;
+            lBuf[*cp].report.level = p->last_evt_lv;
+            lBuf[*cp].report.chip = p->chip->gpiochip;
+            lBuf[*cp].report.gpio = p->gpio;
+            lBuf[*cp].report.flags = 0;
+            lBuf[*cp].nfyHandle = p->nfyHandle;
+
+            if (++(*cp) < LG_ALERTS_PER_LINE_PASS)
             {
                p->last_rpt_ts = p->last_evt_ts + p->debounce_nanos;
                p->last_rpt_lv = p->last_evt_lv;
@@ -336,7 +450,8 @@ void xDebWatEvt(
             else
             {
                --(*cp);
-               LG_DBG(LG_DEBUG_ALWAYS, "more than %d alerts", LG_MAX_ALERTS);
+               LG_DBG(LG_DEBUG_ALWAYS, "more than %d alerts",
+                  LG_ALERTS_PER_LINE_PASS);
             }
          }
       }
@@ -366,14 +481,14 @@ void xDebWatEvt(
          LG_DBG(LG_DEBUG_ALWAYS, "g=%d(2) diff=%"PRId64" wdg=%"PRIu64" ts=%"PRIu64" lts=%"PRIu64"",
             p->gpio, nano_diff, p->watchdog_nanos, ts/100000, p->last_rpt_ts/100000);
          */
-         aBuf[*cp].report.timestamp = p->last_rpt_ts + p->watchdog_nanos;
-         aBuf[*cp].report.level = LG_TIMEOUT;
-         aBuf[*cp].report.chip = p->chip->gpiochip;
-         aBuf[*cp].report.gpio = p->gpio;
-         aBuf[*cp].report.flags = 0;
-         aBuf[*cp].nfyHandle = p->nfyHandle;
-
-         if (++(*cp) < LG_MAX_ALERTS)
+         lBuf[*cp].report.timestamp = p->last_rpt_ts + p->watchdog_nanos;
+         lBuf[*cp].report.level = LG_TIMEOUT;
+         lBuf[*cp].report.chip = p->chip->gpiochip;
+         lBuf[*cp].report.gpio = p->gpio;
+         lBuf[*cp].report.flags = 0;
+         lBuf[*cp].nfyHandle = p->nfyHandle;
+
+         if (++(*cp) < LG_ALERTS_PER_LINE_PASS)
          {
             p->watchdogd = 1;
             p->last_rpt_ts = p->last_rpt_ts + p->watchdog_nanos;
@@ -382,7 +497,8 @@ void xDebWatEvt(
          else
          {
             --(*cp);
-            LG_DBG(LG_DEBUG_ALWAYS, "more than %d alerts", LG_MAX_ALERTS);
+            LG_DBG(LG_DEBUG_ALWAYS, "more than %d alerts",
+               LG_ALERTS_PER_LINE_PASS);
          }
       }
    }
@@ -396,14 +512,14 @@ void xDebWatEvt(
       if (!p->debounce_nanos) // report straightaway if no debounce
       {
 
-         aBuf[*cp].report.timestamp = p->last_evt_ts;
-         aBuf[*cp].report.level = p->last_evt_lv; 
-         aBuf[*cp].report.chip = p->chip->gpiochip;
-         aBuf[*cp].report.gpio = p->gpio;
-         aBuf[*cp].report.flags = 0;
-         aBuf[*cp].nfyHandle = p->nfyHandle;
+         lBuf[*cp].report.timestamp = p->last_evt_ts;
+         lBuf[*cp].report.level = p->last_evt_lv; 
+         lBuf[*cp].report.chip = p->chip->gpiochip;
+         lBuf[*cp].report.gpio = p->gpio;
+         lBuf[*cp].report.flags = 0;
+         lBuf[*cp].nfyHandle = p->nfyHandle;
 
-         if (++(*cp) < LG_MAX_ALERTS)
+         if (++(*cp) < LG_ALERTS_PER_LINE_PASS)
          {
             p->watchdogd = 0;
             p->last_rpt_ts = p->last_evt_ts;
@@ -412,7 +528,8 @@ void xDebWatEvt(
          else
          {
             --(*cp);
-            LG_DBG(LG_DEBUG_ALWAYS, "more than %d alerts", LG_MAX_ALERTS);
+            LG_DBG(LG_DEBUG_ALWAYS, "more than %d alerts",
+               LG_ALERTS_PER_LINE_PASS);
          }
       }
    }
@@ -423,17 +540,17 @@ void *lgPthAlert(void)
    lgAlertRec_p p, t;
    int i, e;
    int num_gpio;
-   int gpiobasecount;
+   int num_merge;
+   int count;
    int retval;
-   int count=0;
-   int sent;
    int bytes;
    uint64_t lastGT=0;
    uint64_t lastLT=0;
    uint64_t nowLT;
    uint64_t nowGT;
-   struct pollfd pfd[64];
-   lgAlertRec_p pAlertRec[64];
+   struct pollfd pfd[LG_MAX_POLL_LINES];
+   lgAlertRec_p pAlertRec[LG_MAX_POLL_LINES];
+   lgAlertRec_p mAlertRec[LG_MAX_MERGE_LINES];
    struct gpio_v2_line_event eIn[LG_GPIO_MAX_ALERTS_PER_READ];
    struct timespec tspec = {0, 5e5}; /* 0.5 ms timeout */
 
@@ -441,182 +558,135 @@ void *lgPthAlert(void)
    {
       pthread_mutex_lock(&lgAlertMutex);
 
-      if (alertRec != NULL)
-      {
-         p = alertRec;
-         i = 0;
+      p = alertRec;
+      num_gpio = 0;
+      num_merge = 0;
 
-         /* poll active alerts */
+      /* poll active alerts, merge anything with pending alerts */
 
-         while (p != NULL)
+      while (p != NULL)
+      {
+         if (p->active && (num_gpio < LG_MAX_POLL_LINES))
          {
-            if (p->active)
-            {
-               pfd[i].fd= p->state->fd;
-               pfd[i].events = POLLIN|POLLPRI;
-               pAlertRec[i] = p;
-               i++;
-            }
-            else
-            {
-               /* delete inactive record */
+            pfd[num_gpio].fd= p->state->fd;
+            pfd[num_gpio].events = POLLIN|POLLPRI;
+            pAlertRec[num_gpio++] = p;
+            mAlertRec[num_merge++] = p;
+         }
+         else if (!p->active && p->ringCount &&
+                  (num_merge < LG_MAX_MERGE_LINES))
+         {
+            /* closed but alerts still to be sent */
 
-               if (p->prev) p->prev->next = p->next;
-               else alertRec = p->next;
+            mAlertRec[num_merge++] = p;
+         }
+         else if (!p->active)
+         {
+            /* delete inactive record */
 
-               if (p->next) p->next->prev = p->prev;
+            if (p->prev) p->prev->next = p->next;
+            else alertRec = p->next;
 
-               t = p; p = p->prev; free(t);
-            }
+            if (p->next) p->next->prev = p->prev;
 
-            if (p) p = p->next;
+            t = p->next; free(p); p = t;
+            continue;
          }
 
-         num_gpio = i;
+         p = p->next;
+      }
+
+      pthread_mutex_unlock(&lgAlertMutex);
+
+      if (num_gpio > 0)
+      {
+         retval = ppoll(pfd, num_gpio, &tspec, NULL);
 
-         pthread_mutex_unlock(&lgAlertMutex);
+         nowLT = xMonotonicTimestamp();
 
-         if (num_gpio > 0)
+         for (i=0; i<num_gpio; i++)
          {
-            retval = ppoll(pfd, num_gpio, &tspec, NULL);
+            count = 0;
 
-            nowLT = xMonotonicTimestamp();
+            p = pAlertRec[i];
 
-            for (i=0; i<num_gpio; i++)
+            if ((retval > 0) && (pfd[i].revents))
             {
-               gpiobasecount = count;
+               /* GPIO changed during ppoll */
 
-               p = pAlertRec[i];
+               bytes = read(pfd[i].fd, &eIn, sizeof(eIn));
 
-               if ((retval > 0) && (pfd[i].revents))
+               if (bytes > 0)
                {
-                  /* GPIO changed during ppoll */
-
-                  bytes = read(pfd[i].fd, &eIn, sizeof(eIn));
+                  e = 0;
 
-                  if (bytes > 0)
+                  while (bytes >= sizeof(eIn[0]))
                   {
-                     e = 0;
+                     /* debounce and watchdog */
+                     xDebWatEvt(p, eIn[e].timestamp_ns, &count, &eIn[e]);
 
-                     while (bytes >= sizeof(eIn[0]))
-                     {
-                        /* debounce and watchdog */
-                        xDebWatEvt(p, eIn[e].timestamp_ns, &count, &eIn[e]);
-
-                        bytes -= sizeof(eIn[0]);
-
-                        e++;
-                     }
+                     bytes -= sizeof(eIn[0]);
 
-                     if (e)
-                     {
-                        p->last_rpt_ts = eIn[e-1].timestamp_ns;
+                     e++;
+                  }
 
-                        if (eIn[e-1].timestamp_ns > lastGT)
-                        {
-                           lastGT = eIn[e-1].timestamp_ns;
-                           lastLT = nowLT;
-                        }
-                     }
+                  if (e)
+                  {
+                     p->last_rpt_ts = eIn[e-1].timestamp_ns;
 
-                     if (bytes)
+                     if (eIn[e-1].timestamp_ns > lastGT)
                      {
-                        if (p->active)
-                           LG_DBG(LG_DEBUG_ALWAYS, "bytes left=%d (%s)",
-                              bytes, strerror(errno));
+                        lastGT = eIn[e-1].timestamp_ns;
+                        lastLT = nowLT;
                      }
                   }
-                  else
+
+                  if (bytes)
                   {
                      if (p->active)
-                        LG_DBG(LG_DEBUG_ALWAYS, "read error %d (%s)",
-                           errno, strerror(errno));
+                        LG_DBG(LG_DEBUG_ALWAYS, "bytes left=%d (%s)",
+                           bytes, strerror(errno));
                   }
                }
-
-               if (gpiobasecount < count)
+               else
                {
-                  if (p->state->alertFunc)
-                  {
-                     (p->state->alertFunc)(count-gpiobasecount,
-                        &aBuf[gpiobasecount], p->state->userdata);
-                  }
+                  if (p->active)
+                     LG_DBG(LG_DEBUG_ALWAYS, "read error %d (%s)",
+                        errno, strerror(errno));
                }
             }
 
-            nowGT = lastGT + (nowLT - lastLT);
-
-            // LG_DBG(LG_DEBUG_ALWAYS, "ts=%"PRIu64"", nowGT/100000);
-
-            if (lastGT)
-            {
-               for (i=0; i<num_gpio; i++)
-               {
-                  gpiobasecount = count;
-
-                  p = pAlertRec[i];
-
-                  // The 50 microsecond leeway is to make sure the
-                  // kernel has supplied current data for all GPIO
-                  // before timing out debounce and watchdogs.
-                  xDebWatEvt(p, nowGT-50000, &count, NULL);
+            xLineAlerts(p, count);
+         }
 
-                  if (gpiobasecount < count)
-                  {
-                     if (p->state->alertFunc)
-                     {
-                        (p->state->alertFunc)(count-gpiobasecount,
-                           &aBuf[gpiobasecount], p->state->userdata);
-                     }
-                  }
-               }
-            }
+         nowGT = lastGT + (nowLT - lastLT);
 
-            if (count > 1)
+         if (lastGT)
+         {
+            for (i=0; i<num_gpio; i++)
             {
-               /*
-               LG_DBG(LG_DEBUG_ALWAYS, "nowGT=%"PRIu64" count=%d",
-                  nowGT/100000, count);
-               */
-               // printbuf(count, "pre qsort");
-               qsort(aBuf, count, sizeof(aBuf[0]), tscomp);
-               //lgcheck(count, "check post qsort");
-               // printbuf(count, "post qsort");
-            }
+               count = 0;
 
-            /* emit any due alerts */
+               p = pAlertRec[i];
 
-            // printbuf(count, "pre emit");
-            // delay 500 microseconds before reporting a GPIO
-            // to make sure the events are sorted in time order.
-            sent = emit(count, nowGT-500000);
+               // The 50 microsecond leeway is to make sure the
+               // kernel has supplied current data for all GPIO
+               // before timing out debounce and watchdogs.
+               xDebWatEvt(p, nowGT-50000, &count, NULL);
 
-            if (sent)
-            {
-               if (sent != count)
-               {
-                  /* shuffle entries down */
-                  memmove(aBuf, aBuf+sent, sizeof(aBuf[0])*(count-sent));
-               }
-               count -= sent;
+               xLineAlerts(p, count);
             }
-            //printbuf(count, "post emit");
          }
-         else /* no active alerts */
-         {
-            emit(count, -1); /* empty the buffer */
-            count = 0;
-            lastGT = 0;
 
-            xWaitForSignal(&lgAlertCond, &lgAlertCondMutex);
-         }
+         /* emit any due alerts */
+
+         // delay 500 microseconds before reporting a GPIO
+         // to make sure the events are sorted in time order.
+         xEmitDue(mAlertRec, num_merge, nowGT-500000);
       }
-      else /* no alerts */
+      else /* no active alerts */
       {
-         pthread_mutex_unlock(&lgAlertMutex);
-
-         emit(count, -1); /* empty the buffer */
-         count = 0;
+         xEmitDue(mAlertRec, num_merge, -1); /* empty the rings */
          lastGT = 0;
 
          xWaitForSignal(&lgAlertCond, &lgAlertCondMutex);
@@ -668,10 +738,15 @@ lgAlertRec_p lgGpioCreateAlertRec(
 {
    lgAlertRec_p p;
 
-   p = malloc(sizeof(lgAlertRec_t));
+   /* the pending alert ring follows the record */
+
+   p = malloc(sizeof(lgAlertRec_t) + (LG_ALERT_RING*sizeof(lgGpioAlert_t)));
 
    if (p)
    {
+      p->ring = (lgGpioAlert_p)(p + 1);
+      p->ringHead = 0;
+      p->ringCount = 0;
       p->chip = chip;
       p->gpio = gpio;
       p->state = state;
@@ -33,6 +33,8 @@ For more information, please refer to <http://unlicense.org/>
 #include "lgpio.h"
 #include "lgGpio.h"
 
+#define LG_ALERT_RING 512 /* pending alerts per line, power of 2 */
+
 typedef struct lgAlertRec_s
 {
    uint64_t last_rpt_ts;
@@ -49,6 +51,9 @@ typedef struct lgAlertRec_s
    lgLineInf_p state;
    int active;
    lgChipObj_p chip;
+   lgGpioAlert_p ring;
+   int ringHead;
+   int ringCount;
    struct lgAlertRec_s *prev;
    struct lgAlertRec_s *next;
 } lgAlertRec_t, *lgAlertRec_p;
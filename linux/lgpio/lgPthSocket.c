@@ -29,7 +29,9 @@ For more information, please refer to <http://unlicense.org/>
 #include <stdlib.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <errno.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
 
@@ -40,6 +42,27 @@ For more information, please refer to <http://unlicense.org/>
 #include "lgDbg.h"
 #include "lgHdl.h"
 
+/* event loop server (rgpiod -e) */
+
+#define LG_SOCK_IN_BUF    (CMD_MAX_EXTENSION*2)
+#define LG_SOCK_OUT_LIMIT (256*1024) /* stop reading above this backlog */
+#define LG_SOCK_MAX_EVENTS 16
+
+typedef struct
+{
+   int sock;
+   lgCtx_p ctx;
+   char *in;
+   int inLen;
+   char *out;
+   int outLen;
+   int outPos;
+   int outCap;
+   int noib;        /* notifications share the socket, see xConnFlush */
+} xConn_t, *xConn_p;
+
+static int xEpollFd = -1;
+
 static void *xSocketThreadHandler(void *fdC)
 {
    int sock = *(int*)fdC;
@@ -237,3 +260,379 @@ void *pthSocketThread(void *x)
    return 0;
 }
 
+/* ----------------------------------------------------------------------- */
+
+static int xConnAppend(xConn_p c, void *buf, int len)
+{
+   char *tmp;
+   int cap;
+
+   if ((c->outLen + len) > c->outCap)
+   {
+      if (c->outPos)
+      {
+         memmove(c->out, c->out + c->outPos, c->outLen - c->outPos);
+         c->outLen -= c->outPos;
+         c->outPos = 0;
+      }
+
+      cap = c->outCap ? c->outCap : (CMD_MAX_EXTENSION);
+
+      while (cap < (c->outLen + len)) cap *= 2;
+
+      if (cap != c->outCap)
+      {
+         tmp = realloc(c->out, cap);
+
+         if (tmp == NULL) return LG_NO_MEMORY;
+
+         c->out = tmp;
+         c->outCap = cap;
+      }
+   }
+
+   memcpy(c->out + c->outLen, buf, len);
+   c->outLen += len;
+
+   return LG_OKAY;
+}
+
+/* once in-band notifications are on, the alert thread writes reports
+   to the socket too, so a response left part sent could be split by
+   one. Those connections block until each backlog is out, as the
+   thread per connection server does. */
+
+static int xConnFlush(xConn_p c)
+{
+   int n, flags;
+
+   flags = c->noib ? MSG_NOSIGNAL : (MSG_DONTWAIT | MSG_NOSIGNAL);
+
+   while (c->outPos < c->outLen)
+   {
+      n = send(c->sock, c->out + c->outPos, c->outLen - c->outPos, flags);
+
+      if (n < 0)
+      {
+         if (errno == EINTR) continue;
+         if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) return LG_OKAY;
+         return LG_SOCK_WRIT_FAILED;
+      }
+
+      c->outPos += n;
+   }
+
+   c->outPos = c->outLen = 0;
+
+   return LG_OKAY;
+}
+
+/* execute every complete command frame held in the input buffer,
+   queueing the responses, until the output backlog hits its limit */
+
+static int xConnExecFrames(xConn_p c)
+{
+   int pos, len, opt;
+   lgCmd_t cmdBuf[CMD_MAX_EXTENSION/sizeof(lgCmd_t)];
+   lgCmd_p cmdP=cmdBuf;
+   uint32_t *arg=(uint32_t*)&cmdP[1];
+   int status = LG_OKAY;
+
+   pos = 0;
+
+   while (((c->inLen - pos) >= (int)sizeof(lgCmd_t)) &&
+          ((c->outLen - c->outPos) <= LG_SOCK_OUT_LIMIT))
+   {
+      memcpy(cmdP, c->in + pos, sizeof(lgCmd_t));
+
+      if (cmdP->size >= (sizeof(cmdBuf)-sizeof(lgCmd_t)))
+      {
+         /* Serious error.  No point continuing. */
+
+         LG_DBG(LG_DEBUG_ALWAYS,
+            "message too large %"PRId32"(%zd), sock=%d",
+            cmdP->size, sizeof(cmdBuf)-sizeof(lgCmd_t), c->sock);
+
+         status = LG_MSG_TOOBIG;
+         break;
+      }
+
+      len = sizeof(lgCmd_t) + cmdP->size;
+
+      if ((c->inLen - pos) < len) break; /* partial frame */
+
+      memcpy(&cmdBuf[1], c->in + pos + sizeof(lgCmd_t), cmdP->size);
+
+      pos += len;
+
+      LG_DBG(LG_DEBUG_INTERNAL, "magic=%d size=%d cmd=%d Q=%d I=%d H=%d",
+         cmdP->magic, cmdP->size, cmdP->cmd,
+         cmdP->doubles, cmdP->longs, cmdP->shorts);
+
+      if (cmdP->cmd == LG_CMD_NOIB)
+      {
+         /* Enable the Nagle algorithm. */
+         opt = 0;
+         setsockopt(
+            c->sock, IPPROTO_TCP, TCP_NODELAY, (char*)&opt, sizeof(int));
+
+         /* set sock as the argument */
+         arg[0] = c->sock;
+
+         /* reports may follow at once, so nothing may be left part sent */
+         c->noib = 1;
+
+         if (xConnFlush(c) < 0)
+         {
+            status = LG_SOCK_WRIT_FAILED;
+            break;
+         }
+      }
+
+      cmdP->status = lgExecCmd(cmdBuf, sizeof(cmdBuf));
+
+      LG_DBG(LG_DEBUG_INTERNAL, "status=%d size=%d cmd=%d Q=%d I=%d H=%d",
+         cmdP->status, cmdP->size, cmdP->cmd,
+         cmdP->doubles, cmdP->longs, cmdP->shorts);
+
+      if (xConnAppend(c, cmdBuf, sizeof(lgCmd_t)+cmdP->size) != LG_OKAY)
+      {
+         status = LG_NO_MEMORY;
+         break;
+      }
+   }
+
+   if (pos)
+   {
+      memmove(c->in, c->in + pos, c->inLen - pos);
+      c->inLen -= pos;
+   }
+
+   return status;
+}
+
+static void xConnClose(xConn_p c)
+{
+   epoll_ctl(xEpollFd, EPOLL_CTL_DEL, c->sock, NULL);
+
+   lgHdlPurgeByOwner(c->ctx->owner);
+
+   close(c->sock);
+
+   LG_DBG(LG_DEBUG_INTERNAL, "Socket %d closed", c->sock);
+
+   LG_DBG(LG_DEBUG_INTERNAL, "free context memory %d", c->ctx->owner);
+
+   lgCtxSet(NULL);
+
+   free(c->ctx);
+   free(c->in);
+   free(c->out);
+   free(c);
+}
+
+/* called by one worker at a time (EPOLLONESHOT) when the connection
+   is readable or, with a backlog, writable */
+
+static void xConnService(xConn_p c)
+{
+   struct epoll_event ev;
+   int n;
+
+   lgCtxSet(c->ctx);
+
+   if (xConnFlush(c) < 0) {xConnClose(c); return;}
+
+   /* frames held back by a previous backlog */
+
+   if (xConnExecFrames(c) < 0) {xConnClose(c); return;}
+
+   if ((c->outLen - c->outPos) <= LG_SOCK_OUT_LIMIT)
+   {
+      do
+      {
+         n = recv(c->sock, c->in + c->inLen, LG_SOCK_IN_BUF - c->inLen,
+            MSG_DONTWAIT);
+      }
+      while ((n < 0) && (errno == EINTR));
+
+      if (n == 0) {xConnClose(c); return;}
+
+      if (n < 0)
+      {
+         if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+         {
+            xConnClose(c);
+            return;
+         }
+      }
+      else
+      {
+         c->inLen += n;
+
+         if (xConnExecFrames(c) < 0) {xConnClose(c); return;}
+      }
+   }
+
+   /* all responses for this read go out in one send */
+
+   if (xConnFlush(c) < 0) {xConnClose(c); return;}
+
+   ev.events = EPOLLONESHOT;
+   ev.data.ptr = c;
+
+   if (c->outPos < c->outLen) ev.events |= EPOLLOUT;
+
+   if ((c->outLen - c->outPos) <= LG_SOCK_OUT_LIMIT) ev.events |= EPOLLIN;
+
+   epoll_ctl(xEpollFd, EPOLL_CTL_MOD, c->sock, &ev);
+}
+
+static void xAccept(void)
+{
+   int fdC, opt;
+   struct sockaddr_storage client;
+   socklen_t c;
+   struct epoll_event ev;
+   xConn_p conn;
+
+   c = sizeof(client);
+
+   fdC = accept(gFdSock, (struct sockaddr *)&client, &c);
+
+   if (fdC < 0) return;
+
+   lgNotifyCloseOrphans(-1, fdC);
+
+   if (!xAddrAllowed((struct sockaddr *)&client))
+   {
+      LG_DBG(LG_DEBUG_ALWAYS, "Connection rejected, closing");
+      close(fdC);
+      return;
+   }
+
+   LG_DBG(LG_DEBUG_INTERNAL, "Connection accepted on socket %d", fdC);
+
+   conn = calloc(1, sizeof(xConn_t));
+
+   if (conn) conn->ctx = calloc(1, sizeof(lgCtx_t));
+   if (conn && conn->ctx) conn->in = malloc(LG_SOCK_IN_BUF);
+
+   if ((conn == NULL) || (conn->ctx == NULL) || (conn->in == NULL))
+   {
+      LG_DBG(LG_DEBUG_ALWAYS, "no memory, closing");
+
+      if (conn) {free(conn->ctx); free(conn);}
+
+      close(fdC);
+      return;
+   }
+
+   conn->sock = fdC;
+
+   opt = 1;
+   setsockopt(fdC, SOL_SOCKET, SO_KEEPALIVE, &opt, sizeof(opt));
+
+   /* Disable the Nagle algorithm. */
+   opt = 1;
+   setsockopt(fdC, IPPROTO_TCP, TCP_NODELAY, (char*)&opt, sizeof(int));
+
+   ev.events = EPOLLIN | EPOLLONESHOT;
+   ev.data.ptr = conn;
+
+   if (epoll_ctl(xEpollFd, EPOLL_CTL_ADD, fdC, &ev) < 0)
+   {
+      LG_DBG(LG_DEBUG_ALWAYS, "epoll_ctl failed (%m), closing");
+      free(conn->in);
+      free(conn->ctx);
+      free(conn);
+      close(fdC);
+   }
+}
+
+static void *xSocketWorker(void *x)
+{
+   struct epoll_event events[LG_SOCK_MAX_EVENTS];
+   struct epoll_event ev;
+   int i, n;
+
+   while (1)
+   {
+      n = epoll_wait(xEpollFd, events, LG_SOCK_MAX_EVENTS, -1);
+
+      if (n < 0)
+      {
+         if (errno == EINTR) continue;
+         PARAM_ERROR((void*)LG_INIT_FAILED, "epoll_wait failed (%m)");
+      }
+
+      for (i=0; i<n; i++)
+      {
+         if (events[i].data.ptr == NULL)
+         {
+            /* listening socket, re-arm for the next worker */
+
+            xAccept();
+
+            ev.events = EPOLLIN | EPOLLONESHOT;
+            ev.data.ptr = NULL;
+            epoll_ctl(xEpollFd, EPOLL_CTL_MOD, gFdSock, &ev);
+         }
+         else xConnService(events[i].data.ptr);
+      }
+   }
+
+   return 0;
+}
+
+/* Serve all connections from an epoll set shared by a small pool of
+   workers.  Each connection is armed EPOLLONESHOT so only one worker
+   handles it at a time, keeping its commands in order. */
+
+void *pthSocketEventThread(void *x)
+{
+   int i, workers;
+   pthread_t thr;
+   pthread_attr_t attr;
+   struct epoll_event ev;
+
+   workers = *(int*)x;
+
+   if (workers < 1) workers = 1;
+
+   if (pthread_attr_init(&attr))
+      PARAM_ERROR((void*)LG_INIT_FAILED,
+         "pthread_attr_init failed (%m)");
+
+   if (pthread_attr_setstacksize(&attr, STACK_SIZE))
+      PARAM_ERROR((void*)LG_INIT_FAILED,
+         "pthread_attr_setstacksize failed (%m)");
+
+   if (pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED))
+      PARAM_ERROR((void*)LG_INIT_FAILED,
+         "pthread_attr_setdetachstate failed (%m)");
+
+   xEpollFd = epoll_create1(EPOLL_CLOEXEC);
+
+   if (xEpollFd < 0)
+      PARAM_ERROR((void*)LG_INIT_FAILED, "epoll_create1 failed (%m)");
+
+   listen(gFdSock, 100);
+
+   ev.events = EPOLLIN | EPOLLONESHOT;
+   ev.data.ptr = NULL;
+
+   if (epoll_ctl(xEpollFd, EPOLL_CTL_ADD, gFdSock, &ev) < 0)
+      PARAM_ERROR((void*)LG_INIT_FAILED, "epoll_ctl failed (%m)");
+
+   for (i=1; i<workers; i++)
+   {
+      if (pthread_create(&thr, &attr, xSocketWorker, NULL))
+         PARAM_ERROR((void*)LG_INIT_FAILED,
+            "socket pthread_create failed (%m)");
+   }
+
+   /* this thread is the last worker */
+
+   return xSocketWorker(NULL);
+}
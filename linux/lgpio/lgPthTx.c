@@ -26,161 +26,302 @@ For more information, please refer to <http://unlicense.org/>
 */
 
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
 
 #include "lgDbg.h"
 #include "lgHdl.h"
 #include "lgPthTx.h"
 
+#define LG_TX_MAX_SLEEP 20000 /* run at least fifty times a second */
+
 int lgMinTxDelay = 10;
 
 static pthread_t pthTx;
 static pthread_mutex_t lgTxMutex = PTHREAD_MUTEX_INITIALIZER;
 static volatile lgTxRec_p txRec = NULL;
 static int pthTxRunning = LG_THREAD_NONE;
-static struct timespec pthTxReq;
-static int pthTxDelayMicros = 0;
+static int pthTxPriority = 0;
 
-void *lgPthTx(void)
+/* min-heap of active records keyed on absolute deadline */
+
+static lgTxRec_p *txHeap = NULL;
+static int txHeapSize = 0;
+static int txHeapCap = 0;
+
+/* time of the next scheduled wake, all deadlines are >= this */
+
+static int64_t pthTxNextMicros = 0;
+
+/* wake latency histogram, bin 0 < 1 us, bin n [2^(n-1), 2^n) us */
+
+static uint32_t txJitter[LG_TX_JITTER_BINS];
+static uint32_t txJitterMax = 0;
+
+static int64_t xMonoMicros(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+
+   return ((int64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+static void xHeapSet(int pos, lgTxRec_p p)
+{
+   txHeap[pos] = p;
+   p->heap_pos = pos;
+}
+
+static void xHeapUp(int pos)
+{
+   lgTxRec_p p;
+   int parent;
+
+   p = txHeap[pos];
+
+   while (pos > 0)
+   {
+      parent = (pos - 1) / 2;
+
+      if (txHeap[parent]->deadline <= p->deadline) break;
+
+      xHeapSet(pos, txHeap[parent]);
+      pos = parent;
+   }
+
+   xHeapSet(pos, p);
+}
+
+static void xHeapDown(int pos)
+{
+   lgTxRec_p p;
+   int child;
+
+   p = txHeap[pos];
+
+   while ((child = (2 * pos) + 1) < txHeapSize)
+   {
+      if (((child + 1) < txHeapSize) &&
+          (txHeap[child+1]->deadline < txHeap[child]->deadline)) child++;
+
+      if (p->deadline <= txHeap[child]->deadline) break;
+
+      xHeapSet(pos, txHeap[child]);
+      pos = child;
+   }
+
+   xHeapSet(pos, p);
+}
+
+static int xHeapInsert(lgTxRec_p p)
+{
+   lgTxRec_p *tmp;
+   int cap;
+
+   if (txHeapSize >= txHeapCap)
+   {
+      cap = txHeapCap ? txHeapCap * 2 : 32;
+
+      tmp = realloc(txHeap, cap * sizeof(lgTxRec_p));
+
+      if (tmp == NULL) return LG_NO_MEMORY;
+
+      txHeap = tmp;
+      txHeapCap = cap;
+   }
+
+   xHeapSet(txHeapSize++, p);
+   xHeapUp(p->heap_pos);
+
+   return LG_OKAY;
+}
+
+static void xHeapRemove(lgTxRec_p p)
+{
+   int pos;
+
+   pos = p->heap_pos;
+
+   if (pos < 0) return;
+
+   p->heap_pos = -1;
+
+   if (--txHeapSize == pos) return;
+
+   xHeapSet(pos, txHeap[txHeapSize]);
+   xHeapUp(pos);
+   xHeapDown(txHeap[pos]->heap_pos);
+}
+
+static void xTxLink(lgTxRec_p p)
+{
+   p->prev = NULL;
+   p->next = txRec;
+   if (txRec) txRec->prev = p;
+   txRec = p;
+}
+
+static void xTxDelete(lgTxRec_p p)
 {
-   lgTxRec_p p, t;
    int i;
 
-   clock_gettime(CLOCK_MONOTONIC, &pthTxReq); // get current time
+   xHeapRemove(p);
 
-   while (1)
+   if (p->prev) p->prev->next = p->next;
+   else txRec = p->next;
+
+   if (p->next) p->next->prev = p->prev;
+
+   if (p->type == LG_TX_WAVE)
    {
-      lgPthTxLock();
+      /* free the malloc'd pulses */
+      for (i=0; i<p->entries; i++)
+      {
+         free(p->pulses[LG_TX_SLOT(p, i)]);
+         p->pulses[LG_TX_SLOT(p, i)] = NULL;
+      }
+   }
+
+   free(p);
+}
+
+static void xTxPwmEdge(lgTxRec_p p)
+{
+   int s;
+
+   s = p->head;
+
+   if (p->next_level || (p->micros_on[s] == 0))
+   {
+      /* start of cycle */
+
+      if ((p->cycles[s] <= 0) && (p->entries > 1))
+      {
+         p->head = s = LG_TX_SLOT(p, 1);
+         --p->entries;
+      }
+
+      if (p->cycles[s] == 0) /* 0 is a result of countdown */
+      {
+         xWrite(p->chip, p->gpio, 0);
+         p->active = 0;
+      }
+      else if (p->micros_on[s])
+      {
+         xWrite(p->chip, p->gpio, 1);
+         p->deadline += p->micros_on[s];
+         if (p->micros_off[s]) p->next_level = 0;
+      }
+      else
+      {
+         xWrite(p->chip, p->gpio, 0);
+         p->deadline += p->micros_off[s];
+         p->next_level = 1;
+      }
+
+      if (--p->cycles[s] < 0) p->cycles[s] = -1;
+   }
+   else /* middle of cycle */
+   {
+      xWrite(p->chip, p->gpio, 0);
+      p->deadline += p->micros_off[s];
+      p->next_level = 1;
+   }
+}
+
+static void xTxWaveEdge(lgTxRec_p p)
+{
+   lgPulse_p pulse;
+   int s;
+
+   s = p->head;
+
+   if ((p->pulse_pos >= p->num_pulses[s]) && (p->entries > 1))
+   {
+      free(p->pulses[s]);
+      p->pulses[s] = NULL;
 
-      // update times
+      p->head = s = LG_TX_SLOT(p, 1);
+      --p->entries;
+      p->pulse_pos = 0;
+   }
+
+   if (p->pulse_pos < p->num_pulses[s])
+   {
+      pulse = &p->pulses[s][p->pulse_pos];
+      xGroupWrite(p->chip, p->gpio, pulse->bits, pulse->mask);
+      p->deadline += pulse->delay;
+      (p->pulse_pos)++;
+   }
+   else p->active = 0;
+}
+
+static void xTxRecordJitter(int64_t lateMicros)
+{
+   int bin;
+
+   if (lateMicros < 0) lateMicros = 0;
+
+   if (lateMicros > txJitterMax) txJitterMax = lateMicros;
+
+   for (bin=0; (bin < (LG_TX_JITTER_BINS-1)) && lateMicros; bin++)
+      lateMicros >>= 1;
+
+   txJitter[bin]++;
+}
+
+void *lgPthTx(void)
+{
+   lgTxRec_p p;
+   int64_t now, next;
+   struct timespec req;
 
-      for (p=txRec; p!=NULL; p=p->next)
-         p->next_micros -= pthTxDelayMicros;
+   while (1)
+   {
+      lgPthTxLock();
 
-      // output changed edges and calculate next delay
+      now = pthTxNextMicros;
 
-      pthTxDelayMicros = 20000; // run at least fifty times a second
+      // output the edges which are due, each record is re-keyed
+      // on its next deadline so only due records are visited
 
-      p = txRec;
-      
-      while (p != NULL)
+      while (txHeapSize && (txHeap[0]->deadline <= now))
       {
+         p = txHeap[0];
+
          if (p->active)
          {
-            if (p->next_micros <= 0)
-            {
-               if (p->type == LG_TX_PWM)
-               {
-                  if (p->next_level || (p->micros_on[0] == 0))
-                  {
-                      /* start of cycle */
-
-                     if ((p->cycles[0] <= 0) && (p->entries > 1))
-                     {
-                        for (i=0; i<p->entries; i++)
-                        {
-                           p->micros_on[i] = p->micros_on[i+1];
-                           p->micros_off[i] = p->micros_off[i+1];
-                           p->cycles[i] = p->cycles[i+1];
-                        }
-                        --p->entries;
-                     }
-                  
-                     if (p->cycles[0] == 0) /* 0 is a result of countdown */
-                     {
-                        xWrite(p->chip, p->gpio, 0);
-                        p->active = 0;
-                     }
-                     else if (p->micros_on[0])
-                     {
-                        xWrite(p->chip, p->gpio, 1);
-                        p->next_micros += p->micros_on[0];
-                        if (p->micros_off[0]) p->next_level = 0;
-                     }
-                     else
-                     {
-                        xWrite(p->chip, p->gpio, 0);
-                        p->next_micros += p->micros_off[0];
-                        p->next_level = 1;
-                     }
-
-                     if (--p->cycles[0] < 0) p->cycles[0] = -1;
-                  }
-                  else /* middle of cycle */
-                  {
-                     xWrite(p->chip, p->gpio, 0);
-                     p->next_micros += p->micros_off[0];
-                     p->next_level = 1;
-                  }
-               }
-               else if (p->type == LG_TX_WAVE)
-               {
-                  if (p->pulse_pos >= p->num_pulses[0])
-                  {
-                     if (p->entries > 1)
-                     {
-                        for (i=0; i<p->entries; i++)
-                        {
-                           p->pulses[i] = p->pulses[i+1];
-                           p->num_pulses[i] = p->num_pulses[i+1];
-                        }
-                        --p->entries;
-                        p->pulse_pos = 0;
-                     }
-                  }
-
-                  if (p->pulse_pos < p->num_pulses[0])
-                  {
-                     xGroupWrite(p->chip, p->gpio,
-                        p->pulses[0][p->pulse_pos].bits,
-                        p->pulses[0][p->pulse_pos].mask);
-                     p->next_micros += p->pulses[0][p->pulse_pos].delay;
-                     (p->pulse_pos)++;
-                  }
-                  else p->active = 0;
-               }
-            }
-
-            if (p->next_micros < pthTxDelayMicros)
-               pthTxDelayMicros = p->next_micros;
-         }
-         else
-         {
-            /* delete inactive record */
-            
-            if (p->prev) p->prev->next = p->next;
-            else txRec = p->next;
-
-            if (p->next) p->next->prev = p->prev;
-
-            if (p->type == LG_TX_WAVE)
-            {
-               /* free the malloc'd pulses */
-               for (i=0; i<p->entries; i++)
-               {
-                  free(p->pulses[i]);
-                  p->pulses[i] = NULL;
-               }
-            }
-
-            t = p; p = p->prev; free(t);
+            if (p->type == LG_TX_PWM) xTxPwmEdge(p);
+            else if (p->type == LG_TX_WAVE) xTxWaveEdge(p);
          }
 
-         if (p) p = p->next;
+         if (p->active) xHeapDown(0);
+         else xTxDelete(p);
       }
 
-      pthTxReq.tv_nsec += (pthTxDelayMicros * 1000);
-      if (pthTxReq.tv_nsec >= 1000000000)
-      {
-         pthTxReq.tv_sec += 1;
-         pthTxReq.tv_nsec -= 1000000000;
-      }
+      next = now + LG_TX_MAX_SLEEP;
+
+      if (txHeapSize && (txHeap[0]->deadline < next))
+         next = txHeap[0]->deadline;
+
+      pthTxNextMicros = next;
 
       lgPthTxUnlock();
 
       // sleep until next edge
 
-      while (clock_nanosleep(
-         CLOCK_MONOTONIC, TIMER_ABSTIME, &pthTxReq, NULL));
+      req.tv_sec = next / 1000000;
+      req.tv_nsec = (next % 1000000) * 1000;
+
+      while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &req, NULL));
+
+      now = xMonoMicros();
+
+      lgPthTxLock();
+      xTxRecordJitter(now - next);
+      lgPthTxUnlock();
    }
 
    pthTxRunning = LG_THREAD_NONE;
@@ -189,9 +330,40 @@ void *lgPthTx(void)
 
 void lgPthTxStart(void)
 {
+   pthread_attr_t attr;
+   struct sched_param param;
+   int started = 0;
+
    if (!pthTxRunning)
    {
-      if (pthread_create(&pthTx, NULL, (void*)lgPthTx, NULL) == 0)
+      lgPthTxLock();
+      pthTxNextMicros = xMonoMicros();
+      lgPthTxUnlock();
+
+      if (pthTxPriority)
+      {
+         pthread_attr_init(&attr);
+         pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+         pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+         param.sched_priority = pthTxPriority;
+         pthread_attr_setschedparam(&attr, &param);
+
+         if (pthread_create(&pthTx, &attr, (void*)lgPthTx, NULL) == 0)
+            started = 1;
+         else
+            LG_DBG(LG_DEBUG_ALWAYS,
+               "can't start tx thread with SCHED_FIFO %d", pthTxPriority);
+
+         pthread_attr_destroy(&attr);
+      }
+
+      if (!started)
+      {
+         if (pthread_create(&pthTx, NULL, (void*)lgPthTx, NULL) == 0)
+            started = 1;
+      }
+
+      if (started)
       {
          pthread_detach(pthTx);
          pthTxRunning = LG_THREAD_STARTED;
@@ -209,16 +381,94 @@ void lgPthTxUnlock(void)
    pthread_mutex_unlock(&lgTxMutex);
 }
 
+void lgPthTxCancel(lgTxRec_p p)
+{
+   p->active = 0;
+
+   /* bring the record forward so the thread reaps it on its next pass */
+
+   if (p->heap_pos >= 0)
+   {
+      p->deadline = pthTxNextMicros;
+      xHeapUp(p->heap_pos);
+   }
+}
+
 void lgPthTxStop(lgChipObj_p chip)
 {
    lgTxRec_p pwm;
 
    /* stop any PWM on chip */
-   
+
+   lgPthTxLock();
+
    for (pwm=txRec; pwm!=NULL; pwm=pwm->next)
    {
-      if (chip->handle == pwm->chip->handle) pwm->active =0;
+      if (chip->handle == pwm->chip->handle) lgPthTxCancel(pwm);
+   }
+
+   lgPthTxUnlock();
+}
+
+int lgPthTxSetPriority(int priority)
+{
+   struct sched_param param;
+   int policy, err;
+
+   if ((priority < 0) || (priority > sched_get_priority_max(SCHED_FIFO)))
+      return LG_BAD_CONFIG_VALUE;
+
+   pthTxPriority = priority;
+
+   if (pthTxRunning)
+   {
+      if (priority) policy = SCHED_FIFO; else policy = SCHED_OTHER;
+
+      param.sched_priority = priority;
+
+      err = pthread_setschedparam(pthTx, policy, &param);
+
+      if (err)
+      {
+         LG_DBG(LG_DEBUG_ALWAYS,
+            "can't set tx thread priority %d (%s)", priority, strerror(err));
+
+         if (err == EPERM) return LG_NO_PERMISSIONS;
+
+         return LG_BAD_CONFIG_VALUE;
+      }
    }
+
+   return LG_OKAY;
+}
+
+int lgPthTxGetPriority(void)
+{
+   return pthTxPriority;
+}
+
+int lgTxJitter(uint32_t *histogram, int clear)
+{
+   int status;
+
+   LG_DBG(LG_DEBUG_TRACE, "histogram=*%p clear=%d", (void*)histogram, clear);
+
+   lgPthTxLock();
+
+   if (histogram)
+      memcpy(histogram, txJitter, sizeof(txJitter));
+
+   status = txJitterMax;
+
+   if (clear)
+   {
+      memset(txJitter, 0, sizeof(txJitter));
+      txJitterMax = 0;
+   }
+
+   lgPthTxUnlock();
+
+   return status;
 }
 
 lgTxRec_p lgGpioGetTxRec(lgChipObj_p chip, int gpio, int type)
@@ -252,7 +502,9 @@ lgTxRec_p lgGpioCreateTxRec(
       p->type = LG_TX_PWM;
       p->chip = chip;
       p->gpio = gpio;
+      p->head = 0;
       p->entries = 1;
+      p->heap_pos = -1;
       p->micros_on[0] = micros_on;
       p->micros_off[0] = micros_off;
       p->micros_offset = micros_offset;
@@ -262,17 +514,21 @@ lgTxRec_p lgGpioCreateTxRec(
 
       lgPthTxLock();
 
-      usec = pthTxReq.tv_nsec / 1000;
+      /* align the first edge with the cycle grid of the next wake */
+
+      usec = pthTxNextMicros % 1000000;
       ct = micros_on + micros_off;
       cyc = usec / ct;
       frac = usec - (ct *cyc);
-      left = ct - frac + pthTxDelayMicros + micros_offset;
-      p->next_micros = left;
-      
-      p->prev = NULL;
-      p->next = txRec;
-      if (txRec) txRec->prev = p;
-      txRec = p;
+      left = ct - frac + micros_offset;
+      p->deadline = pthTxNextMicros + left;
+
+      if (xHeapInsert(p) == LG_OKAY) xTxLink(p);
+      else
+      {
+         free(p);
+         p = NULL;
+      }
 
       lgPthTxUnlock();
    }
@@ -295,7 +551,9 @@ lgTxRec_p lgGroupCreateWaveRec(
       p->type = LG_TX_WAVE;
       p->chip = chip;
       p->gpio = gpio;
+      p->head = 0;
       p->entries = 1;
+      p->heap_pos = -1;
       p->active = 1;
 
       p->pulses[0] = pulses;
@@ -304,16 +562,18 @@ lgTxRec_p lgGroupCreateWaveRec(
 
       lgPthTxLock();
 
-      p->next_micros = pthTxDelayMicros;
-      
-      p->prev = NULL;
-      p->next = txRec;
-      if (txRec) txRec->prev = p;
-      txRec = p;
+      p->deadline = pthTxNextMicros;
+
+      if (xHeapInsert(p) == LG_OKAY) xTxLink(p);
+      else
+      {
+         free(pulses);
+         free(p);
+         p = NULL;
+      }
 
       lgPthTxUnlock();
    }
 
    return p;
 }
-
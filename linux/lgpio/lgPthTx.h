@@ -35,14 +35,19 @@ For more information, please refer to <http://unlicense.org/>
 
 #define LG_TX_BUF 10
 
+/* entry i of a record's queue, 0 being the entry being transmitted */
+#define LG_TX_SLOT(p, i) (((p)->head + (i)) % LG_TX_BUF)
+
 typedef struct lgTxRec_s
 {
    int active;
    struct lgTxRec_s *prev;
    struct lgTxRec_s *next;
-   int next_micros;
+   int64_t deadline; /* absolute CLOCK_MONOTONIC micros of next edge */
+   int heap_pos;     /* index in the deadline heap, -1 if not queued */
    lgChipObj_p chip;
    int gpio;
+   int head;    /* ring index of the current entry */
    int entries; /* number of entries in LG_TX_BUF arrays */
    int type;    /* PWM or WAVE */
    union
@@ -82,5 +87,11 @@ void lgPthTxStop(lgChipObj_p chip);
 void lgPthTxLock(void);
 void lgPthTxUnlock(void);
 
+/* call with the tx lock held */
+void lgPthTxCancel(lgTxRec_p p);
+
+int lgPthTxSetPriority(int priority);
+int lgPthTxGetPriority(void);
+
 #endif
 
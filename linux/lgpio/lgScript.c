@@ -55,8 +55,99 @@ typedef struct
    cmdScript_t script;
    char user[LG_USER_LEN];
    int share;
+   struct scrOp_s *code;
 } lgScript_t, *lgScript_p;
 
+/* compiled script ops */
+
+enum
+{
+   SCR_OP_NOP,
+   SCR_OP_ADD,
+   SCR_OP_AND,
+   SCR_OP_CALL,
+   SCR_OP_CMP,
+   SCR_OP_DCR,
+   SCR_OP_DCRA,
+   SCR_OP_DIV,
+   SCR_OP_HALT,
+   SCR_OP_INR,
+   SCR_OP_INRA,
+   SCR_OP_JGE,
+   SCR_OP_JGT,
+   SCR_OP_JLE,
+   SCR_OP_JLT,
+   SCR_OP_JMP,
+   SCR_OP_JNZ,
+   SCR_OP_JZ,
+   SCR_OP_LD,
+   SCR_OP_LDA,
+   SCR_OP_MLT,
+   SCR_OP_MOD,
+   SCR_OP_OR,
+   SCR_OP_POP,
+   SCR_OP_POPA,
+   SCR_OP_PUSH,
+   SCR_OP_PUSHA,
+   SCR_OP_RET,
+   SCR_OP_RL,
+   SCR_OP_RLA,
+   SCR_OP_RR,
+   SCR_OP_RRA,
+   SCR_OP_SHL,
+   SCR_OP_SHLA,
+   SCR_OP_SHR,
+   SCR_OP_SHRA,
+   SCR_OP_STA,
+   SCR_OP_SUB,
+   SCR_OP_SYS,
+   SCR_OP_X,
+   SCR_OP_XA,
+   SCR_OP_XOR,
+
+   /* daemon commands called directly */
+
+   SCR_OP_GBUSY,
+   SCR_OP_GP,
+   SCR_OP_GPX,
+   SCR_OP_GR,
+   SCR_OP_GROOM,
+   SCR_OP_GW,
+   SCR_OP_I2CPC,
+   SCR_OP_I2CRB,
+   SCR_OP_I2CRS,
+   SCR_OP_I2CRW,
+   SCR_OP_I2CWB,
+   SCR_OP_I2CWQ,
+   SCR_OP_I2CWS,
+   SCR_OP_I2CWW,
+   SCR_OP_MICS,
+   SCR_OP_MILS,
+   SCR_OP_P,
+   SCR_OP_PX,
+   SCR_OP_S,
+   SCR_OP_SERDA,
+   SCR_OP_SERRB,
+   SCR_OP_SERWB,
+   SCR_OP_SX,
+
+   /* any other daemon command, marshalled through lgExecCmd */
+
+   SCR_OP_EXEC,
+
+   SCR_OPS
+};
+
+typedef struct scrOp_s
+{
+   const void *op;         /* handler address (direct threaded)  */
+   int opcode;             /* SCR_OP_x                           */
+   int cmd;                /* original LG_CMD_x                  */
+   int *a[CMD_MAX_ARG];    /* operands, point at k[], a v or a p */
+   int k[CMD_MAX_ARG];     /* numeric operands                   */
+   struct scrOp_s *jmp;    /* resolved jump or call target       */
+} scrOp_t, *scrOp_p;
+
 
 static void _scriptClose(lgScript_p s)
 {
@@ -65,6 +156,10 @@ static void _scriptClose(lgScript_p s)
    if (s->script.par) free(s->script.par);
 
    s->script.par = NULL;
+
+   if (s->code) free(s->code);
+
+   s->code = NULL;
 }
 
 
@@ -89,37 +184,6 @@ int myScriptNameValid(char *name)
    return valid;
 }
 
-static int scrPop(lgScript_p s, int *SP, int *S)
-{
-   if ((*SP) > 0)
-   {
-      return S[--(*SP)];
-   }
-   else
-   {
-      s->run_state = LG_SCRIPT_FAILED;
-      LG_DBG(LG_DEBUG_ALWAYS, "script %d too many pops", s->id);
-      return 0;
-   }
-}
-
-/* ----------------------------------------------------------------------- */
-
-static void scrPush(lgScript_p s, int *SP, int *S, int val)
-{
-   if ((*SP) < LG_SCRIPT_STACK_SIZE)
-   {
-      S[(*SP)++] = val;
-   }
-   else
-   {
-      s->run_state = LG_SCRIPT_FAILED;
-      LG_DBG(LG_DEBUG_ALWAYS, "script %d too many pushes", s->id);
-   }
-}
-
-/* ----------------------------------------------------------------------- */
-
 static void scrSwap(int *v1, int *v2)
 {
    int t;
@@ -171,302 +235,512 @@ static uint32_t xsr(uint32_t x, unsigned int n)
 
 /* ----------------------------------------------------------------------- */
 
-static void *pthScript(void *x)
+static int *xScrReg(lgScript_p s, cmdInstr_t *in, int i)
 {
-   lgScript_p s;
-   int i, t;
-   cmdInstr_t instr;
-   int32_t p0, p1, p0o, p1o, *t1, *t2;
-   int32_t PC, A, F, SP;
-   uint32_t tmp;
-   int S[LG_SCRIPT_STACK_SIZE];
-   lgCtx_p Ctx;
-   lgCmd_t cmdBuf[CMD_MAX_EXTENSION/sizeof(lgCmd_t)];
-   lgCmd_p cmdP=cmdBuf;
-   uint32_t *arg=(uint32_t*)&cmdP[1];
+   /* register operand, v or p, a bare number names a v */
 
-   Ctx = lgCtxGet();
+   if (in->opt[i] == CMD_PAR) return &s->script.par[in->arg[i]];
+   else                       return &s->script.var[in->arg[i]];
+}
 
-   if (!Ctx) return 0;
+static int *xScrVal(lgScript_p s, scrOp_p op, cmdInstr_t *in, int i)
+{
+   /* value operand, constants live in the op itself */
 
-   s = x;
+   if      (in->opt[i] == CMD_VAR) return &s->script.var[in->arg[i]];
+   else if (in->opt[i] == CMD_PAR) return &s->script.par[in->arg[i]];
 
-   strncpy(Ctx->user, s->user, LG_USER_LEN);
-   Ctx->autoUseShare = s->share;
+   op->k[i] = in->arg[i];
 
-   s->run_state = LG_SCRIPT_READY;
+   return &op->k[i];
+}
 
-   while ((volatile int)s->request != LG_SCRIPT_DELETE)
-   {
-      pthread_mutex_lock(&s->pthMutex);
-      if ((volatile int)s->request != LG_SCRIPT_DELETE)
-         pthread_cond_wait(&s->pthCond, &s->pthMutex);
-      s->run_state = LG_SCRIPT_RUNNING;
-      pthread_mutex_unlock(&s->pthMutex);
+/* ----------------------------------------------------------------------- */
 
-      A  = 0;
-      F  = 0;
-      PC = 0;
-      SP = 0;
+static int xScrCompile(lgScript_p s)
+{
+   int j, pc;
+   cmdInstr_t *in;
+   scrOp_p op;
 
-      while (((volatile int)s->request   == LG_SCRIPT_RUN    ) &&
-                           (s->run_state == LG_SCRIPT_RUNNING))
-      {
-         // get local copy of next instruction
+   /* one extra op, a halt, catches running off the end */
 
-         instr = s->script.instr[PC];
+   s->code = calloc(s->script.instrs + 1, sizeof(scrOp_t));
 
-         if (instr.cmd < LG_CMD_SCRIPT)
-         {
-            // parameter and variable substitution
+   if (s->code == NULL) return LG_NO_MEMORY;
 
-            for (i=0; i<CMD_MAX_OPT; i++)
+   for (pc=0; pc<s->script.instrs; pc++)
+   {
+      in = &s->script.instr[pc];
+      op = &s->code[pc];
+
+      op->cmd = in->cmd;
+
+      switch (in->cmd)
+      {
+         /* no operand */
+
+         case LG_CMD_DCRA:  op->opcode = SCR_OP_DCRA;  break;
+         case LG_CMD_HALT:  op->opcode = SCR_OP_HALT;  break;
+         case LG_CMD_INRA:  op->opcode = SCR_OP_INRA;  break;
+         case LG_CMD_NOP:   op->opcode = SCR_OP_NOP;   break;
+         case LG_CMD_POPA:  op->opcode = SCR_OP_POPA;  break;
+         case LG_CMD_PUSHA: op->opcode = SCR_OP_PUSHA; break;
+         case LG_CMD_RET:   op->opcode = SCR_OP_RET;   break;
+         case LG_CMD_SYS:   op->opcode = SCR_OP_SYS;   break;
+
+         /* one value */
+
+         case LG_CMD_ADD:   op->opcode = SCR_OP_ADD;  goto value;
+         case LG_CMD_AND:   op->opcode = SCR_OP_AND;  goto value;
+         case LG_CMD_CMP:   op->opcode = SCR_OP_CMP;  goto value;
+         case LG_CMD_DIV:   op->opcode = SCR_OP_DIV;  goto value;
+         case LG_CMD_LDA:   op->opcode = SCR_OP_LDA;  goto value;
+         case LG_CMD_MLT:   op->opcode = SCR_OP_MLT;  goto value;
+         case LG_CMD_MOD:   op->opcode = SCR_OP_MOD;  goto value;
+         case LG_CMD_OR:    op->opcode = SCR_OP_OR;   goto value;
+         case LG_CMD_RLA:   op->opcode = SCR_OP_RLA;  goto value;
+         case LG_CMD_RRA:   op->opcode = SCR_OP_RRA;  goto value;
+         case LG_CMD_SHLA:  op->opcode = SCR_OP_SHLA; goto value;
+         case LG_CMD_SHRA:  op->opcode = SCR_OP_SHRA; goto value;
+         case LG_CMD_SUB:   op->opcode = SCR_OP_SUB;  goto value;
+         case LG_CMD_XOR:   op->opcode = SCR_OP_XOR;  goto value;
+         value:
+            op->a[0] = xScrVal(s, op, in, 0);
+            break;
+
+         /* one register */
+
+         case LG_CMD_DCR:   op->opcode = SCR_OP_DCR;  goto reg;
+         case LG_CMD_INR:   op->opcode = SCR_OP_INR;  goto reg;
+         case LG_CMD_POP:   op->opcode = SCR_OP_POP;  goto reg;
+         case LG_CMD_PUSH:  op->opcode = SCR_OP_PUSH; goto reg;
+         case LG_CMD_STA:   op->opcode = SCR_OP_STA;  goto reg;
+         case LG_CMD_XA:    op->opcode = SCR_OP_XA;   goto reg;
+         reg:
+            op->a[0] = xScrReg(s, in, 0);
+            break;
+
+         /* register and value */
+
+         case LG_CMD_LD:    op->opcode = SCR_OP_LD;   goto regval;
+         case LG_CMD_RL:    op->opcode = SCR_OP_RL;   goto regval;
+         case LG_CMD_RR:    op->opcode = SCR_OP_RR;   goto regval;
+         case LG_CMD_SHL:   op->opcode = SCR_OP_SHL;  goto regval;
+         case LG_CMD_SHR:   op->opcode = SCR_OP_SHR;  goto regval;
+         regval:
+            op->a[0] = xScrReg(s, in, 0);
+            op->a[1] = xScrVal(s, op, in, 1);
+            break;
+
+         case LG_CMD_X:
+            op->opcode = SCR_OP_X;
+            op->a[0] = xScrReg(s, in, 0);
+            op->a[1] = xScrReg(s, in, 1);
+            break;
+
+         /* jumps, tags were resolved to steps by cmdParseScript */
+
+         case LG_CMD_CALL:  op->opcode = SCR_OP_CALL; goto jump;
+         case LG_CMD_JGE:   op->opcode = SCR_OP_JGE;  goto jump;
+         case LG_CMD_JGT:   op->opcode = SCR_OP_JGT;  goto jump;
+         case LG_CMD_JLE:   op->opcode = SCR_OP_JLE;  goto jump;
+         case LG_CMD_JLT:   op->opcode = SCR_OP_JLT;  goto jump;
+         case LG_CMD_JMP:   op->opcode = SCR_OP_JMP;  goto jump;
+         case LG_CMD_JNZ:   op->opcode = SCR_OP_JNZ;  goto jump;
+         case LG_CMD_JZ:    op->opcode = SCR_OP_JZ;   goto jump;
+         jump:
+            if (in->arg[0] > s->script.instrs) return LG_BAD_TAG;
+            op->jmp = &s->code[in->arg[0]];
+            break;
+
+         /* commands called directly */
+
+         case LG_CMD_GBUSY: op->opcode = SCR_OP_GBUSY; goto cmd;
+         case LG_CMD_GP:    op->opcode = SCR_OP_GP;    goto cmd;
+         case LG_CMD_GPX:   op->opcode = SCR_OP_GPX;   goto cmd;
+         case LG_CMD_GR:    op->opcode = SCR_OP_GR;    goto cmd;
+         case LG_CMD_GROOM: op->opcode = SCR_OP_GROOM; goto cmd;
+         case LG_CMD_GW:    op->opcode = SCR_OP_GW;    goto cmd;
+         case LG_CMD_I2CPC: op->opcode = SCR_OP_I2CPC; goto cmd;
+         case LG_CMD_I2CRB: op->opcode = SCR_OP_I2CRB; goto cmd;
+         case LG_CMD_I2CRS: op->opcode = SCR_OP_I2CRS; goto cmd;
+         case LG_CMD_I2CRW: op->opcode = SCR_OP_I2CRW; goto cmd;
+         case LG_CMD_I2CWB: op->opcode = SCR_OP_I2CWB; goto cmd;
+         case LG_CMD_I2CWQ: op->opcode = SCR_OP_I2CWQ; goto cmd;
+         case LG_CMD_I2CWS: op->opcode = SCR_OP_I2CWS; goto cmd;
+         case LG_CMD_I2CWW: op->opcode = SCR_OP_I2CWW; goto cmd;
+         case LG_CMD_MICS:  op->opcode = SCR_OP_MICS;  goto cmd;
+         case LG_CMD_MILS:  op->opcode = SCR_OP_MILS;  goto cmd;
+         case LG_CMD_P:     op->opcode = SCR_OP_P;     goto cmd;
+         case LG_CMD_PX:    op->opcode = SCR_OP_PX;    goto cmd;
+         case LG_CMD_S:     op->opcode = SCR_OP_S;     goto cmd;
+         case LG_CMD_SERDA: op->opcode = SCR_OP_SERDA; goto cmd;
+         case LG_CMD_SERRB: op->opcode = SCR_OP_SERRB; goto cmd;
+         case LG_CMD_SERWB: op->opcode = SCR_OP_SERWB; goto cmd;
+         case LG_CMD_SX:    op->opcode = SCR_OP_SX;    goto cmd;
+         cmd:
+            for (j=0; j<CMD_MAX_ARG; j++) op->a[j] = xScrVal(s, op, in, j);
+            break;
+
+         default:
+            if (in->cmd < LG_CMD_SCRIPT)
             {
-               t = instr.arg[i];
-               if      (instr.opt[i] == CMD_VAR) instr.arg[i] = s->script.var[t];
-               else if (instr.opt[i] == CMD_PAR) instr.arg[i] = s->script.par[t];
-            }
+               /* anything needing a permit check goes via lgExecCmd */
 
-            fprintf(stderr, "PC=%d cmd=%d p0=%d p1=%d p2=%d p3=%d\n",
-               PC, instr.cmd,
-               instr.arg[0], instr.arg[1], instr.arg[2], instr.arg[3]);
+               op->opcode = SCR_OP_EXEC;
+               for (j=0; j<CMD_MAX_ARG; j++) op->a[j] = xScrVal(s, op, in, j);
+            }
+            else
+            {
+               /* CMDR CMDW LDAB STAB were never implemented */
 
-            fflush(stderr);
+               LG_DBG(LG_DEBUG_ALWAYS, "script command %d not supported",
+                  in->cmd);
 
-            cmdP->magic = LG_MAGIC;
-            cmdP->size = 0;
-            cmdP->cmd = instr.cmd;
-            cmdP->doubles = 0;
-            cmdP->longs = 0;
-            cmdP->shorts = 0;
+               return LG_BAD_SCRIPT_CMD;
+            }
+            break;
+      }
+   }
 
-            for (i=0; i<CMD_MAX_ARG; i++) arg[i] = instr.arg[i];
+   s->code[pc].opcode = SCR_OP_HALT;
 
-            A = lgExecCmd(cmdBuf, sizeof(cmdBuf));
+   return LG_OKAY;
+}
 
-            F = A;
+/* ----------------------------------------------------------------------- */
 
-            PC++;
-         }
-         else
-         {
-            p0o = instr.arg[0];
-            p1o = instr.arg[1];
+static void xScrTrace(lgScript_p s, scrOp_p ip, int A, int F)
+{
+   LG_DBG(LG_DEBUG_SCRIPT, "script %d PC=%d cmd=%d A=%d F=%d",
+      s->id, (int)(ip - s->code), ip->cmd, A, F);
+}
 
-            // parameter and variable substitution
+/* ----------------------------------------------------------------------- */
 
-            for (i=0; i<2; i++) // maximum of two parameters
-            {
-               t = instr.arg[i];
-               if      (instr.opt[i] == CMD_VAR) instr.arg[i] = s->script.var[t];
-               else if (instr.opt[i] == CMD_PAR) instr.arg[i] = s->script.par[t];
-            }
+static void xScrExec(lgScript_p s, int trace)
+{
+   static const void *dispatch[SCR_OPS] =
+   {
+      [SCR_OP_NOP]   = &&op_nop,
+      [SCR_OP_ADD]   = &&op_add,
+      [SCR_OP_AND]   = &&op_and,
+      [SCR_OP_CALL]  = &&op_call,
+      [SCR_OP_CMP]   = &&op_cmp,
+      [SCR_OP_DCR]   = &&op_dcr,
+      [SCR_OP_DCRA]  = &&op_dcra,
+      [SCR_OP_DIV]   = &&op_div,
+      [SCR_OP_HALT]  = &&op_halt,
+      [SCR_OP_INR]   = &&op_inr,
+      [SCR_OP_INRA]  = &&op_inra,
+      [SCR_OP_JGE]   = &&op_jge,
+      [SCR_OP_JGT]   = &&op_jgt,
+      [SCR_OP_JLE]   = &&op_jle,
+      [SCR_OP_JLT]   = &&op_jlt,
+      [SCR_OP_JMP]   = &&op_jmp,
+      [SCR_OP_JNZ]   = &&op_jnz,
+      [SCR_OP_JZ]    = &&op_jz,
+      [SCR_OP_LD]    = &&op_ld,
+      [SCR_OP_LDA]   = &&op_lda,
+      [SCR_OP_MLT]   = &&op_mlt,
+      [SCR_OP_MOD]   = &&op_mod,
+      [SCR_OP_OR]    = &&op_or,
+      [SCR_OP_POP]   = &&op_pop,
+      [SCR_OP_POPA]  = &&op_popa,
+      [SCR_OP_PUSH]  = &&op_push,
+      [SCR_OP_PUSHA] = &&op_pusha,
+      [SCR_OP_RET]   = &&op_ret,
+      [SCR_OP_RL]    = &&op_rl,
+      [SCR_OP_RLA]   = &&op_rla,
+      [SCR_OP_RR]    = &&op_rr,
+      [SCR_OP_RRA]   = &&op_rra,
+      [SCR_OP_SHL]   = &&op_shl,
+      [SCR_OP_SHLA]  = &&op_shla,
+      [SCR_OP_SHR]   = &&op_shr,
+      [SCR_OP_SHRA]  = &&op_shra,
+      [SCR_OP_STA]   = &&op_sta,
+      [SCR_OP_SUB]   = &&op_sub,
+      [SCR_OP_SYS]   = &&op_sys,
+      [SCR_OP_X]     = &&op_x,
+      [SCR_OP_XA]    = &&op_xa,
+      [SCR_OP_XOR]   = &&op_xor,
+      [SCR_OP_GBUSY] = &&op_gbusy,
+      [SCR_OP_GP]    = &&op_gp,
+      [SCR_OP_GPX]   = &&op_gpx,
+      [SCR_OP_GR]    = &&op_gr,
+      [SCR_OP_GROOM] = &&op_groom,
+      [SCR_OP_GW]    = &&op_gw,
+      [SCR_OP_I2CPC] = &&op_i2cpc,
+      [SCR_OP_I2CRB] = &&op_i2crb,
+      [SCR_OP_I2CRS] = &&op_i2crs,
+      [SCR_OP_I2CRW] = &&op_i2crw,
+      [SCR_OP_I2CWB] = &&op_i2cwb,
+      [SCR_OP_I2CWQ] = &&op_i2cwq,
+      [SCR_OP_I2CWS] = &&op_i2cws,
+      [SCR_OP_I2CWW] = &&op_i2cww,
+      [SCR_OP_MICS]  = &&op_mics,
+      [SCR_OP_MILS]  = &&op_mils,
+      [SCR_OP_P]     = &&op_p,
+      [SCR_OP_PX]    = &&op_px,
+      [SCR_OP_S]     = &&op_s,
+      [SCR_OP_SERDA] = &&op_serda,
+      [SCR_OP_SERRB] = &&op_serrb,
+      [SCR_OP_SERWB] = &&op_serwb,
+      [SCR_OP_SX]    = &&op_sx,
+      [SCR_OP_EXEC]  = &&op_exec,
+   };
+
+   int i, t, A, F, SP;
+   uint32_t tmp;
+   int S[LG_SCRIPT_STACK_SIZE];
+   scrOp_p ip;
+   lgCmd_t cmdBuf[CMD_MAX_EXTENSION/sizeof(lgCmd_t)];
+   lgCmd_p cmdP=cmdBuf;
+   uint32_t *arg=(uint32_t*)&cmdP[1];
 
-            p0 = instr.arg[0];
-            p1 = instr.arg[1];
+   /* thread the code on first use, label addresses are only
+      known inside this function */
 
-            fprintf(stderr, "PC=%d cmd=%d p0=%d p0o=%d p1=%d p1o=%d\n",
-               PC, instr.cmd,
-               instr.arg[0], p0o, instr.arg[1], p1o);
+   if (s->code[0].op == NULL)
+   {
+      for (i=0; i<=s->script.instrs; i++)
+         s->code[i].op = dispatch[s->code[i].opcode];
+   }
 
-            fflush(stderr);
+   A  = 0;
+   F  = 0;
+   SP = 0;
+
+   ip = s->code;
+
+/* operands */
+
+#define V0 (*ip->a[0])
+#define V1 (*ip->a[1])
+#define V(n) ((uint32_t)*ip->a[n])
+
+#define DISPATCH()                                                 \
+   do                                                              \
+   {                                                               \
+      if (trace) xScrTrace(s, ip, A, F);                           \
+      goto *ip->op;                                                \
+   }                                                               \
+   while (0)
+
+#define NEXT() do { ip++; DISPATCH(); } while (0)
+
+/* stop and halt requests are only looked at when control transfers
+   or after a command, straight line code always runs to the next */
+
+#define CHECK()                                                    \
+   do                                                              \
+   {                                                               \
+      if (((volatile int)s->request != LG_SCRIPT_RUN) ||           \
+          ((volatile int)s->run_state != LG_SCRIPT_RUNNING))       \
+         return;                                                   \
+   }                                                               \
+   while (0)
+
+#define JUMP(target) do { ip = (target); CHECK(); DISPATCH(); } while (0)
+
+#define RESULT(res) do { A = (res); F = A; ip++; CHECK(); DISPATCH(); } while (0)
+
+#define PUSH(val)                                                  \
+   do                                                              \
+   {                                                               \
+      if (SP >= LG_SCRIPT_STACK_SIZE)                              \
+      {                                                            \
+         LG_DBG(LG_DEBUG_ALWAYS, "script %d too many pushes", s->id); \
+         goto failed;                                              \
+      }                                                            \
+      S[SP++] = (val);                                             \
+   }                                                               \
+   while (0)
+
+#define POP(var)                                                   \
+   do                                                              \
+   {                                                               \
+      if (SP <= 0)                                                 \
+      {                                                            \
+         LG_DBG(LG_DEBUG_ALWAYS, "script %d too many pops", s->id); \
+         goto failed;                                              \
+      }                                                            \
+      (var) = S[--SP];                                             \
+   }                                                               \
+   while (0)
+
+   DISPATCH();
+
+   op_nop:   NEXT();
+
+   op_add:   A += V0; F = A; NEXT();
+   op_and:   A &= V0; F = A; NEXT();
+   op_cmp:   F = A - V0; NEXT();
+   op_dcra:  --A; F = A; NEXT();
+   op_inra:  ++A; F = A; NEXT();
+   op_lda:   A = V0; NEXT();
+   op_mlt:   A *= V0; F = A; NEXT();
+   op_or:    A |= V0; F = A; NEXT();
+   op_rla:   A = xrl(A, V0); F = A; NEXT();
+   op_rra:   A = xrr(A, V0); F = A; NEXT();
+   op_shla:  A = xsl(A, V0); F = A; NEXT();
+   op_shra:  A = xsr(A, V0); F = A; NEXT();
+   op_sub:   A -= V0; F = A; NEXT();
+   op_xor:   A ^= V0; F = A; NEXT();
+
+   op_div:
+      if (!V0) goto divzero;
+      A /= V0; F = A; NEXT();
+
+   op_mod:
+      if (!V0) goto divzero;
+      A %= V0; F = A; NEXT();
+
+   op_dcr:   F = --V0; NEXT();
+   op_inr:   F = ++V0; NEXT();
+   op_sta:   V0 = A; NEXT();
+   op_xa:    scrSwap(ip->a[0], &A); NEXT();
+   op_x:     scrSwap(ip->a[0], ip->a[1]); NEXT();
+
+   op_ld:    V0 = V1; NEXT();
+   op_rl:    tmp = xrl(V0, V1); V0 = tmp; F = tmp; NEXT();
+   op_rr:    tmp = xrr(V0, V1); V0 = tmp; F = tmp; NEXT();
+   op_shl:   tmp = xsl(V0, V1); V0 = tmp; F = tmp; NEXT();
+   op_shr:   tmp = xsr(V0, V1); V0 = tmp; F = tmp; NEXT();
+
+   op_push:  PUSH(V0); NEXT();
+   op_pusha: PUSH(A); NEXT();
+   op_pop:   POP(V0); NEXT();
+   op_popa:  POP(A); NEXT();
+
+   op_sys:   F = A; NEXT();
+
+   op_jmp:   JUMP(ip->jmp);
+   op_jz:    JUMP(!F     ? ip->jmp : ip+1);
+   op_jnz:   JUMP(F      ? ip->jmp : ip+1);
+   op_jge:   JUMP(F >= 0 ? ip->jmp : ip+1);
+   op_jgt:   JUMP(F >  0 ? ip->jmp : ip+1);
+   op_jle:   JUMP(F <= 0 ? ip->jmp : ip+1);
+   op_jlt:   JUMP(F <  0 ? ip->jmp : ip+1);
+
+   op_call:
+      PUSH((ip - s->code) + 1);
+      JUMP(ip->jmp);
+
+   op_ret:
+      POP(t);
+      if ((t < 0) || (t > s->script.instrs)) t = s->script.instrs;
+      JUMP(&s->code[t]);
+
+   op_halt:
+      s->run_state = LG_SCRIPT_ENDED;
+      return;
+
+   /* commands, argument handling mirrors lgExecCmd */
+
+   op_gbusy: RESULT(lgTxBusy(V(0), V(1), V(2)));
+   op_groom: RESULT(lgTxRoom(V(0), V(1), V(2)));
+   op_gp:    RESULT(lgTxPulse(V(0), V(1), V(2), V(3), 0, 0));
+   op_gpx:   RESULT(lgTxPulse(V(0), V(1), V(2), V(3), V(4), V(5)));
+   op_gr:    RESULT(lgGpioRead(V(0), V(1)));
+   op_gw:    RESULT(lgGpioWrite(V(0), V(1), V(2)));
+
+   op_p:
+      RESULT(lgTxPwm(V(0), V(1), V(2)/1000.0, V(3)/1000.0, 0, 0));
+
+   op_px:
+      RESULT(lgTxPwm(V(0), V(1), V(2)/1000.0, V(3)/1000.0, V(4), V(5)));
+
+   op_s:     RESULT(lgTxServo(V(0), V(1), V(2), 50, 0, 0));
+   op_sx:    RESULT(lgTxServo(V(0), V(1), V(2), V(3), V(4), V(5)));
+
+   op_i2cpc: RESULT(lgI2cProcessCall(V(0), V(1), V(2)));
+   op_i2crb: RESULT(lgI2cReadByteData(V(0), V(1)));
+   op_i2crs: RESULT(lgI2cReadByte(V(0)));
+   op_i2crw: RESULT(lgI2cReadWordData(V(0), V(1)));
+   op_i2cwb: RESULT(lgI2cWriteByteData(V(0), V(1), V(2)));
+   op_i2cwq: RESULT(lgI2cWriteQuick(V(0), V(1)));
+   op_i2cws: RESULT(lgI2cWriteByte(V(0), V(1)));
+   op_i2cww: RESULT(lgI2cWriteWordData(V(0), V(1), V(2)));
+
+   op_serda: RESULT(lgSerialDataAvailable(V(0)));
+   op_serrb: RESULT(lgSerialReadByte(V(0)));
+   op_serwb: RESULT(lgSerialWriteByte(V(0), V(1)));
+
+   op_mics:
+      if (V(0) > LG_MAX_MICS_DELAY) RESULT(LG_BAD_MICS_DELAY);
+      lguSleep(V(0)/1E6);
+      RESULT(LG_OKAY);
+
+   op_mils:
+      if (V(0) > LG_MAX_MILS_DELAY) RESULT(LG_BAD_MILS_DELAY);
+      lguSleep(V(0)/1E3);
+      RESULT(LG_OKAY);
+
+   op_exec:
+      cmdP->magic = LG_MAGIC;
+      cmdP->size = 0;
+      cmdP->cmd = ip->cmd;
+      cmdP->doubles = 0;
+      cmdP->longs = 0;
+      cmdP->shorts = 0;
+
+      for (i=0; i<CMD_MAX_ARG; i++) arg[i] = V(i);
+
+      RESULT(lgExecCmd(cmdBuf, sizeof(cmdBuf)));
+
+   divzero:
+      LG_DBG(LG_DEBUG_ALWAYS, "script %d divide by zero", s->id);
+
+   failed:
+      s->run_state = LG_SCRIPT_FAILED;
+      return;
+
+#undef V0
+#undef V1
+#undef V
+#undef DISPATCH
+#undef NEXT
+#undef CHECK
+#undef JUMP
+#undef RESULT
+#undef PUSH
+#undef POP
+}
 
-            switch (instr.cmd)
-            {
-               case LG_CMD_ADD:   A+=p0; F=A;                     PC++; break;
+/* ----------------------------------------------------------------------- */
 
-               case LG_CMD_AND:   A&=p0; F=A;                     PC++; break;
+static void *pthScript(void *x)
+{
+   lgScript_p s;
+   lgCtx_p Ctx;
 
-               case LG_CMD_CALL:  scrPush(s, &SP, S, PC+1);    PC = p0; break;
+   Ctx = lgCtxGet();
 
-               case LG_CMD_CMP:   F=A-p0;                         PC++; break;
+   if (!Ctx) return 0;
 
-               case LG_CMD_DCR:
-                  if (instr.opt[0] == CMD_PAR)
-                     {--s->script.par[p0o]; F=s->script.par[p0o];}
-                  else
-                     {--s->script.var[p0o]; F=s->script.var[p0o];}
-                  PC++;
-                  break;
+   s = x;
 
-               case LG_CMD_DCRA:  --A; F=A;                       PC++; break;
+   strncpy(Ctx->user, s->user, LG_USER_LEN);
+   Ctx->autoUseShare = s->share;
 
-               case LG_CMD_DIV:   A/=p0; F=A;                     PC++; break;
+   /* directly called commands need the owner and permits lgExecCmd sets */
 
-               case LG_CMD_HALT:  s->run_state = LG_SCRIPT_ENDED;       break;
+   lgExecCtxInit(Ctx);
 
-               case LG_CMD_INR:
-                  if (instr.opt[0] == CMD_PAR)
-                     {++s->script.par[p0o]; F=s->script.par[p0o];}
-                  else
-                     {++s->script.var[p0o]; F=s->script.var[p0o];}
-                  PC++;
-                  break;
-
-               case LG_CMD_INRA:  ++A; F=A;                       PC++; break;
-
-               case LG_CMD_JLE:   if (F<=0) PC=p0; else PC++;           break;
-
-               case LG_CMD_JLT:   if (F<0)  PC=p0; else PC++;           break;
-
-               case LG_CMD_JMP:   PC=p0;                                break;
-
-               case LG_CMD_JNZ:   if (F)    PC=p0; else PC++;           break;
-
-               case LG_CMD_JGE:   if (F>=0) PC=p0; else PC++;           break;
-
-               case LG_CMD_JGT:   if (F>0)  PC=p0; else PC++;           break;
-
-               case LG_CMD_JZ:    if (!F)   PC=p0; else PC++;           break;
-
-               case LG_CMD_LD:
-                  if (instr.opt[0] == CMD_PAR) s->script.par[p0o]=p1;
-                  else                         s->script.var[p0o]=p1;
-                  PC++;
-                  break;
-
-               case LG_CMD_LDA:   A=p0;                           PC++; break;
-
-               case LG_CMD_MLT:   A*=p0; F=A;                     PC++; break;
-
-               case LG_CMD_MOD:   A%=p0; F=A;                     PC++; break;
-
-               case LG_CMD_OR:    A|=p0; F=A;                     PC++; break;
-
-               case LG_CMD_POP:
-                  if (instr.opt[0] == CMD_PAR)
-                     s->script.par[p0o]=scrPop(s, &SP, S);
-                  else
-                     s->script.var[p0o]=scrPop(s, &SP, S);
-                  PC++;
-                  break;
-
-               case LG_CMD_POPA:  A=scrPop(s, &SP, S);            PC++; break;
-
-               case LG_CMD_PUSH:
-                  if (instr.opt[0] == CMD_PAR)
-                     scrPush(s, &SP, S, s->script.par[p0o]);
-                  else
-                     scrPush(s, &SP, S, s->script.var[p0o]);
-                  PC++;
-                  break;
-
-               case LG_CMD_PUSHA: scrPush(s, &SP, S, A);          PC++; break;
-
-               case LG_CMD_RET:   PC=scrPop(s, &SP, S);                 break;
-
-               case LG_CMD_RL:
-                  if (instr.opt[0] == CMD_PAR)
-                  {
-                     tmp = xrl(s->script.par[p0o], p1);
-                     s->script.par[p0o] = tmp;
-                     F=tmp;
-                  }
-                  else
-                  {
-                     tmp = xrl(s->script.var[p0o], p1);
-                     s->script.var[p0o] = tmp;
-                     F=tmp;
-                  }
-                  PC++;
-                  break;
-
-               case LG_CMD_RLA:   A=xrl(A, p0); F=A;              PC++; break;
-
-               case LG_CMD_RR:
-                  if (instr.opt[0] == CMD_PAR)
-                  {
-                     tmp = xrr(s->script.par[p0o], p1);
-                     s->script.par[p0o] = tmp;
-                     F=tmp;
-                  }
-                  else
-                  {
-                     tmp = xrr(s->script.var[p0o], p1);
-                     s->script.var[p0o] = tmp;
-                     F=tmp;
-                  }
-                  PC++;
-                  break;
-
-               case LG_CMD_RRA:   A=xrr(A, p0); F=A;              PC++; break;
-
-               case LG_CMD_SHL:
-                  if (instr.opt[0] == CMD_PAR)
-                  {
-                     tmp = xsl(s->script.par[p0o], p1);
-                     s->script.par[p0o] = tmp;
-                     F=tmp;
-                  }
-                  else
-                  {
-                     tmp = xsl(s->script.var[p0o], p1);
-                     s->script.var[p0o] = tmp;
-                     F=tmp;
-                  }
-                  PC++;
-                  break;
-
-               case LG_CMD_SHLA:   A=xsl(A, p0); F=A;              PC++; break;
-
-               case LG_CMD_SHR:
-                  if (instr.opt[0] == CMD_PAR)
-                  {
-                     tmp = xsr(s->script.par[p0o], p1);
-                     s->script.par[p0o] = tmp;
-                     F=tmp;
-                  }
-                  else
-                  {
-                     tmp = xsr(s->script.var[p0o], p1);
-                     s->script.var[p0o] = tmp;
-                     F=tmp;
-                  }
-                  PC++;
-                  break;
-
-               case LG_CMD_SHRA:   A=xsr(A, p0); F=A;              PC++; break;
-
-               case LG_CMD_STA:
-                  if (instr.opt[0] == CMD_PAR) s->script.par[p0o]=A;
-                  else                         s->script.var[p0o]=A;
-                  PC++;
-                  break;
-
-               case LG_CMD_SUB:   A-=p0; F=A;                     PC++; break;
-
-               case LG_CMD_SYS:
-                  //A=scrSys((char*)instr.arg[4], A, 0);
-                  F=A;
-                  PC++;
-                  break;
-
-               case LG_CMD_X:
-                  if (instr.opt[0] == CMD_PAR) t1 = &s->script.par[p0o];
-                  else                         t1 = &s->script.var[p0o];
-
-                  if (instr.opt[1] == CMD_PAR) t2 = &s->script.par[p1o];
-                  else                         t2 = &s->script.var[p1o];
-
-                  scrSwap(t1, t2);
-                  PC++;
-                  break;
-
-               case LG_CMD_XA:
-                  if (instr.opt[0] == CMD_PAR)
-                     scrSwap(&s->script.par[p0o], &A);
-                  else
-                     scrSwap(&s->script.var[p0o], &A);
-                  PC++;
-                  break;
-
-               case LG_CMD_XOR:   A^=p0; F=A;                     PC++; break;
+   s->run_state = LG_SCRIPT_READY;
 
-            }
-         }
+   while ((volatile int)s->request != LG_SCRIPT_DELETE)
+   {
+      pthread_mutex_lock(&s->pthMutex);
+      if ((volatile int)s->request != LG_SCRIPT_DELETE)
+         pthread_cond_wait(&s->pthCond, &s->pthMutex);
+      s->run_state = LG_SCRIPT_RUNNING;
+      pthread_mutex_unlock(&s->pthMutex);
 
-         if (PC >= s->script.instrs) s->run_state = LG_SCRIPT_ENDED;
-      }
+      if ((volatile int)s->request == LG_SCRIPT_RUN)
+         xScrExec(s, (lgDbgLevel & LG_DEBUG_SCRIPT) == LG_DEBUG_SCRIPT);
 
       if (((volatile int)s->request == LG_SCRIPT_HALT)  ||
           ((volatile int)s->request == LG_SCRIPT_DELETE))
@@ -548,6 +822,8 @@ int lgScriptStore(char *script)
 
    status = cmdParseScript(script, &s->script, 0);
 
+   if (status == 0) status = xScrCompile(s);
+
    if (status == 0)
    {
       /* set the owner's user and share */
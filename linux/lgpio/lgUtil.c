@@ -35,6 +35,7 @@ For more information, please refer to <http://unlicense.org/>
 #include "lgpio.h"
 
 #include "lgDbg.h"
+#include "lgPthTx.h"
 
 static char xConfigDir[LG_MAX_PATH];
 static char xWorkDir[LG_MAX_PATH];
@@ -215,6 +216,9 @@ int lguSetInternal(int cfgId, uint64_t cfgVal)
          else return LG_BAD_CONFIG_VALUE;
          break;
 
+      case LG_CFG_ID_TX_PRIORITY:
+         return lgPthTxSetPriority(cfgVal);
+
       default:
          return LG_BAD_CONFIG_ID;
    }
@@ -235,6 +239,10 @@ int lguGetInternal(int cfgId, uint64_t *cfgVal)
          *cfgVal = lgMinTxDelay;
          break;
 
+      case LG_CFG_ID_TX_PRIORITY:
+         *cfgVal = lgPthTxGetPriority();
+         break;
+
       default:
          *cfgVal = 0;
          return LG_BAD_CONFIG_ID;
@@ -108,6 +108,7 @@ lgTxServo                    Starts Servo pulses on a GPIO
 lgTxWave                     Starts a wave on a group of GPIO
 lgTxBusy                     See if tx is active on a GPIO or group
 lgTxRoom                     See if more room for tx on a GPIO or group
+lgTxJitter                   Gets the tx thread wake latency histogram
 
 lgGpioSetDebounce            Sets the debounce time for a GPIO
 lgGpioSetWatchdog            Sets the watchdog time for a GPIO
@@ -219,6 +220,7 @@ extern "C" {
 
 #define LG_CFG_ID_DEBUG_LEVEL 0
 #define LG_CFG_ID_MIN_DELAY   1
+#define LG_CFG_ID_TX_PRIORITY 2
 
 #define LG_MAX_PATH 1024
 
@@ -311,6 +313,8 @@ extern "C" {
 #define LG_TX_PWM 0
 #define LG_TX_WAVE 1
 
+#define LG_TX_JITTER_BINS 16
+
 #define LG_MAX_MICS_DEBOUNCE   5000000 /* 5 seconds */
 #define LG_MAX_MICS_WATCHDOG 300000000 /* 5 minutes */
 
@@ -1252,6 +1256,34 @@ while (lgTxRoom(h, 17, LG_TX_WAVE) > 0))
 ...
 D*/
 
+/*F*/
+int lgTxJitter(uint32_t *histogram, int clear);
+/*D
+This returns the wake latency of the thread which generates
+PWM, servo and wave edges.
+
+. .
+histogram: an array of LG_TX_JITTER_BINS counts, may be NULL
+    clear: if non-zero the statistics are reset after being read
+. .
+
+Each time the tx thread wakes for an edge the lateness against
+the scheduled time is counted in the histogram.  Bin 0 counts
+wakes less than 1 microsecond late, bin n counts wakes 2^(n-1)
+to 2^n-1 microseconds late.  The last bin counts anything later.
+
+Returns the worst lateness seen in microseconds.
+
+The tx thread may be run under SCHED_FIFO by setting
+LG_CFG_ID_TX_PRIORITY with [*lguSetInternal*].
+
+...
+uint32_t hist[LG_TX_JITTER_BINS];
+
+worst = lgTxJitter(hist, 1);
+...
+D*/
+
 /*F*/
 int lgGpioSetDebounce(int handle, int gpio, int debounce_us);
 /*D
@@ -2515,8 +2547,12 @@ A number identifying a configuration item.
 . .
 LG_CFG_ID_DEBUG_LEVEL 0
 LG_CFG_ID_MIN_DELAY   1
+LG_CFG_ID_TX_PRIORITY 2
 . .
 
+LG_CFG_ID_TX_PRIORITY is the SCHED_FIFO priority (1-99) of the
+PWM/wave thread, 0 for normal scheduling.
+
 cfgVal::
 The value of a configuration item.
 
@@ -2529,6 +2565,9 @@ A single character, an 8 bit quantity able to store 0-255.
 chipInfo::
 A pointer to a lgChipInfo_t object.
 
+clear::
+If non-zero the statistics are cleared after being read.
+
 count::
 The number of items.
 
@@ -2603,6 +2642,9 @@ A number referencing an object opened by one of
 [*lgSerialOpen*] 
 [*lgSpiOpen*]
 
+*histogram::
+An array of LG_TX_JITTER_BINS counts.
+
 i2cAddr:: 0-0x7F
 The address of a device on the I2C bus.
 
@@ -0,0 +1,273 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+/*
+Renders a trace written by lgDbgTraceDump (e.g. rgpiod -t file,
+dumped on SIGUSR1) as the text LG_DBG would have printed.
+
+lgtrace file
+
+The trace must be rendered on a machine of the same architecture
+as the one which recorded it.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include "lgpio.h"
+#include "lgDbg.h"
+
+typedef struct
+{
+   char *func;
+   char *format;
+} traceSite_t;
+
+static traceSite_t *sites;
+static uint32_t numSites;
+
+static char *xReadStr(FILE *f)
+{
+   uint16_t len;
+   char *str;
+
+   if (fread(&len, sizeof(len), 1, f) != 1) return NULL;
+
+   str = malloc(len + 1);
+
+   if (!str) return NULL;
+
+   if (len && (fread(str, len, 1, f) != 1)) {free(str); return NULL;}
+
+   str[len] = 0;
+
+   return str;
+}
+
+static void xStrArg(lgDbgTraceRec_t *rec, uint64_t arg, char *buf, int size)
+{
+   int off, len, i, pos, v;
+
+   off = LG_DBG_STR_OFF(arg);
+   len = LG_DBG_STR_LEN(arg);
+
+   if ((off + len) > LG_DBG_TRACE_STR) len = 0;
+
+   buf[0] = 0;
+
+   switch (LG_DBG_STR_KIND(arg))
+   {
+      case LG_DBG_STR_HEX: /* as lgDbgBuf2Str */
+         for (i=0, pos=0; i<len; i++)
+            pos += sprintf(buf+pos, "%02X ", (unsigned char)rec->str[off+i]);
+         if (pos) buf[pos-1] = 0;
+         break;
+
+      case LG_DBG_STR_INTS: /* as lgDbgInt2Str */
+         for (i=0, pos=0; (i+sizeof(int))<=len; i+=sizeof(int))
+         {
+            memcpy(&v, rec->str+off+i, sizeof(int));
+            pos += sprintf(buf+pos, "%d ", v);
+            if (pos > 100) break;
+         }
+         break;
+
+      default:
+         if (len >= size) len = size - 1;
+         memcpy(buf, rec->str+off, len);
+         buf[len] = 0;
+         break;
+   }
+}
+
+#define XPRINT(val)                                                \
+   do                                                              \
+   {                                                               \
+      if (stars == 0)      printf(spec, val);                      \
+      else if (stars == 1) printf(spec, star[0], val);             \
+      else                 printf(spec, star[0], star[1], val);    \
+   }                                                               \
+   while (0)
+
+static void xRender(lgDbgTraceRec_t *rec)
+{
+   const char *p, *start;
+   char spec[64], str[512];
+   int type, stars, star[2], a, i, n;
+   uint64_t v;
+   double d;
+
+   if (!rec->site || (rec->site > numSites) || !sites[rec->site].format)
+   {
+      printf("unknown site %"PRIu32"\n", rec->site);
+      return;
+   }
+
+   printf("[%"PRIu32"] %s: ", rec->thread, sites[rec->site].func);
+
+   p = sites[rec->site].format;
+   a = 0;
+
+   while (*p)
+   {
+      if (*p != '%') {putchar(*p++); continue;}
+
+      start = p;
+      type = lgDbgFormatArg(&p, &stars);
+
+      if (type == LG_DBG_ARG_NONE)
+      {
+         if (start[1] == '%') putchar('%');
+         continue;
+      }
+
+      n = p - start;
+      if (n >= sizeof(spec)) n = sizeof(spec) - 1;
+      memcpy(spec, start, n);
+      spec[n] = 0;
+
+      for (i=0; i<stars; i++)
+         star[i] = (a < LG_DBG_TRACE_ARGS) ? (int)rec->arg[a++] : 0;
+
+      if (a >= LG_DBG_TRACE_ARGS) {putchar('?'); continue;}
+
+      v = rec->arg[a++];
+
+      switch (type)
+      {
+         case LG_DBG_ARG_INT:     XPRINT((int)v);                 break;
+         case LG_DBG_ARG_LONG:    XPRINT((long)v);                break;
+         case LG_DBG_ARG_LLONG:   XPRINT((long long)v);           break;
+         case LG_DBG_ARG_SIZE:    XPRINT((size_t)v);              break;
+         case LG_DBG_ARG_MAX:     XPRINT((intmax_t)v);            break;
+         case LG_DBG_ARG_PTRDIFF: XPRINT((ptrdiff_t)v);           break;
+         case LG_DBG_ARG_PTR:     XPRINT((void *)(uintptr_t)v);   break;
+
+         case LG_DBG_ARG_DOUBLE:
+            memcpy(&d, &v, sizeof(d));
+            XPRINT(d);
+            break;
+
+         case LG_DBG_ARG_LDOUBLE:
+            memcpy(&d, &v, sizeof(d));
+            XPRINT((long double)d);
+            break;
+
+         case LG_DBG_ARG_STR:
+            xStrArg(rec, v, str, sizeof(str));
+            XPRINT(str);
+            break;
+
+         case LG_DBG_ARG_ERRNO:
+            /* printf treats %m as %s of strerror(errno) */
+            spec[n-1] = 's';
+            XPRINT(strerror((int)v));
+            break;
+      }
+   }
+
+   putchar('\n');
+}
+
+int main(int argc, char *argv[])
+{
+   FILE *f;
+   char magic[8], stamp[32];
+   int64_t offset, ns;
+   uint32_t count, i, id;
+   lgDbgTraceRec_t rec;
+   struct tm tmp;
+   time_t secs;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "usage: lgtrace file\n");
+      return 1;
+   }
+
+   f = fopen(argv[1], "r");
+
+   if (!f)
+   {
+      fprintf(stderr, "lgtrace: can't open %s\n", argv[1]);
+      return 1;
+   }
+
+   if ((fread(magic, 8, 1, f) != 1) ||
+       memcmp(magic, LG_DBG_TRACE_MAGIC, 8) ||
+       (fread(&offset, sizeof(offset), 1, f) != 1) ||
+       (fread(&numSites, sizeof(numSites), 1, f) != 1) ||
+       (fread(&count, sizeof(count), 1, f) != 1))
+   {
+      fprintf(stderr, "lgtrace: %s is not a trace\n", argv[1]);
+      return 1;
+   }
+
+   sites = calloc(numSites + 1, sizeof(traceSite_t));
+
+   if (!sites) return 1;
+
+   for (i=0; i<numSites; i++)
+   {
+      if ((fread(&id, sizeof(id), 1, f) != 1) || (id > numSites))
+      {
+         fprintf(stderr, "lgtrace: bad site table\n");
+         return 1;
+      }
+
+      sites[id].func = xReadStr(f);
+      sites[id].format = xReadStr(f);
+   }
+
+   for (i=0; i<count; i++)
+   {
+      if (fread(&rec, sizeof(rec), 1, f) != 1)
+      {
+         fprintf(stderr, "lgtrace: truncated after %"PRIu32" events\n", i);
+         return 1;
+      }
+
+      ns = rec.tick + offset;
+      secs = ns / 1000000000;
+      localtime_r(&secs, &tmp);
+      strftime(stamp, sizeof(stamp), "%F %T", &tmp);
+
+      printf("%s.%06d ", stamp, (int)((ns % 1000000000) / 1000));
+
+      xRender(&rec);
+   }
+
+   fclose(f);
+
+   return 0;
+}
+
@@ -0,0 +1,156 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+/*
+Generates lgCmdHash.h, the perfect hash of the cmdInfo command
+names used by cmdMatch.
+
+mkCmdHash >lgCmdHash.h
+
+The names are hashed into CMD_HASH_BUCKETS buckets.  Starting with
+the fullest bucket a displacement is searched for which places every
+name of the bucket in a free slot.  A lookup then costs one hash of
+the name and one string compare.
+*/
+
+#define LG_CMD_TABLE_ONLY
+
+#include "lgCmd.c"
+
+#define ENTRIES (sizeof(cmdInfo)/sizeof(cmdInfo_t))
+
+static uint32_t hashes[ENTRIES];
+static int bucketOf[ENTRIES];
+static int bucketSize[CMD_HASH_BUCKETS];
+static int order[CMD_HASH_BUCKETS];
+static int disp[CMD_HASH_BUCKETS];
+static int slotIdx[CMD_HASH_SLOTS];
+
+static uint32_t xHash(const char *name)
+{
+   uint32_t hash = CMD_HASH_INIT;
+
+   while (*name) hash = cmdHashAdd(hash, *name++);
+
+   return hash;
+}
+
+static int xBySize(const void *a, const void *b)
+{
+   return bucketSize[*(int *)b] - bucketSize[*(int *)a];
+}
+
+static int xPlace(int b, int d)
+{
+   int i, j, slot;
+   int used[CMD_HASH_SLOTS];
+   int count = 0;
+
+   for (i=0; i<ENTRIES; i++)
+   {
+      if (bucketOf[i] != b) continue;
+
+      slot = cmdHashSlot(hashes[i], d);
+
+      if (slotIdx[slot] >= 0) return 0;
+
+      for (j=0; j<count; j++) if (used[j] == slot) return 0;
+
+      used[count++] = slot;
+   }
+
+   for (i=0; i<ENTRIES; i++)
+   {
+      if (bucketOf[i] == b) slotIdx[cmdHashSlot(hashes[i], d)] = i;
+   }
+
+   return 1;
+}
+
+int main(void)
+{
+   int i, j, b, d;
+
+   for (i=0; i<CMD_HASH_SLOTS; i++) slotIdx[i] = -1;
+
+   for (i=0; i<ENTRIES; i++)
+   {
+      hashes[i] = xHash(cmdInfo[i].name);
+      bucketOf[i] = cmdHashBucket(hashes[i]);
+
+      /* a linear search finds the first of any duplicate names */
+
+      for (j=0; j<i; j++)
+      {
+         if (strcasecmp(cmdInfo[i].name, cmdInfo[j].name) == 0)
+         {
+            bucketOf[i] = -1;
+            break;
+         }
+      }
+
+      if (bucketOf[i] >= 0) bucketSize[bucketOf[i]]++;
+   }
+
+   for (b=0; b<CMD_HASH_BUCKETS; b++) order[b] = b;
+
+   qsort(order, CMD_HASH_BUCKETS, sizeof(int), xBySize);
+
+   for (i=0; i<CMD_HASH_BUCKETS; i++)
+   {
+      b = order[i];
+
+      if (!bucketSize[b]) break;
+
+      for (d=0; d<256; d++) if (xPlace(b, d)) break;
+
+      if (d == 256)
+      {
+         fprintf(stderr, "mkCmdHash: no displacement for bucket %d\n", b);
+         return 1;
+      }
+
+      disp[b] = d;
+   }
+
+   printf("/* generated by mkCmdHash from cmdInfo in lgCmd.c, do not edit */\n\n");
+
+   printf("#define CMD_HASH_ENTRIES %d\n\n", (int)ENTRIES);
+
+   printf("static const uint8_t cmdHashDisp[CMD_HASH_BUCKETS]=\n{");
+   for (b=0; b<CMD_HASH_BUCKETS; b++)
+      printf("%s%3d,", (b%16) ? " " : "\n   ", disp[b]);
+   printf("\n};\n\n");
+
+   printf("static const int16_t cmdHashIdx[CMD_HASH_SLOTS]=\n{");
+   for (i=0; i<CMD_HASH_SLOTS; i++)
+      printf("%s%3d,", (i%16) ? " " : "\n   ", slotIdx[i]);
+   printf("\n};\n");
+
+   return 0;
+}
+
@@ -42,6 +42,7 @@ For more information, please refer to <http://unlicense.org/>
 #include <sys/socket.h>
 #include <netinet/tcp.h>
 #include <sys/select.h>
+#include <poll.h>
 
 #include <arpa/inet.h>
 
@@ -1621,6 +1622,417 @@ void thread_stop(pthread_t *pth)
    }
 }
 
+/* BATCHES */
+
+typedef struct
+{
+   int cmd;
+   int status;
+   int extPos; /* offset of the reply extension in rxBuf */
+   int extLen;
+   batchCBFunc_t f;
+   void *userdata;
+} batchEntry_t;
+
+struct batch_s
+{
+   int sbc;
+   int flushed;
+   uint8_t *txBuf;
+   int txLen;
+   int txCap;
+   batchEntry_t *entry;
+   int entries;
+   int entryCap;
+   uint8_t *rxBuf;
+   int rxLen;
+   int rxCap;
+};
+
+static int xBatchGrow(void **buf, int *cap, int need, int size)
+{
+   void *tmp;
+   int newCap;
+
+   if (need <= *cap) return 0;
+
+   newCap = *cap ? *cap : 64;
+
+   while (newCap < need) newCap *= 2;
+
+   tmp = realloc(*buf, (size_t)newCap * size);
+
+   if (tmp == NULL) return lgif_bad_malloc;
+
+   *buf = tmp;
+   *cap = newCap;
+
+   return 0;
+}
+
+/* append a command frame, mirrors lg_command */
+
+static int xBatchQueue(
+   batch_t *batch, int command, int extents, lgExtent_t *ext,
+   batchCBFunc_t f, void *userdata)
+{
+   int i, size;
+   lgCmd_p h;
+   uint8_t *p;
+   batchEntry_t *e;
+
+   if (batch == NULL) return lgif_bad_batch;
+
+   if (batch->flushed)
+   {
+      batch->txLen = 0;
+      batch->entries = 0;
+      batch->rxLen = 0;
+      batch->flushed = 0;
+   }
+
+   size = 0;
+   for (i=0; i<extents; i++) size += ext[i].size;
+
+   if (size > CMD_MAX_CMD_EXTENSION) return LG_MSG_TOOBIG;
+
+   if (xBatchGrow((void **)&batch->txBuf, &batch->txCap,
+         batch->txLen + sizeof(lgCmd_t) + size, 1)) return lgif_bad_malloc;
+
+   if (xBatchGrow((void **)&batch->entry, &batch->entryCap,
+         batch->entries + 1, sizeof(batchEntry_t))) return lgif_bad_malloc;
+
+   p = batch->txBuf + batch->txLen;
+
+   h = (lgCmd_p) p;
+
+   h->magic = LG_MAGIC;
+   h->size = size;
+   h->cmd = command;
+   h->doubles = 0;
+   h->longs = 0;
+   h->shorts = 0;
+
+   p += sizeof(lgCmd_t);
+
+   for (i=0; i<extents; i++)
+   {
+      memcpy(p, ext[i].ptr, ext[i].size);
+      p += ext[i].size;
+
+      switch(ext[i].bytes)
+      {
+         case 8:
+            h->doubles += ext[i].count;
+            break;
+
+         case 4:
+            h->longs += ext[i].count;
+            break;
+
+         case 2:
+            h->shorts += ext[i].count;
+            break;
+      }
+   }
+
+   batch->txLen += sizeof(lgCmd_t) + size;
+
+   e = &batch->entry[batch->entries];
+
+   e->cmd = command;
+   e->status = lgif_batch_pending;
+   e->extPos = 0;
+   e->extLen = 0;
+   e->f = f;
+   e->userdata = userdata;
+
+   return batch->entries++;
+}
+
+static int xBatchQueueN(
+   batch_t *batch, int command, int count, const uint32_t *param,
+   batchCBFunc_t f, void *userdata)
+{
+   lgExtent_t ext[1];
+
+   ext[0].size = count * sizeof(uint32_t);
+   ext[0].count = count;
+   ext[0].bytes = sizeof(uint32_t);
+   ext[0].ptr = param;
+
+   return xBatchQueue(batch, command, count ? 1 : 0, ext, f, userdata);
+}
+
+batch_t *batch_open(int sbc)
+{
+   batch_t *batch;
+
+   if ((sbc < 0) || (sbc >= MAX_SBC) || !gPiInUse[sbc]) return NULL;
+
+   batch = calloc(1, sizeof(batch_t));
+
+   if (batch) batch->sbc = sbc;
+
+   return batch;
+}
+
+void batch_close(batch_t *batch)
+{
+   if (batch == NULL) return;
+
+   free(batch->txBuf);
+   free(batch->entry);
+   free(batch->rxBuf);
+   free(batch);
+}
+
+int batch_command(
+   batch_t *batch, int command, int count, const uint32_t *param,
+   batchCBFunc_t f, void *userdata)
+{
+   if ((count < 0) || (count > CMD_MAX_PARAM)) return lgif_bad_batch;
+
+   return xBatchQueueN(batch, command, count, param, f, userdata);
+}
+
+int batch_gpio_read(batch_t *batch, int handle, int gpio)
+{
+   uint32_t pars[] = {handle&0xffff, gpio};
+
+   return xBatchQueueN(batch, LG_CMD_GR, 2, pars, NULL, NULL);
+}
+
+int batch_gpio_write(batch_t *batch, int handle, int gpio, int value)
+{
+   uint32_t pars[] = {handle&0xffff, gpio, value};
+
+   return xBatchQueueN(batch, LG_CMD_GW, 3, pars, NULL, NULL);
+}
+
+int batch_group_write(
+   batch_t *batch, int handle, int group,
+   uint64_t groupBits, uint64_t groupMask)
+{
+   lgExtent_t ext[2];
+   uint64_t parq[] = {groupBits, groupMask};
+   uint32_t pars[] = {handle&0xffff, group};
+
+   ext[0].size = sizeof(parq);
+   ext[0].count = sizeof(parq)/sizeof(parq[0]);
+   ext[0].bytes = sizeof(parq[0]);
+   ext[0].ptr = &parq;
+
+   ext[1].size = sizeof(pars);
+   ext[1].count = sizeof(pars)/sizeof(pars[0]);
+   ext[1].bytes = sizeof(pars[0]);
+   ext[1].ptr = &pars;
+
+   return xBatchQueue(batch, LG_CMD_GGWX, 2, ext, NULL, NULL);
+}
+
+int batch_i2c_read_byte_data(batch_t *batch, int handle, int reg)
+{
+   uint32_t pars[] = {handle, reg};
+
+   return xBatchQueueN(batch, LG_CMD_I2CRB, 2, pars, NULL, NULL);
+}
+
+int batch_i2c_write_byte_data(batch_t *batch, int handle, int reg, int val)
+{
+   uint32_t pars[] = {handle, reg, val};
+
+   return xBatchQueueN(batch, LG_CMD_I2CWB, 3, pars, NULL, NULL);
+}
+
+int batch_i2c_read_i2c_block_data(
+   batch_t *batch, int handle, int reg, int count)
+{
+   uint32_t pars[] = {handle, reg, count};
+
+   return xBatchQueueN(batch, LG_CMD_I2CRI, 3, pars, NULL, NULL);
+}
+
+int batch_i2c_write_i2c_block_data(
+   batch_t *batch, int handle, int reg, const char *buf, int count)
+{
+   lgExtent_t ext[2];
+   uint32_t pars[] = {handle, reg};
+
+   ext[0].size = sizeof(pars);
+   ext[0].count = sizeof(pars)/sizeof(pars[0]);
+   ext[0].bytes = sizeof(pars[0]);
+   ext[0].ptr = &pars;
+
+   ext[1].size = count;
+   ext[1].count = count;
+   ext[1].bytes = 1;
+   ext[1].ptr = buf;
+
+   return xBatchQueue(batch, LG_CMD_I2CWI, 2, ext, NULL, NULL);
+}
+
+int batch_on_reply(batch_t *batch, int index, batchCBFunc_t f, void *userdata)
+{
+   if ((batch == NULL) || (index < 0) || (index >= batch->entries))
+      return lgif_bad_batch;
+
+   batch->entry[index].f = f;
+   batch->entry[index].userdata = userdata;
+
+   return 0;
+}
+
+/* parse every complete reply held in rxBuf, returns the replies matched */
+
+static int xBatchParse(batch_t *batch, int *parsePos, int done)
+{
+   lgCmd_p h;
+   int len;
+
+   while ((done < batch->entries) &&
+          ((batch->rxLen - *parsePos) >= (int)sizeof(lgCmd_t)))
+   {
+      h = (lgCmd_p)(batch->rxBuf + *parsePos);
+
+      len = sizeof(lgCmd_t) + h->size;
+
+      if ((batch->rxLen - *parsePos) < len) break;
+
+      batch->entry[done].status = h->status;
+      batch->entry[done].extPos = *parsePos + sizeof(lgCmd_t);
+      batch->entry[done].extLen = h->size;
+
+      *parsePos += len;
+      done++;
+   }
+
+   return done;
+}
+
+int batch_flush(batch_t *batch)
+{
+   struct pollfd pfd;
+   int sbc, sent, done, parsePos, n, i, status;
+   batchEntry_t *e;
+
+   if (batch == NULL) return lgif_bad_batch;
+
+   sbc = batch->sbc;
+
+   if (!gPiInUse[sbc]) return lgif_unconnected_sbc;
+
+   if (batch->flushed || !batch->entries) return 0;
+
+   _pml(sbc);
+
+   /* send and receive together so a large batch can not deadlock
+      with the daemon blocked writing replies we are not reading */
+
+   sent = 0;
+   done = 0;
+   parsePos = 0;
+   batch->rxLen = 0;
+   status = 0;
+
+   pfd.fd = gPigCommand[sbc];
+
+   while (done < batch->entries)
+   {
+      pfd.events = POLLIN;
+      if (sent < batch->txLen) pfd.events |= POLLOUT;
+
+      if (poll(&pfd, 1, -1) < 0)
+      {
+         if (errno == EINTR) continue;
+         status = lgif_bad_recv;
+         break;
+      }
+
+      if (pfd.revents & POLLOUT)
+      {
+         n = send(pfd.fd, batch->txBuf + sent, batch->txLen - sent,
+            MSG_DONTWAIT | MSG_NOSIGNAL);
+
+         if ((n < 0) && (errno != EAGAIN) && (errno != EINTR))
+         {
+            status = lgif_bad_send;
+            break;
+         }
+
+         if (n > 0) sent += n;
+      }
+
+      if (pfd.revents & (POLLIN | POLLHUP | POLLERR))
+      {
+         if (xBatchGrow((void **)&batch->rxBuf, &batch->rxCap,
+               batch->rxLen + CMD_MAX_EXTENSION, 1))
+         {
+            status = lgif_bad_malloc;
+            break;
+         }
+
+         n = recv(pfd.fd, batch->rxBuf + batch->rxLen,
+            batch->rxCap - batch->rxLen, MSG_DONTWAIT);
+
+         if ((n == 0) || ((n < 0) && (errno != EAGAIN) && (errno != EINTR)))
+         {
+            status = lgif_bad_recv;
+            break;
+         }
+
+         if (n > 0)
+         {
+            batch->rxLen += n;
+            done = xBatchParse(batch, &parsePos, done);
+         }
+      }
+   }
+
+   _pmu(sbc);
+
+   batch->flushed = 1;
+
+   for (i=0; i<done; i++)
+   {
+      e = &batch->entry[i];
+
+      if (e->f)
+         (e->f)(sbc, i, e->status,
+            (char *)batch->rxBuf + e->extPos, e->extLen, e->userdata);
+   }
+
+   if (status < 0) return status;
+
+   return done;
+}
+
+int batch_status(batch_t *batch, int index)
+{
+   if ((batch == NULL) || (index < 0) || (index >= batch->entries))
+      return lgif_bad_batch;
+
+   return batch->entry[index].status;
+}
+
+int batch_data(batch_t *batch, int index, char *buf, int count)
+{
+   batchEntry_t *e;
+
+   if ((batch == NULL) || (index < 0) || (index >= batch->entries))
+      return lgif_bad_batch;
+
+   e = &batch->entry[index];
+
+   if (e->status == lgif_batch_pending) return lgif_batch_pending;
+
+   if (count > e->extLen) count = e->extLen;
+
+   if (buf && (count > 0)) memcpy(buf, batch->rxBuf + e->extPos, count);
+
+   return count;
+}
+
 /* UTILITIES */
 
 int lgu_get_internal(int sbc, int config_id, uint64_t *config_value)
@@ -1771,6 +2183,10 @@ const char *lgu_error_text(int errnum)
             return "not connected to sbc";
          case lgif_too_many_pis:
             return "too many connected sbcs";
+         case lgif_bad_batch:
+            return "bad batch or batch index";
+         case lgif_batch_pending:
+            return "batch reply not yet received";
 
          default:
             return "unknown error";
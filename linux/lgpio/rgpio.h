@@ -88,6 +88,27 @@ ESSENTIAL
 rgpiod_start               Connects to a rgpiod daemon
 rgpiod_stop                Disconnects from a rgpiod daemon
 
+BATCHES
+
+batch_open                 Opens a command batch
+batch_close                Closes a command batch
+
+batch_command              Queues a command on a batch
+batch_gpio_read            Queues a GPIO read on a batch
+batch_gpio_write           Queues a GPIO write on a batch
+batch_group_write          Queues a group write on a batch
+batch_i2c_read_byte_data   Queues an I2C byte read on a batch
+batch_i2c_write_byte_data  Queues an I2C byte write on a batch
+batch_i2c_read_i2c_block_data  Queues an I2C block read on a batch
+batch_i2c_write_i2c_block_data Queues an I2C block write on a batch
+
+batch_on_reply             Sets the reply function for a queued command
+
+batch_flush                Sends a batch and collects the replies
+
+batch_status               Gets the status of a batched command
+batch_data                 Gets the reply data of a batched command
+
 FILES
 
 file_open                  Opens a file
@@ -251,6 +272,12 @@ typedef void (*CBFunc_t)
 
 typedef struct callback_s callback_t;
 
+typedef struct batch_s batch_t;
+
+typedef void (*batchCBFunc_t)
+   (int sbc, int index, int status,
+   const char *ext, int extLen, void *userdata);
+
 typedef void *(lgThreadFunc_t) (void *);
 
 /* --------------------------------------------------------- ESSENTIAL API
@@ -298,6 +325,272 @@ sbc: >= 0 (as returned by [*rgpiod_start*]).
 D*/
 
 
+/* ----------------------------------------------------------- BATCHES API
+*/
+
+/*F*/
+batch_t *batch_open(int sbc);
+/*D
+Opens an empty command batch for a sbc.
+
+. .
+sbc: >= 0 (as returned by [*rgpiod_start*]).
+. .
+
+If OK returns a pointer to a batch_t.
+
+On failure returns NULL.
+
+Commands queued on a batch are not sent to the daemon until
+[*batch_flush*] is called.  All the queued commands are then written
+in one go and the replies collected in order, so the round trip cost
+is paid once per batch rather than once per command.
+D*/
+
+/*F*/
+void batch_close(batch_t *batch);
+/*D
+Closes a batch and frees its buffers.
+
+. .
+batch: as returned by [*batch_open*].
+. .
+
+No value is returned.
+D*/
+
+/*F*/
+int batch_command(
+   batch_t *batch, int command, int count, const uint32_t *param,
+   batchCBFunc_t f, void *userdata);
+/*D
+Queues a daemon command on a batch.
+
+. .
+   batch: as returned by [*batch_open*].
+ command: the command number (LG_CMD_x).
+   count: the number of 32-bit parameters, 0-512.
+   param: the 32-bit parameters.
+       f: a function to call with the reply, may be NULL.
+userdata: a pointer to arbitrary user data.
+. .
+
+If OK returns the index of the command within the batch.
+
+On failure returns a negative error code.
+
+The index may be passed to [*batch_status*] and [*batch_data*] once the
+batch has been flushed.
+
+Commands needing 64-bit or byte extents should use one of the
+batch_gpio, batch_group, or batch_i2c functions.
+D*/
+
+/*F*/
+int batch_gpio_read(batch_t *batch, int handle, int gpio);
+/*D
+Queues a [*gpio_read*] on a batch.
+
+. .
+ batch: as returned by [*batch_open*].
+handle: >= 0 (as returned by [*gpiochip_open*]).
+  gpio: the GPIO to be read.
+. .
+
+If OK returns the index of the command within the batch.
+
+On failure returns a negative error code.
+
+After the flush [*batch_status*] returns the GPIO level.
+D*/
+
+/*F*/
+int batch_gpio_write(batch_t *batch, int handle, int gpio, int value);
+/*D
+Queues a [*gpio_write*] on a batch.
+
+. .
+ batch: as returned by [*batch_open*].
+handle: >= 0 (as returned by [*gpiochip_open*]).
+  gpio: the GPIO to be written.
+ value: the level to set, 0 or 1.
+. .
+
+If OK returns the index of the command within the batch.
+
+On failure returns a negative error code.
+D*/
+
+/*F*/
+int batch_group_write(
+   batch_t *batch, int handle, int group,
+   uint64_t groupBits, uint64_t groupMask);
+/*D
+Queues a [*group_write*] on a batch.
+
+. .
+    batch: as returned by [*batch_open*].
+   handle: >= 0 (as returned by [*gpiochip_open*]).
+    group: the group to be written.
+groupBits: the level to set if the corresponding bit in groupMask is set.
+groupMask: a mask indicating the group GPIO to be updated.
+. .
+
+If OK returns the index of the command within the batch.
+
+On failure returns a negative error code.
+D*/
+
+/*F*/
+int batch_i2c_read_byte_data(batch_t *batch, int handle, int reg);
+/*D
+Queues an [*i2c_read_byte_data*] on a batch.
+
+. .
+ batch: as returned by [*batch_open*].
+handle: >= 0 (as returned by [*i2c_open*]).
+   reg: >= 0, the device register.
+. .
+
+If OK returns the index of the command within the batch.
+
+On failure returns a negative error code.
+
+After the flush [*batch_status*] returns the byte read.
+D*/
+
+/*F*/
+int batch_i2c_write_byte_data(batch_t *batch, int handle, int reg, int val);
+/*D
+Queues an [*i2c_write_byte_data*] on a batch.
+
+. .
+ batch: as returned by [*batch_open*].
+handle: >= 0 (as returned by [*i2c_open*]).
+   reg: >= 0, the device register.
+   val: 0-255, the value to write.
+. .
+
+If OK returns the index of the command within the batch.
+
+On failure returns a negative error code.
+D*/
+
+/*F*/
+int batch_i2c_read_i2c_block_data(
+   batch_t *batch, int handle, int reg, int count);
+/*D
+Queues an [*i2c_read_i2c_block_data*] on a batch.
+
+. .
+ batch: as returned by [*batch_open*].
+handle: >= 0 (as returned by [*i2c_open*]).
+   reg: >= 0, the device register.
+ count: 1-32, the number of bytes to read.
+. .
+
+If OK returns the index of the command within the batch.
+
+On failure returns a negative error code.
+
+After the flush [*batch_status*] returns the number of bytes read
+and [*batch_data*] copies them out.
+D*/
+
+/*F*/
+int batch_i2c_write_i2c_block_data(
+   batch_t *batch, int handle, int reg, const char *buf, int count);
+/*D
+Queues an [*i2c_write_i2c_block_data*] on a batch.
+
+. .
+ batch: as returned by [*batch_open*].
+handle: >= 0 (as returned by [*i2c_open*]).
+   reg: >= 0, the device register.
+   buf: the data to write.
+ count: 1-32, the number of bytes to write.
+. .
+
+If OK returns the index of the command within the batch.
+
+On failure returns a negative error code.
+D*/
+
+/*F*/
+int batch_on_reply(batch_t *batch, int index, batchCBFunc_t f, void *userdata);
+/*D
+Sets the function to be called with the reply of a queued command.
+
+. .
+   batch: as returned by [*batch_open*].
+   index: as returned when the command was queued.
+       f: a function to call with the reply, may be NULL.
+userdata: a pointer to arbitrary user data.
+. .
+
+If OK returns 0.
+
+On failure returns a negative error code.
+D*/
+
+/*F*/
+int batch_flush(batch_t *batch);
+/*D
+Sends all the commands queued on a batch and waits for their replies.
+
+. .
+batch: as returned by [*batch_open*].
+. .
+
+If OK returns the number of replies received.
+
+On failure returns a negative error code.
+
+The commands are sent and the replies read concurrently so a large
+batch can not stall with both ends blocked on full socket buffers.
+
+Once all the replies have arrived any reply functions are called in
+queue order.  The sbc command lock is not held while they run so they
+may call other rgpio functions.
+
+The results remain available until the next command is queued on
+the batch, which starts a new batch.
+D*/
+
+/*F*/
+int batch_status(batch_t *batch, int index);
+/*D
+Returns the status of a command in a flushed batch.
+
+. .
+batch: as returned by [*batch_open*].
+index: as returned when the command was queued.
+. .
+
+Returns the value the equivalent unbatched call would have returned.
+This is a negative error code if the command failed.
+
+Returns lgif_batch_pending if the reply has not been received.
+D*/
+
+/*F*/
+int batch_data(batch_t *batch, int index, char *buf, int count);
+/*D
+Copies the reply data of a command in a flushed batch.
+
+. .
+batch: as returned by [*batch_open*].
+index: as returned when the command was queued.
+  buf: a buffer to receive the data.
+count: the maximum number of bytes to copy.
+. .
+
+If OK returns the number of bytes copied.
+
+On failure returns a negative error code.
+D*/
+
+
 /* -------------------------------------------------------------- FILE API
 */
 
@@ -2517,6 +2810,20 @@ the rgpiod daemon.  It may be NULL in which case localhost
 is used unless overridden by the LG_ADDR environment
 variable.
 
+*batch::
+A batch of commands as returned by [*batch_open*].
+
+batchCBFunc_t::
+. .
+typedef void (*batchCBFunc_t)
+   (int sbc, int index, int status,
+   const char *ext, int extLen, void *userdata);
+. .
+
+Called by [*batch_flush*] with the reply to a batched command.  status
+is the value the unbatched call would have returned and ext/extLen any
+reply data.  ext is only valid for the duration of the call.
+
 bitVal::
 A value of 0 or 1.
 
@@ -2548,6 +2855,9 @@ A single character, an 8 bit quantity able to store 0-255.
 chipInfo::
 A pointer to a lgChipInfo_t object.
 
+command::
+A daemon command number, one of the LG_CMD_x values in lgCmd.h.
+
 config_id::
 A number identifying a configuration item.
 
@@ -2669,6 +2979,10 @@ A buffer used to pass data to a function.
 inCount::
 The size of an input buffer.
 
+index::
+The position of a command within a batch, as returned when it
+was queued.
+
 int::
 A whole number, negative or positive.
 
@@ -2765,7 +3079,7 @@ outCount::
 The size of an output buffer.
 
 *param::
-An array of script parameters.
+An array of script or command parameters.
 
 *portStr::
 A string specifying the port address used by the SBC running
@@ -2957,6 +3271,8 @@ typedef enum
    lgif_callback_not_found = -2010,
    lgif_unconnected_sbc    = -2011,
    lgif_too_many_pis       = -2012,
+   lgif_bad_batch          = -2013,
+   lgif_batch_pending      = -2014,
 } lgifError_t;
 
 /*DEF_E*/
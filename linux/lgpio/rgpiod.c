@@ -57,11 +57,15 @@ int      gFdSock = -1;
 
 static int      CfgIfFlags = LG_DEFAULT_IF_FLAGS;
 static int      CfgSocketPort = LG_DEFAULT_SOCKET_PORT;
+static int      CfgSocketWorkers = 0; /* 0 is thread per connection */
+static char    *CfgTraceFile = NULL;
+static volatile sig_atomic_t traceDumpWanted = 0;
 static pthread_t pthSocket;
 
 /* prototypes */
 
 void *pthSocketThread(void *x);
+void *pthSocketEventThread(void *x);
 
 /* ----------------------------------------------------------------------- */
 
@@ -138,8 +142,17 @@ static int xOpenSocket(void)
          PARAM_ERROR(LG_INIT_FAILED, "bind to port %d failed (%m)", port);
    }
 
-   if (pthread_create(&pthSocket, &pthAttr, pthSocketThread, &i))
-      PARAM_ERROR(LG_INIT_FAILED, "pthread_create socket failed (%m)");
+   if (CfgSocketWorkers)
+   {
+      if (pthread_create(&pthSocket, &pthAttr,
+         pthSocketEventThread, &CfgSocketWorkers))
+         PARAM_ERROR(LG_INIT_FAILED, "pthread_create socket failed (%m)");
+   }
+   else
+   {
+      if (pthread_create(&pthSocket, &pthAttr, pthSocketThread, &i))
+         PARAM_ERROR(LG_INIT_FAILED, "pthread_create socket failed (%m)");
+   }
 
    return LG_OKAY;
 }
@@ -160,14 +173,22 @@ static void xFatal(char *fmt, ...)
    exit(EXIT_FAILURE);
 }
 
+static void xTraceSignal(int signum)
+{
+   traceDumpWanted = 1;
+}
+
 static void xUsage()
 {
    fprintf(stderr, "\n" \
       "Usage: rgpiod [OPTION] ...\n" \
       "   -c dir,     set config dir (default launch dir)\n" \
+      "   -e workers, event loop with worker pool (1-64, default\n" \
+      "               thread per connection)\n" \
       "   -l,         localhost socket only (default local+remote)\n" \
       "   -n IP addr, allow address, name or dotted (default allow all)\n" \
       "   -p value,   socket port (1024-32000, default 8889)\n" \
+      "   -t file,    trace debug messages, dump to file on SIGUSR1\n" \
       "   -v,         display rgpiod version and exit\n" \
       "   -w dir,     set working directory (default launch directory)\n" \
       "   -x,         enable access control (default off)\n" \
@@ -223,7 +244,7 @@ static void xInitOpts(int argc, char *argv[])
    int opt, err, i;
    uint32_t addr;
 
-   while ((opt = getopt(argc, argv, "c:ln:p:vw:x")) != -1)
+   while ((opt = getopt(argc, argv, "c:e:ln:p:t:vw:x")) != -1)
    {
       switch (opt)
       {
@@ -231,6 +252,13 @@ static void xInitOpts(int argc, char *argv[])
             lguSetConfigDir(optarg);
             break;
 
+         case 'e':
+            i = xGetNum(optarg, &err);
+            if ((i >= LG_MIN_SOCKET_WORKERS) && (i <= LG_MAX_SOCKET_WORKERS))
+               CfgSocketWorkers = i;
+            else xFatal("invalid -e option (%s)", optarg);
+            break;
+
          case 'l':
             CfgIfFlags |= LG_LOCALHOST_SOCK_IF;
             break; 
@@ -249,6 +277,10 @@ static void xInitOpts(int argc, char *argv[])
             else xFatal("invalid -p option (%d)", i);
             break;
 
+         case 't':
+            CfgTraceFile = optarg;
+            break;
+
          case 'v':
             printf("rgpiod_%d.%d.%d.%d\n",
                (RGPIOD_VERSION>>24)&0xff, (RGPIOD_VERSION>>16)&0xff,
@@ -279,6 +311,12 @@ int main(int argc, char **argv)
 
    xInitOpts(argc, argv);
 
+   if (CfgTraceFile)
+   {
+      lgDbgTraceStart(0);
+      signal(SIGUSR1, xTraceSignal);
+   }
+
    /* initialise */
 
    if (xOpenSocket() >= 0)
@@ -295,6 +333,12 @@ int main(int argc, char **argv)
          sleep(1);
 
          fflush(stderr);
+
+         if (traceDumpWanted)
+         {
+            traceDumpWanted = 0;
+            lgDbgTraceDump(CfgTraceFile);
+         }
       }
    }
 
@@ -55,11 +55,19 @@ extern "C" {
 
 int lgExecCmd(lgCmd_p h, int bufSize);
 
+struct lgCtx_s;
+void lgExecCtxInit(struct lgCtx_s *Ctx);
+
 /* port */
 
 #define LG_MIN_SOCKET_PORT 1024
 #define LG_MAX_SOCKET_PORT 32000
 
+/* event loop workers */
+
+#define LG_MIN_SOCKET_WORKERS 1
+#define LG_MAX_SOCKET_WORKERS 64
+
 /* ifFlags: */
 
 #define LG_LOCALHOST_SOCK_IF 4
@@ -0,0 +1,142 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+
+/*
+Checks the batch size limit against a running daemon: a command with
+the largest extension rgpiod accepts must reach it, and one a byte
+larger must be refused before it is sent.
+
+test_batch
+
+The daemon is located via LG_ADDR/LG_PORT as for any rgpio client.
+Prints ok or FAIL, the library's exit handler hides the exit status.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "rgpio.h"
+#include "rgpiod.h"
+#include "lgCmd.h"
+
+/* the block write parameters precede the data in the extension */
+#define BLOCK_PARAMS (2 * (int)sizeof(uint32_t))
+
+int main(int argc, char *argv[])
+{
+   int sbc, idx, status, failed;
+   char *buf;
+   batch_t *batch;
+
+   (void)argv;
+
+   if (argc > 1)
+   {
+      fprintf(stderr, "usage: test_batch\n");
+      return 1;
+   }
+
+   sbc = rgpiod_start(NULL, NULL);
+
+   if (sbc < 0)
+   {
+      fprintf(stderr, "rgpiod_start failed (%s)\n", lgu_error_text(sbc));
+      return 1;
+   }
+
+   batch = batch_open(sbc);
+   buf = calloc(1, CMD_MAX_CMD_EXTENSION);
+
+   if ((batch == NULL) || (buf == NULL))
+   {
+      fprintf(stderr, "batch_open failed\n");
+      rgpiod_stop(sbc);
+      return 1;
+   }
+
+   failed = 0;
+
+   /* one byte over the limit is refused when queued */
+
+   status = batch_i2c_write_i2c_block_data(
+      batch, 0, 0, buf, CMD_MAX_CMD_EXTENSION - BLOCK_PARAMS + 1);
+
+   if (status != LG_MSG_TOOBIG)
+   {
+      fprintf(stderr, "over the limit: queued (%d)\n", status);
+      failed = 1;
+   }
+
+   /* exactly at the limit is sent, the daemon rejects the bad handle
+      rather than the frame and carries on with the rest of the batch */
+
+   idx = batch_i2c_write_i2c_block_data(
+      batch, 0, 0, buf, CMD_MAX_CMD_EXTENSION - BLOCK_PARAMS);
+
+   if (idx < 0)
+   {
+      fprintf(stderr, "at the limit: not queued (%s)\n", lgu_error_text(idx));
+      failed = 1;
+   }
+   else
+   {
+      batch_command(batch, LG_CMD_SBC, 0, NULL, NULL, NULL);
+
+      status = batch_flush(batch);
+
+      if (status != 2)
+      {
+         fprintf(stderr, "at the limit: flush failed (%s)\n",
+            lgu_error_text(status));
+         failed = 1;
+      }
+      else
+      {
+         status = batch_status(batch, idx);
+
+         if ((status >= 0) || (status == LG_MSG_TOOBIG))
+         {
+            fprintf(stderr, "at the limit: unexpected status (%d)\n", status);
+            failed = 1;
+         }
+
+         status = batch_status(batch, idx + 1);
+
+         if (status < 0)
+         {
+            fprintf(stderr, "after the limit: failed (%s)\n",
+               lgu_error_text(status));
+            failed = 1;
+         }
+      }
+   }
+
+   printf("batch size limit: %s\n", failed ? "FAIL" : "ok");
+
+   free(buf);
+
+   batch_close(batch);
+
+   rgpiod_stop(sbc);
+
+   return failed;
+}